@@ -0,0 +1,163 @@
+// SPDX-License-Identifier: Apache-2.0
+// Helpers shared by the ds-runtime benchmark tools (ds_bench, ds_replay):
+// size parsing, backend construction, test file generation and JSON output.
+
+#pragma once
+
+#include "ds_runtime.hpp"
+#include "ds_runtime_mmap.hpp"
+#ifdef DS_RUNTIME_HAS_IO_URING
+#include "ds_runtime_uring.hpp"
+#endif
+#ifdef DS_RUNTIME_HAS_VULKAN
+#include "ds_runtime_vulkan.hpp"
+#endif
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace bench {
+
+/// "mmap" uses worker threads like the others; "mmap_inline" runs each
+/// request on the submitting thread.
+inline const char* const kAllBackends[] = {"cpu", "mmap", "mmap_inline", "io_uring", "vulkan"};
+
+/// Parse a byte count with an optional K, M or G suffix.
+inline bool parse_size(const char* text, std::size_t& out) {
+    char* end = nullptr;
+    errno = 0;
+    const unsigned long long value = std::strtoull(text, &end, 10);
+    if (errno != 0 || end == text) {
+        return false;
+    }
+    unsigned shift = 0;
+    if (*end == 'K' || *end == 'k') {
+        shift = 10;
+        ++end;
+    } else if (*end == 'M' || *end == 'm') {
+        shift = 20;
+        ++end;
+    } else if (*end == 'G' || *end == 'g') {
+        shift = 30;
+        ++end;
+    }
+    if (*end != '\0' || (shift != 0 && value > (~0ull >> shift))) {
+        return false;
+    }
+    out = static_cast<std::size_t>(value << shift);
+    return true;
+}
+
+/// True if backend @p name was compiled into the library.
+inline bool backend_built(const std::string& name) {
+    if (name == "cpu" || name == "mmap" || name == "mmap_inline") {
+        return true;
+    }
+#ifdef DS_RUNTIME_HAS_IO_URING
+    if (name == "io_uring") {
+        return true;
+    }
+#endif
+#ifdef DS_RUNTIME_HAS_VULKAN
+    if (name == "vulkan") {
+        return true;
+    }
+#endif
+    return false;
+}
+
+/// Construct backend @p name, or return null if it is not built.
+inline std::shared_ptr<ds::Backend> make_backend(const std::string& name,
+                                                 std::size_t workers,
+                                                 std::size_t queue_depth) {
+    (void)queue_depth;
+    if (name == "cpu") {
+        return ds::make_cpu_backend(workers);
+    }
+    if (name == "mmap" || name == "mmap_inline") {
+        ds::MmapBackendConfig config;
+        config.worker_count = name == "mmap" ? workers : 0;
+        return ds::make_mmap_backend(config);
+    }
+#ifdef DS_RUNTIME_HAS_IO_URING
+    if (name == "io_uring") {
+        ds::IoUringBackendConfig config;
+        config.entries = static_cast<unsigned>(std::max<std::size_t>(queue_depth, 256));
+        config.worker_count = workers;
+        return ds::make_io_uring_backend(config);
+    }
+#endif
+#ifdef DS_RUNTIME_HAS_VULKAN
+    if (name == "vulkan") {
+        ds::VulkanBackendConfig config;
+        config.worker_count = workers;
+        return ds::make_vulkan_backend(config);
+    }
+#endif
+    return nullptr;
+}
+
+/// Fill @p path with @p size bytes of lowercase ASCII so FakeUppercase has
+/// work to do on every byte.
+inline bool generate_file(const std::string& path, std::uint64_t size) {
+    const int fd = ::open(path.c_str(), O_CREAT | O_WRONLY | O_TRUNC, 0644);
+    if (fd < 0) {
+        return false;
+    }
+    std::vector<char> chunk(1u << 20);
+    for (std::size_t i = 0; i < chunk.size(); ++i) {
+        chunk[i] = static_cast<char>('a' + i % 26);
+    }
+    std::uint64_t written = 0;
+    while (written < size) {
+        const std::size_t n = static_cast<std::size_t>(
+            std::min<std::uint64_t>(chunk.size(), size - written));
+        const ssize_t rc = ::write(fd, chunk.data(), n);
+        if (rc <= 0) {
+            ::close(fd);
+            return false;
+        }
+        written += static_cast<std::uint64_t>(rc);
+    }
+    ::close(fd);
+    return true;
+}
+
+/// Quote @p s as a JSON string.
+inline std::string json_string(const std::string& s) {
+    std::string out = "\"";
+    for (const char c : s) {
+        if (c == '"' || c == '\\') {
+            out += '\\';
+            out += c;
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            out += ' ';
+        } else {
+            out += c;
+        }
+    }
+    out += '"';
+    return out;
+}
+
+/// Summarise @p h as a JSON object of count, mean and percentiles.
+inline void write_histogram(std::ostream& out, const ds::LatencyHistogram& h) {
+    out << "{\"count\":" << h.count
+        << ",\"mean_ns\":" << static_cast<std::uint64_t>(h.mean_ns())
+        << ",\"p50_ns\":" << h.percentile_ns(50)
+        << ",\"p90_ns\":" << h.percentile_ns(90)
+        << ",\"p99_ns\":" << h.percentile_ns(99)
+        << ",\"p999_ns\":" << h.percentile_ns(99.9)
+        << ",\"max_ns\":" << h.max_ns << "}";
+}
+
+} // namespace bench
@@ -0,0 +1,685 @@
+// SPDX-License-Identifier: Apache-2.0
+// Benchmark suite for ds-runtime backends and the Queue front-end.
+//
+// Cases:
+//  - seq_read               sequential block reads over a generated file
+//  - rand_read              block reads at shuffled, block-aligned offsets
+//  - view_read              rand_read into runtime-owned buffers
+//                           (RequestMemory::Runtime, zero-copy on mmap)
+//  - cached_read            rand_read through a warmed decoded-asset cache
+//  - prefetched_read        seq_read through the readahead prefetcher
+//  - small_read             random small reads (IOPS-bound)
+//  - write                  sequential block writes to a scratch file
+//  - decode_fake_uppercase  block reads with Compression::FakeUppercase
+//  - decode_gdeflate        GDeflate streams of one block each, read
+//                           through the streaming decoder
+//  - enqueue_mp             Queue::enqueue() from 1..N producer threads at
+//                           once, reported as enqueue ops/s per producer
+//                           count (--producers)
+//
+// Every case runs against each backend compiled into the library (cpu,
+// mmap, io_uring, vulkan), except enqueue_mp: enqueue() never reaches the
+// backend, so it runs once, on the first backend. Files are generated in
+// --dir, which defaults to /dev/shm so that results measure the runtime
+// rather than the disk. Results are written as one JSON document for
+// regression tracking.
+//
+// The runtime ships no GDeflate codec, so decode_gdeflate generates streams
+// of stored blocks and decodes them with a copying codec: it measures the
+// read/decode pipeline around the codec, not the codec itself.
+
+#include "bench_common.hpp"
+#include "ds_runtime_cache.hpp"
+#include "ds_runtime_prefetch.hpp"
+#include "ds_runtime_stream_decode.hpp"
+#include "gdeflate_format.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace {
+
+using bench::backend_built;
+using bench::json_string;
+using bench::kAllBackends;
+using bench::parse_size;
+using bench::write_histogram;
+
+/// Bumped whenever the JSON layout changes incompatibly.
+constexpr int kSchemaVersion = 1;
+
+/// Decoded bytes per stored block in the decode_gdeflate streams.
+constexpr std::size_t kGDeflateBlock = 64 * 1024;
+
+const char* const kAllCases[] = {
+    "seq_read", "rand_read", "view_read", "cached_read", "prefetched_read",
+    "small_read", "write",
+    "decode_fake_uppercase", "decode_gdeflate", "enqueue_mp",
+};
+
+struct Options {
+    std::vector<std::string> backends;
+    std::vector<std::string> cases;
+    std::string   dir;
+    std::string   output;
+    std::size_t   file_size   = 64u << 20;
+    std::size_t   block_size  = 1u << 20;
+    std::size_t   small_size  = 4096;
+    std::size_t   small_count = 16384;
+    std::size_t   queue_depth = 32;
+    std::size_t   workers     = 4;
+    std::size_t   repeat      = 3;
+    std::uint64_t seed        = 1;
+    std::size_t   enqueue_count = 65536;
+    std::vector<std::size_t> producers = {1, 2, 4, 8};
+};
+
+/// One measured case on one backend.
+struct Result {
+    std::string   backend;
+    std::string   bench_case;
+    std::string   status = "ok"; ///< ok, failed, skipped or unavailable.
+    std::string   reason;
+    std::size_t   requests = 0;
+    std::size_t   request_size = 0;
+    std::size_t   producers = 0; ///< Producer threads (enqueue_mp only).
+    double        seconds = 0.0;
+    std::uint64_t bytes = 0;
+    std::uint64_t failed = 0;
+    int           first_errno = 0;
+    ds::QueueStats stats;
+};
+
+void usage(const char* argv0) {
+    std::cerr
+        << "usage: " << argv0 << " [options]\n"
+        << "  --backends LIST    comma-separated: cpu,mmap,mmap_inline,io_uring,vulkan\n"
+        << "                     (default: all built)\n"
+        << "  --cases LIST       comma-separated case names (default: all)\n"
+        << "  --dir PATH         directory for generated files (default: /dev/shm or /tmp)\n"
+        << "  --output PATH      write JSON here instead of stdout\n"
+        << "  --file-size N      size of the generated file (default 64M)\n"
+        << "  --block-size N     request size for block cases (default 1M)\n"
+        << "  --small-size N     request size for small_read (default 4K)\n"
+        << "  --small-count N    number of small reads (default 16384)\n"
+        << "  --queue-depth N    max requests in flight (default 32)\n"
+        << "  --workers N        backend worker threads (default 4)\n"
+        << "  --repeat N         runs per case; the median run is reported (default 3)\n"
+        << "  --seed N           seed for random offsets (default 1)\n"
+        << "  --enqueue-count N  requests per enqueue_mp run (default 64K)\n"
+        << "  --producers LIST   comma-separated producer thread counts for\n"
+        << "                     enqueue_mp (default 1,2,4,8)\n"
+        << "Sizes accept K, M and G suffixes.\n";
+}
+
+std::vector<std::string> split_list(const std::string& s) {
+    std::vector<std::string> out;
+    std::stringstream in(s);
+    std::string item;
+    while (std::getline(in, item, ',')) {
+        if (!item.empty()) {
+            out.push_back(item);
+        }
+    }
+    return out;
+}
+
+template <typename List>
+bool known(const List& list, const std::string& name) {
+    return std::find(std::begin(list), std::end(list), name) != std::end(list);
+}
+
+bool parse_options(int argc, char** argv, Options& opt) {
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "--help" || arg == "-h") {
+            usage(argv[0]);
+            std::exit(0);
+        }
+        if (i + 1 >= argc) {
+            std::cerr << "missing value for " << arg << "\n";
+            return false;
+        }
+        const char* value = argv[++i];
+        std::size_t number = 0;
+        if (arg == "--backends") {
+            opt.backends = split_list(value);
+        } else if (arg == "--cases") {
+            opt.cases = split_list(value);
+        } else if (arg == "--dir") {
+            opt.dir = value;
+        } else if (arg == "--output") {
+            opt.output = value;
+        } else if (arg == "--producers") {
+            opt.producers.clear();
+            for (const auto& item : split_list(value)) {
+                if (!parse_size(item.c_str(), number) || number == 0) {
+                    std::cerr << "invalid producer count " << item << "\n";
+                    return false;
+                }
+                opt.producers.push_back(number);
+            }
+        } else if (parse_size(value, number)) {
+            if (arg == "--file-size") {
+                opt.file_size = number;
+            } else if (arg == "--block-size") {
+                opt.block_size = number;
+            } else if (arg == "--small-size") {
+                opt.small_size = number;
+            } else if (arg == "--small-count") {
+                opt.small_count = number;
+            } else if (arg == "--queue-depth") {
+                opt.queue_depth = number;
+            } else if (arg == "--workers") {
+                opt.workers = number;
+            } else if (arg == "--repeat") {
+                opt.repeat = number;
+            } else if (arg == "--seed") {
+                opt.seed = number;
+            } else if (arg == "--enqueue-count") {
+                opt.enqueue_count = number;
+            } else {
+                std::cerr << "unknown option " << arg << "\n";
+                return false;
+            }
+        } else {
+            std::cerr << "invalid value for " << arg << ": " << value << "\n";
+            return false;
+        }
+    }
+
+    if (opt.backends.empty()) {
+        for (const char* name : kAllBackends) {
+            if (backend_built(name)) {
+                opt.backends.push_back(name);
+            }
+        }
+    }
+    if (opt.cases.empty()) {
+        opt.cases.assign(std::begin(kAllCases), std::end(kAllCases));
+    }
+    for (const auto& name : opt.backends) {
+        if (!known(kAllBackends, name)) {
+            std::cerr << "unknown backend " << name << "\n";
+            return false;
+        }
+    }
+    for (const auto& name : opt.cases) {
+        if (!known(kAllCases, name)) {
+            std::cerr << "unknown case " << name << "\n";
+            return false;
+        }
+    }
+    if (opt.dir.empty()) {
+        opt.dir = ::access("/dev/shm", W_OK) == 0 ? "/dev/shm" : "/tmp";
+    }
+    if (opt.block_size == 0 || opt.small_size == 0 ||
+        opt.file_size < opt.block_size || opt.file_size < opt.small_size) {
+        std::cerr << "file size must be at least the block and small sizes, "
+                     "and both must be non-zero\n";
+        return false;
+    }
+    opt.queue_depth = std::max<std::size_t>(opt.queue_depth, 1);
+    opt.workers = std::max<std::size_t>(opt.workers, 1);
+    opt.repeat = std::max<std::size_t>(opt.repeat, 1);
+    opt.enqueue_count = std::max<std::size_t>(opt.enqueue_count, 1);
+    if (opt.producers.empty()) {
+        std::cerr << "--producers needs at least one count\n";
+        return false;
+    }
+    return true;
+}
+
+/// The io_uring backend moves bytes only; it has no decode stage to measure.
+/// decode_gdeflate brings its own decoder and runs everywhere.
+bool backend_decodes(const std::string& backend, const std::string& bench_case) {
+    return backend != "io_uring" || bench_case == "decode_gdeflate";
+}
+
+/// Stored-block codec: decoded bytes are the compressed bytes.
+int stored_decoder(const void* src, std::size_t src_size, void* dst, std::size_t dst_size) {
+    if (src_size != dst_size) {
+        return EINVAL;
+    }
+    std::memcpy(dst, src, src_size);
+    return 0;
+}
+
+/// Encode @p decoded as a GDeflate stream of stored kGDeflateBlock blocks.
+std::vector<char> encode_stored(const char* decoded, std::size_t size) {
+    namespace gd = ds::gdeflate;
+    const std::size_t blocks = (size + kGDeflateBlock - 1) / kGDeflateBlock;
+    gd::FileHeader header{};
+    header.magic = gd::GDEFLATE_MAGIC;
+    header.version_major = gd::GDEFLATE_VERSION_MAJOR;
+    header.version_minor = gd::GDEFLATE_VERSION_MINOR;
+    header.uncompressed_size = static_cast<std::uint32_t>(size);
+    header.compressed_size = static_cast<std::uint32_t>(size);
+    header.block_count = static_cast<std::uint32_t>(blocks);
+
+    const std::size_t table_end = sizeof(header) + blocks * sizeof(gd::BlockInfo);
+    std::vector<char> stream(table_end + size);
+    std::memcpy(stream.data(), &header, sizeof(header));
+    for (std::size_t b = 0; b < blocks; ++b) {
+        gd::BlockInfo block{};
+        block.offset = b * kGDeflateBlock;
+        block.compressed_size = static_cast<std::uint32_t>(
+            std::min(kGDeflateBlock, size - b * kGDeflateBlock));
+        block.uncompressed_size = block.compressed_size;
+        std::memcpy(stream.data() + sizeof(header) + b * sizeof(block), &block, sizeof(block));
+    }
+    std::memcpy(stream.data() + table_end, decoded, size);
+    return stream;
+}
+
+/// Fill @p path with file_size / block_size streams, each decoding to
+/// block_size bytes of lowercase ASCII. Stream i starts at i * @p stride.
+bool generate_gdeflate_file(const std::string& path, const Options& opt, std::size_t& stride) {
+    std::vector<char> decoded(opt.block_size);
+    for (std::size_t i = 0; i < decoded.size(); ++i) {
+        decoded[i] = static_cast<char>('a' + i % 26);
+    }
+    const std::vector<char> stream = encode_stored(decoded.data(), decoded.size());
+    stride = (stream.size() + 4095) / 4096 * 4096;
+
+    const int fd = ::open(path.c_str(), O_CREAT | O_WRONLY | O_TRUNC, 0644);
+    if (fd < 0) {
+        return false;
+    }
+    bool ok = true;
+    const std::size_t count = opt.file_size / opt.block_size;
+    for (std::size_t i = 0; i < count && ok; ++i) {
+        const ssize_t n = ::pwrite(fd, stream.data(), stream.size(),
+                                   static_cast<off_t>(i * stride));
+        ok = n == static_cast<ssize_t>(stream.size());
+    }
+    ::close(fd);
+    return ok;
+}
+
+/// The decode_gdeflate input: stream file and stride.
+struct GDeflateFile {
+    int         fd = -1;
+    std::size_t stride = 0;
+};
+
+/// Build the request list for one case. Requests point into @p buffer,
+/// one distinct region per request, so in-flight requests never overlap.
+std::vector<ds::Request> plan_case(const std::string& bench_case,
+                                   const Options& opt,
+                                   int read_fd,
+                                   int write_fd,
+                                   const GDeflateFile& gdeflate,
+                                   std::vector<char>& buffer) {
+    const bool small = bench_case == "small_read";
+    const std::size_t size = small ? opt.small_size : opt.block_size;
+    const std::size_t slots = opt.file_size / size;
+    const std::size_t count = small ? opt.small_count : slots;
+
+    std::vector<std::uint64_t> offsets(count);
+    if (bench_case == "seq_read" || bench_case == "prefetched_read" || bench_case == "write" ||
+        bench_case.rfind("decode_", 0) == 0) {
+        for (std::size_t i = 0; i < count; ++i) {
+            offsets[i] = i * size;
+        }
+    } else {
+        std::mt19937_64 rng(opt.seed);
+        if (small) {
+            std::uniform_int_distribution<std::size_t> pick(0, slots - 1);
+            for (auto& off : offsets) {
+                off = pick(rng) * size;
+            }
+        } else {
+            for (std::size_t i = 0; i < count; ++i) {
+                offsets[i] = i * size;
+            }
+            std::shuffle(offsets.begin(), offsets.end(), rng);
+        }
+    }
+
+    if (buffer.size() < count * size) {
+        buffer.resize(count * size, 'x');
+    }
+
+    std::vector<ds::Request> requests(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        ds::Request& req = requests[i];
+        req.offset = offsets[i];
+        req.size = size;
+        req.user_tag = i;
+        if (bench_case == "write") {
+            req.op = ds::RequestOp::Write;
+            req.fd = write_fd;
+            req.src = buffer.data() + i * size;
+        } else if (bench_case == "view_read") {
+            req.fd = read_fd;
+            req.dst_memory = ds::RequestMemory::Runtime;
+        } else {
+            req.fd = read_fd;
+            req.dst = buffer.data() + i * size;
+        }
+        if (bench_case == "decode_fake_uppercase") {
+            req.compression = ds::Compression::FakeUppercase;
+        } else if (bench_case == "decode_gdeflate") {
+            req.fd = gdeflate.fd;
+            req.offset = i * gdeflate.stride;
+            req.compression = ds::Compression::GDeflate;
+        }
+    }
+    return requests;
+}
+
+/// Run one pass of @p requests through a fresh Queue on @p backend.
+Result run_once(const std::shared_ptr<ds::Backend>& backend,
+                const std::vector<ds::Request>& requests,
+                const Options& opt) {
+    ds::QueueConfig config;
+    config.completion_mode = ds::CompletionMode::Records;
+    config.completion_capacity = std::max<std::size_t>(opt.queue_depth * 2, 1024);
+    config.max_in_flight_requests = opt.queue_depth;
+    ds::Queue queue(backend, config);
+
+    const auto start = std::chrono::steady_clock::now();
+    for (const auto& req : requests) {
+        queue.enqueue(req);
+    }
+    queue.submit_all();
+    queue.wait_all();
+    const auto end = std::chrono::steady_clock::now();
+
+    Result result;
+    result.seconds = std::chrono::duration<double>(end - start).count();
+    result.requests = requests.size();
+    result.request_size = requests.empty() ? 0 : requests.front().size;
+
+    ds::CompletionRecord records[256];
+    std::size_t n = 0;
+    while ((n = queue.poll_completions(records, 256)) != 0) {
+        for (std::size_t i = 0; i < n; ++i) {
+            if (records[i].status != ds::RequestStatus::Ok) {
+                ++result.failed;
+                if (result.first_errno == 0) {
+                    result.first_errno = records[i].errno_value;
+                }
+            }
+        }
+    }
+
+    result.stats = queue.stats();
+    result.bytes = result.stats.bytes_transferred;
+    if (result.failed != 0) {
+        result.status = "failed";
+        result.reason = std::strerror(result.first_errno);
+    }
+    return result;
+}
+
+/// Time @p producers threads enqueueing opt.enqueue_count requests between
+/// them into one Queue. The submission ring is sized to hold them all, so
+/// this measures the lock-free path rather than the overflow list. Nothing
+/// is submitted; the requests are dropped with the Queue.
+Result run_enqueue(const std::shared_ptr<ds::Backend>& backend,
+                   std::size_t producers,
+                   int read_fd,
+                   const Options& opt) {
+    ds::QueueConfig config;
+    config.submission_capacity = opt.enqueue_count;
+    ds::Queue queue(backend, config);
+
+    const std::size_t per_thread = std::max<std::size_t>(opt.enqueue_count / producers, 1);
+    std::atomic<std::size_t> ready{0};
+    std::atomic<bool> go{false};
+    std::vector<std::thread> threads;
+    for (std::size_t t = 0; t < producers; ++t) {
+        threads.emplace_back([&, t] {
+            ds::Request req;
+            req.fd = read_fd;
+            req.size = opt.small_size;
+            ready.fetch_add(1);
+            while (!go.load(std::memory_order_acquire)) {
+                std::this_thread::yield();
+            }
+            for (std::size_t i = 0; i < per_thread; ++i) {
+                req.offset = (t * per_thread + i) * opt.small_size % opt.file_size;
+                queue.enqueue(req);
+            }
+        });
+    }
+    while (ready.load() != producers) {
+        std::this_thread::yield();
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    go.store(true, std::memory_order_release);
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    const auto end = std::chrono::steady_clock::now();
+
+    Result result;
+    result.seconds = std::chrono::duration<double>(end - start).count();
+    result.requests = per_thread * producers;
+    result.request_size = opt.small_size;
+    result.producers = producers;
+    return result;
+}
+
+// ----------------------------------------------------------------------------
+// JSON output
+// ----------------------------------------------------------------------------
+
+void write_result(std::ostream& out, const Result& r) {
+    out << "    {\"backend\":" << json_string(r.backend)
+        << ",\"case\":" << json_string(r.bench_case)
+        << ",\"status\":" << json_string(r.status);
+    if (!r.reason.empty()) {
+        out << ",\"reason\":" << json_string(r.reason);
+    }
+    if (r.status == "skipped" || r.status == "unavailable") {
+        out << "}";
+        return;
+    }
+    if (r.producers != 0) {
+        out << ",\"producers\":" << r.producers
+            << ",\"requests\":" << r.requests
+            << ",\"seconds\":" << r.seconds
+            << ",\"enqueue_ops_per_s\":"
+            << (r.seconds > 0.0 ? static_cast<double>(r.requests) / r.seconds : 0.0) << "}";
+        return;
+    }
+
+    const double mib_per_s = r.seconds > 0.0
+        ? static_cast<double>(r.bytes) / (1024.0 * 1024.0) / r.seconds : 0.0;
+    const double iops = r.seconds > 0.0
+        ? static_cast<double>(r.requests - r.failed) / r.seconds : 0.0;
+    out << ",\"requests\":" << r.requests
+        << ",\"request_size\":" << r.request_size
+        << ",\"failed\":" << r.failed
+        << ",\"bytes\":" << r.bytes
+        << ",\"seconds\":" << r.seconds
+        << ",\"mib_per_s\":" << mib_per_s
+        << ",\"iops\":" << iops
+        << ",\"peak_in_flight\":" << r.stats.peak_in_flight
+        << ",\"submit_to_start\":";
+    write_histogram(out, r.stats.submit_to_start);
+    out << ",\"start_to_complete\":";
+    write_histogram(out, r.stats.start_to_complete);
+    out << ",\"backend_counters\":{";
+    for (std::size_t i = 0; i < r.stats.backend.counters.size(); ++i) {
+        const auto& c = r.stats.backend.counters[i];
+        out << (i ? "," : "") << json_string(c.name) << ":" << c.value;
+    }
+    out << "}}";
+}
+
+void write_report(std::ostream& out, const Options& opt, const std::vector<Result>& results) {
+    out << "{\n  \"schema_version\":" << kSchemaVersion
+        << ",\n  \"config\":{\"dir\":" << json_string(opt.dir)
+        << ",\"file_size\":" << opt.file_size
+        << ",\"block_size\":" << opt.block_size
+        << ",\"small_size\":" << opt.small_size
+        << ",\"small_count\":" << opt.small_count
+        << ",\"queue_depth\":" << opt.queue_depth
+        << ",\"workers\":" << opt.workers
+        << ",\"repeat\":" << opt.repeat
+        << ",\"seed\":" << opt.seed
+        << ",\"enqueue_count\":" << opt.enqueue_count << "},\n  \"results\":[\n";
+    for (std::size_t i = 0; i < results.size(); ++i) {
+        write_result(out, results[i]);
+        out << (i + 1 < results.size() ? ",\n" : "\n");
+    }
+    out << "  ]\n}\n";
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options opt;
+    if (!parse_options(argc, argv, opt)) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    const std::string pid = std::to_string(::getpid());
+    const std::string read_path = opt.dir + "/ds_bench_read_" + pid + ".bin";
+    const std::string write_path = opt.dir + "/ds_bench_write_" + pid + ".bin";
+    if (!bench::generate_file(read_path, opt.file_size)) {
+        std::cerr << "ds_bench: cannot create " << read_path << ": "
+                  << std::strerror(errno) << "\n";
+        return 1;
+    }
+    const int read_fd = ::open(read_path.c_str(), O_RDONLY);
+    const int write_fd = ::open(write_path.c_str(), O_CREAT | O_WRONLY | O_TRUNC, 0644);
+    if (read_fd < 0 || write_fd < 0) {
+        std::cerr << "ds_bench: cannot open benchmark files in " << opt.dir << "\n";
+        return 1;
+    }
+    const std::string gdeflate_path = opt.dir + "/ds_bench_gdeflate_" + pid + ".bin";
+    GDeflateFile gdeflate;
+    if (known(opt.cases, "decode_gdeflate")) {
+        if (!generate_gdeflate_file(gdeflate_path, opt, gdeflate.stride) ||
+            (gdeflate.fd = ::open(gdeflate_path.c_str(), O_RDONLY)) < 0) {
+            std::cerr << "ds_bench: cannot create " << gdeflate_path << ": "
+                      << std::strerror(errno) << "\n";
+            return 1;
+        }
+    }
+
+    // Errors are summarised per case in the JSON; keep stderr quiet, but
+    // note any error raised while a backend is being constructed.
+    static std::atomic<bool> backend_init_error{false};
+    ds::set_error_callback([](const ds::ErrorContext&) { backend_init_error = true; });
+
+    std::vector<Result> results;
+    std::vector<char> buffer;
+    for (const auto& backend_name : opt.backends) {
+        backend_init_error = false;
+        std::shared_ptr<ds::Backend> backend =
+            backend_built(backend_name) ? bench::make_backend(backend_name, opt.workers, opt.queue_depth) : nullptr;
+        const bool available = backend && !backend_init_error;
+
+        for (const auto& bench_case : opt.cases) {
+            Result result;
+            if (!available) {
+                result.status = "unavailable";
+                result.reason = backend ? "backend initialization failed"
+                                        : "backend not built";
+            } else if (bench_case.rfind("decode_", 0) == 0 &&
+                       !backend_decodes(backend_name, bench_case)) {
+                result.status = "skipped";
+                result.reason = "backend has no decode stage";
+            } else if (bench_case == "enqueue_mp") {
+                if (backend_name != opt.backends.front()) {
+                    continue; // Backend-independent: measured once.
+                }
+                for (std::size_t producers : opt.producers) {
+                    std::vector<Result> runs;
+                    for (std::size_t i = 0; i < opt.repeat; ++i) {
+                        runs.push_back(run_enqueue(backend, producers, read_fd, opt));
+                    }
+                    std::sort(runs.begin(), runs.end(), [](const Result& a, const Result& b) {
+                        return a.seconds < b.seconds;
+                    });
+                    Result run = runs[runs.size() / 2];
+                    run.backend = backend_name;
+                    run.bench_case = bench_case;
+                    std::cerr << "[ds_bench] " << backend_name << " " << bench_case
+                              << " producers=" << producers << ": " << run.status << "\n";
+                    results.push_back(std::move(run));
+                }
+                continue;
+            } else {
+                const auto requests =
+                    plan_case(bench_case, opt, read_fd, write_fd, gdeflate, buffer);
+                std::shared_ptr<ds::Backend> target = backend;
+                if (bench_case == "cached_read") {
+                    // Size the cache (and its few shards) to hold the whole
+                    // file with room for uneven hashing, then warm it so
+                    // the measured runs are all hits.
+                    ds::CacheConfig cache_config;
+                    cache_config.shard_count = 4;
+                    cache_config.capacity_bytes = opt.file_size * 4;
+                    target = ds::make_caching_backend(backend, cache_config);
+                    run_once(target, requests, opt);
+                } else if (bench_case == "prefetched_read") {
+                    target = ds::make_prefetching_backend(backend);
+                } else if (bench_case == "decode_gdeflate") {
+                    ds::StreamDecodeConfig decode_config;
+                    decode_config.decoder = stored_decoder;
+                    decode_config.decode_workers = opt.workers;
+                    target = ds::make_streaming_decode_backend(backend, decode_config);
+                }
+                std::vector<Result> runs;
+                for (std::size_t i = 0; i < opt.repeat; ++i) {
+                    runs.push_back(run_once(target, requests, opt));
+                }
+                std::sort(runs.begin(), runs.end(), [](const Result& a, const Result& b) {
+                    return a.seconds < b.seconds;
+                });
+                result = runs[runs.size() / 2];
+            }
+            result.backend = backend_name;
+            result.bench_case = bench_case;
+            std::cerr << "[ds_bench] " << backend_name << " " << bench_case
+                      << ": " << result.status << "\n";
+            results.push_back(std::move(result));
+        }
+    }
+    ds::set_error_callback(nullptr);
+
+    ::close(read_fd);
+    ::close(write_fd);
+    ::unlink(read_path.c_str());
+    ::unlink(write_path.c_str());
+    if (gdeflate.fd >= 0) {
+        ::close(gdeflate.fd);
+        ::unlink(gdeflate_path.c_str());
+    }
+
+    if (opt.output.empty()) {
+        write_report(std::cout, opt, results);
+    } else {
+        std::ofstream file(opt.output, std::ios::out | std::ios::trunc);
+        write_report(file, opt, results);
+        if (!file) {
+            std::cerr << "ds_bench: cannot write " << opt.output << "\n";
+            return 1;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,409 @@
+// SPDX-License-Identifier: Apache-2.0
+// Trace replay for ds-runtime.
+//
+// Re-issues a workload recorded with ds::RequestCapture against a chosen
+// backend and reports latency distributions as JSON.
+//
+//  - A synthetic file set is generated in --dir, one file per captured file,
+//    sized to the captured extent.
+//  - Requests are issued at their captured times divided by --speed
+//    (1 = original timing, 10 = ten times faster, 0 = as fast as possible).
+//  - Latency is measured from issue to completion through a CompletionHook,
+//    so it includes queueing inside the runtime. How far issue fell behind
+//    schedule is reported separately as "schedule_lag".
+//
+// At most --max-outstanding requests are outstanding at once, each with its
+// own buffer; when all are busy the replay waits and counts a stall.
+
+#include "bench_common.hpp"
+#include "ds_runtime_capture.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace {
+
+struct Options {
+    std::string trace;
+    std::string backend = "cpu";
+    std::string dir;
+    std::string output;
+    double      speed = 1.0;
+    std::size_t workers = 4;
+    std::size_t queue_depth = 0;
+    std::size_t max_outstanding = 1024;
+};
+
+void usage(const char* argv0) {
+    std::cerr
+        << "usage: " << argv0 << " --trace PATH [options]\n"
+        << "  --trace PATH           capture written by ds::write_capture()\n"
+        << "  --backend NAME         cpu, mmap, mmap_inline, io_uring or vulkan\n"
+        << "                         (default cpu)\n"
+        << "  --speed X              timing multiplier; 0 issues as fast as possible (default 1)\n"
+        << "  --workers N            backend worker threads (default 4)\n"
+        << "  --queue-depth N        QueueConfig::max_in_flight_requests, 0 = unlimited (default 0)\n"
+        << "  --max-outstanding N    issued but uncompleted requests (default 1024)\n"
+        << "  --dir PATH             directory for the synthetic files (default: /dev/shm or /tmp)\n"
+        << "  --output PATH          write JSON here instead of stdout\n";
+}
+
+bool parse_options(int argc, char** argv, Options& opt) {
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "--help" || arg == "-h") {
+            usage(argv[0]);
+            std::exit(0);
+        }
+        if (i + 1 >= argc) {
+            std::cerr << "missing value for " << arg << "\n";
+            return false;
+        }
+        const char* value = argv[++i];
+        std::size_t number = 0;
+        if (arg == "--trace") {
+            opt.trace = value;
+        } else if (arg == "--backend") {
+            opt.backend = value;
+        } else if (arg == "--dir") {
+            opt.dir = value;
+        } else if (arg == "--output") {
+            opt.output = value;
+        } else if (arg == "--speed") {
+            char* end = nullptr;
+            opt.speed = std::strtod(value, &end);
+            if (end == value || *end != '\0' || !(opt.speed >= 0.0)) {
+                std::cerr << "invalid speed " << value << "\n";
+                return false;
+            }
+        } else if (bench::parse_size(value, number)) {
+            if (arg == "--workers") {
+                opt.workers = number;
+            } else if (arg == "--queue-depth") {
+                opt.queue_depth = number;
+            } else if (arg == "--max-outstanding") {
+                opt.max_outstanding = number;
+            } else {
+                std::cerr << "unknown option " << arg << "\n";
+                return false;
+            }
+        } else {
+            std::cerr << "invalid value for " << arg << ": " << value << "\n";
+            return false;
+        }
+    }
+    if (opt.trace.empty()) {
+        std::cerr << "--trace is required\n";
+        return false;
+    }
+    if (opt.dir.empty()) {
+        opt.dir = ::access("/dev/shm", W_OK) == 0 ? "/dev/shm" : "/tmp";
+    }
+    opt.workers = std::max<std::size_t>(opt.workers, 1);
+    opt.max_outstanding = std::max<std::size_t>(opt.max_outstanding, 1);
+    return true;
+}
+
+/// Size classes used to split the latency report.
+constexpr std::size_t kSizeClassCount = 4;
+const char* const kSizeClassNames[kSizeClassCount] = {"le_4k", "le_64k", "le_1m", "gt_1m"};
+
+std::size_t size_class(std::size_t size) {
+    if (size <= (4u << 10)) {
+        return 0;
+    }
+    if (size <= (64u << 10)) {
+        return 1;
+    }
+    return size <= (1u << 20) ? 2 : 3;
+}
+
+/// Latency results, updated from backend worker threads.
+struct Report {
+    std::mutex            mtx;
+    ds::LatencyHistogram  all;
+    ds::LatencyHistogram  by_op[2];
+    ds::LatencyHistogram  by_size[kSizeClassCount];
+    ds::LatencyHistogram  schedule_lag;
+    std::uint64_t         failed = 0;
+    std::uint64_t         bytes = 0;
+    std::uint64_t         stalls = 0;
+};
+
+class Replayer;
+
+/// An outstanding request: its buffer and issue time. Completion returns
+/// the slot to the free list.
+struct Slot final : ds::CompletionHook {
+    Replayer*         owner = nullptr;
+    std::size_t       index = 0;
+    std::uint64_t     issue_ns = 0;
+    std::vector<char> buffer;
+
+    void on_request_complete(ds::Request& req) override;
+};
+
+class Replayer {
+public:
+    Replayer(const Options& opt, const ds::CaptureTrace& trace, std::vector<int> fds)
+        : opt_(opt), trace_(trace), fds_(std::move(fds)), slots_(opt.max_outstanding)
+    {
+        for (std::size_t i = 0; i < slots_.size(); ++i) {
+            slots_[i].owner = this;
+            slots_[i].index = i;
+            free_.push_back(slots_.size() - 1 - i);
+        }
+    }
+
+    /// Issue every captured request on schedule, then wait for completion.
+    ds::QueueStats run(const std::shared_ptr<ds::Backend>& backend, double& seconds) {
+        ds::QueueConfig config;
+        config.max_in_flight_requests = opt_.queue_depth;
+        ds::Queue queue(backend, config);
+
+        const auto& requests = trace_.requests;
+        const std::uint64_t start_ns = now_ns();
+        for (std::size_t i = 0; i < requests.size(); ++i) {
+            const ds::CapturedRequest& cap = requests[i];
+            const std::uint64_t due_ns = opt_.speed > 0.0
+                ? start_ns + static_cast<std::uint64_t>(static_cast<double>(cap.time_ns) / opt_.speed)
+                : start_ns;
+            const std::uint64_t before_ns = now_ns();
+            if (before_ns < due_ns) {
+                std::this_thread::sleep_for(std::chrono::nanoseconds(due_ns - before_ns));
+            }
+
+            Slot& slot = acquire_slot(queue);
+            if (slot.buffer.size() < cap.size) {
+                slot.buffer.resize(cap.size, 'r');
+            }
+
+            ds::Request req;
+            req.fd = fds_[cap.file_id];
+            req.offset = cap.offset;
+            req.size = cap.size;
+            req.op = cap.op;
+            req.compression = cap.compression;
+            if (cap.op == ds::RequestOp::Write) {
+                req.src = slot.buffer.data();
+            } else {
+                req.dst = slot.buffer.data();
+            }
+
+            slot.issue_ns = now_ns();
+            {
+                std::lock_guard<std::mutex> lock(report_.mtx);
+                report_.schedule_lag.record(slot.issue_ns > due_ns ? slot.issue_ns - due_ns : 0);
+            }
+            queue.enqueue(req, &slot);
+
+            // Hand the batch to the backend once nothing else is due yet.
+            const bool last = i + 1 == requests.size();
+            if (last || opt_.speed == 0.0 ||
+                start_ns + static_cast<std::uint64_t>(
+                    static_cast<double>(requests[i + 1].time_ns) / opt_.speed) > now_ns()) {
+                queue.try_submit_all();
+            }
+        }
+        queue.submit_all();
+        queue.wait_all();
+        seconds = static_cast<double>(now_ns() - start_ns) / 1e9;
+        return queue.stats();
+    }
+
+    void complete(Slot& slot, const ds::Request& req) {
+        const std::uint64_t latency = now_ns() - slot.issue_ns;
+        {
+            std::lock_guard<std::mutex> lock(report_.mtx);
+            report_.all.record(latency);
+            report_.by_op[static_cast<std::size_t>(req.op)].record(latency);
+            report_.by_size[size_class(req.size)].record(latency);
+            report_.bytes += req.bytes_transferred;
+            if (req.status != ds::RequestStatus::Ok) {
+                ++report_.failed;
+            }
+        }
+        {
+            std::lock_guard<std::mutex> lock(free_mtx_);
+            free_.push_back(slot.index);
+        }
+        free_cv_.notify_one();
+    }
+
+    Report& report() { return report_; }
+
+private:
+    static std::uint64_t now_ns() {
+        return static_cast<std::uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count());
+    }
+
+    Slot& acquire_slot(ds::Queue& queue) {
+        std::unique_lock<std::mutex> lock(free_mtx_);
+        if (free_.empty()) {
+            // Everything issued must reach the backend before we can block.
+            lock.unlock();
+            queue.try_submit_all();
+            lock.lock();
+            {
+                std::lock_guard<std::mutex> report_lock(report_.mtx);
+                ++report_.stalls;
+            }
+            free_cv_.wait(lock, [this] { return !free_.empty(); });
+        }
+        const std::size_t index = free_.back();
+        free_.pop_back();
+        return slots_[index];
+    }
+
+    const Options&            opt_;
+    const ds::CaptureTrace&   trace_;
+    std::vector<int>          fds_;
+    std::vector<Slot>         slots_;
+    std::mutex                free_mtx_;
+    std::condition_variable   free_cv_;
+    std::vector<std::size_t>  free_;
+    Report                    report_;
+};
+
+void Slot::on_request_complete(ds::Request& req) {
+    owner->complete(*this, req);
+}
+
+void write_report(std::ostream& out, const Options& opt, const ds::CaptureTrace& trace,
+                  Report& r, const ds::QueueStats& stats, double seconds) {
+    using bench::json_string;
+    using bench::write_histogram;
+
+    std::uint64_t captured_ns = trace.requests.empty() ? 0 : trace.requests.back().time_ns;
+    std::uint64_t reads = 0;
+    for (const auto& req : trace.requests) {
+        reads += req.op == ds::RequestOp::Read;
+    }
+
+    out << "{\n  \"config\":{\"trace\":" << json_string(opt.trace)
+        << ",\"backend\":" << json_string(opt.backend)
+        << ",\"speed\":" << opt.speed
+        << ",\"workers\":" << opt.workers
+        << ",\"queue_depth\":" << opt.queue_depth
+        << ",\"max_outstanding\":" << opt.max_outstanding
+        << ",\"dir\":" << json_string(opt.dir) << "},\n"
+        << "  \"trace\":{\"files\":" << trace.files.size()
+        << ",\"requests\":" << trace.requests.size()
+        << ",\"reads\":" << reads
+        << ",\"writes\":" << trace.requests.size() - reads
+        << ",\"duration_ns\":" << captured_ns << "},\n"
+        << "  \"result\":{\"seconds\":" << seconds
+        << ",\"failed\":" << r.failed
+        << ",\"bytes\":" << r.bytes
+        << ",\"iops\":" << (seconds > 0.0 ? static_cast<double>(trace.requests.size()) / seconds : 0.0)
+        << ",\"mib_per_s\":"
+        << (seconds > 0.0 ? static_cast<double>(r.bytes) / (1024.0 * 1024.0) / seconds : 0.0)
+        << ",\"slot_stalls\":" << r.stalls
+        << ",\"peak_in_flight\":" << stats.peak_in_flight << "},\n"
+        << "  \"latency\":";
+    write_histogram(out, r.all);
+    out << ",\n  \"latency_by_op\":{\"read\":";
+    write_histogram(out, r.by_op[static_cast<std::size_t>(ds::RequestOp::Read)]);
+    out << ",\"write\":";
+    write_histogram(out, r.by_op[static_cast<std::size_t>(ds::RequestOp::Write)]);
+    out << "},\n  \"latency_by_size\":{";
+    for (std::size_t i = 0; i < kSizeClassCount; ++i) {
+        out << (i ? "," : "") << json_string(kSizeClassNames[i]) << ":";
+        write_histogram(out, r.by_size[i]);
+    }
+    out << "},\n  \"schedule_lag\":";
+    write_histogram(out, r.schedule_lag);
+    out << ",\n  \"submit_to_start\":";
+    write_histogram(out, stats.submit_to_start);
+    out << ",\n  \"start_to_complete\":";
+    write_histogram(out, stats.start_to_complete);
+    out << "\n}\n";
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options opt;
+    if (!parse_options(argc, argv, opt)) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    ds::CaptureTrace trace;
+    if (!ds::read_capture(opt.trace, trace)) {
+        std::cerr << "ds_replay: cannot read capture " << opt.trace << "\n";
+        return 1;
+    }
+    std::stable_sort(trace.requests.begin(), trace.requests.end(),
+                     [](const ds::CapturedRequest& a, const ds::CapturedRequest& b) {
+                         return a.time_ns < b.time_ns;
+                     });
+
+    if (!bench::backend_built(opt.backend)) {
+        std::cerr << "ds_replay: backend " << opt.backend << " is not built\n";
+        return 1;
+    }
+
+    // Synthetic file set: one file per captured file, sized to its extent.
+    const std::string prefix = opt.dir + "/ds_replay_" + std::to_string(::getpid()) + "_";
+    std::vector<std::string> paths;
+    std::vector<int> fds;
+    bool files_ok = true;
+    for (std::size_t i = 0; i < trace.files.size() && files_ok; ++i) {
+        paths.push_back(prefix + std::to_string(i) + ".bin");
+        files_ok = bench::generate_file(paths.back(), trace.files[i].extent);
+        const int fd = files_ok ? ::open(paths.back().c_str(), O_RDWR) : -1;
+        files_ok = fd >= 0;
+        fds.push_back(fd);
+    }
+
+    int rc = 0;
+    if (!files_ok) {
+        std::cerr << "ds_replay: cannot create files in " << opt.dir << ": "
+                  << std::strerror(errno) << "\n";
+        rc = 1;
+    } else {
+        // Failures show up in the report; keep stderr quiet.
+        ds::set_error_callback([](const ds::ErrorContext&) {});
+        auto backend = bench::make_backend(opt.backend, opt.workers,
+                                           std::max<std::size_t>(opt.queue_depth, 1));
+        Replayer replayer(opt, trace, fds);
+        double seconds = 0.0;
+        const ds::QueueStats stats = replayer.run(backend, seconds);
+        ds::set_error_callback(nullptr);
+
+        if (opt.output.empty()) {
+            write_report(std::cout, opt, trace, replayer.report(), stats, seconds);
+        } else {
+            std::ofstream file(opt.output, std::ios::out | std::ios::trunc);
+            write_report(file, opt, trace, replayer.report(), stats, seconds);
+            if (!file) {
+                std::cerr << "ds_replay: cannot write " << opt.output << "\n";
+                rc = 1;
+            }
+        }
+    }
+
+    for (std::size_t i = 0; i < paths.size(); ++i) {
+        if (fds[i] >= 0) {
+            ::close(fds[i]);
+        }
+        ::unlink(paths[i].c_str());
+    }
+    return rc;
+}
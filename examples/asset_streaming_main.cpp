@@ -2,21 +2,22 @@
 // Asset streaming demo for ds-runtime.
 //
 // This example demonstrates:
-//  - Writing a "packed" asset file (two payloads back-to-back).
-//  - Submitting concurrent read requests for both payloads.
+//  - Building an asset pack (ds_runtime_archive.hpp) with two payloads.
+//  - Resolving assets by name and submitting concurrent reads for both.
 //  - Using the error reporting callback for verbose diagnostics.
 //  - Performing a basic transformation request (FakeUppercase).
 
 #include "ds_runtime.hpp"
+#include "ds_runtime_archive.hpp"
 
 #include <atomic>
+#include <cerrno>
 #include <cstring>
 #include <fstream>
 #include <iostream>
 #include <string>
 #include <vector>
 
-#include <fcntl.h>
 #include <unistd.h>
 
 namespace {
@@ -40,49 +41,29 @@ int main() {
 
     set_error_callback(verbose_error_logger);
 
-    const char* filename = "streaming_assets.bin";
+    const char* filename = "streaming_assets.dspk";
     const std::string payload_a = "texture:albedo.dds";
     const std::string payload_b = "shader:lighting.hlsl";
 
-    // Build a packed file with two assets (A then B).
+    // Build a pack with two assets. B is stored as-is and uppercased by
+    // the runtime on read (FakeUppercase).
     {
-        const int fd = ::open(filename, O_CREAT | O_WRONLY | O_TRUNC, 0644);
-        if (fd < 0) {
-            report_error("demo",
-                         "open",
-                         "Failed to create asset pack file",
-                         errno,
-                         __FILE__,
-                         __LINE__,
-                         __func__);
-            return 1;
+        ArchiveBuilder builder;
+        ArchiveAsset asset_a;
+        asset_a.name = "textures/albedo.dds";
+        ArchiveAsset asset_b;
+        asset_b.name = "shaders/lighting.hlsl";
+        asset_b.compression = Compression::FakeUppercase;
+        if (!builder.add(asset_a, payload_a.data(), payload_a.size()) ||
+            !builder.add(asset_b, payload_b.data(), payload_b.size()) ||
+            !builder.write(filename)) {
+            return 1; // Already reported through the error callback.
         }
-
-        if (::write(fd, payload_a.data(), payload_a.size()) < 0 ||
-            ::write(fd, payload_b.data(), payload_b.size()) < 0) {
-            report_error("demo",
-                         "write",
-                         "Failed to write asset payloads",
-                         errno,
-                         __FILE__,
-                         __LINE__,
-                         __func__);
-            ::close(fd);
-            return 1;
-        }
-        ::close(fd);
     }
 
-    // Open the file for reading.
-    const int fd = ::open(filename, O_RDONLY);
-    if (fd < 0) {
-        report_error("demo",
-                     "open",
-                     "Failed to open asset pack for reading",
-                     errno,
-                     __FILE__,
-                     __LINE__,
-                     __func__);
+    // Map the pack's table of contents for reading.
+    const auto pack = open_archive(filename);
+    if (!pack) {
         return 1;
     }
 
@@ -93,21 +74,23 @@ int main() {
     auto backend = make_cpu_backend(/*worker_count=*/2);
     Queue queue(backend);
 
-    // Request A: raw read at offset 0.
+    // Resolve both assets by name: fd, offset, size and compression come
+    // from the pack's table of contents.
     Request req_a;
-    req_a.fd = fd;
-    req_a.offset = 0;
-    req_a.size = payload_a.size();
-    req_a.dst = buffer_a.data();
-    req_a.compression = Compression::None;
-
-    // Request B: uppercase transform at offset payload_a.size().
     Request req_b;
-    req_b.fd = fd;
-    req_b.offset = payload_a.size();
-    req_b.size = payload_b.size();
+    if (!pack->make_request("textures/albedo.dds", req_a) ||
+        !pack->make_request("shaders/lighting.hlsl", req_b)) {
+        report_error("demo",
+                     "lookup",
+                     "Asset missing from pack",
+                     ENOENT,
+                     __FILE__,
+                     __LINE__,
+                     __func__);
+        return 1;
+    }
+    req_a.dst = buffer_a.data();
     req_b.dst = buffer_b.data();
-    req_b.compression = Compression::FakeUppercase;
 
     queue.enqueue(req_a);
     queue.enqueue(req_b);
@@ -119,7 +102,7 @@ int main() {
     std::cout << "[asset_streaming] read A: \"" << buffer_a.data() << "\"\n";
     std::cout << "[asset_streaming] read B: \"" << buffer_b.data() << "\"\n";
 
-    ::close(fd);
+    ::unlink(filename);
     set_error_callback(nullptr);
     return 0;
 }
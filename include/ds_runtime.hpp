@@ -4,20 +4,27 @@
 //
 // This header declares:
 //  - ds::Request and related enums
+//  - ds::BufferView (ref-counted, read-only runtime-owned memory)
 //  - ds::Backend (abstract execution backend)
 //  - ds::Queue (front-end request queue)
+//  - Telemetry snapshots (LatencyHistogram, BackendStats, QueueStats)
 //  - make_cpu_backend() factory for the CPU backend
 //
 // The focus is on clear semantics and portability rather than peak throughput.
 
 #pragma once
 
-#include <cstddef>    // std::size_t
+#include <array>      // std::array
+#include <atomic>     // std::atomic
+#include <cstddef>    // std::size_t, std::byte
 #include <cstdint>    // std::uint64_t
-#include <chrono>     // std::chrono::system_clock
+#include <chrono>     // std::chrono::system_clock, std::chrono::nanoseconds
 #include <functional> // std::function
 #include <memory>     // std::shared_ptr, std::unique_ptr
+#include <span>       // std::span
 #include <string>     // std::string
+#include <utility>    // std::exchange, std::swap
+#include <vector>     // std::vector
 
 namespace ds {
 
@@ -32,7 +39,7 @@ namespace ds {
 enum class Compression {
     None,          ///< No compression; data is read as-is.
     FakeUppercase, ///< Demo mode: uppercase ASCII bytes after reading.
-    GDeflate       ///< Placeholder for GDeflate support (not yet implemented).
+    GDeflate       ///< Block stream (gdeflate_format.h); needs CpuBackendConfig::gdeflate_decoder, else ENOTSUP.
 };
 
 /// Status of a Request after execution by a Backend.
@@ -40,7 +47,8 @@ enum class RequestStatus {
     Pending,   ///< Not yet submitted or still in flight.
     Ok,        ///< Completed successfully.
     IoError,   ///< I/O error; errno_value is set.
-    Cancelled  ///< Request was cancelled before completion.
+    Cancelled, ///< Request was cancelled before completion.
+    Corrupt    ///< Data failed an integrity check; errno_value is EBADMSG.
 };
 
 /// Operation type for a Request.
@@ -51,8 +59,119 @@ enum class RequestOp {
 
 /// Memory location for request buffers.
 enum class RequestMemory {
-    Host, ///< Buffer resides in host memory.
-    Gpu   ///< Buffer resides in a GPU buffer (Vulkan backend).
+    Host,   ///< Buffer resides in host memory.
+    Gpu,    ///< Buffer resides in a GPU buffer (Vulkan backend).
+    Runtime ///< Reads only: the runtime supplies the destination and hands
+            ///< the data back as Request::buffer (dst is ignored).
+};
+
+// -----------------------------------------------------------------------------
+// Runtime-owned buffers
+// -----------------------------------------------------------------------------
+
+class BufferView;
+
+/// Memory shared by one or more BufferViews.
+///
+/// Carries an intrusive reference count so that copying a view is a single
+/// atomic increment. Owners derive from it to lend memory they already hold
+/// (pool blocks, mapped file pages) without copying it.
+class BufferStorage {
+public:
+    BufferStorage(const BufferStorage&) = delete;
+    BufferStorage& operator=(const BufferStorage&) = delete;
+
+protected:
+    BufferStorage() = default;
+    ~BufferStorage() = default;
+
+    /// Called once, on the thread that drops the last view. Typically
+    /// returns the memory to its pool or deletes this.
+    virtual void recycle() noexcept = 0;
+
+private:
+    friend class BufferView;
+    std::atomic<std::size_t> refs_{0};
+};
+
+/// Ref-counted, read-only view of runtime-owned memory.
+///
+/// Produced by RequestMemory::Runtime reads (see Request::buffer) and by
+/// BufferPool. Copies share the memory; it is recycled when the last view
+/// is destroyed or reset(). Views are safe to pass between threads, but a
+/// single view object must not be modified concurrently.
+class BufferView {
+public:
+    BufferView() noexcept = default;
+
+    /// View [data, data + size) and take a reference on @p storage.
+    BufferView(BufferStorage* storage, const void* data, std::size_t size) noexcept
+        : storage_(storage)
+        , data_(static_cast<const std::byte*>(data))
+        , size_(size) {
+        if (storage_ != nullptr) {
+            storage_->refs_.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    BufferView(const BufferView& other) noexcept
+        : BufferView(other.storage_, other.data_, other.size_) {}
+
+    BufferView(BufferView&& other) noexcept
+        : storage_(std::exchange(other.storage_, nullptr))
+        , data_(std::exchange(other.data_, nullptr))
+        , size_(std::exchange(other.size_, 0)) {}
+
+    BufferView& operator=(BufferView other) noexcept {
+        swap(other);
+        return *this;
+    }
+
+    ~BufferView() { reset(); }
+
+    const std::byte* data() const noexcept { return data_; }
+    std::size_t size() const noexcept { return size_; }
+    bool empty() const noexcept { return size_ == 0; }
+    std::span<const std::byte> bytes() const noexcept { return {data_, size_}; }
+
+    /// True if the view holds a reference (it may still be empty, e.g. a
+    /// read that hit EOF).
+    explicit operator bool() const noexcept { return storage_ != nullptr; }
+
+    /// View of @p length bytes starting at @p offset, clamped to this view,
+    /// sharing the same memory.
+    BufferView subview(std::size_t offset, std::size_t length = ~std::size_t{0}) const noexcept {
+        offset = offset < size_ ? offset : size_;
+        length = length < size_ - offset ? length : size_ - offset;
+        return BufferView(storage_, data_ + offset, length);
+    }
+
+    /// Number of views sharing this memory (0 for an empty view).
+    std::size_t use_count() const noexcept {
+        return storage_ != nullptr ? storage_->refs_.load(std::memory_order_relaxed) : 0;
+    }
+
+    /// Drop this view's reference.
+    void reset() noexcept {
+        BufferStorage* storage = std::exchange(storage_, nullptr);
+        data_ = nullptr;
+        size_ = 0;
+        if (storage != nullptr &&
+            storage->refs_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            storage->recycle();
+        }
+    }
+
+    void swap(BufferView& other) noexcept {
+        std::swap(storage_, other.storage_);
+        std::swap(data_, other.data_);
+        std::swap(size_, other.size_);
+    }
+
+private:
+    BufferStorage*   storage_ = nullptr;
+    const std::byte* data_ = nullptr;
+    std::size_t      size_ = 0;
 };
 
 // -----------------------------------------------------------------------------
@@ -66,6 +185,11 @@ enum class RequestMemory {
 /// object itself is passed by value into the backend; the caller retains
 /// ownership of the underlying buffers (dst/src) and must keep them alive until
 /// completion.
+///
+/// With dst_memory set to RequestMemory::Runtime a read needs no dst: the
+/// runtime allocates the destination and completes the request with a
+/// read-only view of it in buffer, which may alias memory the backend
+/// already holds (e.g. mmap pages) instead of a copy.
 struct Request {
     int           fd          = -1;      ///< POSIX file descriptor.
     std::uint64_t offset      = 0;       ///< Byte offset within the file.
@@ -82,6 +206,90 @@ struct Request {
     RequestStatus status      = RequestStatus::Pending;  ///< Result status.
     int           errno_value = 0;        ///< errno value on IoError, 0 otherwise.
     std::size_t   bytes_transferred = 0;  ///< Number of bytes actually transferred.
+    std::uint64_t user_tag    = 0;        ///< Opaque caller value echoed in CompletionRecord.
+
+    /// Steady-clock nanoseconds when the Queue handed the request to the
+    /// backend (0 if it never reached one). Set by the runtime.
+    std::uint64_t submit_time_ns = 0;
+    /// Steady-clock nanoseconds when the backend began executing it, or 0
+    /// if the backend does not report start times. Set by the backend.
+    std::uint64_t start_time_ns  = 0;
+
+    /// Result of a RequestMemory::Runtime read: bytes_transferred bytes of
+    /// runtime-owned memory. Empty for other requests and failed reads.
+    BufferView    buffer;
+};
+
+/// Compact completion entry surfaced by Queue::poll_completions().
+///
+/// Records are fixed-size and carry only the result of a Request plus the
+/// caller's user_tag, so the completion path never copies a full Request.
+struct CompletionRecord {
+    std::uint64_t user_tag          = 0;                      ///< Request::user_tag of the completed request.
+    RequestStatus status            = RequestStatus::Pending; ///< Final status.
+    int           errno_value       = 0;                      ///< errno value on IoError, 0 otherwise.
+    std::size_t   bytes_transferred = 0;                      ///< Number of bytes actually transferred.
+    BufferView    buffer;                                     ///< Request::buffer of a Runtime read.
+};
+
+// -----------------------------------------------------------------------------
+// Telemetry
+// -----------------------------------------------------------------------------
+
+/// Latency distribution with HDR-style log-linear buckets.
+///
+/// Each power-of-two range is split into kSubBuckets linear buckets, so a
+/// sample is reported within 12.5% of its true value anywhere from 1 ns up
+/// to about 18 minutes (larger samples land in the last bucket).
+struct LatencyHistogram {
+    static constexpr std::size_t kSubBucketBits = 3;
+    static constexpr std::size_t kSubBuckets = std::size_t{1} << kSubBucketBits;
+    static constexpr std::size_t kMaxMagnitude = 40; ///< Highest exact bit: 2^40 ns.
+    static constexpr std::size_t kBucketCount =
+        (kMaxMagnitude - kSubBucketBits + 2) * kSubBuckets;
+
+    std::array<std::uint64_t, kBucketCount> counts{}; ///< Samples per bucket.
+    std::uint64_t count  = 0; ///< Total samples.
+    std::uint64_t sum_ns = 0; ///< Sum of all samples.
+    std::uint64_t max_ns = 0; ///< Largest sample.
+
+    /// Bucket that a sample of @p ns falls into.
+    static std::size_t bucket_index(std::uint64_t ns) noexcept;
+
+    /// Largest value (inclusive) that maps to bucket @p index.
+    static std::uint64_t bucket_upper_ns(std::size_t index) noexcept;
+
+    /// Value at percentile @p p (0-100), as the upper bound of its bucket
+    /// clamped to max_ns. Returns 0 for an empty histogram.
+    std::uint64_t percentile_ns(double p) const noexcept;
+
+    /// Mean sample, or 0 for an empty histogram.
+    double mean_ns() const noexcept;
+
+    /// Add one sample of @p ns.
+    void record(std::uint64_t ns) noexcept;
+
+    /// Add every sample of @p other into this histogram.
+    void merge(const LatencyHistogram& other) noexcept;
+};
+
+/// Named backend-specific counter (e.g. "sq_full", "staging_stalls").
+struct BackendCounter {
+    std::string   name;
+    std::uint64_t value = 0;
+};
+
+/// Snapshot of a backend's own counters, returned by Backend::stats().
+struct BackendStats {
+    std::string   backend;               ///< Backend name ("cpu", "io_uring", ...).
+    std::uint64_t submitted = 0;         ///< Requests accepted by submit().
+    std::uint64_t completed = 0;         ///< Completion callbacks invoked.
+    std::uint64_t failed = 0;            ///< Completions with a non-Ok status.
+    std::uint64_t bytes_transferred = 0; ///< Sum of bytes_transferred.
+    std::vector<BackendCounter> counters; ///< Backend-specific extras.
+
+    /// Value of the counter called @p name, or 0 if absent.
+    std::uint64_t counter(const std::string& name) const noexcept;
 };
 
 // -----------------------------------------------------------------------------
@@ -110,6 +318,18 @@ public:
     ///
     /// The completion callback is invoked on a backend-owned worker thread.
     virtual void submit(Request req, CompletionCallback on_complete) = 0;
+
+    /// Snapshot of this backend's counters.
+    ///
+    /// Safe to call concurrently with submit(). Backends that keep no
+    /// statistics return an empty snapshot.
+    virtual BackendStats stats() const { return {}; }
+
+    /// True if the backend fills Request::buffer itself for
+    /// RequestMemory::Runtime reads, e.g. with views of memory it already
+    /// holds. Otherwise the Queue allocates the buffer from its BufferPool
+    /// and points Request::dst at it before submit().
+    virtual bool provides_buffers() const noexcept { return false; }
 };
 
 // -----------------------------------------------------------------------------
@@ -164,6 +384,164 @@ void report_request_error(const std::string& subsystem,
 // Queue
 // -----------------------------------------------------------------------------
 
+/// How a Queue surfaces completed requests.
+enum class CompletionMode {
+    Retain,  ///< Copy each completed Request; retrieve with take_completed().
+    Records  ///< Push a CompletionRecord; retrieve with poll_completions()/wait_completions().
+};
+
+class Queue;
+class RequestCapture;
+class BufferPool;
+
+/// Identifier of a node in a Queue's dependency graph: a request enqueued
+/// with Queue::enqueue_tracked() or a continuation registered with
+/// Queue::then(). Ids are unique per queue and never reused; zero is never
+/// a valid id.
+using RequestId = std::uint64_t;
+
+/// Continuation run by the runtime once all of its predecessors completed.
+///
+/// Runs on a backend worker thread (or inline in Queue::then() if the
+/// predecessors had already completed). @p predecessors_ok is false if any
+/// predecessor failed or was cancelled. The continuation may enqueue
+/// follow-up work on @p queue, including further tracked requests and
+/// continuations; anything it enqueues is submitted automatically when it
+/// returns. It must not block on the queue (e.g. call wait_all()).
+using Continuation = std::function<void(Queue& queue, bool predecessors_ok)>;
+
+/// Intrusive, allocation-free completion target for a single request.
+///
+/// Used by adapters such as the coroutine awaitables in ds_runtime_coro.hpp.
+/// The hook object is owned by the caller and must stay alive until
+/// on_request_complete() has been called.
+class CompletionHook {
+public:
+    /// Called exactly once, on a backend worker thread, when the request
+    /// completes. The hook may destroy itself (e.g. by resuming a
+    /// coroutine) but must not block on the queue.
+    virtual void on_request_complete(Request& request) = 0;
+
+protected:
+    ~CompletionHook() = default;
+};
+
+/// What Queue::submit_all() does when the in-flight caps are reached.
+///
+/// In both modes, requests that do not fit are held back inside the Queue
+/// and handed to the backend from completion context as capacity frees up,
+/// so backend-side buffering stays bounded regardless of burst size.
+enum class BackpressureMode {
+    Block,   ///< submit_all() returns only once every request reached the backend.
+    Callback ///< submit_all() never blocks; the backpressure callback fires when
+             ///< held-back requests have drained.
+};
+
+/// Callback fired when requests that were held back by the in-flight caps
+/// have all been submitted.
+///
+/// Requests that fit under the caps when submitted never fire it. It runs
+/// on the thread whose pump drained the last held-back request: usually a
+/// backend worker completing a request, or a submit_all() caller.
+using BackpressureCallback = std::function<void()>;
+
+/// Tuning knobs for a Queue.
+///
+/// The defaults are suitable for most callers; the single-argument Queue
+/// constructor uses them.
+struct QueueConfig {
+    /// Slots in the lock-free submission ring shared by enqueue() callers.
+    /// Rounded up to a power of two. When the ring is full, enqueue() falls
+    /// back to a mutex-protected overflow list instead of failing.
+    std::size_t submission_capacity = 1024;
+
+    /// Slots in the lock-free completion channel filled by backend workers
+    /// and drained by take_completed() or poll_completions(). Overflows the
+    /// same way.
+    std::size_t completion_capacity = 1024;
+
+    /// Completion delivery model. Retain keeps the original take_completed()
+    /// behaviour; Records is the cheaper CQ-style model for high-rate I/O.
+    CompletionMode completion_mode = CompletionMode::Retain;
+
+    /// Maximum number of requests handed to the backend at once.
+    /// Zero means unlimited.
+    std::size_t max_in_flight_requests = 0;
+
+    /// Maximum sum of Request::size over requests handed to the backend.
+    /// Zero means unlimited. A single request larger than the cap is still
+    /// admitted once nothing else is in flight.
+    std::size_t max_in_flight_bytes = 0;
+
+    /// Behaviour of submit_all() when a cap is reached.
+    BackpressureMode backpressure_mode = BackpressureMode::Block;
+
+    /// When set, every request the queue accepts is recorded here for
+    /// offline replay (see ds_runtime_capture.hpp). Null disables capture.
+    std::shared_ptr<RequestCapture> capture;
+
+    /// Pool that RequestMemory::Runtime reads are allocated from when the
+    /// backend does not provide buffers itself (see ds_runtime_buffer.hpp).
+    /// Null uses default_buffer_pool().
+    std::shared_ptr<BufferPool> buffer_pool;
+
+    /// Single-flight identical reads. A host or Runtime read of the same
+    /// file (by device and inode), offset, size and compression as one
+    /// already at the backend is not submitted again; it completes when
+    /// that read does, with the bytes copied into its dst or, for Runtime
+    /// reads, sharing the same buffer. Costs one fstat() per read.
+    bool deduplicate_reads = false;
+
+    /// Failed or cancelled tracked ids remembered after they complete, so
+    /// that enqueue_tracked()/then() calls naming them later are cancelled
+    /// too. Older failures are forgotten first; a predecessor that failed
+    /// more than this many failures ago counts as satisfied. Zero keeps
+    /// none.
+    std::size_t failed_id_window = 4096;
+};
+
+/// Point-in-time telemetry for a Queue, returned by Queue::stats().
+///
+/// Counters are cumulative since the queue was created; take two snapshots
+/// and use throughput_between() for rates over an interval.
+struct QueueStats {
+    std::chrono::nanoseconds elapsed{0}; ///< Time since the queue was created.
+
+    std::size_t pending = 0;         ///< Enqueued but not yet drained by submit (approximate).
+    std::size_t held_back = 0;       ///< Drained but held back by in-flight caps.
+    std::size_t in_flight = 0;       ///< At the backend right now.
+    std::size_t in_flight_bytes = 0; ///< Sum of Request::size at the backend.
+    std::size_t peak_in_flight = 0;  ///< Highest in_flight seen.
+
+    std::uint64_t submitted = 0;         ///< Requests handed to the backend.
+    std::uint64_t deduplicated = 0;      ///< Reads completed from an identical read in flight instead.
+    std::uint64_t completed = 0;         ///< Requests finished, in any status.
+    std::uint64_t failed = 0;            ///< Completions with a non-Ok status.
+    std::uint64_t bytes_transferred = 0; ///< Sum of bytes_transferred.
+    std::size_t   remembered_failures = 0; ///< Failed tracked ids kept (QueueConfig::failed_id_window).
+
+    std::array<std::uint64_t, 2> completed_by_op{};          ///< Indexed by RequestOp.
+    std::array<std::uint64_t, 3> completed_by_compression{}; ///< Indexed by Compression.
+
+    /// Time from hand-off to the backend until it started executing.
+    /// Only recorded for backends that report Request::start_time_ns.
+    LatencyHistogram submit_to_start;
+    /// Time from execution start (or hand-off, if the backend reports no
+    /// start time) until the completion reached the queue.
+    LatencyHistogram start_to_complete;
+
+    BackendStats backend; ///< The queue's backend, via Backend::stats().
+};
+
+/// Rates derived from two QueueStats snapshots.
+struct Throughput {
+    double requests_per_second = 0.0;
+    double bytes_per_second    = 0.0;
+};
+
+/// Completion and byte rates between @p earlier and @p later.
+Throughput throughput_between(const QueueStats& earlier, const QueueStats& later);
+
 /// Front-end request queue.
 ///
 /// A Queue collects Requests, batches them, and hands them off to a Backend
@@ -179,6 +557,9 @@ public:
     /// The Queue takes shared ownership of @p backend.
     explicit Queue(std::shared_ptr<Backend> backend);
 
+    /// Construct a queue with explicit tuning parameters.
+    Queue(std::shared_ptr<Backend> backend, const QueueConfig& config);
+
     /// Destroy the queue.
     ///
     /// Semantics: this destructor does *not* implicitly call wait_all().
@@ -191,17 +572,100 @@ public:
     /// The Request object is moved into internal storage. The caller may
     /// reuse or destroy their original Request instance after this call,
     /// but must keep any referenced buffers (dst) alive until completion.
+    ///
+    /// Safe to call from many threads at once; the common path is a single
+    /// CAS on a lock-free ring.
     void enqueue(Request req);
 
+    /// Enqueue a request that takes part in dependency tracking.
+    ///
+    /// The request is held back until every id in @p after has completed,
+    /// then submitted automatically without a round trip through the
+    /// caller. If any predecessor failed or was cancelled, whether before
+    /// or after this call, the request is not executed and completes with
+    /// RequestStatus::Cancelled (errno ECANCELED). Failures that completed
+    /// before this call are remembered up to QueueConfig::failed_id_window.
+    ///
+    /// If every predecessor has already completed successfully, the request
+    /// behaves like enqueue() and is submitted by the next submit_all().
+    /// Returns an id usable in later enqueue_tracked()/then() calls.
+    RequestId enqueue_tracked(Request req, const std::vector<RequestId>& after = {});
+
+    /// Enqueue a request whose completion is delivered to @p hook.
+    ///
+    /// The request is counted in stats and in_flight() like any other, but
+    /// its result goes only to the hook: it does not appear in
+    /// take_completed() or poll_completions(). No allocation is made on
+    /// the queue side for the hook.
+    void enqueue(Request req, CompletionHook* hook);
+
+    /// Run @p fn once every id in @p after has completed.
+    ///
+    /// Typical use is header-then-body loading: the continuation inspects
+    /// the header that a predecessor read and enqueues the body read, all
+    /// without returning to the application thread. Requests that are held
+    /// in the graph, and continuations that have not run yet, count as in
+    /// flight for wait_all().
+    ///
+    /// If all predecessors have already completed, @p fn runs inline before
+    /// then() returns, and what it enqueued is submitted before then()
+    /// returns too. Returns an id that other nodes can depend on; it
+    /// completes when @p fn returns.
+    RequestId then(const std::vector<RequestId>& after, Continuation fn);
+
+    /// Block until the tracked request or continuation @p id has completed.
+    ///
+    /// Unlike wait_all(), this ignores unrelated work such as background
+    /// prefetches. @p id must have been returned by this queue, and the
+    /// request must have been (or later be) submitted, or this never
+    /// returns. Completion here means the result is already visible via
+    /// take_completed()/poll_completions().
+    void wait(RequestId id);
+
+    /// Like wait(), but gives up after @p timeout. Returns true if @p id
+    /// completed. A timeout too large to represent as a deadline, such as
+    /// nanoseconds::max(), waits like wait().
+    bool wait_for(RequestId id, std::chrono::nanoseconds timeout);
+
+    /// Block until any of @p ids has completed and return its index in
+    /// @p ids. Returns ids.size() if @p ids is empty.
+    std::size_t wait_any(const std::vector<RequestId>& ids);
+
+    /// Like wait_any(), but gives up after @p timeout and returns
+    /// ids.size() if nothing completed in time. Oversized timeouts wait
+    /// indefinitely, as in wait_for().
+    std::size_t wait_any_for(const std::vector<RequestId>& ids,
+                             std::chrono::nanoseconds timeout);
+
+    /// Non-blocking check: true if @p id has completed.
+    bool is_complete(RequestId id) const;
+
     /// Submit all currently pending requests to the backend.
     ///
-    /// Requests enqueued so far are moved into a local batch and submitted
-    /// to the backend without holding the internal mutex, to avoid blocking
-    /// concurrent enqueue() calls or backend internals.
+    /// Requests enqueued so far are drained from the submission ring and
+    /// submitted to the backend without holding any internal lock, to avoid
+    /// blocking concurrent enqueue() calls or backend internals.
+    ///
+    /// When QueueConfig sets in-flight caps, only requests that fit are
+    /// submitted immediately. The rest are held back and submitted as
+    /// completions free capacity; in BackpressureMode::Block this call waits
+    /// until that has happened.
     void submit_all();
 
+    /// Submit whatever fits under the in-flight caps without blocking.
+    ///
+    /// Returns the number of requests still held back. Held-back requests
+    /// are submitted automatically as capacity frees up.
+    std::size_t try_submit_all();
+
+    /// Install a callback fired when held-back requests have drained to the
+    /// backend. Pass nullptr to clear. Useful with BackpressureMode::Callback
+    /// to resume producers without polling.
+    void set_backpressure_callback(BackpressureCallback callback);
+
     /// Block until all in-flight requests have completed.
     ///
+    /// Requests held back by the in-flight caps count as in flight here.
     /// This does not prevent new submissions from racing in from other
     /// threads; it only guarantees that at the moment of return, there
     /// are no requests currently in flight.
@@ -213,12 +677,42 @@ public:
     /// other threads may be submitting or completing work concurrently.
     std::size_t in_flight() const;
 
+    /// Return the sum of Request::size over requests currently in flight.
+    std::size_t in_flight_bytes() const;
+
+    /// Return the number of requests held back by the in-flight caps.
+    std::size_t held_back() const;
+
+    /// Snapshot queue depth, counters, latency histograms and backend stats.
+    ///
+    /// Never takes the submission lock; counters are kept per thread and
+    /// summed here, so the snapshot is approximate under concurrent load.
+    QueueStats stats() const;
+
     /// Retrieve and clear the list of completed requests.
     ///
     /// This returns a snapshot of completed requests accumulated since the
     /// last call. The caller can inspect status, bytes_transferred, etc.
+    ///
+    /// Only populated in CompletionMode::Retain; returns an empty list in
+    /// CompletionMode::Records.
     std::vector<Request> take_completed();
 
+    /// Copy up to @p max completion records into @p out without blocking.
+    ///
+    /// Returns the number of records written. Records are only produced in
+    /// CompletionMode::Records; in Retain mode this always returns 0.
+    std::size_t poll_completions(CompletionRecord* out, std::size_t max);
+
+    /// Block until at least @p min_count records are available (or nothing
+    /// is left in flight), then copy up to @p max of them into @p out.
+    ///
+    /// Returns the number of records written, which can be smaller than
+    /// @p min_count if the queue ran dry.
+    std::size_t wait_completions(CompletionRecord* out,
+                                 std::size_t max,
+                                 std::size_t min_count = 1);
+
 private:
     /// Internal implementation type.
     ///
@@ -230,6 +724,43 @@ private:
     std::unique_ptr<Impl> impl_;
 };
 
+// -----------------------------------------------------------------------------
+// Worker placement
+// -----------------------------------------------------------------------------
+
+/// One NUMA node and the CPUs this process may run on there.
+struct NumaNodeInfo {
+    int id = 0;            ///< Kernel node id (not necessarily dense).
+    std::vector<int> cpus; ///< Online CPUs in the process affinity mask, ascending.
+};
+
+/// Nodes that have at least one usable CPU, discovered from
+/// /sys/devices/system/node and the process affinity mask at first call.
+/// Machines and containers without NUMA information report a single
+/// node 0 holding every usable CPU. Never empty.
+const std::vector<NumaNodeInfo>& numa_topology();
+
+/// How a backend lays its worker threads out over NUMA nodes.
+///
+/// The default leaves placement to the scheduler, as before. Setting
+/// either workers_per_node or pin_workers gives every node its own worker
+/// group and job queue, with workers pinned to that node's CPUs.
+struct WorkerPlacement {
+    /// Workers started on every node. Non-zero overrides the backend's
+    /// worker_count and pins the workers.
+    std::size_t workers_per_node = 0;
+
+    /// Spread worker_count workers round-robin over the nodes and pin
+    /// each to its node's CPUs.
+    bool pin_workers = false;
+
+    /// With per-node groups, send each request to the group nearest its
+    /// data: the node of the caller's buffer when it has one, otherwise
+    /// the node of the file's block device. Requests with no known node,
+    /// or all requests when false, are spread round-robin.
+    bool route_by_locality = true;
+};
+
 // -----------------------------------------------------------------------------
 // Backend factories
 // -----------------------------------------------------------------------------
@@ -245,4 +776,46 @@ private:
 /// Compression::FakeUppercase is requested.
 std::shared_ptr<Backend> make_cpu_backend(std::size_t worker_count = 1);
 
+/// Decodes one independently compressed block of a Compression::GDeflate
+/// stream: @p src holds the block's @p src_size compressed bytes, and
+/// exactly @p dst_size decoded bytes must be written to @p dst. Returns 0
+/// or an errno value. Called from several workers at once.
+using BlockDecoder = std::function<int(const void* src, std::size_t src_size,
+                                       void* dst, std::size_t dst_size)>;
+
+/// Configuration for the CPU backend.
+struct CpuBackendConfig {
+    /// Worker threads. Zero is clamped up to 1.
+    std::size_t worker_count = 1;
+
+    /// Pool for RequestMemory::Runtime reads. Blocks are allocated by the
+    /// worker that services the read, so with a NUMA-aware pool they land
+    /// on that worker's node. Null uses default_buffer_pool().
+    std::shared_ptr<BufferPool> buffer_pool;
+
+    /// NUMA placement of the workers and routing of requests to them.
+    WorkerPlacement placement;
+
+    /// GDeflate block codec. When set, a GDeflate read first reads the
+    /// stream header and block table, then splits the blocks into groups
+    /// decoded on all workers at once, each straight into its place in
+    /// dst; the request completes when the last group does. Null keeps
+    /// GDeflate reads failing with ENOTSUP.
+    BlockDecoder gdeflate_decoder;
+
+    /// Least decoded bytes per block group, so small streams are not
+    /// spread over more workers than they can keep busy.
+    std::size_t decode_split_bytes = std::size_t{1} << 20;
+
+    /// Check each decoded block of a stream flagged
+    /// gdeflate::FLAG_BLOCK_CRC32C against its BlockInfo::checksum, on the
+    /// worker that decoded it. A mismatch, or a decoder returning EBADMSG,
+    /// completes the read as RequestStatus::Corrupt with EBADMSG; counted
+    /// as `verified_blocks` and `checksum_failures` in stats().
+    bool verify_block_checksums = true;
+};
+
+/// Create a CPU backend from an explicit configuration.
+std::shared_ptr<Backend> make_cpu_backend(const CpuBackendConfig& config);
+
 } // namespace ds
@@ -0,0 +1,303 @@
+// SPDX-License-Identifier: Apache-2.0
+//
+// ds-runtime asset archives
+//
+// This header declares:
+//  - ds::archive, the on-disk layout of a pack file (header, table of
+//    contents, fanout table, names) and the asset id hash
+//  - ds::ArchiveBuilder, which writes pack files (see tools/ds_pack.cpp)
+//  - ds::Archive / open_archive(), which map a pack's index and resolve
+//    asset names to Requests
+//
+// A pack file is laid out as
+//
+//     Header | TocEntry[entry_count] | fanout | names | [perfect hash] | data
+//
+// The index (everything before data_offset) is memory-mapped as is and
+// never parsed, so opening a pack costs the same for ten entries or ten
+// million. TOC entries are sorted by asset id, a 64-bit hash of the asset
+// name; the fanout table holds, for each value of the id's top
+// fanout_bits bits, the index of the first entry with that prefix, which
+// narrows a lookup to about one entry. Packs may also carry a minimal
+// perfect hash of the ids (flag kFlagPerfectHash), which maps every asset
+// id to its own slot with a few bit probes and no search; readers prefer
+// it when present. Asset data is aligned per entry so
+// it can be read with O_DIRECT or mapped, and GDeflate entries store an
+// unmodified gdeflate_format.h stream (file header, block table, blocks).
+//
+// All integers are little-endian.
+
+#pragma once
+
+#include "ds_runtime.hpp"
+
+#include <cstddef>     // std::size_t
+#include <cstdint>     // std::uint32_t, std::uint64_t
+#include <memory>      // std::shared_ptr
+#include <string>      // std::string
+#include <string_view> // std::string_view
+#include <vector>      // std::vector
+
+namespace ds {
+namespace archive {
+
+/// "DSPK" read as a little-endian integer.
+constexpr std::uint32_t kMagic = 0x4b505344u;
+
+/// Readers accept any minor version of their major version. Minor 1 adds
+/// the optional perfect hash section.
+constexpr std::uint16_t kVersionMajor = 1;
+constexpr std::uint16_t kVersionMinor = 1;
+
+/// Header::flags bit: a perfect hash section is present.
+constexpr std::uint32_t kFlagPerfectHash = 1u << 0;
+
+/// Default alignment of asset data in a pack.
+constexpr std::uint32_t kDefaultAlignment = 4096;
+
+/// Largest fanout table: 2^24 + 1 entries (64 MiB).
+constexpr std::uint32_t kMaxFanoutBits = 24;
+
+/// Most levels a perfect hash may have.
+constexpr std::uint32_t kMaxPerfectHashLevels = 64;
+
+/// Fixed-size header at offset 0.
+struct Header {
+    std::uint32_t magic;          ///< kMagic.
+    std::uint16_t version_major;  ///< kVersionMajor.
+    std::uint16_t version_minor;  ///< kVersionMinor of the writer.
+    std::uint32_t header_size;    ///< sizeof(Header) of the writer.
+    std::uint32_t flags;          ///< kFlag* bits.
+    std::uint64_t entry_count;    ///< TocEntry records at toc_offset.
+    std::uint64_t toc_offset;     ///< TocEntry[entry_count], sorted by id.
+    std::uint64_t fanout_offset;  ///< uint32_t[2^fanout_bits + 1].
+    std::uint64_t names_offset;   ///< Asset names, not NUL-terminated.
+    std::uint64_t names_size;     ///< Bytes of names.
+    std::uint64_t data_offset;    ///< End of the index; first byte of asset data.
+    std::uint64_t file_size;      ///< Size of the whole pack.
+    std::uint32_t fanout_bits;    ///< Id prefix bits indexed by the fanout table.
+    std::uint32_t alignment;      ///< Default data alignment used by the writer.
+    std::uint32_t index_checksum; ///< crc32c() of bytes [header_size, data_offset).
+    std::uint32_t reserved0;
+    std::uint64_t mphf_offset;    ///< Perfect hash section, if kFlagPerfectHash.
+    std::uint64_t mphf_size;      ///< Bytes of the perfect hash section.
+};
+static_assert(sizeof(Header) == 104, "archive::Header layout is part of the format");
+
+/// One asset in the table of contents.
+struct TocEntry {
+    std::uint64_t id;                ///< hash_id() of the name.
+    std::uint64_t offset;            ///< Absolute offset of the stored bytes.
+    std::uint64_t size;              ///< Stored bytes.
+    std::uint64_t uncompressed_size; ///< Bytes after decoding (== size when stored raw).
+    std::uint32_t name_offset;       ///< Offset of the name in the names section.
+    std::uint32_t name_size;         ///< Length of the name.
+    std::uint32_t checksum;          ///< crc32c() of the stored bytes.
+    std::uint8_t  compression;       ///< ds::Compression of the stored bytes.
+    std::uint8_t  flags;             ///< Reserved, 0.
+    std::uint16_t reserved;
+};
+static_assert(sizeof(TocEntry) == 48, "archive::TocEntry layout is part of the format");
+
+/// Start of the perfect hash section, which is laid out as
+///
+///     PerfectHashHeader | PerfectHashLevel[level_count]
+///       | uint64_t bits[word_count] | uint32_t ranks[word_count / 8 + 1]
+///       | uint32_t slots[key_count]
+///
+/// Each level is a bitset over the ids that collided on every earlier
+/// level; an id owns bit perfect_hash_position() of the first level where
+/// that bit is set. Its slot is the number of set bits before that one in
+/// the concatenated bitsets (ranks[i] counts those before word 8 * i), and
+/// slots[slot] is its index in the TOC.
+struct PerfectHashHeader {
+    std::uint64_t key_count;   ///< == Header::entry_count.
+    std::uint64_t word_count;  ///< 64-bit words in all level bitsets.
+    std::uint32_t level_count; ///< At most kMaxPerfectHashLevels.
+    std::uint32_t seed;        ///< Mixed into every level's hash.
+};
+static_assert(sizeof(PerfectHashHeader) == 24, "archive::PerfectHashHeader layout is part of the format");
+
+/// One level of the perfect hash.
+struct PerfectHashLevel {
+    std::uint64_t word_offset; ///< First bitset word of the level.
+    std::uint64_t bit_count;   ///< Bits in the level, a non-zero multiple of 64.
+};
+static_assert(sizeof(PerfectHashLevel) == 16, "archive::PerfectHashLevel layout is part of the format");
+
+/// Bit of asset id @p id within a perfect hash level of @p bit_count
+/// (non-zero) bits.
+constexpr std::uint64_t perfect_hash_position(std::uint64_t id, std::uint32_t seed,
+                                              std::uint32_t level,
+                                              std::uint64_t bit_count) noexcept {
+    std::uint64_t h = id ^ (0x9e3779b97f4a7c15ull * (std::uint64_t{seed} << 32 | level));
+    h ^= h >> 30;
+    h *= 0xbf58476d1ce4e5b9ull;
+    h ^= h >> 27;
+    h *= 0x94d049bb133111ebull;
+    h ^= h >> 31;
+    return h % bit_count;
+}
+
+/// Asset id of @p name: 64-bit FNV-1a followed by a splitmix64 finalizer,
+/// so the top bits used by the fanout table are well mixed.
+constexpr std::uint64_t hash_id(std::string_view name) noexcept {
+    std::uint64_t h = 0xcbf29ce484222325ull;
+    for (const char c : name) {
+        h ^= static_cast<unsigned char>(c);
+        h *= 0x100000001b3ull;
+    }
+    h ^= h >> 30;
+    h *= 0xbf58476d1ce4e5b9ull;
+    h ^= h >> 27;
+    h *= 0x94d049bb133111ebull;
+    h ^= h >> 31;
+    return h;
+}
+
+} // namespace archive
+
+/// Tuning knobs for an ArchiveBuilder.
+struct ArchiveBuildConfig {
+    /// Alignment of each asset's data; a power of two, 1 packs assets
+    /// back to back.
+    std::uint32_t alignment = archive::kDefaultAlignment;
+
+    /// Store a minimal perfect hash of the asset ids (about 3.5 bits plus
+    /// a 32-bit slot per asset) for search-free lookups.
+    bool perfect_hash = true;
+};
+
+/// Description of an asset added to an ArchiveBuilder.
+struct ArchiveAsset {
+    std::string   name;                             ///< Lookup key; unique within a pack.
+    Compression   compression = Compression::None;  ///< Encoding of the stored bytes.
+    std::uint64_t uncompressed_size = 0;            ///< Decoded size; 0 means the stored size.
+    std::uint32_t alignment = 0;                    ///< Power of two; 0 uses the builder's.
+};
+
+/// Writes pack files.
+///
+/// Assets are collected with add() and add_file() and written in the order
+/// they were added by write(), which builds the index. File contents are
+/// read at write() time. Errors are reported through report_error() under
+/// the "archive" subsystem.
+class ArchiveBuilder {
+public:
+    explicit ArchiveBuilder(const ArchiveBuildConfig& config = {});
+
+    /// Add @p size bytes at @p data (copied) as @p asset. Returns false on
+    /// an empty name or an invalid alignment.
+    bool add(const ArchiveAsset& asset, const void* data, std::size_t size);
+
+    /// Add the contents of @p path as @p asset. A GDeflate asset must be a
+    /// valid gdeflate_format.h stream; its uncompressed_size defaults to
+    /// the stream header's.
+    bool add_file(const ArchiveAsset& asset, const std::string& path);
+
+    /// Number of assets added so far.
+    std::size_t size() const noexcept { return assets_.size(); }
+
+    /// Write the pack to @p path, through a temporary file renamed into
+    /// place. Returns false if an input cannot be read, the output cannot
+    /// be written, or two assets share a name or an id.
+    bool write(const std::string& path) const;
+
+private:
+    struct Pending {
+        ArchiveAsset      asset;
+        std::string       path;   ///< Source file, or empty for data.
+        std::vector<char> data;   ///< In-memory contents.
+        std::uint64_t     size = 0;
+    };
+
+    bool accept(const ArchiveAsset& asset);
+
+    ArchiveBuildConfig   config_;
+    std::vector<Pending> assets_;
+};
+
+/// A pack file opened for reading.
+///
+/// Only the index is mapped; asset data is read through fd() with ordinary
+/// Requests. Lookups never allocate. The index is bounds-checked as it is
+/// used, so a damaged pack yields failed lookups rather than out-of-range
+/// reads; verify() checks it in full.
+class Archive {
+public:
+    ~Archive();
+
+    Archive(const Archive&) = delete;
+    Archive& operator=(const Archive&) = delete;
+
+    /// Read-only descriptor of the pack, valid for the Archive's lifetime.
+    int fd() const noexcept { return fd_; }
+
+    /// The mapped header.
+    const archive::Header& header() const noexcept { return *header_; }
+
+    /// Number of assets.
+    std::size_t entry_count() const noexcept { return entry_count_; }
+
+    /// The table of contents, sorted by id.
+    const archive::TocEntry* entries() const noexcept { return toc_; }
+
+    /// Entry named @p name, or null.
+    const archive::TocEntry* find(std::string_view name) const noexcept;
+
+    /// Entry with id @p id, or null. Ids of distinct names are unique
+    /// within a pack. Uses the perfect hash when the pack has one.
+    const archive::TocEntry* find_id(std::uint64_t id) const noexcept;
+
+    /// Name of @p entry, or empty if its name lies outside the index.
+    std::string_view name(const archive::TocEntry& entry) const noexcept;
+
+    /// Fill @p out with a read of @p entry: fd, offset, compression, and
+    /// size set to the decoded size. dst and the memory fields are left
+    /// to the caller. Returns false if the entry lies outside the pack.
+    bool make_request(const archive::TocEntry& entry, Request& out) const noexcept;
+
+    /// make_request() for the entry named @p name.
+    bool make_request(std::string_view name, Request& out) const noexcept;
+
+    /// True if lookups go through a perfect hash.
+    bool has_perfect_hash() const noexcept { return hash_levels_ != nullptr; }
+
+    /// Check the index checksum, TOC order, fanout table, perfect hash and
+    /// every entry's bounds. O(entry count); meant for untrusted packs and tools.
+    bool verify() const;
+
+    /// Read the stored bytes of @p entry and compare their checksum.
+    bool verify_entry(const archive::TocEntry& entry) const;
+
+private:
+    friend std::shared_ptr<Archive> open_archive(const std::string& path);
+
+    Archive() = default;
+
+    const archive::TocEntry* find_id_by_hash(std::uint64_t id) const noexcept;
+
+    int                        fd_ = -1;
+    void*                      map_ = nullptr;
+    std::size_t                map_size_ = 0;
+    const archive::Header*     header_ = nullptr;
+    const archive::TocEntry*   toc_ = nullptr;
+    const std::uint32_t*       fanout_ = nullptr;
+    const char*                names_ = nullptr;
+    std::size_t                entry_count_ = 0;
+
+    // Perfect hash section, when present.
+    const archive::PerfectHashLevel* hash_levels_ = nullptr;
+    const std::uint64_t*       hash_bits_ = nullptr;
+    const std::uint32_t*       hash_ranks_ = nullptr;
+    const std::uint32_t*       hash_slots_ = nullptr;
+    std::uint32_t              hash_level_count_ = 0;
+    std::uint32_t              hash_seed_ = 0;
+};
+
+/// Open the pack at @p path and map its index. Returns null (after
+/// report_error()) if the file is not a readable pack of a supported
+/// version.
+std::shared_ptr<Archive> open_archive(const std::string& path);
+
+} // namespace ds
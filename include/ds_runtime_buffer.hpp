@@ -0,0 +1,157 @@
+// SPDX-License-Identifier: Apache-2.0
+//
+// ds-runtime buffer pool
+//
+// This header declares:
+//  - ds::BufferPool, a NUMA-aware, size-classed pool of page-aligned host
+//    blocks that backs RequestMemory::Runtime reads and can hand callers
+//    I/O buffers directly
+//  - ds::PoolBuffer, an exclusive writable block that is frozen into a
+//    read-only BufferView once filled
+//  - default_buffer_pool(), the process-wide pool Queues use by default
+//
+// Blocks return to the pool when the last BufferView referencing them is
+// released, so steady-state streaming reuses the same memory instead of
+// allocating per request. Small blocks are carved from large slabs that
+// can be huge-page backed, locked in memory and bound to a NUMA node.
+
+#pragma once
+
+#include "ds_runtime.hpp"
+
+#include <cstddef> // std::size_t
+#include <cstdint> // std::uint64_t
+#include <memory>  // std::shared_ptr
+
+namespace ds {
+
+/// Tuning knobs for a BufferPool.
+struct BufferPoolConfig {
+    /// Smallest block handed out. Block sizes are powers of two from here
+    /// up to max_pooled_bytes; rounded up to a power of two.
+    std::size_t min_block_bytes = std::size_t{4} << 10;
+
+    /// Largest pooled block. Bigger requests get a dedicated allocation
+    /// that is freed, not cached, when released.
+    std::size_t max_pooled_bytes = std::size_t{16} << 20;
+
+    /// Upper bound on free memory kept in blocks of slab_bytes or more,
+    /// which own their mapping; released blocks beyond it are unmapped.
+    /// Blocks carved from slabs are always kept until trim().
+    std::size_t max_cached_bytes = std::size_t{256} << 20;
+
+    /// Alignment of every block; a power of two, at least alignof(max_align_t).
+    /// Page alignment keeps blocks usable for O_DIRECT-style I/O.
+    std::size_t alignment = 4096;
+
+    /// Blocks smaller than this are carved out of slabs of this size, so
+    /// one mmap() serves many allocations. Larger blocks get their own
+    /// mapping. Rounded up to a power of two.
+    std::size_t slab_bytes = std::size_t{2} << 20;
+
+    /// Keep free lists per NUMA node and place each slab on the node it is
+    /// allocated for: the calling thread's node unless allocate() names
+    /// one. Has no effect on single-node machines.
+    bool numa_aware = true;
+
+    /// Back mappings of at least 2 MiB with transparent huge pages (2 MiB
+    /// aligned, MADV_HUGEPAGE). A partly used slab may then keep a whole
+    /// huge page resident.
+    bool huge_pages = false;
+
+    /// mlock() every mapping so its pages stay resident and pinned, as
+    /// io_uring fixed-buffer registration and RDMA expect. Subject to
+    /// RLIMIT_MEMLOCK; failures are counted in lock_failures, not fatal.
+    bool lock_memory = false;
+};
+
+/// Point-in-time counters for a BufferPool.
+struct BufferPoolStats {
+    std::uint64_t allocations = 0;       ///< Successful allocate() calls.
+    std::uint64_t reused = 0;            ///< Allocations served from a cached block.
+    std::uint64_t oversized = 0;         ///< Allocations above max_pooled_bytes.
+    std::uint64_t failures = 0;          ///< allocate() calls that ran out of memory.
+    std::size_t   outstanding = 0;       ///< Blocks currently held by callers.
+    std::size_t   outstanding_bytes = 0; ///< Capacity of those blocks.
+    std::size_t   cached_bytes = 0;      ///< Free memory kept for reuse.
+    std::size_t   mapped_bytes = 0;      ///< Memory currently mapped by the pool.
+    std::size_t   slabs = 0;             ///< Slabs currently mapped.
+    std::size_t   numa_nodes = 0;        ///< Nodes with their own free lists.
+    std::uint64_t huge_page_regions = 0; ///< Mappings advised MADV_HUGEPAGE.
+    std::uint64_t numa_bound_regions = 0; ///< Mappings bound to a NUMA node.
+    std::uint64_t lock_failures = 0;     ///< Mappings mlock() refused.
+};
+
+/// Exclusive, writable block from a BufferPool.
+///
+/// Fill it through data(), then call share() to turn it into a read-only
+/// BufferView. Destroying it unshared returns the block to the pool.
+class PoolBuffer {
+public:
+    PoolBuffer() noexcept = default;
+
+    void* data() const noexcept { return data_; }
+
+    /// Usable bytes; at least the size passed to allocate().
+    std::size_t capacity() const noexcept { return view_.size(); }
+
+    explicit operator bool() const noexcept { return data_ != nullptr; }
+
+    /// Freeze the first @p size bytes into a read-only view. Leaves this
+    /// object empty.
+    BufferView share(std::size_t size) {
+        BufferView out = view_.subview(0, size);
+        view_.reset();
+        data_ = nullptr;
+        return out;
+    }
+
+private:
+    friend class BufferPool;
+    PoolBuffer(BufferView view, void* data) noexcept
+        : view_(std::move(view)), data_(data) {}
+
+    BufferView view_;
+    void*      data_ = nullptr;
+};
+
+/// Thread-safe, size-classed pool of host memory blocks.
+///
+/// Free lists are kept per NUMA node, size class and thread shard, each
+/// under its own short mutex: a thread reuses blocks it released itself
+/// first and only then looks at other threads' lists on the same node.
+/// Blocks outstanding when the pool is destroyed stay valid; they are
+/// freed when their last view goes away.
+class BufferPool {
+public:
+    /// allocate() node meaning "the node the calling thread runs on".
+    static constexpr int kLocalNode = -1;
+
+    explicit BufferPool(const BufferPoolConfig& config = {});
+    ~BufferPool();
+
+    BufferPool(const BufferPool&) = delete;
+    BufferPool& operator=(const BufferPool&) = delete;
+
+    /// Allocate a block of at least @p size bytes (at least one byte) on
+    /// NUMA node @p node. Call it from the thread that will fill the block
+    /// to get memory local to that thread. Returns an empty PoolBuffer if
+    /// memory is exhausted.
+    PoolBuffer allocate(std::size_t size, int node = kLocalNode) noexcept;
+
+    /// Unmap cached large blocks and every slab whose blocks are all free.
+    void trim() noexcept;
+
+    BufferPoolStats stats() const;
+
+    const BufferPoolConfig& config() const noexcept;
+
+private:
+    struct Impl;
+    std::shared_ptr<Impl> impl_; ///< Shared with outstanding blocks.
+};
+
+/// Process-wide pool used by Queues whose QueueConfig::buffer_pool is null.
+std::shared_ptr<BufferPool> default_buffer_pool();
+
+} // namespace ds
@@ -23,7 +23,8 @@ typedef enum ds_request_status {
     DS_REQUEST_PENDING = 0,
     DS_REQUEST_OK = 1,
     DS_REQUEST_IO_ERROR = 2,
-    DS_REQUEST_CANCELLED = 3
+    DS_REQUEST_CANCELLED = 3,
+    DS_REQUEST_CORRUPT = 4
 } ds_request_status;
 
 typedef enum ds_request_op {
@@ -58,6 +59,19 @@ typedef void (*ds_completion_callback)(ds_request* request, void* user_data);
 ds_backend_t* ds_make_cpu_backend(size_t worker_count);
 void ds_backend_release(ds_backend_t* backend);
 
+/* mmap backend: reads are copied out of a shared mapping of the file.
+ * worker_count 0 runs requests on the submitting thread; files up to
+ * populate_max_bytes are mapped with MAP_POPULATE (0 disables); non-zero
+ * huge_pages requests huge-page aligned mappings. */
+typedef struct ds_mmap_backend_config {
+    size_t worker_count;
+    size_t populate_max_bytes;
+    int    huge_pages;
+} ds_mmap_backend_config;
+
+/* NULL config uses the C++ defaults. */
+ds_backend_t* ds_make_mmap_backend(const ds_mmap_backend_config* config);
+
 ds_queue_t* ds_queue_create(ds_backend_t* backend);
 void ds_queue_release(ds_queue_t* queue);
 
@@ -66,6 +80,42 @@ void ds_queue_submit_all(ds_queue_t* queue, ds_completion_callback callback, voi
 void ds_queue_wait_all(ds_queue_t* queue);
 size_t ds_queue_in_flight(const ds_queue_t* queue);
 
+/* Cumulative counters since the queue was created. Lock-free reads. */
+uint64_t ds_queue_total_completed(const ds_queue_t* queue);
+uint64_t ds_queue_total_failed(const ds_queue_t* queue);
+uint64_t ds_queue_total_bytes_transferred(const ds_queue_t* queue);
+
+#define DS_QUEUE_STATS_VERSION 1u
+
+/* Bulk statistics snapshot filled by ds_queue_get_stats().
+ *
+ * Versioned for ABI stability: callers set struct_size to
+ * sizeof(ds_queue_stats) before the call; the library fills at most that
+ * many bytes and reports its own layout in version. New fields are only
+ * ever appended. Latencies measure submission to completion. */
+typedef struct ds_queue_stats {
+    uint32_t struct_size;             /* In: sizeof(ds_queue_stats). */
+    uint32_t version;                 /* Out: DS_QUEUE_STATS_VERSION. */
+    uint64_t elapsed_ns;              /* Time since ds_queue_create(). */
+    uint64_t pending;                 /* Enqueued, not yet submitted. */
+    uint64_t in_flight;               /* Submitted, not yet completed. */
+    uint64_t in_flight_bytes;         /* Sum of size over in-flight requests. */
+    uint64_t total_submitted;
+    uint64_t total_completed;
+    uint64_t total_failed;
+    uint64_t total_bytes_transferred;
+    uint64_t latency_mean_ns;
+    uint64_t latency_p50_ns;
+    uint64_t latency_p90_ns;
+    uint64_t latency_p99_ns;
+    uint64_t latency_max_ns;
+} ds_queue_stats;
+
+/* Fill *stats without taking the submission lock. Returns 0 on success or
+ * EINVAL if an argument is NULL or struct_size is too small to hold the
+ * version header. */
+int ds_queue_get_stats(const ds_queue_t* queue, ds_queue_stats* stats);
+
 #ifdef DS_RUNTIME_HAS_VULKAN
 typedef struct ds_vulkan_backend_config {
     void*    instance;
@@ -0,0 +1,98 @@
+// SPDX-License-Identifier: Apache-2.0
+//
+// ds-runtime decoded-asset cache
+//
+// This header declares:
+//  - ds::CacheConfig / ds::CacheStats, the tuning knobs and counters
+//  - ds::CachingBackend, a Backend decorator that keeps decoded read
+//    results in memory and answers repeated reads without touching the
+//    wrapped backend
+//  - make_caching_backend(), which wraps any Backend
+//
+// Entries are keyed by file identity (device, inode, modification time),
+// offset, size and compression, so a descriptor number being reused for
+// another file, or a file being rewritten, never serves stale bytes.
+// The index is split into independently locked shards, each evicting
+// with segmented LRU: entries start in a probationary segment and move
+// to a protected one on their second hit, so one pass over a large level
+// cannot flush the assets every frame uses. Concurrent misses on the
+// same key are single-flighted: one backend operation runs and every
+// waiter completes from its result.
+
+#pragma once
+
+#include "ds_runtime.hpp"
+
+#include <cstddef> // std::size_t
+#include <cstdint> // std::uint64_t
+#include <memory>  // std::shared_ptr
+
+namespace ds {
+
+/// Tuning knobs for a CachingBackend.
+struct CacheConfig {
+    /// Memory budget for cached results, in decoded bytes plus a small
+    /// per-entry overhead. Split evenly between shards.
+    std::size_t capacity_bytes = std::size_t{256} << 20;
+
+    /// Independently locked index shards. Zero is clamped up to 1. More
+    /// shards reduce contention but make per-shard eviction coarser.
+    std::size_t shard_count = 16;
+
+    /// Reads larger than this bypass the cache (they are still forwarded,
+    /// just not stored or single-flighted). Zero means capacity / shard
+    /// count, the largest entry a shard can hold.
+    std::size_t max_entry_bytes = 0;
+
+    /// Share of each shard's budget reserved for the protected segment
+    /// (entries hit at least twice), in percent, clamped to [0, 100].
+    unsigned protected_percent = 80;
+
+    /// Where results of misses are decoded when the wrapped backend does
+    /// not provide buffers itself. Null uses default_buffer_pool().
+    std::shared_ptr<BufferPool> buffer_pool;
+};
+
+/// Point-in-time counters for a CachingBackend.
+struct CacheStats {
+    std::uint64_t hits = 0;          ///< Reads answered from the cache.
+    std::uint64_t misses = 0;        ///< Reads forwarded to the wrapped backend.
+    std::uint64_t coalesced = 0;     ///< Reads that joined an identical miss in flight.
+    std::uint64_t bypassed = 0;      ///< Reads not eligible (GPU, oversized, unknown file).
+    std::uint64_t insertions = 0;    ///< Results stored.
+    std::uint64_t evictions = 0;     ///< Entries dropped to stay within budget.
+    std::uint64_t invalidations = 0; ///< Entries dropped by writes, invalidate() or clear().
+    std::uint64_t promotions = 0;    ///< Entries moved to the protected segment.
+    std::size_t   entries = 0;       ///< Entries currently cached.
+    std::size_t   bytes = 0;         ///< Decoded bytes currently cached.
+    std::size_t   protected_bytes = 0; ///< Part of bytes in the protected segment.
+};
+
+/// Backend decorator caching decoded reads.
+///
+/// Reads of host memory or RequestMemory::Runtime are cached; GPU reads
+/// and writes pass through, and a write drops every entry of its file.
+/// Hits complete inside submit(): Runtime reads share the cached memory
+/// (no copy), host reads get a copy in dst. Failed reads are not cached.
+///
+/// provides_buffers() is true, so a Queue in front of the cache leaves
+/// Runtime buffers to it. stats() reports the wrapped backend's counters
+/// (i.e. the I/O that actually ran) plus the cache counters prefixed
+/// with "cache_".
+class CachingBackend : public Backend {
+public:
+    /// Snapshot of hit/miss/eviction counters and current occupancy.
+    virtual CacheStats cache_stats() const = 0;
+
+    /// Drop every entry for the file open as @p fd.
+    virtual void invalidate(int fd) = 0;
+
+    /// Drop every entry.
+    virtual void clear() = 0;
+};
+
+/// Wrap @p inner in a decoded-asset cache.
+std::shared_ptr<CachingBackend> make_caching_backend(std::shared_ptr<Backend> inner,
+                                                     const CacheConfig& config = {});
+
+} // namespace ds
@@ -0,0 +1,113 @@
+// SPDX-License-Identifier: Apache-2.0
+//
+// ds-runtime request capture
+//
+// This header declares:
+//  - ds::RequestCapture, a recorder that a Queue feeds with every request
+//    it accepts (set QueueConfig::capture to enable it)
+//  - ds::CaptureTrace, the recorded workload: files referenced plus one
+//    entry per request (time, file, op, compression, offset, size)
+//  - write_capture() / read_capture() to store traces as text files
+//
+// Captures hold no data and no file descriptors, only the access pattern,
+// so they can be taken in production and replayed offline against a
+// synthetic file set (see bench/ds_replay.cpp).
+
+#pragma once
+
+#include "ds_runtime.hpp"
+
+#include <cstddef>       // std::size_t
+#include <cstdint>       // std::uint32_t, std::uint64_t
+#include <iosfwd>        // std::istream, std::ostream
+#include <mutex>         // std::mutex
+#include <string>        // std::string
+#include <unordered_map> // std::unordered_map
+#include <vector>        // std::vector
+
+namespace ds {
+
+/// A file referenced by a capture.
+struct CapturedFile {
+    std::string   name;       ///< Label from name_file(), or "fd<N>".
+    std::uint64_t extent = 0; ///< Highest offset + size accessed.
+};
+
+/// One request accepted by a capturing Queue.
+struct CapturedRequest {
+    std::uint64_t time_ns     = 0;                 ///< Nanoseconds since the capture started.
+    std::uint32_t file_id     = 0;                 ///< Index into CaptureTrace::files.
+    RequestOp     op          = RequestOp::Read;   ///< Read or write.
+    Compression   compression = Compression::None; ///< Requested decode step.
+    std::uint64_t offset      = 0;                 ///< Byte offset within the file.
+    std::size_t   size        = 0;                 ///< Request size in bytes.
+};
+
+/// A recorded workload, ordered by time.
+struct CaptureTrace {
+    std::vector<CapturedFile>    files;
+    std::vector<CapturedRequest> requests;
+};
+
+/// Thread-safe request recorder.
+///
+/// A Queue records each request when it becomes submittable: at enqueue()
+/// time, or when its predecessors complete for requests enqueued with
+/// enqueue_tracked(). File descriptors are mapped to dense file ids in
+/// order of first use. Recording takes a mutex, so capture is meant for
+/// tracing sessions rather than always-on use.
+class RequestCapture {
+public:
+    /// Start a capture; time_ns values are relative to construction.
+    RequestCapture();
+
+    /// Label @p fd with @p name (typically the file path).
+    ///
+    /// Requests on @p fd recorded afterwards belong to a file with that
+    /// name. Naming an fd again with a different name starts a new file id,
+    /// which handles descriptors that are closed and reused.
+    void name_file(int fd, const std::string& name);
+
+    /// Append @p req to the capture. Called by Queue.
+    ///
+    /// Never throws; if memory runs out the request is counted in
+    /// dropped() instead.
+    void record(const Request& req) noexcept;
+
+    /// Copy of everything recorded so far.
+    CaptureTrace snapshot() const;
+
+    /// Number of requests recorded so far.
+    std::size_t size() const;
+
+    /// Requests that could not be recorded.
+    std::size_t dropped() const;
+
+private:
+    std::uint32_t file_id_locked(int fd);
+
+    mutable std::mutex                       mtx_;
+    std::uint64_t                            start_ns_;
+    std::unordered_map<int, std::uint32_t>   fd_to_file_;
+    CaptureTrace                             trace_;
+    std::size_t                              dropped_ = 0;
+};
+
+/// Write @p trace in the text capture format.
+///
+/// Returns false if the stream went bad.
+bool write_capture(std::ostream& out, const CaptureTrace& trace);
+
+/// Convenience wrapper writing @p trace to @p path.
+bool write_capture(const std::string& path, const CaptureTrace& trace);
+
+/// Parse a trace written by write_capture() into @p out.
+///
+/// Returns false (leaving @p out unspecified) on malformed input or on
+/// requests that reference unknown files.
+bool read_capture(std::istream& in, CaptureTrace& out);
+
+/// Convenience wrapper reading a trace from @p path.
+bool read_capture(const std::string& path, CaptureTrace& out);
+
+} // namespace ds
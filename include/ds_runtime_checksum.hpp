@@ -0,0 +1,29 @@
+// SPDX-License-Identifier: Apache-2.0
+//
+// ds-runtime checksums
+//
+// This header declares crc32c(), the CRC-32C (Castagnoli) checksum used to
+// protect asset archive indexes and entries and to verify decoded GDeflate
+// blocks.
+
+#pragma once
+
+#include <cstddef> // std::size_t
+#include <cstdint> // std::uint32_t
+
+namespace ds {
+
+/// CRC-32C of @p size bytes at @p data.
+///
+/// Pass the result of a previous call as @p crc to continue a checksum
+/// over several buffers; crc32c(b, n2, crc32c(a, n1)) equals the checksum
+/// of a followed by b.
+///
+/// Runs on the CPU's CRC32C instructions (SSE4.2 on x86, the CRC extension
+/// on ARMv8) when present, picked once at first use, else on tables.
+std::uint32_t crc32c(const void* data, std::size_t size, std::uint32_t crc = 0) noexcept;
+
+/// True when crc32c() runs on CRC32C instructions rather than tables.
+bool crc32c_hardware() noexcept;
+
+} // namespace ds
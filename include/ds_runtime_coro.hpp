@@ -0,0 +1,230 @@
+// SPDX-License-Identifier: Apache-2.0
+//
+// ds-runtime C++20 coroutine adapters
+//
+// This header declares:
+//  - ds::coro::Executor and two stock executors (inline and manual)
+//  - Awaitables that submit a Request to a ds::Queue and resume the awaiting
+//    coroutine when the backend completes it
+//  - A batch awaitable that resumes once N requests have completed
+//
+// Awaiting never blocks a thread: the coroutine suspends, the request goes
+// straight to the backend, and the completion callback hands the coroutine
+// back to the chosen executor. Awaitables live in the coroutine frame and
+// register themselves with Queue::enqueue(Request, CompletionHook*), so an
+// await does not allocate.
+//
+// The header deliberately does not define a task type; any coroutine type
+// (an engine's own task, a fire-and-forget task, ...) can co_await these.
+
+#pragma once
+
+#include "ds_runtime.hpp"
+
+#include <atomic>      // std::atomic
+#include <coroutine>   // std::coroutine_handle
+#include <cstddef>     // std::byte, std::size_t
+#include <mutex>       // std::mutex
+#include <span>        // std::span
+#include <vector>      // std::vector
+
+namespace ds::coro {
+
+// -----------------------------------------------------------------------------
+// Executors
+// -----------------------------------------------------------------------------
+
+/// Where a suspended coroutine is resumed once its I/O completes.
+///
+/// post() is called on a backend worker thread. Implementations must not
+/// block there for long; they either resume the handle immediately or hand
+/// it off to another thread.
+class Executor {
+public:
+    virtual ~Executor() = default;
+
+    /// Schedule @p handle to be resumed.
+    virtual void post(std::coroutine_handle<> handle) = 0;
+};
+
+/// Resumes coroutines directly on the backend completion thread.
+///
+/// Lowest latency, but the coroutine body then runs on a backend worker
+/// and must not block on the queue (e.g. call wait_all()).
+class InlineExecutor final : public Executor {
+public:
+    void post(std::coroutine_handle<> handle) override { handle.resume(); }
+};
+
+/// Process-wide InlineExecutor used when no executor is given.
+InlineExecutor& inline_executor();
+
+/// Collects ready coroutines until the owner drains them.
+///
+/// Typical use is a game or render loop that calls run_pending() once per
+/// frame so that streaming coroutines always resume on the main thread.
+class ManualExecutor final : public Executor {
+public:
+    void post(std::coroutine_handle<> handle) override;
+
+    /// Resume every coroutine posted so far. Coroutines posted while
+    /// running are left for the next call. Returns how many were resumed.
+    std::size_t run_pending();
+
+    /// Number of coroutines waiting to be resumed.
+    std::size_t pending() const;
+
+private:
+    mutable std::mutex mtx_;
+    std::vector<std::coroutine_handle<>> ready_;
+    std::vector<std::coroutine_handle<>> running_;
+};
+
+// -----------------------------------------------------------------------------
+// Awaitables
+// -----------------------------------------------------------------------------
+
+/// Awaitable for a single Request. co_await yields the completed Request.
+///
+/// The request is submitted on suspension via Queue::try_submit_all(), so
+/// in-flight caps are honoured: if the queue is saturated the request is
+/// held back and the coroutine stays suspended until it has run.
+class RequestAwaitable final : private CompletionHook {
+public:
+    RequestAwaitable(Queue& queue, const Request& request, Executor& executor)
+        : queue_(queue), executor_(executor), request_(request) {}
+
+    RequestAwaitable(const RequestAwaitable&) = delete;
+    RequestAwaitable& operator=(const RequestAwaitable&) = delete;
+
+    bool await_ready() const noexcept { return false; }
+
+    void await_suspend(std::coroutine_handle<> handle) {
+        handle_ = handle;
+        // The completion may resume (and destroy) this awaitable before
+        // enqueue() returns, so only locals are touched afterwards.
+        Queue& queue = queue_;
+        queue.enqueue(request_, this);
+        queue.try_submit_all();
+    }
+
+    Request await_resume() const noexcept { return request_; }
+
+private:
+    void on_request_complete(Request& request) override {
+        request_ = request;
+        Executor& executor = executor_;
+        const std::coroutine_handle<> handle = handle_;
+        executor.post(handle);
+    }
+
+    Queue&                  queue_;
+    Executor&               executor_;
+    Request                 request_;
+    std::coroutine_handle<> handle_;
+};
+
+/// Awaitable for a batch of requests; resumes once all have completed.
+///
+/// Results (status, errno_value, bytes_transferred) are written back into
+/// the caller's span in place, so the span must outlive the await. co_await
+/// yields the number of requests that did not complete with Ok.
+class BatchAwaitable final : private CompletionHook {
+public:
+    BatchAwaitable(Queue& queue, std::span<Request> requests, Executor& executor)
+        : queue_(queue), executor_(executor), requests_(requests) {}
+
+    BatchAwaitable(const BatchAwaitable&) = delete;
+    BatchAwaitable& operator=(const BatchAwaitable&) = delete;
+
+    bool await_ready() const noexcept { return requests_.empty(); }
+
+    void await_suspend(std::coroutine_handle<> handle) {
+        handle_ = handle;
+        remaining_.store(requests_.size(), std::memory_order_relaxed);
+
+        Queue& queue = queue_;
+        const std::span<Request> requests = requests_;
+        for (std::size_t i = 0; i < requests.size(); ++i) {
+            // The index rides in user_tag; the caller's tag stays in the span.
+            Request req = requests[i];
+            req.user_tag = i;
+            queue.enqueue(req, this);
+        }
+        queue.try_submit_all();
+    }
+
+    std::size_t await_resume() const noexcept {
+        return failed_.load(std::memory_order_relaxed);
+    }
+
+private:
+    void on_request_complete(Request& request) override {
+        Request& slot = requests_[static_cast<std::size_t>(request.user_tag)];
+        slot.status = request.status;
+        slot.errno_value = request.errno_value;
+        slot.bytes_transferred = request.bytes_transferred;
+        slot.buffer = std::move(request.buffer);
+        if (request.status != RequestStatus::Ok) {
+            failed_.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        // The last completion publishes every slot write to the resumer.
+        if (remaining_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            Executor& executor = executor_;
+            const std::coroutine_handle<> handle = handle_;
+            executor.post(handle);
+        }
+    }
+
+    Queue&                   queue_;
+    Executor&                executor_;
+    std::span<Request>       requests_;
+    std::coroutine_handle<>  handle_;
+    std::atomic<std::size_t> remaining_{0};
+    std::atomic<std::size_t> failed_{0};
+};
+
+// -----------------------------------------------------------------------------
+// Convenience factories
+// -----------------------------------------------------------------------------
+
+/// co_await submit(queue, req) runs an arbitrary Request.
+inline RequestAwaitable submit(Queue& queue, const Request& request,
+                               Executor& executor = inline_executor()) {
+    return RequestAwaitable(queue, request, executor);
+}
+
+/// co_await read(queue, fd, offset, dst) reads dst.size() bytes into dst.
+inline RequestAwaitable read(Queue& queue, int fd, std::uint64_t offset,
+                             std::span<std::byte> dst,
+                             Executor& executor = inline_executor()) {
+    Request req;
+    req.fd = fd;
+    req.offset = offset;
+    req.size = dst.size();
+    req.dst = dst.data();
+    req.op = RequestOp::Read;
+    return RequestAwaitable(queue, req, executor);
+}
+
+/// co_await write(queue, fd, offset, src) writes src to the file.
+inline RequestAwaitable write(Queue& queue, int fd, std::uint64_t offset,
+                              std::span<const std::byte> src,
+                              Executor& executor = inline_executor()) {
+    Request req;
+    req.fd = fd;
+    req.offset = offset;
+    req.size = src.size();
+    req.src = src.data();
+    req.op = RequestOp::Write;
+    return RequestAwaitable(queue, req, executor);
+}
+
+/// co_await submit_all(queue, requests) runs a batch and resumes once.
+inline BatchAwaitable submit_all(Queue& queue, std::span<Request> requests,
+                                 Executor& executor = inline_executor()) {
+    return BatchAwaitable(queue, requests, executor);
+}
+
+} // namespace ds::coro
@@ -0,0 +1,76 @@
+// SPDX-License-Identifier: Apache-2.0
+// Memory-mapped file backend interface for ds-runtime.
+//
+// Reads are served by copying out of a shared, read-only mapping of the
+// file instead of calling pread(), which removes a syscall (and, for data
+// already in the page cache, all kernel work) from the hot path. Writes
+// still go through pwrite() on the same descriptor; the page cache keeps
+// both views coherent.
+
+#pragma once
+
+#include "ds_runtime.hpp"
+
+namespace ds {
+
+/// Configuration for the mmap backend.
+struct MmapBackendConfig {
+    /// Worker threads. Zero runs each request on the thread that submits
+    /// it, which gives the lowest latency for data already in memory; use
+    /// workers when reads may fault on cold pages.
+    std::size_t worker_count = 0;
+
+    /// Files up to this size are mapped with MAP_POPULATE so the first
+    /// reads do not fault. Zero disables populating.
+    std::size_t populate_max_bytes = std::size_t{64} << 20;
+
+    /// Align mappings of at least 2 MiB to a huge-page boundary and request
+    /// MADV_HUGEPAGE. Ignored where the kernel or filesystem lacks support.
+    bool huge_pages = true;
+
+    /// Back-to-back reads after which a file is advised MADV_SEQUENTIAL.
+    std::size_t sequential_threshold = 2;
+
+    /// Bytes ahead of a sequential stream advised MADV_WILLNEED.
+    std::size_t readahead_bytes = std::size_t{4} << 20;
+
+    /// Reads at least this large get MADV_WILLNEED over their own range
+    /// before copying, so faults overlap with kernel readahead.
+    std::size_t willneed_min_bytes = std::size_t{256} << 10;
+
+    /// Pool for RequestMemory::Runtime reads that need a decode step.
+    /// Plain Runtime reads are views of the mapping and use no pool memory.
+    /// Null uses default_buffer_pool().
+    std::shared_ptr<BufferPool> buffer_pool;
+    /// NUMA placement of the workers. workers_per_node starts workers even
+    /// when worker_count is zero. Routing uses the node of the caller's
+    /// buffer only, since the page cache is not tied to the device's node.
+    WorkerPlacement placement;
+};
+
+/// mmap-backed implementation.
+///
+/// Files are mapped lazily on first read and kept mapped, keyed by file
+/// descriptor, until release_file() or destruction. A mapping is grown
+/// when a read reaches past the size the file had when it was mapped.
+/// Files must not be truncated while mapped; reading a truncated range
+/// raises SIGBUS, as with any mapping. GPU-targeted requests are rejected.
+///
+/// RequestMemory::Runtime reads without compression complete with a view
+/// straight into the mapping, so no bytes are copied. Such a view keeps
+/// its mapping alive after release_file() and, like the mapping, reflects
+/// later writes to the same file range.
+class MmapBackend : public Backend {
+public:
+    /// Drop the mapping for @p fd, if any.
+    ///
+    /// Call this before closing a descriptor used with this backend if the
+    /// descriptor number may be reused for another file. Reads still in
+    /// flight keep their mapping alive until they finish.
+    virtual void release_file(int fd) = 0;
+};
+
+/// Create an mmap-backed implementation.
+std::shared_ptr<MmapBackend> make_mmap_backend(const MmapBackendConfig& config = {});
+
+} // namespace ds
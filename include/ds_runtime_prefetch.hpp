@@ -0,0 +1,97 @@
+// SPDX-License-Identifier: Apache-2.0
+//
+// ds-runtime readahead prefetcher
+//
+// This header declares:
+//  - ds::PrefetchConfig / ds::PrefetchStats, the tuning knobs and counters
+//  - ds::PrefetchingBackend, a Backend decorator that detects sequential
+//    and strided read patterns per file and reads ahead of them
+//  - make_prefetching_backend(), which wraps any Backend
+//
+// Each file (device and inode, so every descriptor for it) has one access
+// stream. Once a stream has seen `trigger` consecutive reads of the same
+// size at the same positive stride, every further read on the stride
+// issues speculative reads for the next `depth` positions into a bounded
+// prefetch buffer. A read that finds its result there completes without
+// touching the wrapped backend; one that finds it still in flight waits
+// for it. Depth adapts: it doubles when a consumer has to wait, and halves
+// when the pattern breaks or a prefetched result is dropped unused.
+
+#pragma once
+
+#include "ds_runtime.hpp"
+
+#include <cstddef> // std::size_t
+#include <cstdint> // std::uint64_t
+#include <memory>  // std::shared_ptr
+
+namespace ds {
+
+/// Tuning knobs for a PrefetchingBackend.
+struct PrefetchConfig {
+    /// Memory budget for speculative results, in flight or waiting to be
+    /// consumed. Prefetching pauses while it is exhausted.
+    std::size_t buffer_bytes = std::size_t{64} << 20;
+
+    /// Consecutive reads at a constant stride before a stream starts
+    /// prefetching. Zero is clamped up to 1.
+    unsigned trigger = 2;
+
+    /// Reads issued ahead of a newly detected stream.
+    unsigned initial_depth = 2;
+
+    /// Upper bound for the adaptive read-ahead depth.
+    unsigned max_depth = 16;
+
+    /// Reads larger than this are neither tracked nor prefetched.
+    std::size_t max_request_bytes = std::size_t{8} << 20;
+
+    /// Files tracked at once; the least recently read stream is forgotten
+    /// beyond this.
+    std::size_t max_streams = 256;
+
+    /// Where prefetched results are decoded when the wrapped backend does
+    /// not provide buffers itself. Null uses default_buffer_pool().
+    std::shared_ptr<BufferPool> buffer_pool;
+};
+
+/// Point-in-time counters for a PrefetchingBackend.
+struct PrefetchStats {
+    std::uint64_t issued = 0;    ///< Speculative reads sent to the wrapped backend.
+    std::uint64_t hits = 0;      ///< Reads answered from a completed prefetch.
+    std::uint64_t late_hits = 0; ///< Reads that waited for a prefetch in flight.
+    std::uint64_t misses = 0;    ///< Tracked reads forwarded to the wrapped backend.
+    std::uint64_t wasted = 0;    ///< Prefetches dropped without being read.
+    std::uint64_t bypassed = 0;  ///< Reads not tracked (GPU, oversized, unknown file).
+    std::size_t   bytes_buffered = 0; ///< Budget currently held by prefetches.
+    std::size_t   streams = 0;        ///< Files currently tracked.
+};
+
+/// Backend decorator reading ahead of sequential and strided consumers.
+///
+/// Reads of host memory or RequestMemory::Runtime are tracked; GPU reads
+/// and writes pass through, and a write drops its file's prefetches and
+/// resets its stream. Hits complete inside submit(): Runtime reads take
+/// the prefetched buffer, host reads get a copy in dst. Each prefetched
+/// result is handed out once.
+///
+/// Prefetches read through a private duplicate of the caller's
+/// descriptor, so closing it after the last read is safe. The destructor
+/// waits for prefetches still in flight.
+///
+/// provides_buffers() is true. stats() reports the wrapped backend's
+/// counters plus the prefetch counters prefixed with "prefetch_".
+class PrefetchingBackend : public Backend {
+public:
+    /// Snapshot of hit/miss counters and current occupancy.
+    virtual PrefetchStats prefetch_stats() const = 0;
+
+    /// Forget the stream and drop the prefetches for the file open as @p fd.
+    virtual void invalidate(int fd) = 0;
+};
+
+/// Wrap @p inner in a readahead prefetcher.
+std::shared_ptr<PrefetchingBackend> make_prefetching_backend(std::shared_ptr<Backend> inner,
+                                                             const PrefetchConfig& config = {});
+
+} // namespace ds
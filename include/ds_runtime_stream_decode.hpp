@@ -0,0 +1,102 @@
+// SPDX-License-Identifier: Apache-2.0
+//
+// ds-runtime streaming GDeflate decoder
+//
+// This header declares:
+//  - ds::StreamDecodeConfig / ds::StreamDecodeStats, the tuning knobs and
+//    counters
+//  - ds::StreamingDecodeBackend, a Backend decorator that decodes
+//    Compression::GDeflate reads block by block as their bytes arrive
+//  - make_streaming_decode_backend(), which wraps any Backend
+//
+// A GDeflate read first fetches the stream header and block table through
+// the wrapped backend. It then keeps up to `ring_blocks` block reads
+// ahead of the decoders, each into its own slot of a bounded buffer ring.
+// A block is decoded straight into its place in dst on a decode worker as
+// soon as its read lands, and the slot goes back to the ring for the next
+// read. The disk reads block k+1..k+n while block k decodes, so a read
+// takes about max(I/O time, decode time) instead of their sum.
+//
+// Only the wrapped backend touches the file, through plain reads with
+// Compression::None, so this works the same over the CPU, io_uring and
+// mmap backends.
+
+#pragma once
+
+#include "ds_runtime.hpp"
+
+#include <cstddef> // std::size_t
+#include <cstdint> // std::uint64_t
+#include <memory>  // std::shared_ptr
+
+namespace ds {
+
+/// Tuning knobs for a StreamingDecodeBackend.
+struct StreamDecodeConfig {
+    /// Block codec. Without one, GDeflate reads pass through to the
+    /// wrapped backend unchanged.
+    BlockDecoder decoder;
+
+    /// Threads decoding blocks as their reads complete. Zero is clamped
+    /// up to 1.
+    std::size_t decode_workers = 2;
+
+    /// NUMA placement of the decode workers.
+    WorkerPlacement placement;
+
+    /// Ring slots per GDeflate read: how many of its blocks may be read,
+    /// waiting or decoding at once. Each slot holds the stream's largest
+    /// compressed block. Zero is clamped up to 1, which disables overlap.
+    std::size_t ring_blocks = 8;
+
+    /// Bytes read at the start of a stream for its header and block
+    /// table; larger tables take a second read.
+    std::size_t index_read_bytes = 8192;
+
+    /// Source of ring slots, and of destinations for Runtime reads when
+    /// the wrapped backend provides buffers. Null uses
+    /// default_buffer_pool().
+    std::shared_ptr<BufferPool> buffer_pool;
+
+    /// Check each decoded block of a stream flagged
+    /// gdeflate::FLAG_BLOCK_CRC32C against its checksum on the decode
+    /// worker, right after it is written.
+    bool verify_checksums = true;
+};
+
+/// Point-in-time counters for a StreamingDecodeBackend.
+struct StreamDecodeStats {
+    std::uint64_t streams = 0;     ///< GDeflate reads completed successfully.
+    std::uint64_t failed = 0;      ///< GDeflate reads that failed.
+    std::uint64_t blocks = 0;      ///< Blocks decoded.
+    std::uint64_t overlapped = 0;  ///< Blocks decoded while a read of the same stream was in flight.
+    std::uint64_t ring_full = 0;   ///< Times a stream had blocks left but no free slot.
+    std::uint64_t verified = 0;    ///< Blocks whose checksum was checked.
+    std::uint64_t corrupt = 0;     ///< Blocks whose checksum did not match.
+    std::size_t   in_flight = 0;   ///< GDeflate reads being decoded now.
+};
+
+/// Backend decorator decoding GDeflate reads in a read/decode pipeline.
+///
+/// GDeflate reads of host or RequestMemory::Runtime memory are decoded
+/// here; every other request passes through. Decoded reads complete with
+/// bytes_transferred equal to the stream's decoded size, or fail with the
+/// first error: a malformed stream (EINVAL), a destination smaller than
+/// the decoded size (EOVERFLOW), a failed or short block read, or the
+/// decoder's errno. A block failing its checksum, or a decoder returning
+/// EBADMSG, completes the read as RequestStatus::Corrupt.
+///
+/// provides_buffers() follows the wrapped backend. The destructor waits
+/// for GDeflate reads still in flight. stats() reports the wrapped
+/// backend's counters plus the decode counters prefixed with "decode_".
+class StreamingDecodeBackend : public Backend {
+public:
+    /// Snapshot of the decode counters.
+    virtual StreamDecodeStats decode_stats() const = 0;
+};
+
+/// Wrap @p inner in a streaming GDeflate decoder.
+std::shared_ptr<StreamingDecodeBackend> make_streaming_decode_backend(
+    std::shared_ptr<Backend> inner, const StreamDecodeConfig& config = {});
+
+} // namespace ds
@@ -13,8 +13,9 @@ namespace ds {
 
 /// Configuration for the io_uring backend.
 struct IoUringBackendConfig {
-    unsigned entries = 256;   ///< SQ/CQ size. Must be >= 1.
-    std::size_t worker_count = 1; ///< Reserved for future use.
+    unsigned entries = 256;   ///< SQ/CQ size per ring. Must be >= 1.
+    std::size_t worker_count = 1; ///< Rings, each with its own worker thread. Zero is clamped to 1.
+    WorkerPlacement placement;    ///< NUMA placement of the ring workers.
 };
 
 /// Create an io_uring-backed implementation.
@@ -3,8 +3,13 @@
 
 #pragma once
 
+#include <algorithm>
+#include <bit>
+#include <cstddef>
 #include <cstdint>
 #include <cstring>
+#include <span>
+#include <utility>
 #include <vector>
 
 namespace ds {
@@ -21,6 +26,10 @@ constexpr uint32_t GDEFLATE_MAGIC = 0x4744464C;  // "GDFL" in little-endian
 constexpr uint16_t GDEFLATE_VERSION_MAJOR = 1;
 constexpr uint16_t GDEFLATE_VERSION_MINOR = 0;
 
+// FileHeader::flags bits
+// Every BlockInfo::checksum holds the CRC-32C of the block's decoded bytes.
+constexpr uint32_t FLAG_BLOCK_CRC32C = 1u << 0;
+
 // Maximum block size (16 MB is typical for DirectStorage)
 constexpr uint32_t MAX_BLOCK_SIZE = 16 * 1024 * 1024;
 
@@ -48,10 +57,10 @@ struct FileHeader {
 
 // Metadata for a single compressed block
 struct BlockInfo {
-    uint64_t offset;             // Offset in compressed stream (bytes)
+    uint64_t offset;             // Offset of the compressed bytes, counted from the end of the block table
     uint32_t compressed_size;    // Compressed block size (bytes)
     uint32_t uncompressed_size;  // Uncompressed block size (bytes)
-    uint32_t checksum;           // Block checksum (CRC32 or similar)
+    uint32_t checksum;           // CRC-32C of the decoded bytes, with FLAG_BLOCK_CRC32C
     
     // Validate block info
     bool is_valid() const {
@@ -61,6 +70,290 @@ struct BlockInfo {
     }
 };
 
+// On-disk sizes; BlockInfo carries 4 bytes of tail padding.
+static_assert(sizeof(FileHeader) == 32, "FileHeader is 32 bytes on disk");
+static_assert(sizeof(BlockInfo) == 24, "BlockInfo is 24 bytes on disk");
+
+// Streams are little-endian on disk. These loads accept any alignment.
+inline uint32_t load_le32(const uint8_t* p) {
+    return static_cast<uint32_t>(p[0]) | static_cast<uint32_t>(p[1]) << 8 |
+           static_cast<uint32_t>(p[2]) << 16 | static_cast<uint32_t>(p[3]) << 24;
+}
+
+inline uint16_t load_le16(const uint8_t* p) {
+    return static_cast<uint16_t>(p[0] | p[1] << 8);
+}
+
+inline uint64_t load_le64(const uint8_t* p) {
+    return static_cast<uint64_t>(load_le32(p)) | static_cast<uint64_t>(load_le32(p + 4)) << 32;
+}
+
+// Decode the FileHeader at data, which must hold sizeof(FileHeader) bytes.
+inline FileHeader load_file_header(const void* data) {
+    const auto* p = static_cast<const uint8_t*>(data);
+    FileHeader header{};
+    header.magic = load_le32(p);
+    header.version_major = load_le16(p + 4);
+    header.version_minor = load_le16(p + 6);
+    header.flags = load_le32(p + 8);
+    header.uncompressed_size = load_le32(p + 12);
+    header.compressed_size = load_le32(p + 16);
+    header.block_count = load_le32(p + 20);
+    header.reserved[0] = load_le32(p + 24);
+    header.reserved[1] = load_le32(p + 28);
+    return header;
+}
+
+// Decode the BlockInfo at data, which must hold sizeof(BlockInfo) bytes.
+inline BlockInfo load_block_info(const void* data) {
+    const auto* p = static_cast<const uint8_t*>(data);
+    BlockInfo block{};
+    block.offset = load_le64(p);
+    block.compressed_size = load_le32(p + 8);
+    block.uncompressed_size = load_le32(p + 12);
+    block.checksum = load_le32(p + 16);
+    return block;
+}
+
+// Zero-copy view of a block table inside the caller's buffer. Entries are
+// decoded on access, so the buffer needs no particular alignment and must
+// outlive the view.
+class BlockTableView {
+public:
+    BlockTableView() = default;
+    BlockTableView(const void* table, size_t count)
+        : table_(static_cast<const uint8_t*>(table)), count_(count) {}
+
+    size_t size() const { return count_; }
+    bool empty() const { return count_ == 0; }
+    const uint8_t* data() const { return table_; }
+
+    BlockInfo operator[](size_t index) const {
+        return load_block_info(table_ + index * sizeof(BlockInfo));
+    }
+
+private:
+    const uint8_t* table_ = nullptr;
+    size_t count_ = 0;
+};
+
+// Outcome of checking a stream: Ok, or the first problem found.
+enum class ParseStatus {
+    Ok,
+    Truncated,         // The buffer ends inside the header or block table
+    BadHeader,         // Wrong magic or version, or a zero size or count
+    TooManyBlocks,     // More blocks than decoded bytes
+    BadBlock,          // A block with a zero or oversized length
+    BlockOutOfBounds,  // A block's compressed bytes leave the payload
+    BlocksOverlap,     // Two blocks share compressed bytes
+    SizeMismatch       // Decoded block sizes do not add up to the header's
+};
+
+inline const char* parse_status_string(ParseStatus status) {
+    switch (status) {
+        case ParseStatus::Ok:               return "Ok";
+        case ParseStatus::Truncated:        return "Truncated GDeflate stream";
+        case ParseStatus::BadHeader:        return "Not a GDeflate stream";
+        case ParseStatus::TooManyBlocks:    return "Corrupt GDeflate block count";
+        case ParseStatus::BadBlock:         return "Corrupt GDeflate block size";
+        case ParseStatus::BlockOutOfBounds: return "GDeflate block lies outside the stream";
+        case ParseStatus::BlocksOverlap:    return "GDeflate blocks overlap";
+        case ParseStatus::SizeMismatch:     return "GDeflate block sizes disagree with the header";
+    }
+    return "Unknown GDeflate parse status";
+}
+
+// Check the block table of a stream described by header in place, without
+// copying it: table_size bytes at table. Every block must have valid
+// sizes and lie inside the header.compressed_size payload bytes that
+// follow the table, no two blocks may share payload bytes, and the decoded
+// sizes must add up to header.uncompressed_size. On Ok, view covers the
+// table.
+//
+// All arithmetic is checked against the 32-bit header sizes, so hostile
+// counts and offsets cannot wrap. Tables stored in payload order are
+// checked in one pass; others take a sorted copy of their extents.
+inline ParseStatus check_block_table(const FileHeader& header, const void* table, size_t table_size,
+                                     BlockTableView& view) {
+    const size_t count = header.block_count;
+    if (count > table_size / sizeof(BlockInfo)) {
+        return ParseStatus::Truncated;
+    }
+    // Every block decodes to at least one byte.
+    if (count > header.uncompressed_size) {
+        return ParseStatus::TooManyBlocks;
+    }
+
+    const BlockTableView blocks(table, count);
+    uint64_t decoded = 0;
+    uint64_t end = 0;
+    bool in_order = true;
+    for (size_t b = 0; b < count; ++b) {
+        const BlockInfo block = blocks[b];
+        if (!block.is_valid()) {
+            return ParseStatus::BadBlock;
+        }
+        if (block.offset > header.compressed_size ||
+            block.compressed_size > header.compressed_size - block.offset) {
+            return ParseStatus::BlockOutOfBounds;
+        }
+        decoded += block.uncompressed_size;
+        in_order = in_order && block.offset >= end;
+        end = block.offset + block.compressed_size;
+    }
+    if (decoded != header.uncompressed_size) {
+        return ParseStatus::SizeMismatch;
+    }
+
+    if (!in_order) {
+        std::vector<std::pair<uint64_t, uint64_t>> extents(count);
+        for (size_t b = 0; b < count; ++b) {
+            const BlockInfo block = blocks[b];
+            extents[b] = {block.offset, block.offset + block.compressed_size};
+        }
+        std::sort(extents.begin(), extents.end());
+        for (size_t b = 1; b < count; ++b) {
+            if (extents[b].first < extents[b - 1].second) {
+                return ParseStatus::BlocksOverlap;
+            }
+        }
+    }
+    view = blocks;
+    return ParseStatus::Ok;
+}
+
+// Check the header and block table at the start of the size bytes at data,
+// in place. The payload need not be present; when it must be, compare
+// stream_size(header) with the buffer size. On Ok, header and view
+// describe the stream.
+inline ParseStatus check_stream_index(const void* data, size_t size, FileHeader& header,
+                                      BlockTableView& view) {
+    if (data == nullptr || size < sizeof(FileHeader)) {
+        return ParseStatus::Truncated;
+    }
+    header = load_file_header(data);
+    if (!header.is_valid()) {
+        return ParseStatus::BadHeader;
+    }
+    return check_block_table(header, static_cast<const uint8_t*>(data) + sizeof(FileHeader),
+                             size - sizeof(FileHeader), view);
+}
+
+// Bytes from the start of a stream to the end of its payload.
+inline uint64_t stream_size(const FileHeader& header) {
+    return sizeof(FileHeader) + uint64_t{header.block_count} * sizeof(BlockInfo) +
+           header.compressed_size;
+}
+
+// Validated view of a stream index (header and block table) held in a
+// caller's buffer: a mapped file, pinned staging memory, an archive entry.
+// open() checks it once with check_stream_index(); header() and blocks()
+// then point straight into the buffer, which must outlive the view and
+// stay unchanged. When the buffer is not 8-byte aligned, or the host is
+// big-endian, open() decodes the header and table once into storage of
+// its own instead, and zero_copy() is false.
+//
+// open() also stores prefix sums of the decoded block sizes, so
+// find_block() maps a decoded offset to its block in O(log n) and a
+// reader can start decoding anywhere in the stream.
+class StreamView {
+public:
+    static constexpr size_t npos = static_cast<size_t>(-1);
+
+    StreamView() = default;
+    StreamView(const StreamView&) = delete;
+    StreamView& operator=(const StreamView&) = delete;
+    StreamView(StreamView&&) = default;
+    StreamView& operator=(StreamView&&) = default;
+
+    // Check the size bytes at data and view them. The payload need not be
+    // present. On failure the view is left empty.
+    ParseStatus open(const void* data, size_t size) {
+        *this = StreamView();
+        FileHeader header{};
+        BlockTableView table;
+        const ParseStatus status = check_stream_index(data, size, header, table);
+        if (status != ParseStatus::Ok) {
+            return status;
+        }
+
+        const bool aligned = reinterpret_cast<uintptr_t>(data) % alignof(BlockInfo) == 0;
+        if (aligned && std::endian::native == std::endian::little) {
+            header_ = static_cast<const FileHeader*>(data);
+            blocks_ = std::span<const BlockInfo>(
+                reinterpret_cast<const BlockInfo*>(table.data()), table.size());
+        } else {
+            owned_header_ = header;
+            header_ = nullptr;
+            owned_blocks_.resize(table.size());
+            for (size_t b = 0; b < table.size(); ++b) {
+                owned_blocks_[b] = table[b];
+            }
+            blocks_ = owned_blocks_;
+        }
+
+        offsets_.resize(blocks_.size() + 1);
+        offsets_[0] = 0;
+        for (size_t b = 0; b < blocks_.size(); ++b) {
+            offsets_[b + 1] = offsets_[b] + blocks_[b].uncompressed_size;
+            max_compressed_ = std::max(max_compressed_, blocks_[b].compressed_size);
+        }
+        valid_ = true;
+        return status;
+    }
+
+    bool valid() const { return valid_; }
+
+    // True when header() and blocks() point into the buffer given to open().
+    bool zero_copy() const { return header_ != nullptr; }
+
+    const FileHeader& header() const { return header_ != nullptr ? *header_ : owned_header_; }
+    std::span<const BlockInfo> blocks() const { return blocks_; }
+    size_t block_count() const { return blocks_.size(); }
+
+    // Decoded offset of every block, plus the decoded size at the end.
+    std::span<const uint64_t> decoded_offsets() const { return offsets_; }
+    uint64_t decoded_offset(size_t block) const { return offsets_[block]; }
+    uint64_t decoded_size() const { return offsets_.empty() ? 0 : offsets_.back(); }
+
+    // Largest compressed block, for sizing read buffers.
+    uint32_t max_compressed_size() const { return max_compressed_; }
+
+    // Bytes from the stream start to block offset 0.
+    uint64_t payload_offset() const {
+        return sizeof(FileHeader) + uint64_t{blocks_.size()} * sizeof(BlockInfo);
+    }
+
+    // Block holding decoded byte offset, or npos past the end.
+    size_t find_block(uint64_t offset) const {
+        if (offset >= decoded_size()) {
+            return npos;
+        }
+        const auto it = std::upper_bound(offsets_.begin() + 1, offsets_.end(), offset);
+        return static_cast<size_t>(it - offsets_.begin() - 1);
+    }
+
+    // Blocks [first, last) covering decoded bytes [offset, offset + size),
+    // clamped to the stream; empty when the range is.
+    std::pair<size_t, size_t> block_range(uint64_t offset, uint64_t size) const {
+        const uint64_t total = decoded_size();
+        if (size == 0 || offset >= total) {
+            return {0, 0};
+        }
+        const uint64_t end = size > total - offset ? total : offset + size;
+        return {find_block(offset), find_block(end - 1) + 1};
+    }
+
+private:
+    const FileHeader* header_ = nullptr;   // Into the buffer, when zero-copy
+    FileHeader owned_header_{};
+    std::span<const BlockInfo> blocks_;
+    std::vector<BlockInfo> owned_blocks_;  // Decoded copy, when not zero-copy
+    std::vector<uint64_t> offsets_;        // block_count() + 1 prefix sums
+    uint32_t max_compressed_ = 0;
+    bool valid_ = false;
+};
+
 // Complete GDeflate stream information
 struct StreamInfo {
     FileHeader header;
@@ -104,28 +397,30 @@ struct StreamInfo {
 // Parse GDeflate file header from buffer
 // Returns true if header is valid and successfully parsed
 inline bool parse_file_header(const void* data, size_t size, FileHeader& header) {
-    if (size < sizeof(FileHeader)) {
+    if (data == nullptr || size < sizeof(FileHeader)) {
         return false;
     }
     
-    std::memcpy(&header, data, sizeof(FileHeader));
+    header = load_file_header(data);
     return header.is_valid();
 }
 
 // Parse block metadata from buffer
-// Returns number of blocks parsed, or 0 on error
+// Returns number of blocks parsed, or 0 on error. Only the entries
+// themselves are checked; check_block_table() also checks them against
+// the header.
 inline size_t parse_block_info(const void* data, size_t size, 
                                size_t block_count, std::vector<BlockInfo>& blocks) {
-    if (size < block_count * sizeof(BlockInfo)) {
+    // Divide rather than multiply, so a hostile count cannot wrap.
+    if (data == nullptr || block_count > size / sizeof(BlockInfo)) {
         return 0;
     }
     
+    const BlockTableView view(data, block_count);
     blocks.resize(block_count);
-    std::memcpy(blocks.data(), data, block_count * sizeof(BlockInfo));
-    
-    // Validate all blocks
-    for (const auto& block : blocks) {
-        if (!block.is_valid()) {
+    for (size_t b = 0; b < block_count; ++b) {
+        blocks[b] = view[b];
+        if (!blocks[b].is_valid()) {
             blocks.clear();
             return 0;
         }
@@ -135,24 +430,20 @@ inline size_t parse_block_info(const void* data, size_t size,
 }
 
 // Parse complete GDeflate stream information
+// The header and block table are checked as by check_stream_index(),
+// then the table is copied into info.blocks.
 inline bool parse_stream_info(const void* data, size_t size, StreamInfo& info) {
-    if (size < sizeof(FileHeader)) {
+    BlockTableView view;
+    if (check_stream_index(data, size, info.header, view) != ParseStatus::Ok) {
+        info.blocks.clear();
         return false;
     }
     
-    // Parse header
-    if (!parse_file_header(data, size, info.header)) {
-        return false;
+    info.blocks.resize(view.size());
+    for (size_t b = 0; b < view.size(); ++b) {
+        info.blocks[b] = view[b];
     }
-    
-    // Parse block metadata (comes after header)
-    const uint8_t* block_data = static_cast<const uint8_t*>(data) + sizeof(FileHeader);
-    size_t remaining = size - sizeof(FileHeader);
-    
-    size_t parsed = parse_block_info(block_data, remaining, 
-                                     info.header.block_count, info.blocks);
-    
-    return parsed == info.header.block_count && info.is_valid();
+    return true;
 }
 
 } // namespace gdeflate
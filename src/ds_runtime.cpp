@@ -12,18 +12,32 @@
 // maximum I/O throughput.
 
 #include "ds_runtime.hpp"
+#include "ds_runtime_buffer.hpp"
+#include "ds_runtime_capture.hpp"
+#include "ds_runtime_gdeflate_index.hpp"
+#include "ds_runtime_read_key.hpp"
+#include "ds_runtime_ring.hpp"
+#include "ds_runtime_stats.hpp"
+#include "ds_runtime_thread_pool.hpp"
+#include "ds_runtime_trace.hpp"
 
+#include <algorithm>
 #include <atomic>
 #include <cerrno>
+#include <chrono>
 #include <cctype>
 #include <condition_variable>
 #include <cstdint>
 #include <cstring>
+#include <deque>
 #include <functional>
 #include <memory>
 #include <mutex>
-#include <queue>
-#include <thread>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
 #include <vector>
 
 #include <fcntl.h>
@@ -31,110 +45,6 @@
 
 namespace ds {
 
-// -------------------------
-// Internal thread pool
-// -------------------------
-
-namespace {
-
-/**
- * @brief Very small, fixed-size thread pool.
- *
- *  - Jobs are std::function<void()>.
- *  - Threads run until destruction.
- *  - No dynamic resizing or fancy features; this is intentionally minimal.
- */
-class ThreadPool {
-public:
-    /**
-     * @brief Construct a thread pool with @p thread_count workers.
-     *
-     * If @p thread_count is 0, it is clamped up to 1 to avoid
-     * a degenerate pool with no workers.
-     */
-    explicit ThreadPool(std::size_t thread_count)
-        : stop_(false)
-    {
-        if (thread_count == 0) {
-            thread_count = 1;
-        }
-
-        workers_.reserve(thread_count);
-        for (std::size_t i = 0; i < thread_count; ++i) {
-            workers_.emplace_back([this]() { worker_loop(); });
-        }
-    }
-
-    /**
-     * @brief Join all worker threads and destroy the pool.
-     *
-     * Any jobs still in the queue are discarded after @ref stop_ is set.
-     * Workers finish at job boundaries; there is no preemption.
-     */
-    ~ThreadPool() {
-        {
-            std::lock_guard<std::mutex> lock(mtx_);
-            stop_ = true;
-        }
-        cv_.notify_all();
-
-        for (auto& t : workers_) {
-            if (t.joinable()) {
-                t.join();
-            }
-        }
-    }
-
-    /**
-     * @brief Submit a job to be executed by the pool.
-     *
-     * The job is queued and executed by the next available worker thread.
-     * This function is thread-safe.
-     */
-    void submit(std::function<void()> job) {
-        {
-            std::lock_guard<std::mutex> lock(mtx_);
-            jobs_.push(std::move(job));
-        }
-        cv_.notify_one();
-    }
-
-private:
-    /// Worker thread main loop.
-    ///
-    /// Each worker waits for jobs, executes them, and terminates only when:
-    ///  - @ref stop_ is true *and*
-    ///  - the job queue is empty.
-    void worker_loop() {
-        for (;;) {
-            std::function<void()> job;
-
-            {
-                std::unique_lock<std::mutex> lock(mtx_);
-                cv_.wait(lock, [&] { return stop_ || !jobs_.empty(); });
-
-                // If we're asked to stop and there's no more work, exit.
-                if (stop_ && jobs_.empty()) {
-                    return;
-                }
-
-                job = std::move(jobs_.front());
-                jobs_.pop();
-            }
-
-            job();
-        }
-    }
-
-    std::vector<std::thread>          workers_; ///< Worker threads owned by the pool.
-    std::queue<std::function<void()>> jobs_;    ///< FIFO queue of pending jobs.
-    std::mutex                        mtx_;     ///< Protects jobs_ and stop_.
-    std::condition_variable           cv_;      ///< Signals workers when work is available or stop_ changes.
-    bool                              stop_;    ///< Set to true during destruction to shut workers down.
-};
-
-} // anonymous namespace
-
 // -------------------------
 // CPU backend
 // -------------------------
@@ -148,6 +58,7 @@ namespace {
  *  - ThreadPool for concurrency.
  *  - pread() for POSIX file I/O.
  *  - Optional "fake decompression" (uppercase transformation).
+ *  - A pluggable GDeflate block decoder, run on several workers per read.
  *
  * This backend is intended as a simple, correct reference implementation
  * and semantic baseline, not a high-throughput I/O engine.
@@ -155,13 +66,18 @@ namespace {
 class CpuBackend final : public Backend {
 public:
     /**
-     * @brief Construct a CPU backend with @p worker_count worker threads.
+     * @brief Construct a CPU backend from @p config.
      *
-     * @param worker_count  Desired worker thread count. Zero is allowed and
-     *                      is clamped up to 1 by the internal ThreadPool.
+     * @param config  Worker count (zero is clamped up to 1 by the internal
+     *                ThreadPool), NUMA placement and the pool for Runtime
+     *                reads.
      */
-    explicit CpuBackend(std::size_t worker_count)
-        : pool_(worker_count) // ThreadPool itself clamps zero to 1
+    explicit CpuBackend(const CpuBackendConfig& config)
+        : buffer_pool_(config.buffer_pool ? config.buffer_pool : default_buffer_pool())
+        , decoder_(config.gdeflate_decoder)
+        , split_bytes_(std::max<std::size_t>(config.decode_split_bytes, 1))
+        , verify_(config.verify_block_checksums)
+        , pool_(config.worker_count, config.placement) // ThreadPool itself clamps zero to 1
     {}
 
     /**
@@ -176,192 +92,477 @@ public:
      *                     has finished.
      */
     void submit(Request req, CompletionCallback on_complete) override {
+        counters_.add(kSubmitted);
+        const std::uint64_t queued_ns = trace::enabled() ? trace::now_ns() : 0;
+        // With per-node worker groups, run near the buffer or the device.
+        const int node = pool_.routes_by_node() ? detail::request_numa_node(req, true) : -1;
         // Copy req by value into the job; the user-owned Request is distinct.
-        pool_.submit([req, on_complete]() mutable {
-            // Validate the request before attempting any I/O.
-            if (req.fd < 0) {
-                report_request_error("cpu",
-                                     "submit",
-                                     "Invalid file descriptor",
-                                     req,
-                                     EBADF,
-                                     __FILE__,
-                                     __LINE__,
-                                     __func__);
-                req.status = RequestStatus::IoError;
-                req.errno_value = EBADF;
-                if (on_complete) {
-                    on_complete(req);
-                }
+        pool_.submit([this, req, on_complete, queued_ns, node]() mutable {
+            req.start_time_ns = detail::steady_now_ns();
+            if (queued_ns != 0) {
+                trace::record("cpu", "pool_wait", queued_ns, req.start_time_ns, req);
+            }
+            if (decoder_ && req.op == RequestOp::Read && req.compression == Compression::GDeflate) {
+                start_decode(std::move(req), std::move(on_complete), node);
                 return;
             }
+            execute(req);
+            finish(req, on_complete);
+        }, node);
+    }
 
-            if (req.size == 0) {
-                report_request_error("cpu",
-                                     "submit",
-                                     "Zero-length request is not allowed",
-                                     req,
-                                     EINVAL,
-                                     __FILE__,
-                                     __LINE__,
-                                     __func__);
-                req.status = RequestStatus::IoError;
-                req.errno_value = EINVAL;
-                if (on_complete) {
-                    on_complete(req);
-                }
+    /**
+     * @brief Snapshot submission/completion counters and pool depth.
+     */
+    BackendStats stats() const override {
+        BackendStats out;
+        out.backend = "cpu";
+        out.submitted = counters_.read(kSubmitted);
+        out.completed = counters_.read(kCompleted);
+        out.failed = counters_.read(kFailed);
+        out.bytes_transferred = counters_.read(kBytes);
+        out.counters.push_back({"workers", pool_.worker_count()});
+        out.counters.push_back({"queued_jobs", pool_.queued()});
+        out.counters.push_back({"numa_groups", pool_.group_count()});
+        out.counters.push_back({"pinned_workers", pool_.pinned_count()});
+        out.counters.push_back({"decode_groups", counters_.read(kDecodeGroups)});
+        out.counters.push_back({"decoded_blocks", counters_.read(kDecodedBlocks)});
+        out.counters.push_back({"verified_blocks", counters_.read(kVerifiedBlocks)});
+        out.counters.push_back({"checksum_failures", counters_.read(kChecksumFailures)});
+        return out;
+    }
+
+    // Runtime reads are allocated on the worker that fills them.
+    bool provides_buffers() const noexcept override { return true; }
+
+private:
+    /// Shared state of one GDeflate read split into block groups.
+    struct DecodeJob {
+        Request            req;
+        CompletionCallback on_complete;
+        PoolBuffer         block;            ///< Destination of a Runtime read.
+        detail::GDeflateIndex index;         ///< payload_offset is made absolute.
+        std::atomic<std::size_t> pending{0}; ///< Groups still running.
+        std::atomic<int>   error{0};         ///< First failure's errno, or 0.
+    };
+
+    /**
+     * @brief Account for a finished request and invoke its callback.
+     */
+    void finish(Request& req, const CompletionCallback& on_complete) {
+        counters_.add(kCompleted);
+        if (req.status != RequestStatus::Ok) {
+            counters_.add(kFailed);
+        }
+        counters_.add(kBytes, req.bytes_transferred);
+
+        // Invoke completion callback.
+        //
+        // Note: this is called on a worker thread. Callers must ensure
+        // that any captured state is thread-safe.
+        if (on_complete) {
+            trace::Span span("cpu", "callback", req);
+            on_complete(req);
+        }
+    }
+
+    /**
+     * @brief Start a GDeflate read: read the stream header and block table,
+     * then decode groups of blocks on all workers.
+     *
+     * Groups hold consecutive blocks of about equal decoded size, at least
+     * split_bytes_ each. The first group runs on this worker; the worker
+     * finishing the last group completes the request.
+     */
+    void start_decode(Request req, CompletionCallback on_complete, int node) {
+        auto job = std::make_shared<DecodeJob>();
+        job->on_complete = std::move(on_complete);
+        if (req.dst_memory == RequestMemory::Runtime) {
+            job->block = buffer_pool_->allocate(req.size);
+            if (!job->block) {
+                report_request_error("cpu", "allocate", "Buffer pool exhausted", req, ENOMEM,
+                                     __FILE__, __LINE__, __func__);
+                fail(req, ENOMEM);
+                finish(req, job->on_complete);
                 return;
             }
+            req.dst = job->block.data();
+        }
+        if (!validate(req) || !read_stream_index(req, *job)) {
+            finish(req, job->on_complete);
+            return;
+        }
+        job->req = req;
 
-            if (req.op == RequestOp::Read && req.dst == nullptr) {
-                report_request_error("cpu",
-                                     "submit",
-                                     "Read request missing destination buffer",
-                                     req,
-                                     EINVAL,
-                                     __FILE__,
-                                     __LINE__,
-                                     __func__);
-                req.status = RequestStatus::IoError;
-                req.errno_value = EINVAL;
-                if (on_complete) {
-                    on_complete(req);
-                }
-                return;
+        const detail::GDeflateIndex& index = job->index;
+        const std::size_t block_count = index.blocks.size();
+        const std::size_t groups = std::min(
+            {pool_.worker_count(), block_count, std::max<std::size_t>(index.decoded_size / split_bytes_, 1)});
+        std::vector<std::size_t> cuts{0};
+        const std::size_t target = (index.decoded_size + groups - 1) / groups;
+        for (std::size_t b = 1; b < block_count && cuts.size() < groups; ++b) {
+            if (index.dst_offsets[b] >= target * cuts.size()) {
+                cuts.push_back(b);
             }
+        }
+        cuts.push_back(block_count);
 
-            if (req.op == RequestOp::Write && req.src == nullptr) {
-                report_request_error("cpu",
-                                     "submit",
-                                     "Write request missing source buffer",
-                                     req,
-                                     EINVAL,
-                                     __FILE__,
-                                     __LINE__,
-                                     __func__);
-                req.status = RequestStatus::IoError;
-                req.errno_value = EINVAL;
-                if (on_complete) {
-                    on_complete(req);
+        job->pending.store(cuts.size() - 1, std::memory_order_relaxed);
+        counters_.add(kDecodeGroups, cuts.size() - 1);
+        for (std::size_t g = 1; g + 1 < cuts.size(); ++g) {
+            pool_.submit([this, job, first = cuts[g], last = cuts[g + 1]] {
+                decode_group(job, first, last);
+            }, node);
+        }
+        decode_group(job, cuts[0], cuts[1]);
+    }
+
+    /**
+     * @brief Read and check the header and block table of the GDeflate
+     * stream at req.offset into @p job. Reports and fails @p req if the
+     * stream is unreadable, malformed or decodes past req.size.
+     */
+    static bool read_stream_index(Request& req, DecodeJob& job) {
+        const auto reject = [&req](const char* detail, int err, int line) {
+            report_request_error("cpu", "decompression", detail, req, err,
+                                 __FILE__, line, "read_stream_index");
+            fail(req, err);
+            return false;
+        };
+
+        gdeflate::FileHeader header{};
+        std::vector<char> bytes(sizeof(header));
+        int err = read_fully(req.fd, bytes.data(), bytes.size(), req.offset);
+        if (err != 0) {
+            return reject("Cannot read GDeflate stream header", err, __LINE__);
+        }
+        if (const char* problem = detail::check_gdeflate_header(bytes.data(), bytes.size(), req.size,
+                                                                header, err)) {
+            return reject(problem, err, __LINE__);
+        }
+        bytes.resize(sizeof(header) + detail::gdeflate_table_bytes(header));
+        err = read_fully(req.fd, bytes.data() + sizeof(header), bytes.size() - sizeof(header),
+                         req.offset + sizeof(header));
+        if (err != 0) {
+            return reject("Cannot read GDeflate block table", err, __LINE__);
+        }
+        if (const char* problem = detail::build_gdeflate_index(std::move(bytes), job.index, err)) {
+            return reject(problem, err, __LINE__);
+        }
+        job.index.payload_offset += req.offset;
+        return true;
+    }
+
+    /**
+     * @brief Read and decode blocks [@p first, @p last) of @p job into its
+     * destination, checking each block's CRC-32C as soon as it is decoded.
+     * Stops early once any group has failed.
+     */
+    void decode_group(const std::shared_ptr<DecodeJob>& job, std::size_t first, std::size_t last) {
+        {
+            trace::Span span("cpu", "decompress", job->req);
+            const detail::GDeflateIndex& index = job->index;
+            auto* dst = static_cast<char*>(job->req.dst);
+            std::vector<char> compressed;
+            for (std::size_t b = first; b < last && job->error.load(std::memory_order_relaxed) == 0; ++b) {
+                const gdeflate::BlockInfo& block = index.blocks[b];
+                compressed.resize(std::max<std::size_t>(compressed.size(), block.compressed_size));
+                const char* operation = "pread";
+                int err = read_fully(job->req.fd, compressed.data(), block.compressed_size,
+                                     index.payload_offset + block.offset);
+                if (err == 0) {
+                    operation = "decompression";
+                    err = decoder_(compressed.data(), block.compressed_size,
+                                   dst + index.dst_offsets[b], block.uncompressed_size);
                 }
-                return;
+                if (err == 0 && verify_ && index.checksummed) {
+                    counters_.add(kVerifiedBlocks);
+                    if (!detail::gdeflate_block_intact(index, b, dst + index.dst_offsets[b])) {
+                        counters_.add(kChecksumFailures);
+                        operation = "verify";
+                        err = EBADMSG;
+                    }
+                }
+                if (err != 0) {
+                    int expected = 0;
+                    if (job->error.compare_exchange_strong(expected, err)) {
+                        report_request_error("cpu", operation,
+                                             "GDeflate block " + std::to_string(b) + " failed",
+                                             job->req, err, __FILE__, __LINE__, __func__);
+                    }
+                    break;
+                }
+                counters_.add(kDecodedBlocks);
             }
+        }
+        if (job->pending.fetch_sub(1, std::memory_order_acq_rel) != 1) {
+            return;
+        }
 
-            if ((req.op == RequestOp::Read && req.dst_memory == RequestMemory::Gpu) ||
-                (req.op == RequestOp::Write && req.src_memory == RequestMemory::Gpu)) {
-                report_request_error("cpu",
-                                     "submit",
-                                     "GPU memory requested on CPU backend",
-                                     req,
-                                     EINVAL,
-                                     __FILE__,
-                                     __LINE__,
-                                     __func__);
-                req.status = RequestStatus::IoError;
-                req.errno_value = EINVAL;
-                if (on_complete) {
-                    on_complete(req);
+        Request& req = job->req;
+        const int err = job->error.load(std::memory_order_relaxed);
+        if (err != 0) {
+            fail(req, err);
+            if (err == EBADMSG) {
+                req.status = RequestStatus::Corrupt;
+            }
+        } else {
+            req.status = RequestStatus::Ok;
+            req.errno_value = 0;
+            req.bytes_transferred = job->index.decoded_size;
+            if (job->block) {
+                req.buffer = job->block.share(job->index.decoded_size);
+            }
+        }
+        finish(req, job->on_complete);
+    }
+
+    /**
+     * @brief pread() exactly @p size bytes at @p offset.
+     *
+     * @return 0, errno, or EIO if the file ends first.
+     */
+    static int read_fully(int fd, void* dst, std::size_t size, std::uint64_t offset) {
+        auto* p = static_cast<char*>(dst);
+        while (size != 0) {
+            const ssize_t n = ::pread(fd, p, size, static_cast<off_t>(offset));
+            if (n <= 0) {
+                if (n < 0 && errno == EINTR) {
+                    continue;
                 }
-                return;
+                return n < 0 ? errno : EIO;
             }
+            p += n;
+            size -= static_cast<std::size_t>(n);
+            offset += static_cast<std::uint64_t>(n);
+        }
+        return 0;
+    }
 
-            ssize_t io_bytes = 0;
+    /// Mark @p req failed with @p err.
+    static void fail(Request& req, int err) {
+        req.status = RequestStatus::IoError;
+        req.errno_value = err;
+        req.bytes_transferred = 0;
+    }
 
-            if (req.op == RequestOp::Write) {
-                io_bytes = ::pwrite(
-                    req.fd,
-                    req.src,
-                    req.size,
-                    static_cast<off_t>(req.offset)
-                );
-            } else {
-                io_bytes = ::pread(
-                    req.fd,
-                    req.dst,
-                    req.size,
-                    static_cast<off_t>(req.offset)
-                );
-            }
+    /**
+     * @brief Execute @p req, first giving a Runtime read a pool block on
+     * this worker's NUMA node to land in.
+     */
+    void execute(Request& req) {
+        if (req.op != RequestOp::Read || req.dst_memory != RequestMemory::Runtime) {
+            execute_io(req);
+            return;
+        }
+        PoolBuffer block = buffer_pool_->allocate(req.size);
+        if (!block) {
+            report_request_error("cpu", "allocate", "Buffer pool exhausted", req, ENOMEM,
+                                 __FILE__, __LINE__, __func__);
+            req.status = RequestStatus::IoError;
+            req.errno_value = ENOMEM;
+            return;
+        }
+        req.dst = block.data();
+        execute_io(req);
+        if (req.status == RequestStatus::Ok) {
+            req.buffer = block.share(req.bytes_transferred);
+        }
+    }
 
-            if (io_bytes < 0) {
-                // I/O error: capture errno and mark the request as failed.
-                report_request_error("cpu",
-                                     req.op == RequestOp::Write ? "pwrite" : "pread",
-                                     "POSIX I/O failed",
-                                     req,
-                                     errno,
-                                     __FILE__,
-                                     __LINE__,
-                                     __func__);
-                req.status      = RequestStatus::IoError;
-                req.errno_value = errno;
-                req.bytes_transferred = 0;
-            } else {
-                // Successful read/write.
-                req.status      = RequestStatus::Ok;
-                req.errno_value = 0;
-                req.bytes_transferred = static_cast<std::size_t>(io_bytes);
-
-                if (req.op == RequestOp::Read) {
-                    // For safety in string-based demos: if we read fewer bytes
-                    // than the buffer size, zero-terminate.
-                    //
-                    // NOTE: This is *not* suitable as a general binary I/O
-                    // policy; callers should not rely on it for non-text data.
-                    if (static_cast<std::size_t>(io_bytes) < req.size) {
-                        auto* c = static_cast<char*>(req.dst);
-                        c[io_bytes] = '\0';
-                    }
+    /**
+     * @brief Check @p req's descriptor, size and buffers; reports and
+     * fails it if they cannot be used.
+     */
+    static bool validate(Request& req) {
+        // Validate the request before attempting any I/O.
+        if (req.fd < 0) {
+            report_request_error("cpu",
+                                 "submit",
+                                 "Invalid file descriptor",
+                                 req,
+                                 EBADF,
+                                 __FILE__,
+                                 __LINE__,
+                                 __func__);
+            req.status = RequestStatus::IoError;
+            req.errno_value = EBADF;
+            return false;
+        }
+
+        if (req.size == 0) {
+            report_request_error("cpu",
+                                 "submit",
+                                 "Zero-length request is not allowed",
+                                 req,
+                                 EINVAL,
+                                 __FILE__,
+                                 __LINE__,
+                                 __func__);
+            req.status = RequestStatus::IoError;
+            req.errno_value = EINVAL;
+            return false;
+        }
+
+        if (req.op == RequestOp::Read && req.dst == nullptr) {
+            report_request_error("cpu",
+                                 "submit",
+                                 "Read request missing destination buffer",
+                                 req,
+                                 EINVAL,
+                                 __FILE__,
+                                 __LINE__,
+                                 __func__);
+            req.status = RequestStatus::IoError;
+            req.errno_value = EINVAL;
+            return false;
+        }
+
+        if (req.op == RequestOp::Write && req.src == nullptr) {
+            report_request_error("cpu",
+                                 "submit",
+                                 "Write request missing source buffer",
+                                 req,
+                                 EINVAL,
+                                 __FILE__,
+                                 __LINE__,
+                                 __func__);
+            req.status = RequestStatus::IoError;
+            req.errno_value = EINVAL;
+            return false;
+        }
+
+        if ((req.op == RequestOp::Read && req.dst_memory == RequestMemory::Gpu) ||
+            (req.op == RequestOp::Write && req.src_memory == RequestMemory::Gpu)) {
+            report_request_error("cpu",
+                                 "submit",
+                                 "GPU memory requested on CPU backend",
+                                 req,
+                                 EINVAL,
+                                 __FILE__,
+                                 __LINE__,
+                                 __func__);
+            req.status = RequestStatus::IoError;
+            req.errno_value = EINVAL;
+            return false;
+        }
+        return true;
+    }
+
+    /**
+     * @brief Validate and execute @p req on the calling worker thread.
+     *
+     * Sets status, errno_value and bytes_transferred; never throws.
+     */
+    static void execute_io(Request& req) {
+        if (!validate(req)) {
+            return;
+        }
+
+        ssize_t io_bytes = 0;
+
+        if (req.op == RequestOp::Write) {
+            trace::Span span("cpu", "pwrite", req);
+            io_bytes = ::pwrite(
+                req.fd,
+                req.src,
+                req.size,
+                static_cast<off_t>(req.offset)
+            );
+        } else {
+            trace::Span span("cpu", "pread", req);
+            io_bytes = ::pread(
+                req.fd,
+                req.dst,
+                req.size,
+                static_cast<off_t>(req.offset)
+            );
+        }
+
+        if (io_bytes < 0) {
+            // I/O error: capture errno and mark the request as failed.
+            report_request_error("cpu",
+                                 req.op == RequestOp::Write ? "pwrite" : "pread",
+                                 "POSIX I/O failed",
+                                 req,
+                                 errno,
+                                 __FILE__,
+                                 __LINE__,
+                                 __func__);
+            req.status      = RequestStatus::IoError;
+            req.errno_value = errno;
+            req.bytes_transferred = 0;
+        } else {
+            // Successful read/write.
+            req.status      = RequestStatus::Ok;
+            req.errno_value = 0;
+            req.bytes_transferred = static_cast<std::size_t>(io_bytes);
+
+            if (req.op == RequestOp::Read) {
+                // For safety in string-based demos: if we read fewer bytes
+                // than the buffer size, zero-terminate.
+                //
+                // NOTE: This is *not* suitable as a general binary I/O
+                // policy; callers should not rely on it for non-text data.
+                if (static_cast<std::size_t>(io_bytes) < req.size) {
+                    auto* c = static_cast<char*>(req.dst);
+                    c[io_bytes] = '\0';
                 }
             }
+        }
 
-            // "Decompression" pass.
-            //
-            // In real DirectStorage-style pipelines, this would be a true
-            // codec (e.g., GDeflate) running on CPU or GPU. Here we handle
-            // different compression modes.
-            if (req.op == RequestOp::Read &&
-                req.status == RequestStatus::Ok) {
-
-                if (req.compression == Compression::FakeUppercase) {
-                    // Demo mode: uppercase ASCII characters for demonstration and testing.
-                    char* c = static_cast<char*>(req.dst);
-                    for (std::size_t i = 0; i < req.size && c[i] != '\0'; ++i) {
-                        c[i] = static_cast<char>(
-                            std::toupper(static_cast<unsigned char>(c[i]))
-                        );
-                    }
-                } else if (req.compression == Compression::GDeflate) {
-                    // GDeflate decompression requested but not yet implemented.
-                    // Report error via the error callback system.
-                    report_request_error(
-                        "cpu",
-                        "decompression",
-                        "GDeflate compression is not yet implemented (ENOTSUP)",
-                        req,
-                        ENOTSUP,
-                        __FILE__,
-                        __LINE__,
-                        __func__
+        // "Decompression" pass.
+        //
+        // In real DirectStorage-style pipelines, this would be a true
+        // codec (e.g., GDeflate) running on CPU or GPU. Here we handle
+        // different compression modes.
+        if (req.op == RequestOp::Read &&
+            req.status == RequestStatus::Ok &&
+            req.compression != Compression::None) {
+            trace::Span span("cpu", "decompress", req);
+
+            if (req.compression == Compression::FakeUppercase) {
+                // Demo mode: uppercase ASCII characters for demonstration and testing.
+                char* c = static_cast<char*>(req.dst);
+                for (std::size_t i = 0; i < req.size && c[i] != '\0'; ++i) {
+                    c[i] = static_cast<char>(
+                        std::toupper(static_cast<unsigned char>(c[i]))
                     );
-                    req.status = RequestStatus::IoError;
-                    req.errno_value = ENOTSUP;
-                    req.bytes_transferred = 0;
                 }
+            } else if (req.compression == Compression::GDeflate) {
+                // No block decoder configured (gdeflate_decoder); those
+                // reads never get here. Report via the error callback.
+                report_request_error(
+                    "cpu",
+                    "decompression",
+                    "GDeflate compression is not yet implemented (ENOTSUP)",
+                    req,
+                    ENOTSUP,
+                    __FILE__,
+                    __LINE__,
+                    __func__
+                );
+                req.status = RequestStatus::IoError;
+                req.errno_value = ENOTSUP;
+                req.bytes_transferred = 0;
             }
-
-            // Invoke completion callback.
-            //
-            // Note: this is called on a worker thread. Callers must ensure
-            // that any captured state is thread-safe.
-            if (on_complete) {
-                on_complete(req);
-            }
-        });
+        }
     }
 
-private:
-    ThreadPool pool_; ///< Worker pool used to execute I/O and post-processing work.
+    /// Indices into counters_.
+    enum Counter : std::size_t {
+        kSubmitted, kCompleted, kFailed, kBytes, kDecodeGroups, kDecodedBlocks,
+        kVerifiedBlocks, kChecksumFailures, kCounterCount
+    };
+
+    const std::shared_ptr<BufferPool> buffer_pool_; ///< Destination of Runtime reads.
+    const BlockDecoder decoder_;      ///< GDeflate codec; null fails GDeflate reads.
+    const std::size_t  split_bytes_;  ///< Least decoded bytes per block group.
+    const bool         verify_;       ///< Check CRC-32C of checksummed blocks.
+    detail::ShardedCounters<kCounterCount> counters_; ///< Per-thread request counters.
+    // Declared last so it is released first: the jobs it drains on stop
+    // still use the members above.
+    detail::ThreadPool pool_; ///< Worker pool used to execute I/O and post-processing work.
 };
 
 } // anonymous namespace
@@ -375,8 +576,17 @@ private:
  * @return Shared pointer to a new CpuBackend instance.
  */
 std::shared_ptr<Backend> make_cpu_backend(std::size_t worker_count) {
+    CpuBackendConfig config;
+    config.worker_count = worker_count;
+    return make_cpu_backend(config);
+}
+
+/**
+ * @brief Factory function for a CPU backend with explicit configuration.
+ */
+std::shared_ptr<Backend> make_cpu_backend(const CpuBackendConfig& config) {
     // Using std::make_shared keeps allocation overhead low.
-    return std::make_shared<CpuBackend>(worker_count);
+    return std::make_shared<CpuBackend>(config);
 }
 
 // -------------------------
@@ -387,8 +597,9 @@ std::shared_ptr<Backend> make_cpu_backend(std::size_t worker_count) {
  * @brief Internal implementation for ds::Queue.
  *
  * Responsibilities:
- *  - store enqueued Request objects until submission
- *  - hand them off to the Backend for execution
+ *  - store enqueued Request objects until submission (lock-free ring)
+ *  - hand them off to the Backend for execution, within in-flight caps
+ *  - release dependent requests and continuations as predecessors finish
  *  - track how many requests are currently in flight
  *  - provide a blocking wait_all() primitive
  *
@@ -396,86 +607,710 @@ std::shared_ptr<Backend> make_cpu_backend(std::size_t worker_count) {
  * interface in ds_runtime.hpp can remain small and stable.
  */
 struct Queue::Impl {
+    /// A request plus its dependency-graph id (0 when untracked) and an
+    /// optional intrusive completion hook.
+    struct ReadFlight;
+
+    struct PendingRequest {
+        Request         req;
+        RequestId       id = 0;
+        CompletionHook* hook = nullptr;
+        std::uint64_t   enqueue_ns = 0; ///< Set only while tracing.
+        ReadFlight*     flight = nullptr; ///< Set on the leader of deduplicated reads.
+    };
+
+    /// A read at the backend plus identical reads waiting for its result
+    /// (QueueConfig::deduplicate_reads). Owned by flights_.
+    struct ReadFlight {
+        detail::ReadKey             key;
+        RequestId                   id = 0;        ///< Leader's graph id.
+        CompletionHook*             hook = nullptr; ///< Leader's hook.
+        std::vector<PendingRequest> followers;
+    };
+
+    /// Dependency-graph node: a tracked request or a continuation.
+    ///
+    /// Nodes live in graph_ from creation until they complete. A node whose
+    /// predecessors have not all completed yet is "waiting" and holds its
+    /// request (or continuation) here instead of in the submission ring.
+    struct GraphNode {
+        std::size_t            unmet_deps = 0;     ///< Predecessors not yet completed.
+        bool                   any_failed = false; ///< A predecessor failed or was cancelled.
+        bool                   is_request = false; ///< Request node (else continuation).
+        Request                req;                ///< Held request while waiting.
+        Continuation           continuation;       ///< Continuation body.
+        std::vector<RequestId> dependents;         ///< Nodes waiting on this one.
+    };
+
     /**
      * @brief Construct a Queue::Impl with a given backend.
      *
      * @param backend  Backend used to execute submitted requests.
+     * @param config   Ring sizes and other tuning parameters.
      */
-    explicit Impl(std::shared_ptr<Backend> backend)
+    Impl(std::shared_ptr<Backend> backend, const QueueConfig& config)
         : backend_(std::move(backend))
+        , completion_mode_(config.completion_mode)
+        , pending_(config.submission_capacity)
+        , max_in_flight_requests_(config.max_in_flight_requests)
+        , max_in_flight_bytes_(config.max_in_flight_bytes)
+        , backpressure_mode_(config.backpressure_mode)
+        , capture_(config.capture)
+        , buffer_pool_(config.buffer_pool ? config.buffer_pool : default_buffer_pool())
+        , backend_buffers_(backend_->provides_buffers())
+        , deduplicate_reads_(config.deduplicate_reads)
+        , failed_id_window_(config.failed_id_window)
+        , completed_(config.completion_mode == CompletionMode::Retain
+                         ? config.completion_capacity : 2)
+        , records_(config.completion_mode == CompletionMode::Records
+                       ? config.completion_capacity : 2)
         , in_flight_(0)
-        , total_completed_(0)
-        , total_failed_(0)
-        , total_bytes_transferred_(0)
+        , created_ns_(detail::steady_now_ns())
     {}
 
-    /// Enqueue a request into the pending list.
+    /// Enqueue a request into the pending ring.
     ///
-    /// The Request object is moved into internal storage. The caller may
-    /// reuse or destroy their original Request instance after this call,
-    /// but must keep any referenced buffers (dst) alive until completion.
+    /// The common path is lock-free: producers claim a ring slot with a
+    /// single CAS. If the ring is full, the request spills into a
+    /// mutex-protected overflow list so enqueue() never fails.
     void enqueue(Request req) {
-        std::lock_guard<std::mutex> lock(mtx_);
-        pending_.push_back(std::move(req));
+        push_pending(PendingRequest{std::move(req), 0, nullptr});
     }
 
-    /// Submit all currently pending requests to the backend.
+    /// Enqueue a request whose completion is delivered only to @p hook.
+    void enqueue(Request req, CompletionHook* hook) {
+        push_pending(PendingRequest{std::move(req), 0, hook});
+    }
+
+    /// Push an entry into the submission ring, spilling on overflow.
+    void push_pending(PendingRequest pending) {
+        // Counted first so the drain side never overtakes it.
+        counters_.add(kEnqueued);
+        if (trace::enabled()) {
+            pending.enqueue_ns = trace::now_ns();
+        }
+        if (capture_) {
+            capture_->record(pending.req);
+        }
+        if (pending_.try_push(pending)) {
+            return;
+        }
+        std::lock_guard<std::mutex> lock(pending_overflow_mtx_);
+        pending_overflow_.push_back(std::move(pending));
+        has_pending_overflow_.store(true, std::memory_order_release);
+    }
+
+    /// Register a new graph node depending on @p after.
     ///
-    /// The requests are moved out of the pending_ vector under lock and then
-    /// submitted without holding mtx_, to avoid blocking other enqueue() calls
-    /// or backend internals.
-    void submit_all() {
-        std::vector<Request> to_submit;
+    /// Predecessors that are no longer in the graph have already completed
+    /// (ids are never reused): they count as satisfied, or set @p failed if
+    /// they are among the failures remembered by remember_failure(). Returns the new id and whether the node
+    /// must wait; a node that need not wait is not stored as waiting and the
+    /// caller dispatches it immediately (or cancels it if @p failed).
+    RequestId add_node(GraphNode node, const std::vector<RequestId>& after,
+                       bool& must_wait, bool& failed) {
+        const RequestId id = next_id_.fetch_add(1, std::memory_order_relaxed);
+        std::lock_guard<std::mutex> lock(graph_mtx_);
+        for (RequestId dep : after) {
+            auto it = graph_.find(dep);
+            if (it == graph_.end()) {
+                node.any_failed |= failed_nodes_.count(dep) != 0;
+                continue;
+            }
+            it->second.dependents.push_back(id);
+            ++node.unmet_deps;
+        }
+        must_wait = node.unmet_deps != 0;
+        failed = node.any_failed;
+        if (must_wait) {
+            graph_waiting_.fetch_add(1, std::memory_order_relaxed);
+            graph_.emplace(id, std::move(node));
+        } else if (node.is_request) {
+            // Ready now, but still trackable by later dependents.
+            graph_.emplace(id, GraphNode{});
+        }
+        return id;
+    }
 
-        {
-            // Move all pending requests into a local buffer so we can release
-            // the lock before calling into the backend.
-            std::lock_guard<std::mutex> lock(mtx_);
-            to_submit.swap(pending_);
-        }
-
-        for (auto& req : to_submit) {
-            // Mark this request as in flight. Relaxed ordering is sufficient
-            // for the increment; we use stronger ordering on decrement/loads
-            // where we synchronize with wait_all().
-            in_flight_.fetch_add(1, std::memory_order_relaxed);
-
-            backend_->submit(
-                std::move(req),
-                [this](Request& completed_req) {
-                    // Completion callback runs on a worker thread owned by
-                    // the backend. For now we:
-                    //  - stash the completed Request for potential future use
-                    //  - update the in-flight count and notify waiters.
-                    {
-                        std::lock_guard<std::mutex> lock(mtx_);
-                        completed_.push_back(completed_req);
+    /// Enqueue a request that takes part in dependency tracking.
+    RequestId enqueue_tracked(Request req, const std::vector<RequestId>& after) {
+        GraphNode node;
+        node.is_request = true;
+        node.req = req;
+        bool must_wait = false;
+        bool failed = false;
+        const RequestId id = add_node(std::move(node), after, must_wait, failed);
+        if (must_wait) {
+            return id;
+        }
+        if (failed) {
+            cancel_released(std::move(req), id);
+        } else {
+            push_pending(PendingRequest{std::move(req), id, nullptr});
+        }
+        return id;
+    }
+
+    /// Register a continuation; runs inline if @p after are all complete.
+    RequestId then(const std::vector<RequestId>& after, Continuation fn) {
+        GraphNode node;
+        node.continuation = fn;
+        bool must_wait = false;
+        bool failed = false;
+        const RequestId id = add_node(std::move(node), after, must_wait, failed);
+        if (!must_wait) {
+            if (fn) {
+                fn(*owner_, !failed);
+            }
+            // Submit what the continuation enqueued, as complete_node()
+            // does on the worker path.
+            try_submit_all();
+        }
+        return id;
+    }
+
+    /// Mark graph node @p id complete and release ready dependents.
+    ///
+    /// Ready request nodes go into the submission ring (or are cancelled if
+    /// a predecessor failed). Ready continuations run on this thread, and
+    /// their own completion cascades iteratively. Anything that became
+    /// submittable is pushed to the backend before returning.
+    void complete_node(RequestId id, bool ok) {
+        std::vector<std::pair<RequestId, bool>> done{{id, ok}};
+        bool released_requests = false;
+
+        while (!done.empty()) {
+            const auto [done_id, done_ok] = done.back();
+            done.pop_back();
+
+            std::vector<std::pair<RequestId, GraphNode>> ready;
+            {
+                std::lock_guard<std::mutex> lock(graph_mtx_);
+                auto it = graph_.find(done_id);
+                if (it == graph_.end()) {
+                    continue;
+                }
+                const std::vector<RequestId> dependents =
+                    std::move(it->second.dependents);
+                graph_.erase(it);
+                if (!done_ok) {
+                    remember_failure(done_id);
+                }
+
+                for (RequestId dep_id : dependents) {
+                    auto dep = graph_.find(dep_id);
+                    if (dep == graph_.end()) {
+                        continue;
                     }
+                    dep->second.any_failed |= !done_ok;
+                    if (--dep->second.unmet_deps == 0) {
+                        // Hand the payload out but keep the entry (and any
+                        // dependents) addressable until the node finishes.
+                        GraphNode released = std::move(dep->second);
+                        dep->second = GraphNode{};
+                        dep->second.dependents = std::move(released.dependents);
+                        ready.emplace_back(dep_id, std::move(released));
+                    }
+                }
+            }
 
-                    total_completed_.fetch_add(1, std::memory_order_relaxed);
-                    if (completed_req.status != RequestStatus::Ok) {
-                        total_failed_.fetch_add(1, std::memory_order_relaxed);
+            for (auto& [ready_id, node] : ready) {
+                if (node.is_request) {
+                    if (node.any_failed) {
+                        cancel_released(std::move(node.req), ready_id);
+                    } else {
+                        push_pending(PendingRequest{std::move(node.req), ready_id, nullptr});
+                        released_requests = true;
                     }
-                    total_bytes_transferred_.fetch_add(
-                        completed_req.bytes_transferred,
-                        std::memory_order_relaxed
+                } else {
+                    if (node.continuation) {
+                        node.continuation(*owner_, !node.any_failed);
+                    }
+                    released_requests = true; // It may have enqueued work.
+                    done.emplace_back(ready_id, true);
+                }
+                graph_waiting_.fetch_sub(1, std::memory_order_acq_rel);
+            }
+        }
+
+        if (released_requests) {
+            try_submit_all();
+        }
+    }
+
+    /// Record that graph node @p id failed, for dependents added after it
+    /// has left graph_. Called with graph_mtx_ held.
+    ///
+    /// Only the last failed_id_window_ failures are kept, so a queue that
+    /// runs for hours with a steady trickle of failures stays bounded. The
+    /// oldest is dropped first.
+    void remember_failure(RequestId id) {
+        if (failed_id_window_ == 0) {
+            return;
+        }
+        failed_nodes_.insert(id);
+        failed_order_.push_back(id);
+        if (failed_order_.size() > failed_id_window_) {
+            failed_nodes_.erase(failed_order_.front());
+            failed_order_.pop_front();
+        }
+    }
+
+    /// Complete a released request as Cancelled without touching the
+    /// backend (a predecessor failed). Goes through the normal completion
+    /// path so callers observe it like any other completion.
+    void cancel_released(Request req, RequestId id) {
+        req.status = RequestStatus::Cancelled;
+        req.errno_value = ECANCELED;
+        req.bytes_transferred = 0;
+        in_flight_.fetch_add(1, std::memory_order_relaxed);
+        in_flight_bytes_.fetch_add(req.size, std::memory_order_relaxed);
+        outstanding_.fetch_add(1, std::memory_order_relaxed);
+        on_complete(req, id, nullptr);
+    }
+
+    /// Submit pending requests to the backend, respecting in-flight caps.
+    ///
+    /// Requests are drained from the ring (and any overflow) into the staged
+    /// list, then as many as fit under the caps are handed to the backend.
+    /// In BackpressureMode::Block this waits until every staged request has
+    /// been submitted; otherwise the remainder is submitted from completion
+    /// context as capacity frees up.
+    void submit_all() {
+        const std::size_t held_back = try_submit_all();
+        if (held_back == 0 || backpressure_mode_ != BackpressureMode::Block) {
+            return;
+        }
+
+        waiters_.fetch_add(1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        {
+            std::unique_lock<std::mutex> lock(wait_mtx_);
+            wait_cv_.wait(lock, [this] {
+                return staged_count_.load(std::memory_order_acquire) == 0;
+            });
+        }
+        waiters_.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    /// Submit whatever fits under the caps without blocking.
+    ///
+    /// Returns the number of requests still held back waiting for capacity.
+    std::size_t try_submit_all() {
+        {
+            std::lock_guard<std::mutex> lock(submit_mtx_);
+            const std::size_t before = staged_.size();
+            PendingRequest pending;
+            while (pending_.try_pop(pending)) {
+                staged_.push_back(std::move(pending));
+            }
+            if (has_pending_overflow_.load(std::memory_order_acquire)) {
+                std::lock_guard<std::mutex> overflow_lock(pending_overflow_mtx_);
+                for (auto& spilled : pending_overflow_) {
+                    staged_.push_back(std::move(spilled));
+                }
+                pending_overflow_.clear();
+                has_pending_overflow_.store(false, std::memory_order_release);
+            }
+            drained_.fetch_add(staged_.size() - before, std::memory_order_relaxed);
+            staged_count_.store(staged_.size(), std::memory_order_release);
+        }
+
+        pump();
+        return staged_count_.load(std::memory_order_acquire);
+    }
+
+    /// True if @p req may be submitted now without exceeding the caps.
+    ///
+    /// Called with submit_mtx_ held. Completions only ever lower the
+    /// in-flight counters, so a positive answer cannot be invalidated
+    /// before the caller reserves capacity. An idle queue always admits
+    /// one request so that an oversized request still makes progress.
+    bool fits(const Request& req) const {
+        const std::size_t count = in_flight_.load(std::memory_order_acquire);
+        if (count == 0) {
+            return true;
+        }
+        if (max_in_flight_requests_ != 0 && count >= max_in_flight_requests_) {
+            return false;
+        }
+        if (max_in_flight_bytes_ != 0 &&
+            in_flight_bytes_.load(std::memory_order_acquire) + req.size >
+                max_in_flight_bytes_) {
+            return false;
+        }
+        return true;
+    }
+
+    /// Move staged requests that fit under the caps to the backend.
+    ///
+    /// Only one thread pumps at a time. Callers that find a pump already
+    /// running (including completions that fire inline from within
+    /// backend->submit()) leave a request behind and the active pump loops
+    /// again, so capacity freed concurrently is never missed.
+    void pump() {
+        pump_requests_.fetch_add(1);
+        if (pumping_.exchange(true)) {
+            return;
+        }
+
+        for (;;) {
+            pump_requests_.store(0);
+
+            std::vector<PendingRequest> batch;
+            bool drained = false;
+            {
+                std::lock_guard<std::mutex> lock(submit_mtx_);
+                while (!staged_.empty() && fits(staged_.front().req)) {
+                    // Reserve capacity before releasing the lock. Relaxed
+                    // ordering is sufficient for the increment; we use
+                    // stronger ordering on decrement/loads where we
+                    // synchronize with wait_all().
+                    in_flight_.fetch_add(1, std::memory_order_relaxed);
+                    in_flight_bytes_.fetch_add(staged_.front().req.size,
+                                               std::memory_order_relaxed);
+                    outstanding_.fetch_add(1, std::memory_order_relaxed);
+                    batch.push_back(std::move(staged_.front()));
+                    staged_.pop_front();
+                }
+                staged_count_.store(staged_.size(), std::memory_order_release);
+                // Only requests an earlier pass left behind for lack of
+                // capacity count; a batch that fits at once is not a drain.
+                drained = cap_held_back_ && staged_.empty();
+                cap_held_back_ = !staged_.empty();
+                if (!batch.empty()) {
+                    detail::update_peak(peak_in_flight_,
+                                        in_flight_.load(std::memory_order_relaxed));
+                }
+            }
+
+            const std::uint64_t submit_ns = batch.empty() ? 0 : detail::steady_now_ns();
+            for (auto& pending : batch) {
+                pending.req.submit_time_ns = submit_ns;
+                pending.req.start_time_ns = 0;
+                if (pending.enqueue_ns != 0) {
+                    trace::record("queue", "pending", pending.enqueue_ns, submit_ns,
+                                  pending.req);
+                }
+            }
+            if (deduplicate_reads_ && !batch.empty()) {
+                join_flights(batch);
+            }
+            if (!batch.empty()) {
+                counters_.add(kSubmitted, batch.size());
+            }
+            for (auto& pending : batch) {
+                if (!attach_buffer(pending)) {
+                    continue;
+                }
+                // Capture at most two words so std::function stores the
+                // callback inline instead of allocating per request.
+                if (pending.flight != nullptr) {
+                    ReadFlight* flight = pending.flight;
+                    backend_->submit(
+                        std::move(pending.req),
+                        [this, flight](Request& completed_req) {
+                            finish_flight(completed_req, flight);
+                        }
+                    );
+                    continue;
+                }
+                if (pending.hook != nullptr) {
+                    CompletionHook* hook = pending.hook;
+                    backend_->submit(
+                        std::move(pending.req),
+                        [this, hook](Request& completed_req) {
+                            on_complete(completed_req, 0, hook);
+                        }
                     );
+                    continue;
+                }
 
-                    const auto remaining =
-                        in_flight_.fetch_sub(1, std::memory_order_acq_rel) - 1;
+                const RequestId id = pending.id;
+                backend_->submit(
+                    std::move(pending.req),
+                    [this, id](Request& completed_req) {
+                        // Completion callback runs on a worker thread owned
+                        // by the backend. We:
+                        //  - stash the completion for take_completed() or
+                        //    poll_completions()
+                        //  - release dependents in the graph
+                        //  - release capacity, pump held-back requests,
+                        //    and notify waiters.
+                        on_complete(completed_req, id, nullptr);
+                    }
+                );
+            }
+
+            if (drained) {
+                BackpressureCallback callback;
+                {
+                    std::lock_guard<std::mutex> lock(backpressure_cb_mtx_);
+                    callback = backpressure_cb_;
+                }
+                if (callback) {
+                    callback();
+                }
+            }
+
+            // Sequentially consistent: a thread that saw pumping_ == true
+            // must have its request observed by the load below.
+            pumping_.store(false);
+            if (pump_requests_.load() == 0 || pumping_.exchange(true)) {
+                return;
+            }
+        }
+    }
 
-                    // If this was the last in-flight request, wake any
-                    // threads blocked in wait_all().
-                    if (remaining == 0) {
-                        std::lock_guard<std::mutex> lock(wait_mtx_);
-                        wait_cv_.notify_all();
+    /// True if @p req reads into runtime-owned memory.
+    static bool is_runtime_read(const Request& req) {
+        return req.op == RequestOp::Read && req.dst_memory == RequestMemory::Runtime;
+    }
+
+    /// Give a RequestMemory::Runtime read a pool block to land in, unless
+    /// the backend provides buffers itself.
+    ///
+    /// Called from pump() after capacity was reserved. On allocation
+    /// failure the request completes with ENOMEM through the normal
+    /// completion path and false is returned.
+    bool attach_buffer(PendingRequest& pending) {
+        Request& req = pending.req;
+        if (!is_runtime_read(req) || backend_buffers_) {
+            return true;
+        }
+        PoolBuffer block = buffer_pool_->allocate(req.size);
+        if (!block) {
+            report_request_error("queue", "allocate", "Buffer pool exhausted", req, ENOMEM,
+                                 __FILE__, __LINE__, __func__);
+            req.status = RequestStatus::IoError;
+            req.errno_value = ENOMEM;
+            req.bytes_transferred = 0;
+            if (pending.flight != nullptr) {
+                finish_flight(req, pending.flight);
+            } else {
+                on_complete(req, pending.id, pending.hook);
+            }
+            return false;
+        }
+        req.dst = block.data();
+        req.buffer = block.share(req.size);
+        return true;
+    }
+
+    /// Attach reads in @p batch that duplicate a read already in flight
+    /// (or an earlier one in the batch) to that read, removing them from
+    /// the batch. The remaining shareable reads become flight leaders.
+    ///
+    /// Followers keep the in-flight capacity reserved for them and complete
+    /// from the leader's result in finish_flight().
+    void join_flights(std::vector<PendingRequest>& batch) {
+        // Keys need an fstat() each; take them before flights_mtx_ so the
+        // lock covers only the map.
+        std::vector<std::optional<detail::ReadKey>> keys(batch.size());
+        for (std::size_t i = 0; i < batch.size(); ++i) {
+            detail::ReadKey key;
+            if (detail::is_shareable_read(batch[i].req) &&
+                detail::make_read_key(batch[i].req, key)) {
+                keys[i] = key;
+            }
+        }
+
+        std::size_t kept = 0;
+        std::uint64_t joined = 0;
+        {
+            std::lock_guard<std::mutex> lock(flights_mtx_);
+            for (std::size_t i = 0; i < batch.size(); ++i) {
+                PendingRequest& pending = batch[i];
+                if (keys[i]) {
+                    const detail::ReadKey& key = *keys[i];
+                    auto [it, leader] = flights_.try_emplace(key);
+                    if (!leader) {
+                        it->second->followers.push_back(std::move(pending));
+                        ++joined;
+                        continue;
                     }
+                    it->second = std::make_unique<ReadFlight>();
+                    it->second->key = key;
+                    it->second->id = pending.id;
+                    it->second->hook = pending.hook;
+                    pending.flight = it->second.get();
                 }
-            );
+                if (&batch[kept] != &pending) {
+                    batch[kept] = std::move(pending);
+                }
+                ++kept;
+            }
+        }
+        batch.resize(kept);
+        if (joined != 0) {
+            counters_.add(kDeduplicated, joined);
+        }
+    }
+
+    /// Complete a flight leader and every read that joined it.
+    ///
+    /// Followers get the leader's status and a copy of its bytes (or, for
+    /// Runtime reads, a share of its buffer) before the leader completes,
+    /// since the leader's dst belongs to its caller once it has.
+    void finish_flight(Request& leader, ReadFlight* flight) {
+        std::unique_ptr<ReadFlight> owned;
+        {
+            std::lock_guard<std::mutex> lock(flights_mtx_);
+            const auto it = flights_.find(flight->key);
+            owned = std::move(it->second);
+            flights_.erase(it);
+        }
+        for (auto& follower : owned->followers) {
+            share_result(leader, follower.req);
+        }
+        on_complete(leader, owned->id, owned->hook);
+        // Each follower still holds its outstanding_ slot, so *this stays
+        // alive until the last of these returns.
+        for (auto& follower : owned->followers) {
+            on_complete(follower.req, follower.id, follower.hook);
+        }
+    }
+
+    /// Give @p follower the outcome of the identical read @p leader.
+    void share_result(const Request& leader, Request& follower) {
+        follower.status = leader.status;
+        follower.errno_value = leader.errno_value;
+        follower.start_time_ns = leader.start_time_ns;
+        follower.bytes_transferred = 0;
+        if (leader.status != RequestStatus::Ok) {
+            return;
+        }
+
+        const std::size_t bytes = leader.bytes_transferred;
+        const void* source = is_runtime_read(leader)
+            ? static_cast<const void*>(leader.buffer.data()) : leader.dst;
+        if (!is_runtime_read(follower)) {
+            if (bytes != 0) {
+                std::memcpy(follower.dst, source, bytes);
+            }
+        } else if (is_runtime_read(leader)) {
+            follower.buffer = leader.buffer.subview(0, bytes);
+        } else {
+            PoolBuffer block = buffer_pool_->allocate(bytes);
+            if (!block) {
+                report_request_error("queue", "allocate", "Buffer pool exhausted", follower,
+                                     ENOMEM, __FILE__, __LINE__, __func__);
+                follower.status = RequestStatus::IoError;
+                follower.errno_value = ENOMEM;
+                return;
+            }
+            if (bytes != 0) {
+                std::memcpy(block.data(), source, bytes);
+            }
+            follower.buffer = block.share(bytes);
         }
+        follower.bytes_transferred = bytes;
     }
 
-    /// Block until all in-flight requests have completed.
+    /// Trim a completed Runtime read's view to the bytes actually read, or
+    /// drop it if the read failed. dst is cleared: the data is only
+    /// reachable (read-only) through the view.
+    static void finish_buffer(Request& req) {
+        if (req.status != RequestStatus::Ok) {
+            req.buffer.reset();
+        } else if (req.buffer.size() > req.bytes_transferred) {
+            req.buffer = req.buffer.subview(0, req.bytes_transferred);
+        }
+        req.dst = nullptr;
+    }
+
+    /// Install the callback fired when held-back requests finish draining.
+    void set_backpressure_callback(BackpressureCallback callback) {
+        std::lock_guard<std::mutex> lock(backpressure_cb_mtx_);
+        backpressure_cb_ = std::move(callback);
+    }
+
+    /// Record a completed request and release its in-flight slot.
+    ///
+    /// Runs on backend worker threads. Depending on the completion mode, the
+    /// full Request or a compact CompletionRecord is pushed into a lock-free
+    /// channel; only when that channel is full do we fall back to an
+    /// overflow list under a mutex. Requests with a hook are delivered to
+    /// the hook instead.
+    void on_complete(Request& completed_req, RequestId id, CompletionHook* hook) {
+        trace::Span span("queue", "complete", completed_req);
+        record_stats(completed_req);
+        if (is_runtime_read(completed_req)) {
+            finish_buffer(completed_req);
+        }
+
+        if (hook != nullptr) {
+            // Delivered below, once the queue's own bookkeeping is done.
+        } else if (completion_mode_ == CompletionMode::Records) {
+            CompletionRecord record;
+            record.user_tag = completed_req.user_tag;
+            record.status = completed_req.status;
+            record.errno_value = completed_req.errno_value;
+            record.bytes_transferred = completed_req.bytes_transferred;
+            record.buffer = std::move(completed_req.buffer);
+            if (!records_.try_push(record)) {
+                std::lock_guard<std::mutex> lock(completed_overflow_mtx_);
+                records_overflow_.push_back(std::move(record));
+                has_records_overflow_.store(true, std::memory_order_release);
+            }
+        } else if (!completed_.try_push(completed_req)) {
+            std::lock_guard<std::mutex> lock(completed_overflow_mtx_);
+            completed_overflow_.push_back(std::move(completed_req));
+        }
+
+        in_flight_bytes_.fetch_sub(completed_req.size, std::memory_order_relaxed);
+        in_flight_.fetch_sub(1, std::memory_order_acq_rel);
+
+        // Tracked requests may unblock dependents. This runs while we still
+        // hold our outstanding_ slot, so wait_all() cannot return between
+        // a predecessor finishing and its dependents being released.
+        if (id != 0) {
+            complete_node(id, completed_req.status == RequestStatus::Ok);
+        }
+
+        // Freed capacity: hand held-back requests to the backend.
+        if (staged_count_.load(std::memory_order_acquire) != 0) {
+            pump();
+        }
+
+        if (hook != nullptr) {
+            hook->on_request_complete(completed_req);
+        }
+
+        // Pairs with the fence taken by blocking waiters: either the waiter
+        // observes our state change, or we observe its registration.
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+
+        // Wake threads blocked in wait_completions()/submit_all()/wait().
+        if (waiters_.load(std::memory_order_relaxed) != 0) {
+            std::lock_guard<std::mutex> lock(wait_mtx_);
+            wait_cv_.notify_all();
+        }
+
+        release_outstanding();
+    }
+
+    /// Drop this completion from outstanding_ and wake wait_all() if it was
+    /// the last one. This must be the final access to *this on the
+    /// completion path: once wait_all() observes zero, the owner may
+    /// destroy the queue. The final decrement therefore happens under
+    /// wait_mtx_ so wait_all() cannot see zero before we are done.
+    void release_outstanding() {
+        std::size_t current = outstanding_.load(std::memory_order_acquire);
+        while (current > 1) {
+            if (outstanding_.compare_exchange_weak(current, current - 1,
+                                                   std::memory_order_acq_rel)) {
+                return;
+            }
+        }
+
+        std::lock_guard<std::mutex> lock(wait_mtx_);
+        if (outstanding_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            wait_cv_.notify_all();
+        }
+    }
+
+    /// Block until all in-flight (and held-back) requests have completed.
     ///
     /// This does not prevent new submissions from racing in from other
     /// threads; it only guarantees that at the moment of return, there
@@ -483,7 +1318,12 @@ struct Queue::Impl {
     void wait_all() {
         std::unique_lock<std::mutex> lock(wait_mtx_);
         wait_cv_.wait(lock, [this] {
-            return in_flight_.load(std::memory_order_acquire) == 0;
+            // Staged requests are moved to outstanding under submit_mtx_
+            // before staged_count_ drops, so both can't read zero while work
+            // remains.
+            return staged_count_.load(std::memory_order_acquire) == 0 &&
+                   outstanding_.load(std::memory_order_acquire) == 0 &&
+                   graph_waiting_.load(std::memory_order_acquire) == 0;
         });
     }
 
@@ -495,32 +1335,289 @@ struct Queue::Impl {
         return in_flight_.load(std::memory_order_acquire);
     }
 
+    /// Snapshot of the bytes currently in flight.
+    std::size_t in_flight_bytes() const {
+        return in_flight_bytes_.load(std::memory_order_acquire);
+    }
+
+    /// Snapshot of requests held back by the in-flight caps.
+    std::size_t held_back() const {
+        return staged_count_.load(std::memory_order_acquire);
+    }
+
+    /// Update counters and latency histograms for a finished request.
+    ///
+    /// Runs on backend worker threads; everything lands in the calling
+    /// thread's shard, so concurrent completions do not contend.
+    void record_stats(const Request& req) {
+        counters_.add(kCompleted);
+        if (req.status != RequestStatus::Ok) {
+            counters_.add(kFailed);
+        }
+        counters_.add(kBytes, req.bytes_transferred);
+        counters_.add(req.op == RequestOp::Write ? kWrites : kReads);
+        counters_.add(kByCompression + static_cast<std::size_t>(req.compression));
+
+        // Cancelled requests never reached the backend and carry no times.
+        if (req.submit_time_ns == 0) {
+            return;
+        }
+        const std::uint64_t now = detail::steady_now_ns();
+        std::uint64_t start = req.submit_time_ns;
+        if (req.start_time_ns >= req.submit_time_ns) {
+            start = req.start_time_ns;
+            submit_to_start_.record(start - req.submit_time_ns);
+        }
+        start_to_complete_.record(now >= start ? now - start : 0);
+    }
+
+    /// Assemble a QueueStats snapshot without taking submit_mtx_.
+    QueueStats stats() const {
+        QueueStats out;
+        out.elapsed = std::chrono::nanoseconds(detail::steady_now_ns() - created_ns_);
+
+        const std::uint64_t enqueued = counters_.read(kEnqueued);
+        const std::uint64_t drained = drained_.load(std::memory_order_relaxed);
+        out.pending = enqueued > drained ? static_cast<std::size_t>(enqueued - drained) : 0;
+        out.held_back = staged_count_.load(std::memory_order_acquire);
+        out.in_flight = in_flight_.load(std::memory_order_acquire);
+        out.in_flight_bytes = in_flight_bytes_.load(std::memory_order_acquire);
+        out.peak_in_flight = static_cast<std::size_t>(
+            peak_in_flight_.load(std::memory_order_relaxed));
+
+        out.submitted = counters_.read(kSubmitted);
+        out.deduplicated = counters_.read(kDeduplicated);
+        out.completed = counters_.read(kCompleted);
+        out.failed = counters_.read(kFailed);
+        out.bytes_transferred = counters_.read(kBytes);
+        out.completed_by_op[static_cast<std::size_t>(RequestOp::Read)] = counters_.read(kReads);
+        out.completed_by_op[static_cast<std::size_t>(RequestOp::Write)] = counters_.read(kWrites);
+        for (std::size_t i = 0; i < out.completed_by_compression.size(); ++i) {
+            out.completed_by_compression[i] = counters_.read(kByCompression + i);
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(graph_mtx_);
+            out.remembered_failures = failed_nodes_.size();
+        }
+
+        out.submit_to_start = submit_to_start_.snapshot();
+        out.start_to_complete = start_to_complete_.snapshot();
+        out.backend = backend_->stats();
+        return out;
+    }
+
+    /// True if graph node @p id has completed (or is not a live node).
+    ///
+    /// Ids are handed out in increasing order and nodes leave graph_ only
+    /// when they complete, so an issued id that is not in graph_ is done.
+    bool is_complete(RequestId id) const {
+        if (id >= next_id_.load(std::memory_order_acquire)) {
+            return false;
+        }
+        std::lock_guard<std::mutex> lock(graph_mtx_);
+        return graph_.find(id) == graph_.end();
+    }
+
+    /// Index of the first completed id in @p ids, or ids.size() if none.
+    std::size_t first_complete(const std::vector<RequestId>& ids) const {
+        for (std::size_t i = 0; i < ids.size(); ++i) {
+            if (is_complete(ids[i])) {
+                return i;
+            }
+        }
+        return ids.size();
+    }
+
+    /// Block until one of @p ids completes or @p timeout elapses.
+    ///
+    /// A negative timeout, or one too large to add to the clock (such as
+    /// nanoseconds::max()), waits indefinitely. Returns the index of a
+    /// completed id, or ids.size() on timeout (or if @p ids is empty).
+    std::size_t wait_any_for(const std::vector<RequestId>& ids,
+                             std::chrono::nanoseconds timeout) {
+        std::size_t index = first_complete(ids);
+        if (index < ids.size() || ids.empty() ||
+            timeout == std::chrono::nanoseconds::zero()) {
+            return index;
+        }
+
+        waiters_.fetch_add(1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        {
+            std::unique_lock<std::mutex> lock(wait_mtx_);
+            auto ready = [&] {
+                index = first_complete(ids);
+                return index < ids.size();
+            };
+            // wait_for() adds the timeout to now() and would overflow, so
+            // compute the deadline here and check the headroom first.
+            const auto now = std::chrono::steady_clock::now();
+            if (timeout < std::chrono::nanoseconds::zero() ||
+                timeout >= std::chrono::steady_clock::time_point::max() - now) {
+                wait_cv_.wait(lock, ready);
+            } else {
+                wait_cv_.wait_until(
+                    lock,
+                    now + std::chrono::duration_cast<std::chrono::steady_clock::duration>(timeout),
+                    ready);
+            }
+        }
+        waiters_.fetch_sub(1, std::memory_order_relaxed);
+        return index;
+    }
+
     /// Retrieve and clear the list of completed requests.
     ///
     /// This returns a snapshot of completed requests accumulated since the
     /// last call. The caller can inspect status, bytes_transferred, etc.
     std::vector<Request> take_completed() {
-        std::lock_guard<std::mutex> lock(mtx_);
         std::vector<Request> result;
-        result.swap(completed_);
+        {
+            std::lock_guard<std::mutex> lock(completed_overflow_mtx_);
+            result.swap(completed_overflow_);
+        }
+        Request req;
+        while (completed_.try_pop(req)) {
+            result.push_back(std::move(req));
+        }
         return result;
     }
 
-    // (Optional) You could expose access to completed_ later to let users
-    // inspect statuses, aggregate stats, etc.
+    /// Copy up to @p max completion records into @p out without blocking.
+    ///
+    /// Spilled records (if any) are drained before the ring so that the
+    /// overflow list cannot grow without bound under sustained load.
+    std::size_t poll_completions(CompletionRecord* out, std::size_t max) {
+        std::size_t count = 0;
+        if (max == 0 || out == nullptr) {
+            return 0;
+        }
+
+        if (has_records_overflow_.load(std::memory_order_acquire)) {
+            std::lock_guard<std::mutex> lock(completed_overflow_mtx_);
+            std::size_t taken = 0;
+            while (taken < records_overflow_.size() && count < max) {
+                out[count++] = std::move(records_overflow_[taken++]);
+            }
+            records_overflow_.erase(records_overflow_.begin(),
+                                    records_overflow_.begin() +
+                                        static_cast<std::ptrdiff_t>(taken));
+            has_records_overflow_.store(!records_overflow_.empty(),
+                                        std::memory_order_release);
+        }
+
+        while (count < max && records_.try_pop(out[count])) {
+            ++count;
+        }
+        return count;
+    }
+
+    /// Block until @p min_count records are available or the queue has
+    /// nothing left in flight, then copy up to @p max of them.
+    std::size_t wait_completions(CompletionRecord* out,
+                                 std::size_t max,
+                                 std::size_t min_count) {
+        if (min_count > max) {
+            min_count = max;
+        }
+
+        std::size_t count = poll_completions(out, max);
+        if (count >= min_count) {
+            return count;
+        }
+
+        waiters_.fetch_add(1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        {
+            std::unique_lock<std::mutex> lock(wait_mtx_);
+            wait_cv_.wait(lock, [&] {
+                count += poll_completions(out + count, max - count);
+                return count >= min_count ||
+                       (staged_count_.load(std::memory_order_acquire) == 0 &&
+                        outstanding_.load(std::memory_order_acquire) == 0 &&
+                        graph_waiting_.load(std::memory_order_acquire) == 0);
+            });
+        }
+        waiters_.fetch_sub(1, std::memory_order_relaxed);
+
+        // Completions that raced with the final in-flight decrement.
+        count += poll_completions(out + count, max - count);
+        return count;
+    }
+
     std::shared_ptr<Backend> backend_;   ///< Backend used to execute submitted requests.
+    const CompletionMode     completion_mode_; ///< Retain full Requests or emit CompletionRecords.
 
-    mutable std::mutex       mtx_;       ///< Protects pending_ and completed_.
-    std::vector<Request>     pending_;   ///< Requests enqueued but not yet submitted.
-    std::vector<Request>     completed_; ///< Requests that have completed (not yet surfaced).
+    Queue*                   owner_ = nullptr; ///< Public Queue, passed to continuations.
+
+    detail::BoundedRing<PendingRequest> pending_; ///< Lock-free ring of requests enqueued but not yet submitted.
+    std::mutex               pending_overflow_mtx_;  ///< Protects pending_overflow_.
+    std::vector<PendingRequest> pending_overflow_;   ///< Requests that did not fit in pending_.
+    std::atomic<bool>        has_pending_overflow_{false}; ///< Fast check before taking the overflow lock.
+
+    const std::size_t        max_in_flight_requests_; ///< Request cap (0 = unlimited).
+    const std::size_t        max_in_flight_bytes_;    ///< Byte cap (0 = unlimited).
+    const BackpressureMode   backpressure_mode_;      ///< Whether submit_all() blocks on the caps.
+    const std::shared_ptr<RequestCapture> capture_;   ///< Request recorder, or null.
+    const std::shared_ptr<BufferPool> buffer_pool_;   ///< Source of RequestMemory::Runtime buffers.
+    const bool               backend_buffers_;        ///< Backend fills Request::buffer itself.
+    const bool               deduplicate_reads_;      ///< QueueConfig::deduplicate_reads.
+    std::mutex               flights_mtx_;            ///< Protects flights_.
+    std::unordered_map<detail::ReadKey, std::unique_ptr<ReadFlight>, detail::ReadKeyHash>
+                             flights_;                ///< Deduplicated reads at the backend.
+    std::mutex               submit_mtx_;    ///< Protects staged_ and capacity reservation.
+    std::deque<PendingRequest> staged_;      ///< Drained from pending_ but held back by the caps.
+    bool                     cap_held_back_ = false; ///< Last pump left staged_ non-empty (submit_mtx_).
+    std::atomic<std::size_t> staged_count_{0}; ///< staged_.size(), readable without submit_mtx_.
+    std::atomic<std::size_t> pump_requests_{0}; ///< Pump requests since the active pump last looked.
+    std::atomic<bool>        pumping_{false};   ///< True while a thread is running pump().
+    mutable std::mutex       graph_mtx_;     ///< Protects graph_, failed_nodes_ and failed_order_.
+    std::unordered_map<RequestId, GraphNode> graph_; ///< Tracked nodes that have not completed.
+    std::unordered_set<RequestId> failed_nodes_; ///< Recently failed or cancelled nodes.
+    std::deque<RequestId>    failed_order_;  ///< failed_nodes_ in failure order, oldest first.
+    const std::size_t        failed_id_window_; ///< Most failures failed_nodes_ holds.
+    std::atomic<RequestId>   next_id_{1};    ///< Next graph id; ids are never reused.
+    std::atomic<std::size_t> graph_waiting_{0}; ///< Nodes held in graph_ waiting on predecessors.
+
+    std::mutex               backpressure_cb_mtx_; ///< Protects backpressure_cb_.
+    BackpressureCallback     backpressure_cb_;     ///< Fired when held-back requests drain.
+
+    detail::BoundedRing<Request> completed_; ///< Lock-free channel of completed requests (Retain mode).
+    detail::BoundedRing<CompletionRecord> records_; ///< Lock-free completion records (Records mode).
+    std::mutex               completed_overflow_mtx_; ///< Protects both overflow lists below.
+    std::vector<Request>     completed_overflow_;     ///< Completions that did not fit in completed_.
+    std::vector<CompletionRecord> records_overflow_;  ///< Records that did not fit in records_.
+    std::atomic<bool>        has_records_overflow_{false}; ///< Fast check before taking the overflow lock.
 
     std::atomic<std::size_t> in_flight_; ///< Number of requests currently in flight.
-    std::atomic<std::size_t> total_completed_; ///< Total completed requests.
-    std::atomic<std::size_t> total_failed_; ///< Total failed requests.
-    std::atomic<std::size_t> total_bytes_transferred_; ///< Total bytes transferred.
+    std::atomic<std::size_t> in_flight_bytes_{0}; ///< Sum of Request::size over in-flight requests.
+    std::atomic<std::size_t> outstanding_{0}; ///< Submitted requests whose completion handler has not finished.
+
+    /// Indices into counters_.
+    enum Counter : std::size_t {
+        kEnqueued,
+        kSubmitted,
+        kDeduplicated,
+        kCompleted,
+        kFailed,
+        kBytes,
+        kReads,
+        kWrites,
+        kByCompression, ///< First of one slot per Compression value.
+        kCounterCount = kByCompression + 3
+    };
+
+    const std::uint64_t      created_ns_;  ///< steady_now_ns() at construction.
+    detail::ShardedCounters<kCounterCount> counters_; ///< Per-thread request counters.
+    detail::ShardedHistogram submit_to_start_;   ///< Backend queueing latency.
+    detail::ShardedHistogram start_to_complete_; ///< Execution latency.
+    std::atomic<std::uint64_t> drained_{0};        ///< Requests moved from pending_ into staged_.
+    std::atomic<std::uint64_t> peak_in_flight_{0}; ///< Highest in_flight_ after a submission.
 
     mutable std::mutex       wait_mtx_;  ///< Guards wait_cv_ for wait_all().
     std::condition_variable  wait_cv_;   ///< Used to block/wake threads in wait_all().
+    std::atomic<std::size_t> waiters_{0}; ///< Threads blocked on wait_cv_ for something other than idle.
 };
 
 // -------------------------
@@ -534,9 +1631,18 @@ struct Queue::Impl {
  * all submitted requests.
  */
 Queue::Queue(std::shared_ptr<Backend> backend)
-    : impl_(std::make_unique<Impl>(std::move(backend)))
+    : Queue(std::move(backend), QueueConfig{})
 {}
 
+/**
+ * @brief Construct a Queue with explicit ring sizes and tuning.
+ */
+Queue::Queue(std::shared_ptr<Backend> backend, const QueueConfig& config)
+    : impl_(std::make_unique<Impl>(std::move(backend), config))
+{
+    impl_->owner_ = this;
+}
+
 /**
  * @brief Destroy the Queue.
  *
@@ -553,14 +1659,55 @@ void Queue::enqueue(Request req) {
     impl_->enqueue(std::move(req));
 }
 
+RequestId Queue::enqueue_tracked(Request req, const std::vector<RequestId>& after) {
+    return impl_->enqueue_tracked(std::move(req), after);
+}
+
+RequestId Queue::then(const std::vector<RequestId>& after, Continuation fn) {
+    return impl_->then(after, std::move(fn));
+}
+
+void Queue::wait(RequestId id) {
+    impl_->wait_any_for({id}, std::chrono::nanoseconds(-1));
+}
+
+bool Queue::wait_for(RequestId id, std::chrono::nanoseconds timeout) {
+    return impl_->wait_any_for({id}, timeout) == 0;
+}
+
+std::size_t Queue::wait_any(const std::vector<RequestId>& ids) {
+    return impl_->wait_any_for(ids, std::chrono::nanoseconds(-1));
+}
+
+std::size_t Queue::wait_any_for(const std::vector<RequestId>& ids,
+                                std::chrono::nanoseconds timeout) {
+    return impl_->wait_any_for(ids, timeout);
+}
+
+bool Queue::is_complete(RequestId id) const {
+    return impl_->is_complete(id);
+}
+
+void Queue::enqueue(Request req, CompletionHook* hook) {
+    impl_->enqueue(std::move(req), hook);
+}
+
 void Queue::submit_all() {
     // Forward to Impl::submit_all(), which handles:
-    //  - moving pending requests under lock
-    //  - incrementing in-flight count
+    //  - draining the lock-free pending ring
+    //  - metering submissions against the in-flight caps
     //  - delegating to the backend with completion callbacks
     impl_->submit_all();
 }
 
+std::size_t Queue::try_submit_all() {
+    return impl_->try_submit_all();
+}
+
+void Queue::set_backpressure_callback(BackpressureCallback callback) {
+    impl_->set_backpressure_callback(std::move(callback));
+}
+
 void Queue::wait_all() {
     // Forward to Impl::wait_all(), which uses in_flight_ and
     // wait_cv_ to block until there are no in-flight requests.
@@ -572,8 +1719,30 @@ std::size_t Queue::in_flight() const {
     return impl_->in_flight();
 }
 
+std::size_t Queue::in_flight_bytes() const {
+    return impl_->in_flight_bytes();
+}
+
+std::size_t Queue::held_back() const {
+    return impl_->held_back();
+}
+
+QueueStats Queue::stats() const {
+    return impl_->stats();
+}
+
 std::vector<Request> Queue::take_completed() {
     return impl_->take_completed();
 }
 
+std::size_t Queue::poll_completions(CompletionRecord* out, std::size_t max) {
+    return impl_->poll_completions(out, max);
+}
+
+std::size_t Queue::wait_completions(CompletionRecord* out,
+                                    std::size_t max,
+                                    std::size_t min_count) {
+    return impl_->wait_completions(out, max, min_count);
+}
+
 } // namespace ds
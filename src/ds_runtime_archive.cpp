@@ -0,0 +1,742 @@
+// SPDX-License-Identifier: Apache-2.0
+// Asset archive writer and reader for ds-runtime.
+//
+// The builder lays the whole index out in memory once every asset's size
+// is known, streams the asset data to its aligned offsets (checksumming
+// it on the way), then writes the index in one piece. The reader checks
+// the header and section bounds, maps the index and answers lookups
+// straight from the mapping.
+//
+// The perfect hash is BBHash-style: each level is a bitset of twice as
+// many bits as ids left, an id that lands alone on a bit owns it and the
+// rest move to the next level. A lookup probes about 1.6 levels on
+// average, then ranks the owned bit with a popcount over at most eight
+// words, all in place in the mapping.
+
+#include "ds_runtime_archive.hpp"
+#include "ds_runtime_checksum.hpp"
+#include "gdeflate_format.h"
+
+#include <algorithm>
+#include <bit>
+#include <cerrno>
+#include <cstring>
+#include <numeric>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace ds {
+
+namespace {
+
+/// Chunk size used to copy and checksum asset data.
+constexpr std::size_t kCopyChunk = std::size_t{1} << 20;
+
+/// Perfect hash level size in bits per id left to place.
+constexpr std::uint64_t kPerfectHashGamma = 2;
+
+/// Seeds tried before giving up on a perfect hash. With gamma 2 the first
+/// one practically always converges well within kMaxPerfectHashLevels.
+constexpr std::uint32_t kPerfectHashSeeds = 8;
+
+/// No-slot result of perfect_hash_slot().
+constexpr std::uint64_t kNoSlot = UINT64_MAX;
+
+constexpr std::uint64_t align_up(std::uint64_t value, std::uint64_t alignment) noexcept {
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+
+bool valid_alignment(std::uint32_t alignment) noexcept {
+    return std::has_single_bit(alignment);
+}
+
+bool valid_compression(std::uint8_t compression) noexcept {
+    return compression <= static_cast<std::uint8_t>(Compression::GDeflate);
+}
+
+/// True if [offset, offset + bytes) lies inside [begin, end).
+bool in_range(std::uint64_t offset, std::uint64_t bytes,
+              std::uint64_t begin, std::uint64_t end) noexcept {
+    return offset >= begin && offset <= end && bytes <= end - offset;
+}
+
+void archive_error(const char* operation, const std::string& detail, int errno_value,
+                   int line, const char* function) {
+    report_error("archive", operation, detail, errno_value, __FILE__, line, function);
+}
+
+bool write_all(int fd, const void* data, std::size_t size, std::uint64_t offset) {
+    const auto* p = static_cast<const char*>(data);
+    while (size != 0) {
+        const ssize_t n = ::pwrite(fd, p, size, static_cast<off_t>(offset));
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        p += n;
+        size -= static_cast<std::size_t>(n);
+        offset += static_cast<std::uint64_t>(n);
+    }
+    return true;
+}
+
+/// Bytes of a perfect hash section with the given shape.
+std::uint64_t perfect_hash_bytes(std::uint64_t level_count, std::uint64_t word_count,
+                                 std::uint64_t key_count) noexcept {
+    return sizeof(archive::PerfectHashHeader) +
+           level_count * sizeof(archive::PerfectHashLevel) +
+           word_count * sizeof(std::uint64_t) +
+           (word_count / 8 + 1) * sizeof(std::uint32_t) +
+           key_count * sizeof(std::uint32_t);
+}
+
+/// Slot of @p id: the rank of the first level bit it owns, or kNoSlot.
+/// Ids that are not in the hash map to an arbitrary slot or none.
+std::uint64_t perfect_hash_slot(const archive::PerfectHashLevel* levels, std::uint32_t level_count,
+                                std::uint32_t seed, const std::uint64_t* bits,
+                                const std::uint32_t* ranks, std::uint64_t id) noexcept {
+    for (std::uint32_t level = 0; level < level_count; ++level) {
+        const std::uint64_t bit = levels[level].word_offset * 64 +
+            archive::perfect_hash_position(id, seed, level, levels[level].bit_count);
+        const std::uint64_t word = bit / 64;
+        const std::uint64_t mask = std::uint64_t{1} << (bit % 64);
+        if ((bits[word] & mask) == 0) {
+            continue;
+        }
+        std::uint64_t rank = ranks[word / 8];
+        for (std::uint64_t w = word & ~std::uint64_t{7}; w < word; ++w) {
+            rank += static_cast<std::uint64_t>(std::popcount(bits[w]));
+        }
+        return rank + static_cast<std::uint64_t>(std::popcount(bits[word] & (mask - 1)));
+    }
+    return kNoSlot;
+}
+
+/// Build the perfect hash section for @p ids, given in TOC order. Empty if
+/// no seed converged.
+std::vector<char> build_perfect_hash(const std::vector<std::uint64_t>& ids) {
+    using archive::PerfectHashHeader;
+    using archive::PerfectHashLevel;
+
+    std::vector<PerfectHashLevel> levels;
+    std::vector<std::uint64_t> bits;
+    std::vector<std::uint64_t> collided;
+    std::vector<std::uint64_t> remaining;
+    std::vector<std::uint64_t> next;
+    std::uint32_t seed = 0;
+    for (; seed < kPerfectHashSeeds; ++seed) {
+        levels.clear();
+        bits.clear();
+        remaining = ids;
+        while (!remaining.empty() && levels.size() < archive::kMaxPerfectHashLevels) {
+            const auto level = static_cast<std::uint32_t>(levels.size());
+            PerfectHashLevel info{};
+            info.word_offset = bits.size();
+            info.bit_count = align_up(remaining.size() * kPerfectHashGamma, 64);
+            const std::size_t words = static_cast<std::size_t>(info.bit_count / 64);
+            bits.resize(bits.size() + words, 0);
+            collided.assign(words, 0);
+            std::uint64_t* owned = bits.data() + info.word_offset;
+
+            for (const std::uint64_t id : remaining) {
+                const std::uint64_t bit = archive::perfect_hash_position(id, seed, level, info.bit_count);
+                const std::uint64_t mask = std::uint64_t{1} << (bit % 64);
+                if ((owned[bit / 64] & mask) != 0) {
+                    collided[bit / 64] |= mask;
+                } else {
+                    owned[bit / 64] |= mask;
+                }
+            }
+            next.clear();
+            for (const std::uint64_t id : remaining) {
+                const std::uint64_t bit = archive::perfect_hash_position(id, seed, level, info.bit_count);
+                if ((collided[bit / 64] >> (bit % 64) & 1) != 0) {
+                    next.push_back(id);
+                }
+            }
+            for (std::size_t w = 0; w < words; ++w) {
+                owned[w] &= ~collided[w];
+            }
+            remaining.swap(next);
+            levels.push_back(info);
+        }
+        if (remaining.empty()) {
+            break;
+        }
+    }
+    if (!remaining.empty()) {
+        return {};
+    }
+
+    PerfectHashHeader header{};
+    header.key_count = ids.size();
+    header.word_count = bits.size();
+    header.level_count = static_cast<std::uint32_t>(levels.size());
+    header.seed = seed;
+
+    std::vector<char> section(static_cast<std::size_t>(
+        perfect_hash_bytes(levels.size(), bits.size(), ids.size())));
+    char* p = section.data() + sizeof(PerfectHashHeader);
+    auto* level_out = reinterpret_cast<PerfectHashLevel*>(p);
+    std::memcpy(level_out, levels.data(), levels.size() * sizeof(PerfectHashLevel));
+    p += levels.size() * sizeof(PerfectHashLevel);
+    auto* bits_out = reinterpret_cast<std::uint64_t*>(p);
+    std::memcpy(bits_out, bits.data(), bits.size() * sizeof(std::uint64_t));
+    p += bits.size() * sizeof(std::uint64_t);
+    auto* ranks = reinterpret_cast<std::uint32_t*>(p);
+    p += (bits.size() / 8 + 1) * sizeof(std::uint32_t);
+    auto* slots = reinterpret_cast<std::uint32_t*>(p);
+
+    std::uint32_t rank = 0;
+    for (std::size_t w = 0; w < bits.size(); ++w) {
+        if (w % 8 == 0) {
+            ranks[w / 8] = rank;
+        }
+        rank += static_cast<std::uint32_t>(std::popcount(bits[w]));
+    }
+    if (bits.size() % 8 == 0) {
+        ranks[bits.size() / 8] = rank;
+    }
+    for (std::size_t i = 0; i < ids.size(); ++i) {
+        const std::uint64_t slot = perfect_hash_slot(level_out, header.level_count, header.seed,
+                                                     bits_out, ranks, ids[i]);
+        slots[slot] = static_cast<std::uint32_t>(i);
+    }
+    std::memcpy(section.data(), &header, sizeof(header));
+    return section;
+}
+
+} // namespace
+
+// -----------------------------------------------------------------------------
+// ArchiveBuilder
+// -----------------------------------------------------------------------------
+
+ArchiveBuilder::ArchiveBuilder(const ArchiveBuildConfig& config)
+    : config_(config)
+{
+    if (!valid_alignment(config_.alignment)) {
+        config_.alignment = archive::kDefaultAlignment;
+    }
+}
+
+bool ArchiveBuilder::accept(const ArchiveAsset& asset) {
+    if (asset.name.empty() || (asset.alignment != 0 && !valid_alignment(asset.alignment))) {
+        archive_error("add", "Asset needs a name and a power-of-two alignment: \"" +
+                      asset.name + "\"", EINVAL, __LINE__, __func__);
+        return false;
+    }
+    return true;
+}
+
+bool ArchiveBuilder::add(const ArchiveAsset& asset, const void* data, std::size_t size) {
+    if (!accept(asset)) {
+        return false;
+    }
+    Pending pending;
+    pending.asset = asset;
+    pending.size = size;
+    const auto* bytes = static_cast<const char*>(data);
+    pending.data.assign(bytes, bytes + size);
+    assets_.push_back(std::move(pending));
+    return true;
+}
+
+bool ArchiveBuilder::add_file(const ArchiveAsset& asset, const std::string& path) {
+    if (!accept(asset)) {
+        return false;
+    }
+    const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    struct stat st{};
+    if (fd < 0 || ::fstat(fd, &st) != 0) {
+        const int err = errno;
+        if (fd >= 0) {
+            ::close(fd);
+        }
+        archive_error("open", "Cannot read asset file " + path, err, __LINE__, __func__);
+        return false;
+    }
+
+    Pending pending;
+    pending.asset = asset;
+    pending.path = path;
+    pending.size = static_cast<std::uint64_t>(st.st_size);
+    if (asset.compression == Compression::GDeflate) {
+        gdeflate::FileHeader header{};
+        const ssize_t n = ::pread(fd, &header, sizeof(header), 0);
+        if (n != static_cast<ssize_t>(sizeof(header)) ||
+            !gdeflate::parse_file_header(&header, sizeof(header), header)) {
+            ::close(fd);
+            archive_error("add", "Not a GDeflate stream: " + path, EINVAL, __LINE__, __func__);
+            return false;
+        }
+        if (pending.asset.uncompressed_size == 0) {
+            pending.asset.uncompressed_size = header.uncompressed_size;
+        }
+    }
+    ::close(fd);
+    assets_.push_back(std::move(pending));
+    return true;
+}
+
+bool ArchiveBuilder::write(const std::string& path) const {
+    using archive::Header;
+    using archive::TocEntry;
+
+    const std::size_t count = assets_.size();
+    if (count > UINT32_MAX) {
+        archive_error("write", "Too many assets for one pack", EOVERFLOW, __LINE__, __func__);
+        return false;
+    }
+
+    // TOC order: by id. Equal ids are either the same name twice or a
+    // hash collision; both would make lookups ambiguous.
+    std::vector<std::uint64_t> ids(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        ids[i] = archive::hash_id(assets_[i].asset.name);
+    }
+    std::vector<std::uint32_t> order(count);
+    std::iota(order.begin(), order.end(), 0u);
+    std::sort(order.begin(), order.end(), [&ids](std::uint32_t a, std::uint32_t b) {
+        return ids[a] < ids[b];
+    });
+    for (std::size_t i = 1; i < count; ++i) {
+        if (ids[order[i]] == ids[order[i - 1]]) {
+            const std::string& a = assets_[order[i - 1]].asset.name;
+            const std::string& b = assets_[order[i]].asset.name;
+            archive_error("write",
+                          a == b ? "Duplicate asset name \"" + a + "\""
+                                 : "Asset ids collide: \"" + a + "\" and \"" + b + "\"",
+                          EEXIST, __LINE__, __func__);
+            return false;
+        }
+    }
+
+    std::uint64_t names_size = 0;
+    for (const Pending& pending : assets_) {
+        names_size += pending.asset.name.size();
+    }
+    if (names_size > UINT32_MAX) {
+        archive_error("write", "Asset names exceed 4 GiB", EOVERFLOW, __LINE__, __func__);
+        return false;
+    }
+
+    // About one entry per fanout bucket.
+    const std::uint32_t fanout_bits = count < 2
+        ? 0
+        : std::min<std::uint32_t>(static_cast<std::uint32_t>(std::bit_width(count) - 1),
+                                  archive::kMaxFanoutBits);
+    const std::size_t fanout_count = (std::size_t{1} << fanout_bits) + 1;
+
+    std::vector<char> perfect_hash;
+    if (config_.perfect_hash && count != 0) {
+        std::vector<std::uint64_t> sorted_ids(count);
+        for (std::size_t slot = 0; slot < count; ++slot) {
+            sorted_ids[slot] = ids[order[slot]];
+        }
+        perfect_hash = build_perfect_hash(sorted_ids);
+        if (perfect_hash.empty()) {
+            archive_error("write", "Cannot build a perfect hash of the asset ids", ERANGE,
+                          __LINE__, __func__);
+            return false;
+        }
+    }
+
+    Header header{};
+    header.magic = archive::kMagic;
+    header.version_major = archive::kVersionMajor;
+    header.version_minor = archive::kVersionMinor;
+    header.header_size = sizeof(Header);
+    header.entry_count = count;
+    header.toc_offset = sizeof(Header);
+    header.fanout_offset = header.toc_offset + count * sizeof(TocEntry);
+    header.names_offset = header.fanout_offset + fanout_count * sizeof(std::uint32_t);
+    header.names_size = names_size;
+    header.data_offset = header.names_offset + names_size;
+    if (!perfect_hash.empty()) {
+        header.flags |= archive::kFlagPerfectHash;
+        header.mphf_offset = align_up(header.data_offset, alignof(std::uint64_t));
+        header.mphf_size = perfect_hash.size();
+        header.data_offset = header.mphf_offset + header.mphf_size;
+    }
+    header.fanout_bits = fanout_bits;
+    header.alignment = config_.alignment;
+
+    std::vector<char> index(header.data_offset, 0);
+    auto* toc = reinterpret_cast<TocEntry*>(index.data() + header.toc_offset);
+    auto* fanout = reinterpret_cast<std::uint32_t*>(index.data() + header.fanout_offset);
+    char* names = index.data() + header.names_offset;
+
+    // Data keeps the order assets were added in, so related assets stay
+    // adjacent; only the TOC is sorted.
+    std::vector<std::uint64_t> offsets(count);
+    std::uint64_t cursor = header.data_offset;
+    for (std::size_t i = 0; i < count; ++i) {
+        const std::uint32_t alignment = assets_[i].asset.alignment != 0
+            ? assets_[i].asset.alignment
+            : config_.alignment;
+        cursor = align_up(cursor, alignment);
+        offsets[i] = cursor;
+        cursor += assets_[i].size;
+    }
+    header.file_size = cursor;
+
+    const std::string tmp_path = path + ".tmp";
+    const int out = ::open(tmp_path.c_str(), O_CREAT | O_WRONLY | O_TRUNC | O_CLOEXEC, 0644);
+    if (out < 0) {
+        archive_error("open", "Cannot create " + tmp_path, errno, __LINE__, __func__);
+        return false;
+    }
+    const auto fail = [&](const char* operation, const std::string& detail, int err, int line) {
+        ::close(out);
+        ::unlink(tmp_path.c_str());
+        archive_error(operation, detail, err, line, __func__);
+        return false;
+    };
+
+    std::vector<std::uint32_t> checksums(count);
+    std::vector<char> chunk;
+    for (std::size_t i = 0; i < count; ++i) {
+        const Pending& pending = assets_[i];
+        if (pending.path.empty()) {
+            checksums[i] = crc32c(pending.data.data(), pending.data.size());
+            if (!write_all(out, pending.data.data(), pending.data.size(), offsets[i])) {
+                return fail("pwrite", "Cannot write " + tmp_path, errno, __LINE__);
+            }
+            continue;
+        }
+
+        const int in = ::open(pending.path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (in < 0) {
+            return fail("open", "Cannot read asset file " + pending.path, errno, __LINE__);
+        }
+        chunk.resize(kCopyChunk);
+        std::uint32_t crc = 0;
+        std::uint64_t copied = 0;
+        while (copied < pending.size) {
+            const std::size_t want =
+                static_cast<std::size_t>(std::min<std::uint64_t>(kCopyChunk, pending.size - copied));
+            const ssize_t n = ::pread(in, chunk.data(), want, static_cast<off_t>(copied));
+            if (n <= 0) {
+                if (n < 0 && errno == EINTR) {
+                    continue;
+                }
+                const int err = n < 0 ? errno : EIO;
+                ::close(in);
+                return fail("pread", "Asset file shrank or failed: " + pending.path, err, __LINE__);
+            }
+            crc = crc32c(chunk.data(), static_cast<std::size_t>(n), crc);
+            if (!write_all(out, chunk.data(), static_cast<std::size_t>(n), offsets[i] + copied)) {
+                const int err = errno;
+                ::close(in);
+                return fail("pwrite", "Cannot write " + tmp_path, err, __LINE__);
+            }
+            copied += static_cast<std::uint64_t>(n);
+        }
+        ::close(in);
+        checksums[i] = crc;
+    }
+
+    std::uint32_t name_offset = 0;
+    for (std::size_t slot = 0; slot < count; ++slot) {
+        const std::uint32_t i = order[slot];
+        const Pending& pending = assets_[i];
+        TocEntry& entry = toc[slot];
+        entry.id = ids[i];
+        entry.offset = offsets[i];
+        entry.size = pending.size;
+        entry.uncompressed_size = pending.asset.uncompressed_size != 0
+            ? pending.asset.uncompressed_size
+            : pending.size;
+        entry.name_offset = name_offset;
+        entry.name_size = static_cast<std::uint32_t>(pending.asset.name.size());
+        entry.checksum = checksums[i];
+        entry.compression = static_cast<std::uint8_t>(pending.asset.compression);
+        std::memcpy(names + name_offset, pending.asset.name.data(), pending.asset.name.size());
+        name_offset += entry.name_size;
+    }
+
+    // fanout[b] = first entry whose id prefix is >= b.
+    std::size_t next = 0;
+    for (std::size_t bucket = 0; bucket < fanout_count; ++bucket) {
+        while (next < count && fanout_bits != 0 && (ids[order[next]] >> (64 - fanout_bits)) < bucket) {
+            ++next;
+        }
+        fanout[bucket] = static_cast<std::uint32_t>(
+            fanout_bits == 0 ? (bucket == 0 ? 0 : count) : next);
+    }
+
+    if (!perfect_hash.empty()) {
+        std::memcpy(index.data() + header.mphf_offset, perfect_hash.data(), perfect_hash.size());
+    }
+
+    header.index_checksum = crc32c(index.data() + sizeof(Header), index.size() - sizeof(Header));
+    std::memcpy(index.data(), &header, sizeof(Header));
+
+    if (!write_all(out, index.data(), index.size(), 0) ||
+        ::ftruncate(out, static_cast<off_t>(header.file_size)) != 0 ||
+        ::fsync(out) != 0) {
+        return fail("pwrite", "Cannot write " + tmp_path, errno, __LINE__);
+    }
+    if (::close(out) != 0) {
+        ::unlink(tmp_path.c_str());
+        archive_error("close", "Cannot write " + tmp_path, errno, __LINE__, __func__);
+        return false;
+    }
+    if (::rename(tmp_path.c_str(), path.c_str()) != 0) {
+        const int err = errno;
+        ::unlink(tmp_path.c_str());
+        archive_error("rename", "Cannot replace " + path, err, __LINE__, __func__);
+        return false;
+    }
+    return true;
+}
+
+// -----------------------------------------------------------------------------
+// Archive
+// -----------------------------------------------------------------------------
+
+Archive::~Archive() {
+    if (map_ != nullptr) {
+        ::munmap(map_, map_size_);
+    }
+    if (fd_ >= 0) {
+        ::close(fd_);
+    }
+}
+
+const archive::TocEntry* Archive::find_id(std::uint64_t id) const noexcept {
+    if (hash_levels_ != nullptr) {
+        return find_id_by_hash(id);
+    }
+    const std::uint32_t bits = header_->fanout_bits;
+    const std::uint64_t bucket = bits == 0 ? 0 : id >> (64 - bits);
+    const std::size_t hi = std::min<std::size_t>(fanout_[bucket + 1], entry_count_);
+    const std::size_t lo = fanout_[bucket];
+    if (lo > hi) {
+        return nullptr;
+    }
+    const archive::TocEntry* it = std::lower_bound(
+        toc_ + lo, toc_ + hi, id,
+        [](const archive::TocEntry& entry, std::uint64_t value) { return entry.id < value; });
+    return it != toc_ + hi && it->id == id ? it : nullptr;
+}
+
+const archive::TocEntry* Archive::find_id_by_hash(std::uint64_t id) const noexcept {
+    const std::uint64_t slot = perfect_hash_slot(hash_levels_, hash_level_count_, hash_seed_,
+                                                 hash_bits_, hash_ranks_, id);
+    if (slot >= entry_count_) {
+        return nullptr;
+    }
+    const std::uint32_t index = hash_slots_[slot];
+    return index < entry_count_ && toc_[index].id == id ? toc_ + index : nullptr;
+}
+
+const archive::TocEntry* Archive::find(std::string_view name) const noexcept {
+    const std::uint64_t id = archive::hash_id(name);
+    const archive::TocEntry* end = toc_ + entry_count_;
+    for (const archive::TocEntry* it = find_id(id); it != nullptr && it != end && it->id == id; ++it) {
+        if (this->name(*it) == name) {
+            return it;
+        }
+    }
+    return nullptr;
+}
+
+std::string_view Archive::name(const archive::TocEntry& entry) const noexcept {
+    if (!in_range(entry.name_offset, entry.name_size, 0, header_->names_size)) {
+        return {};
+    }
+    return std::string_view(names_ + entry.name_offset, entry.name_size);
+}
+
+bool Archive::make_request(const archive::TocEntry& entry, Request& out) const noexcept {
+    if (!in_range(entry.offset, entry.size, header_->data_offset, header_->file_size) ||
+        !valid_compression(entry.compression)) {
+        return false;
+    }
+    out.fd = fd_;
+    out.offset = entry.offset;
+    out.compression = static_cast<Compression>(entry.compression);
+    out.size = static_cast<std::size_t>(
+        out.compression == Compression::None ? entry.size : entry.uncompressed_size);
+    return true;
+}
+
+bool Archive::make_request(std::string_view name, Request& out) const noexcept {
+    const archive::TocEntry* entry = find(name);
+    return entry != nullptr && make_request(*entry, out);
+}
+
+bool Archive::verify() const {
+    const archive::Header& h = *header_;
+    const auto* index = static_cast<const char*>(map_);
+    if (crc32c(index + h.header_size, h.data_offset - h.header_size) != h.index_checksum) {
+        return false;
+    }
+
+    const std::uint32_t bits = h.fanout_bits;
+    const std::size_t buckets = std::size_t{1} << bits;
+    if (fanout_[0] != 0 || fanout_[buckets] != entry_count_) {
+        return false;
+    }
+    for (std::size_t b = 0; b < buckets; ++b) {
+        if (fanout_[b] > fanout_[b + 1]) {
+            return false;
+        }
+    }
+    for (std::size_t i = 0; i < entry_count_; ++i) {
+        const archive::TocEntry& entry = toc_[i];
+        const std::uint64_t bucket = bits == 0 ? 0 : entry.id >> (64 - bits);
+        if ((i != 0 && toc_[i - 1].id >= entry.id) ||
+            i < fanout_[bucket] || i >= fanout_[bucket + 1] ||
+            !in_range(entry.offset, entry.size, h.data_offset, h.file_size) ||
+            !valid_compression(entry.compression) ||
+            !in_range(entry.name_offset, entry.name_size, 0, h.names_size) ||
+            archive::hash_id(name(entry)) != entry.id) {
+            return false;
+        }
+        // Every id reaching its own entry also proves the slots distinct.
+        if (hash_levels_ != nullptr && find_id_by_hash(entry.id) != &entry) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool Archive::verify_entry(const archive::TocEntry& entry) const {
+    if (!in_range(entry.offset, entry.size, header_->data_offset, header_->file_size)) {
+        return false;
+    }
+    std::vector<char> chunk(static_cast<std::size_t>(std::min<std::uint64_t>(kCopyChunk, entry.size)));
+    std::uint32_t crc = 0;
+    std::uint64_t done = 0;
+    while (done < entry.size) {
+        const std::size_t want =
+            static_cast<std::size_t>(std::min<std::uint64_t>(chunk.size(), entry.size - done));
+        const ssize_t n = ::pread(fd_, chunk.data(), want, static_cast<off_t>(entry.offset + done));
+        if (n <= 0) {
+            if (n < 0 && errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        crc = crc32c(chunk.data(), static_cast<std::size_t>(n), crc);
+        done += static_cast<std::uint64_t>(n);
+    }
+    return crc == entry.checksum;
+}
+
+std::shared_ptr<Archive> open_archive(const std::string& path) {
+    using archive::Header;
+
+    if constexpr (std::endian::native != std::endian::little) {
+        archive_error("open", "Packs are little-endian; big-endian hosts are not supported",
+                      ENOTSUP, __LINE__, __func__);
+        return nullptr;
+    }
+
+    std::shared_ptr<Archive> out(new Archive());
+    out->fd_ = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    struct stat st{};
+    if (out->fd_ < 0 || ::fstat(out->fd_, &st) != 0) {
+        archive_error("open", "Cannot open " + path, errno, __LINE__, __func__);
+        return nullptr;
+    }
+
+    Header h{};
+    const std::uint64_t file_size = static_cast<std::uint64_t>(st.st_size);
+    if (file_size < sizeof(Header) ||
+        ::pread(out->fd_, &h, sizeof(Header), 0) != static_cast<ssize_t>(sizeof(Header)) ||
+        h.magic != archive::kMagic) {
+        archive_error("open", "Not an asset pack: " + path, EINVAL, __LINE__, __func__);
+        return nullptr;
+    }
+    if (h.version_major != archive::kVersionMajor) {
+        archive_error("open", "Unsupported pack version " + std::to_string(h.version_major) +
+                      " in " + path, ENOTSUP, __LINE__, __func__);
+        return nullptr;
+    }
+
+    // Every section must lie inside the index, aligned for its records,
+    // so lookups can index the mapping directly.
+    const std::uint64_t fanout_bytes = h.fanout_bits <= archive::kMaxFanoutBits
+        ? ((std::uint64_t{1} << h.fanout_bits) + 1) * sizeof(std::uint32_t)
+        : 0;
+    const bool sane =
+        h.header_size >= sizeof(Header) &&
+        h.file_size <= file_size &&
+        h.data_offset >= h.header_size && h.data_offset <= h.file_size &&
+        h.entry_count <= UINT32_MAX &&
+        fanout_bytes != 0 &&
+        h.toc_offset % alignof(archive::TocEntry) == 0 &&
+        h.fanout_offset % alignof(std::uint32_t) == 0 &&
+        in_range(h.toc_offset, h.entry_count * sizeof(archive::TocEntry), h.header_size, h.data_offset) &&
+        in_range(h.fanout_offset, fanout_bytes, h.header_size, h.data_offset) &&
+        in_range(h.names_offset, h.names_size, h.header_size, h.data_offset);
+    if (!sane) {
+        archive_error("open", "Corrupt pack header in " + path, EINVAL, __LINE__, __func__);
+        return nullptr;
+    }
+
+    out->map_size_ = static_cast<std::size_t>(h.data_offset);
+    void* map = ::mmap(nullptr, out->map_size_, PROT_READ, MAP_SHARED, out->fd_, 0);
+    if (map == MAP_FAILED) {
+        archive_error("mmap", "Cannot map the index of " + path, errno, __LINE__, __func__);
+        return nullptr;
+    }
+    // Lookups touch a few scattered pages; readahead would only waste I/O.
+    ::madvise(map, out->map_size_, MADV_RANDOM);
+
+    const auto* base = static_cast<const char*>(map);
+    out->map_ = map;
+    out->header_ = static_cast<const Header*>(map);
+    out->toc_ = reinterpret_cast<const archive::TocEntry*>(base + h.toc_offset);
+    out->fanout_ = reinterpret_cast<const std::uint32_t*>(base + h.fanout_offset);
+    out->names_ = base + h.names_offset;
+    out->entry_count_ = static_cast<std::size_t>(h.entry_count);
+
+    // The perfect hash is used in place as well; check every bound a
+    // lookup relies on so corrupt sections cannot read past the mapping.
+    if ((h.flags & archive::kFlagPerfectHash) != 0) {
+        archive::PerfectHashHeader ph{};
+        bool hash_sane = h.mphf_offset % alignof(std::uint64_t) == 0 &&
+                         in_range(h.mphf_offset, h.mphf_size, h.header_size, h.data_offset) &&
+                         h.mphf_size >= sizeof(ph);
+        if (hash_sane) {
+            std::memcpy(&ph, base + h.mphf_offset, sizeof(ph));
+            hash_sane = ph.key_count == h.entry_count &&
+                        ph.level_count != 0 && ph.level_count <= archive::kMaxPerfectHashLevels &&
+                        ph.word_count <= h.mphf_size / sizeof(std::uint64_t) &&
+                        perfect_hash_bytes(ph.level_count, ph.word_count, ph.key_count) <= h.mphf_size;
+        }
+        const char* p = base + h.mphf_offset + sizeof(ph);
+        const auto* levels = reinterpret_cast<const archive::PerfectHashLevel*>(p);
+        for (std::uint32_t level = 0; hash_sane && level < ph.level_count; ++level) {
+            hash_sane = levels[level].bit_count != 0 && levels[level].bit_count % 64 == 0 &&
+                        in_range(levels[level].word_offset, levels[level].bit_count / 64,
+                                 0, ph.word_count);
+        }
+        if (!hash_sane) {
+            archive_error("open", "Corrupt perfect hash in " + path, EINVAL, __LINE__, __func__);
+            return nullptr;
+        }
+        p += ph.level_count * sizeof(archive::PerfectHashLevel);
+        out->hash_levels_ = levels;
+        out->hash_level_count_ = ph.level_count;
+        out->hash_seed_ = ph.seed;
+        out->hash_bits_ = reinterpret_cast<const std::uint64_t*>(p);
+        p += ph.word_count * sizeof(std::uint64_t);
+        out->hash_ranks_ = reinterpret_cast<const std::uint32_t*>(p);
+        p += (ph.word_count / 8 + 1) * sizeof(std::uint32_t);
+        out->hash_slots_ = reinterpret_cast<const std::uint32_t*>(p);
+    }
+    return out;
+}
+
+} // namespace ds
@@ -0,0 +1,510 @@
+// SPDX-License-Identifier: Apache-2.0
+// Size-classed, NUMA-aware buffer pool for ds-runtime.
+//
+// All memory comes from anonymous mappings. Blocks below slab_bytes are
+// carved out of slabs (one mmap() per slab, split evenly into blocks of a
+// single size class); bigger blocks own their mapping. Each mapping can
+// be huge-page aligned, bound to a NUMA node and mlock()ed when it is
+// created, so those costs are paid once per slab rather than per request.
+//
+// Free lists are indexed by (node, thread shard, size class). A block is
+// released onto the releasing thread's shard of the node its memory lives
+// on, and allocation tries the caller's shard before the others, so a
+// thread that recycles its own buffers never touches another thread's
+// lock. Lists are LIFO: recently released blocks are the most likely to
+// still be in cache.
+
+#include "ds_runtime_buffer.hpp"
+#include "ds_runtime_numa.hpp"
+#include "ds_runtime_ring.hpp"  // kCacheLineSize
+#include "ds_runtime_stats.hpp" // ShardedCounters, this_thread_shard
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <mutex>
+#include <new>
+#include <unordered_map>
+#include <vector>
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace ds {
+
+namespace {
+
+constexpr std::size_t kHugePageSize = std::size_t{2} << 20;
+
+std::size_t page_size() {
+    static const std::size_t size = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+    return size;
+}
+
+std::size_t round_up(std::size_t n, std::size_t alignment) {
+    return (n + alignment - 1) & ~(alignment - 1);
+}
+
+/// Normalise @p config so every block size is an aligned power of two.
+BufferPoolConfig normalise(BufferPoolConfig config) {
+    config.alignment = std::bit_ceil(std::max(config.alignment, alignof(std::max_align_t)));
+    config.min_block_bytes = std::bit_ceil(std::max(config.min_block_bytes, config.alignment));
+    config.max_pooled_bytes = std::bit_ceil(std::max(config.max_pooled_bytes,
+                                                     config.min_block_bytes));
+    config.slab_bytes = std::bit_ceil(std::max(config.slab_bytes, config.min_block_bytes));
+    return config;
+}
+
+} // namespace
+
+/**
+ * @brief Shared state of a BufferPool.
+ *
+ * Outstanding blocks hold a reference, so a pool destroyed while its views
+ * are still alive keeps this state until the last one is released.
+ */
+struct BufferPool::Impl {
+    static constexpr std::size_t kOversized = ~std::size_t{0};
+
+    /// One mapping split into equal blocks of a single size class.
+    struct Slab {
+        void*       base = nullptr;
+        std::size_t bytes = 0;
+        std::size_t block_count = 0;
+    };
+
+    /// One block plus its reference count. Slab blocks point at their
+    /// slab; other blocks own a mapping of mapped_bytes at memory.
+    struct Block final : BufferStorage {
+        std::shared_ptr<Impl> owner;      ///< Set while the block is outstanding.
+        void*                 memory = nullptr;
+        std::size_t           capacity = 0;
+        std::size_t           mapped_bytes = 0;
+        std::size_t           size_class = kOversized;
+        std::size_t           node = 0;
+        Slab*                 slab = nullptr;
+
+        void recycle() noexcept override {
+            const std::shared_ptr<Impl> pool = std::move(owner);
+            pool->release(this);
+        }
+    };
+
+    struct alignas(detail::kCacheLineSize) FreeList {
+        std::mutex          mtx;
+        std::vector<Block*> blocks; ///< Most recently released last.
+    };
+
+    enum Counter : std::size_t {
+        kAllocations,
+        kReused,
+        kOversizedCount,
+        kFailures,
+        kHugePageRegions,
+        kNumaBoundRegions,
+        kLockFailures,
+        kCounterCount
+    };
+
+    explicit Impl(const BufferPoolConfig& cfg)
+        : config(normalise(cfg))
+        , class_count(static_cast<std::size_t>(
+              std::countr_zero(config.max_pooled_bytes / config.min_block_bytes)) + 1)
+        , node_count(config.numa_aware ? detail::numa_node_count() : 1)
+        , lists(std::make_unique<FreeList[]>(node_count * detail::kStatsShards * class_count))
+    {}
+
+    ~Impl() {
+        // Every block is back on a free list by now (outstanding blocks
+        // keep this object alive).
+        const std::size_t list_count = node_count * detail::kStatsShards * class_count;
+        for (std::size_t i = 0; i < list_count; ++i) {
+            for (Block* block : lists[i].blocks) {
+                destroy(block);
+            }
+        }
+        for (const auto& slab : slabs) {
+            unmap(slab->base, slab->bytes);
+        }
+    }
+
+    FreeList& list(std::size_t node, std::size_t shard, std::size_t size_class) {
+        return lists[(node * detail::kStatsShards + shard) * class_count + size_class];
+    }
+
+    /// Size class holding blocks of at least @p size bytes.
+    std::size_t class_for(std::size_t size) const {
+        if (size <= config.min_block_bytes) {
+            return 0;
+        }
+        return static_cast<std::size_t>(std::bit_width((size - 1) / config.min_block_bytes));
+    }
+
+    /// Node a request for @p node is served from.
+    std::size_t resolve_node(int node) const {
+        if (node_count == 1) {
+            return 0;
+        }
+        if (node < 0) {
+            node = detail::current_numa_node();
+        }
+        return static_cast<std::size_t>(node) < node_count ? static_cast<std::size_t>(node) : 0;
+    }
+
+    /**
+     * @brief Map @p bytes of anonymous memory for @p node, applying the
+     * alignment, huge-page, NUMA and mlock policy. Returns null on failure.
+     */
+    void* map(std::size_t bytes, std::size_t node) {
+        const bool huge = config.huge_pages && bytes >= kHugePageSize;
+        const std::size_t align = std::max(config.alignment, huge ? kHugePageSize : page_size());
+        const std::size_t slack = align > page_size() ? align : 0;
+        void* raw = ::mmap(nullptr, bytes + slack, PROT_READ | PROT_WRITE,
+                           MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (raw == MAP_FAILED) {
+            return nullptr;
+        }
+
+        // Give back the unaligned head and the unused tail of the slack.
+        char* const raw_begin = static_cast<char*>(raw);
+        char* const base = reinterpret_cast<char*>(
+            round_up(reinterpret_cast<std::uintptr_t>(raw), align));
+        if (base > raw_begin) {
+            ::munmap(raw_begin, static_cast<std::size_t>(base - raw_begin));
+        }
+        char* const tail = base + bytes;
+        char* const raw_end = raw_begin + bytes + slack;
+        if (raw_end > tail) {
+            ::munmap(tail, static_cast<std::size_t>(raw_end - tail));
+        }
+
+#ifdef MADV_HUGEPAGE
+        if (huge && ::madvise(base, bytes, MADV_HUGEPAGE) == 0) {
+            counters.add(kHugePageRegions);
+        }
+#endif
+        if (node_count > 1 && detail::prefer_numa_node(base, bytes, static_cast<int>(node))) {
+            counters.add(kNumaBoundRegions);
+        }
+        if (config.lock_memory && ::mlock(base, bytes) != 0) {
+            counters.add(kLockFailures);
+        }
+        mapped_bytes.fetch_add(bytes, std::memory_order_relaxed);
+        return base;
+    }
+
+    void unmap(void* base, std::size_t bytes) noexcept {
+        ::munmap(base, bytes);
+        mapped_bytes.fetch_sub(bytes, std::memory_order_relaxed);
+    }
+
+    /// Delete a block header, unmapping its memory if it owns it.
+    void destroy(Block* block) noexcept {
+        if (block->slab == nullptr) {
+            unmap(block->memory, block->mapped_bytes);
+        }
+        delete block;
+    }
+
+    /// A block with its own mapping of @p capacity bytes, or null.
+    Block* dedicated_block(std::size_t capacity, std::size_t size_class, std::size_t node) {
+        Block* block = new (std::nothrow) Block;
+        if (block == nullptr) {
+            return nullptr;
+        }
+        block->mapped_bytes = round_up(capacity, std::max(config.alignment, page_size()));
+        block->memory = map(block->mapped_bytes, node);
+        if (block->memory == nullptr) {
+            delete block;
+            return nullptr;
+        }
+        block->capacity = capacity;
+        block->size_class = size_class;
+        block->node = node;
+        return block;
+    }
+
+    /**
+     * @brief Map a slab for @p size_class on @p node, return one of its
+     * blocks and put the rest on the caller's free list.
+     */
+    Block* carve_slab(std::size_t size_class, std::size_t node) {
+        const std::size_t block_bytes = config.min_block_bytes << size_class;
+        auto slab = std::unique_ptr<Slab>(new (std::nothrow) Slab);
+        if (!slab) {
+            return nullptr;
+        }
+        slab->bytes = config.slab_bytes;
+        slab->block_count = config.slab_bytes / block_bytes;
+
+        std::vector<Block*> blocks;
+        try {
+            blocks.reserve(slab->block_count);
+        } catch (const std::bad_alloc&) {
+            return nullptr;
+        }
+        for (std::size_t i = 0; i < slab->block_count; ++i) {
+            Block* block = new (std::nothrow) Block;
+            if (block == nullptr) {
+                for (Block* created : blocks) {
+                    delete created;
+                }
+                return nullptr;
+            }
+            block->capacity = block_bytes;
+            block->size_class = size_class;
+            block->node = node;
+            block->slab = slab.get();
+            blocks.push_back(block);
+        }
+
+        slab->base = map(slab->bytes, node);
+        if (slab->base == nullptr) {
+            for (Block* block : blocks) {
+                delete block;
+            }
+            return nullptr;
+        }
+        for (std::size_t i = 0; i < blocks.size(); ++i) {
+            blocks[i]->memory = static_cast<char*>(slab->base) + i * block_bytes;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(slabs_mtx);
+            try {
+                slabs.push_back(std::move(slab));
+            } catch (const std::bad_alloc&) {
+                unmap(slab->base, slab->bytes);
+                for (Block* block : blocks) {
+                    delete block;
+                }
+                return nullptr;
+            }
+        }
+
+        // Hand out the first block; the rest become free, lowest address
+        // on top.
+        FreeList& free = list(node, detail::this_thread_shard(), size_class);
+        {
+            std::lock_guard<std::mutex> lock(free.mtx);
+            for (std::size_t i = blocks.size(); i-- > 1;) {
+                free.blocks.push_back(blocks[i]);
+            }
+        }
+        cached_bytes.fetch_add((blocks.size() - 1) * block_bytes, std::memory_order_relaxed);
+        return blocks.front();
+    }
+
+    /// Pop a free block of @p size_class on @p node, own shard first.
+    Block* pop(std::size_t size_class, std::size_t node) {
+        const std::size_t home = detail::this_thread_shard();
+        for (std::size_t i = 0; i < detail::kStatsShards; ++i) {
+            FreeList& free = list(node, (home + i) % detail::kStatsShards, size_class);
+            std::lock_guard<std::mutex> lock(free.mtx);
+            if (!free.blocks.empty()) {
+                Block* block = free.blocks.back();
+                free.blocks.pop_back();
+                return block;
+            }
+        }
+        return nullptr;
+    }
+
+    /// Put @p block on the releasing thread's free list.
+    void push(Block* block) noexcept {
+        FreeList& free = list(block->node, detail::this_thread_shard(), block->size_class);
+        cached_bytes.fetch_add(block->capacity, std::memory_order_relaxed);
+        std::lock_guard<std::mutex> lock(free.mtx);
+        try {
+            free.blocks.push_back(block);
+        } catch (const std::bad_alloc&) {
+            cached_bytes.fetch_sub(block->capacity, std::memory_order_relaxed);
+            if (block->slab == nullptr) {
+                dedicated_cached_bytes.fetch_sub(block->capacity, std::memory_order_relaxed);
+                destroy(block);
+            }
+            // A slab block's header is leaked; its memory goes with the slab.
+        }
+    }
+
+    /// Return @p block to a free list, or unmap it if it is oversized or
+    /// over the cache budget.
+    void release(Block* block) noexcept {
+        outstanding.fetch_sub(1, std::memory_order_relaxed);
+        outstanding_bytes.fetch_sub(block->capacity, std::memory_order_relaxed);
+
+        if (block->slab != nullptr) {
+            push(block); // Slab memory is reclaimed by trim() or the pool.
+            return;
+        }
+        if (block->size_class != kOversized && !closed.load(std::memory_order_acquire)) {
+            std::size_t cached = dedicated_cached_bytes.load(std::memory_order_relaxed);
+            while (cached + block->capacity <= config.max_cached_bytes) {
+                if (dedicated_cached_bytes.compare_exchange_weak(
+                        cached, cached + block->capacity, std::memory_order_relaxed)) {
+                    push(block);
+                    return;
+                }
+            }
+        }
+        destroy(block);
+    }
+
+    /**
+     * @brief Unmap cached dedicated blocks and fully free slabs.
+     *
+     * Blocks are taken off the lists while they are counted, so a
+     * concurrent allocate() may map a fresh slab instead of waiting.
+     */
+    void trim() noexcept {
+        const std::size_t list_count = node_count * detail::kStatsShards * class_count;
+        std::vector<std::vector<Block*>> taken(list_count);
+        std::unordered_map<Slab*, std::size_t> free_per_slab;
+        for (std::size_t i = 0; i < list_count; ++i) {
+            {
+                std::lock_guard<std::mutex> lock(lists[i].mtx);
+                taken[i].swap(lists[i].blocks);
+            }
+            for (Block* block : taken[i]) {
+                if (block->slab != nullptr) {
+                    ++free_per_slab[block->slab];
+                }
+            }
+        }
+
+        for (std::size_t i = 0; i < list_count; ++i) {
+            std::vector<Block*> keep;
+            for (Block* block : taken[i]) {
+                Slab* slab = block->slab;
+                if (slab != nullptr && free_per_slab[slab] != slab->block_count) {
+                    keep.push_back(block);
+                    continue;
+                }
+                cached_bytes.fetch_sub(block->capacity, std::memory_order_relaxed);
+                if (slab == nullptr) {
+                    dedicated_cached_bytes.fetch_sub(block->capacity, std::memory_order_relaxed);
+                }
+                destroy(block);
+            }
+            if (!keep.empty()) {
+                std::lock_guard<std::mutex> lock(lists[i].mtx);
+                lists[i].blocks.insert(lists[i].blocks.end(), keep.begin(), keep.end());
+            }
+        }
+
+        std::lock_guard<std::mutex> lock(slabs_mtx);
+        auto end = std::remove_if(slabs.begin(), slabs.end(), [&](const std::unique_ptr<Slab>& slab) {
+            auto it = free_per_slab.find(slab.get());
+            if (it == free_per_slab.end() || it->second != slab->block_count) {
+                return false;
+            }
+            unmap(slab->base, slab->bytes);
+            return true;
+        });
+        slabs.erase(end, slabs.end());
+    }
+
+    const BufferPoolConfig      config;
+    const std::size_t           class_count;
+    const std::size_t           node_count;
+    std::unique_ptr<FreeList[]> lists; ///< [node][shard][class].
+
+    std::mutex                         slabs_mtx; ///< Protects slabs.
+    std::vector<std::unique_ptr<Slab>> slabs;     ///< Every mapped slab.
+
+    std::atomic<bool>        closed{false};       ///< Pool object destroyed; stop caching.
+    std::atomic<std::size_t> outstanding{0};
+    std::atomic<std::size_t> outstanding_bytes{0};
+    std::atomic<std::size_t> cached_bytes{0};
+    std::atomic<std::size_t> dedicated_cached_bytes{0}; ///< Part of cached_bytes under the budget.
+    std::atomic<std::size_t> mapped_bytes{0};
+    detail::ShardedCounters<kCounterCount> counters;
+};
+
+BufferPool::BufferPool(const BufferPoolConfig& config)
+    : impl_(std::make_shared<Impl>(config))
+{}
+
+/**
+ * @brief Drop cached blocks. Outstanding blocks are freed on release.
+ */
+BufferPool::~BufferPool() {
+    impl_->closed.store(true, std::memory_order_release);
+    impl_->trim();
+}
+
+/**
+ * @brief Pop a cached block of the right class and node, or map one.
+ */
+PoolBuffer BufferPool::allocate(std::size_t size, int node) noexcept {
+    Impl& impl = *impl_;
+    size = std::max<std::size_t>(size, 1);
+    const std::size_t home = impl.resolve_node(node);
+
+    Impl::Block* block = nullptr;
+    if (size > impl.config.max_pooled_bytes) {
+        impl.counters.add(Impl::kOversizedCount);
+        block = impl.dedicated_block(size, Impl::kOversized, home);
+    } else {
+        const std::size_t size_class = impl.class_for(size);
+        const std::size_t block_bytes = impl.config.min_block_bytes << size_class;
+        block = impl.pop(size_class, home);
+        if (block != nullptr) {
+            impl.cached_bytes.fetch_sub(block->capacity, std::memory_order_relaxed);
+            if (block->slab == nullptr) {
+                impl.dedicated_cached_bytes.fetch_sub(block->capacity, std::memory_order_relaxed);
+            }
+            impl.counters.add(Impl::kReused);
+        } else if (block_bytes < impl.config.slab_bytes) {
+            block = impl.carve_slab(size_class, home);
+        } else {
+            block = impl.dedicated_block(block_bytes, size_class, home);
+        }
+    }
+
+    if (block == nullptr) {
+        impl.counters.add(Impl::kFailures);
+        return {};
+    }
+    impl.counters.add(Impl::kAllocations);
+    impl.outstanding.fetch_add(1, std::memory_order_relaxed);
+    impl.outstanding_bytes.fetch_add(block->capacity, std::memory_order_relaxed);
+    block->owner = impl_;
+    return PoolBuffer(BufferView(block, block->memory, block->capacity), block->memory);
+}
+
+void BufferPool::trim() noexcept {
+    impl_->trim();
+}
+
+BufferPoolStats BufferPool::stats() const {
+    BufferPoolStats out;
+    out.allocations = impl_->counters.read(Impl::kAllocations);
+    out.reused = impl_->counters.read(Impl::kReused);
+    out.oversized = impl_->counters.read(Impl::kOversizedCount);
+    out.failures = impl_->counters.read(Impl::kFailures);
+    out.outstanding = impl_->outstanding.load(std::memory_order_relaxed);
+    out.outstanding_bytes = impl_->outstanding_bytes.load(std::memory_order_relaxed);
+    out.cached_bytes = impl_->cached_bytes.load(std::memory_order_relaxed);
+    out.mapped_bytes = impl_->mapped_bytes.load(std::memory_order_relaxed);
+    {
+        std::lock_guard<std::mutex> lock(impl_->slabs_mtx);
+        out.slabs = impl_->slabs.size();
+    }
+    out.numa_nodes = impl_->node_count;
+    out.huge_page_regions = impl_->counters.read(Impl::kHugePageRegions);
+    out.numa_bound_regions = impl_->counters.read(Impl::kNumaBoundRegions);
+    out.lock_failures = impl_->counters.read(Impl::kLockFailures);
+    return out;
+}
+
+const BufferPoolConfig& BufferPool::config() const noexcept {
+    return impl_->config;
+}
+
+std::shared_ptr<BufferPool> default_buffer_pool() {
+    static const std::shared_ptr<BufferPool> pool = std::make_shared<BufferPool>();
+    return pool;
+}
+
+} // namespace ds
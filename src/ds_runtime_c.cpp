@@ -4,6 +4,8 @@
 #include "ds_runtime_c.h"
 
 #include "ds_runtime.hpp"
+#include "ds_runtime_mmap.hpp"
+#include "ds_runtime_stats.hpp"
 
 #ifdef DS_RUNTIME_HAS_VULKAN
 #include "ds_runtime_vulkan.hpp"
@@ -12,8 +14,12 @@
 #include "ds_runtime_uring.hpp"
 #endif
 
+#include <algorithm>
 #include <atomic>
+#include <cerrno>
 #include <condition_variable>
+#include <cstddef>
+#include <cstring>
 #include <memory>
 #include <mutex>
 #include <utility>
@@ -65,6 +71,8 @@ ds_request_status to_c_status(ds::RequestStatus status) {
             return DS_REQUEST_IO_ERROR;
         case ds::RequestStatus::Cancelled:
             return DS_REQUEST_CANCELLED;
+        case ds::RequestStatus::Corrupt:
+            return DS_REQUEST_CORRUPT;
         case ds::RequestStatus::Pending:
         default:
             return DS_REQUEST_PENDING;
@@ -107,12 +115,13 @@ struct PendingRequest {
 };
 
 // C ABI queue wrapper. Owns a C++ backend and manages
-// pending submission and in-flight tracking.
+// pending submission, in-flight tracking and statistics.
 class CQueue {
 public:
     explicit CQueue(std::shared_ptr<ds::Backend> backend)
         : backend_(std::move(backend))
         , in_flight_(0)
+        , created_ns_(ds::detail::steady_now_ns())
     {}
 
     // Enqueue a request. Ownership of the C struct remains with the caller.
@@ -125,6 +134,7 @@ public:
         PendingRequest pending{to_cpp_request(*request), request};
         std::lock_guard<std::mutex> lock(mtx_);
         pending_.push_back(std::move(pending));
+        pending_count_.fetch_add(1, std::memory_order_relaxed);
     }
 
     // Submit all enqueued requests to the backend.
@@ -134,15 +144,23 @@ public:
         {
             std::lock_guard<std::mutex> lock(mtx_);
             to_submit.swap(pending_);
+            pending_count_.store(0, std::memory_order_relaxed);
+        }
+        if (!to_submit.empty()) {
+            counters_.add(kSubmitted, to_submit.size());
         }
 
+        const std::uint64_t submit_ns = ds::detail::steady_now_ns();
         for (auto& pending : to_submit) {
             in_flight_.fetch_add(1, std::memory_order_relaxed);
+            in_flight_bytes_.fetch_add(pending.cpp_request.size, std::memory_order_relaxed);
+            pending.cpp_request.submit_time_ns = submit_ns;
             ds_request* c_request = pending.c_request;
 
             backend_->submit(
                 std::move(pending.cpp_request),
                 [this, c_request, callback, user_data](ds::Request& completed) {
+                    record_completion(completed);
                     if (c_request) {
                         update_c_request(*c_request, completed);
                     }
@@ -175,13 +193,58 @@ public:
         return in_flight_.load(std::memory_order_acquire);
     }
 
+    std::uint64_t total_completed() const { return counters_.read(kCompleted); }
+    std::uint64_t total_failed() const { return counters_.read(kFailed); }
+    std::uint64_t total_bytes_transferred() const { return counters_.read(kBytes); }
+
+    // Fill a full stats snapshot. Only atomics and per-thread shards are
+    // read, so this never contends with enqueue()/submit_all().
+    void stats(ds_queue_stats& out) const {
+        out.elapsed_ns = ds::detail::steady_now_ns() - created_ns_;
+        out.pending = pending_count_.load(std::memory_order_relaxed);
+        out.in_flight = in_flight_.load(std::memory_order_acquire);
+        out.in_flight_bytes = in_flight_bytes_.load(std::memory_order_relaxed);
+        out.total_submitted = counters_.read(kSubmitted);
+        out.total_completed = counters_.read(kCompleted);
+        out.total_failed = counters_.read(kFailed);
+        out.total_bytes_transferred = counters_.read(kBytes);
+
+        const ds::LatencyHistogram latency = latency_.snapshot();
+        out.latency_mean_ns = static_cast<std::uint64_t>(latency.mean_ns());
+        out.latency_p50_ns = latency.percentile_ns(50.0);
+        out.latency_p90_ns = latency.percentile_ns(90.0);
+        out.latency_p99_ns = latency.percentile_ns(99.0);
+        out.latency_max_ns = latency.max_ns;
+    }
+
 private:
+    enum Counter : std::size_t { kSubmitted, kCompleted, kFailed, kBytes, kCounterCount };
+
+    // Runs on backend workers before the caller's callback sees the result.
+    void record_completion(const ds::Request& completed) {
+        counters_.add(kCompleted);
+        if (completed.status != ds::RequestStatus::Ok) {
+            counters_.add(kFailed);
+        }
+        counters_.add(kBytes, completed.bytes_transferred);
+        in_flight_bytes_.fetch_sub(completed.size, std::memory_order_relaxed);
+
+        const std::uint64_t now = ds::detail::steady_now_ns();
+        latency_.record(now >= completed.submit_time_ns ? now - completed.submit_time_ns : 0);
+    }
+
     std::shared_ptr<ds::Backend> backend_;
     mutable std::mutex mtx_;
     std::vector<PendingRequest> pending_;
     std::atomic<size_t> in_flight_;
+    std::atomic<size_t> in_flight_bytes_{0};
+    std::atomic<size_t> pending_count_{0};
     mutable std::mutex wait_mtx_;
     std::condition_variable wait_cv_;
+
+    const std::uint64_t created_ns_;
+    ds::detail::ShardedCounters<kCounterCount> counters_;
+    ds::detail::ShardedHistogram latency_;
 };
 
 } // namespace
@@ -198,6 +261,16 @@ ds_backend_t* ds_make_cpu_backend(size_t worker_count) {
     return new ds_backend_t{ds::make_cpu_backend(worker_count)};
 }
 
+ds_backend_t* ds_make_mmap_backend(const ds_mmap_backend_config* config) {
+    ds::MmapBackendConfig cpp_config{};
+    if (config) {
+        cpp_config.worker_count = config->worker_count;
+        cpp_config.populate_max_bytes = config->populate_max_bytes;
+        cpp_config.huge_pages = config->huge_pages != 0;
+    }
+    return new ds_backend_t{ds::make_mmap_backend(cpp_config)};
+}
+
 void ds_backend_release(ds_backend_t* backend) {
     delete backend;
 }
@@ -242,6 +315,46 @@ size_t ds_queue_in_flight(const ds_queue_t* queue) {
     return queue->queue->in_flight();
 }
 
+uint64_t ds_queue_total_completed(const ds_queue_t* queue) {
+    if (!queue) {
+        return 0;
+    }
+    return queue->queue->total_completed();
+}
+
+uint64_t ds_queue_total_failed(const ds_queue_t* queue) {
+    if (!queue) {
+        return 0;
+    }
+    return queue->queue->total_failed();
+}
+
+uint64_t ds_queue_total_bytes_transferred(const ds_queue_t* queue) {
+    if (!queue) {
+        return 0;
+    }
+    return queue->queue->total_bytes_transferred();
+}
+
+int ds_queue_get_stats(const ds_queue_t* queue, ds_queue_stats* stats) {
+    constexpr size_t kHeaderSize = offsetof(ds_queue_stats, elapsed_ns);
+    if (!queue || !stats || stats->struct_size < kHeaderSize) {
+        return EINVAL;
+    }
+
+    // Fill a full local copy, then hand back only what the caller's
+    // (possibly older, smaller) struct has room for.
+    ds_queue_stats full{};
+    full.struct_size = static_cast<uint32_t>(sizeof(ds_queue_stats));
+    full.version = DS_QUEUE_STATS_VERSION;
+    queue->queue->stats(full);
+
+    const size_t copy_size = std::min<size_t>(stats->struct_size, sizeof(ds_queue_stats));
+    full.struct_size = static_cast<uint32_t>(copy_size);
+    std::memcpy(stats, &full, copy_size);
+    return 0;
+}
+
 #ifdef DS_RUNTIME_HAS_VULKAN
 ds_backend_t* ds_make_vulkan_backend(const ds_vulkan_backend_config* config) {
     if (!config) {
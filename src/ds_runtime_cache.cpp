@@ -0,0 +1,361 @@
+// SPDX-License-Identifier: Apache-2.0
+// Decoded-asset cache for ds-runtime.
+//
+// Every cacheable read looks its key up in one shard of the index. A hit
+// completes immediately from the stored BufferView. A miss registers the
+// request as the leader of an in-flight entry and forwards one read to the
+// wrapped backend; identical reads arriving meanwhile wait on that entry.
+// When the read completes, the result is stored and fanned out to every
+// waiter outside the shard lock.
+
+#include "ds_runtime_cache.hpp"
+#include "ds_runtime_buffer.hpp"
+#include "ds_runtime_read_key.hpp"
+#include "ds_runtime_ring.hpp"
+#include "ds_runtime_shared_read.hpp"
+#include "ds_runtime_stats.hpp"
+#include "ds_runtime_trace.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include <sys/stat.h>
+
+namespace ds {
+
+namespace {
+
+/// Charged per entry on top of its bytes, so empty results still count
+/// against the budget and the entry count stays bounded.
+constexpr std::size_t kEntryOverhead = 128;
+
+using CacheKey = detail::ReadKey;
+using CacheKeyHash = detail::ReadKeyHash;
+
+class CachingBackendImpl final : public CachingBackend {
+public:
+    CachingBackendImpl(std::shared_ptr<Backend> inner, const CacheConfig& config)
+        : buffer_pool_(config.buffer_pool ? config.buffer_pool : default_buffer_pool())
+        , inner_buffers_(inner->provides_buffers())
+        , inner_(std::move(inner))
+    {
+        const std::size_t shard_count = std::max<std::size_t>(config.shard_count, 1);
+        shard_budget_ = config.capacity_bytes / shard_count;
+        protected_budget_ =
+            shard_budget_ / 100 * std::min<unsigned>(config.protected_percent, 100);
+        max_entry_bytes_ = config.max_entry_bytes != 0
+            ? config.max_entry_bytes
+            : (shard_budget_ > kEntryOverhead ? shard_budget_ - kEntryOverhead : 0);
+        shards_.reserve(shard_count);
+        for (std::size_t i = 0; i < shard_count; ++i) {
+            shards_.push_back(std::make_unique<Shard>());
+        }
+    }
+
+    void submit(Request req, CompletionCallback on_complete) override {
+        if (req.op == RequestOp::Write) {
+            forward_write(std::move(req), std::move(on_complete));
+            return;
+        }
+
+        CacheKey key;
+        const bool eligible = detail::is_shareable_read(req) &&
+                              req.size <= max_entry_bytes_ &&
+                              detail::make_read_key(req, key);
+        if (!eligible) {
+            counters_.add(kBypassed);
+            if (req.dst_memory != RequestMemory::Runtime || inner_buffers_) {
+                inner_->submit(std::move(req), std::move(on_complete));
+                return;
+            }
+            // provides_buffers() promises Runtime reads a buffer.
+            fetch(std::move(req), [on_complete](Request& done, BufferView view) {
+                detail::deliver_shared_read(Waiter{done, on_complete}, done, view);
+            });
+            return;
+        }
+
+        Shard& shard = shard_for(key);
+        BufferView hit;
+        {
+            std::lock_guard<std::mutex> lock(shard.mtx);
+            const auto found = shard.index.find(key);
+            if (found != shard.index.end()) {
+                touch(shard, found->second);
+                hit = found->second->view;
+            } else {
+                auto [waiters, leader] = shard.inflight.try_emplace(key);
+                waiters->second.push_back(Waiter{req, std::move(on_complete)});
+                if (!leader) {
+                    counters_.add(kCoalesced);
+                    return;
+                }
+            }
+        }
+
+        if (hit) {
+            counters_.add(kHits);
+            req.start_time_ns = detail::steady_now_ns();
+            trace::Span span("cache", "hit", req);
+            Request result = req;
+            result.status = RequestStatus::Ok;
+            result.errno_value = 0;
+            detail::deliver_shared_read(Waiter{std::move(req), std::move(on_complete)}, result, hit);
+            return;
+        }
+
+        counters_.add(kMisses);
+        fetch(std::move(req), [this, key](Request& done, BufferView view) {
+            complete(key, done, std::move(view));
+        });
+    }
+
+    // The cache hands out its own views for Runtime reads.
+    bool provides_buffers() const noexcept override { return true; }
+
+    // The wrapped backend's counters plus cache_* counters.
+    BackendStats stats() const override {
+        BackendStats out = inner_->stats();
+        const CacheStats cache = cache_stats();
+        out.counters.push_back({"cache_hits", cache.hits});
+        out.counters.push_back({"cache_misses", cache.misses});
+        out.counters.push_back({"cache_coalesced", cache.coalesced});
+        out.counters.push_back({"cache_bypassed", cache.bypassed});
+        out.counters.push_back({"cache_insertions", cache.insertions});
+        out.counters.push_back({"cache_evictions", cache.evictions});
+        out.counters.push_back({"cache_invalidations", cache.invalidations});
+        out.counters.push_back({"cache_entries", cache.entries});
+        out.counters.push_back({"cache_bytes", cache.bytes});
+        return out;
+    }
+
+    CacheStats cache_stats() const override {
+        CacheStats out;
+        out.hits = counters_.read(kHits);
+        out.misses = counters_.read(kMisses);
+        out.coalesced = counters_.read(kCoalesced);
+        out.bypassed = counters_.read(kBypassed);
+        out.insertions = counters_.read(kInsertions);
+        out.evictions = counters_.read(kEvictions);
+        out.invalidations = counters_.read(kInvalidations);
+        out.promotions = counters_.read(kPromotions);
+        for (const auto& shard : shards_) {
+            std::lock_guard<std::mutex> lock(shard->mtx);
+            out.entries += shard->index.size();
+            out.bytes += shard->bytes;
+            out.protected_bytes += shard->protected_bytes;
+        }
+        return out;
+    }
+
+    void invalidate(int fd) override {
+        struct stat st{};
+        if (::fstat(fd, &st) == 0) {
+            drop_if([&st](const CacheKey& key) {
+                return key.dev == st.st_dev && key.ino == st.st_ino;
+            });
+        }
+    }
+
+    void clear() override {
+        drop_if([](const CacheKey&) { return true; });
+    }
+
+private:
+    enum Counter : std::size_t {
+        kHits,
+        kMisses,
+        kCoalesced,
+        kBypassed,
+        kInsertions,
+        kEvictions,
+        kInvalidations,
+        kPromotions,
+        kCounterCount
+    };
+
+    struct Entry {
+        CacheKey    key;
+        BufferView  view;
+        std::size_t charge = 0;
+        bool        is_protected = false;
+    };
+    using EntryList = std::list<Entry>;
+
+    using Waiter = detail::ReadWaiter;
+
+    /// One independently locked part of the index. Both segments keep the
+    /// most recently used entry at the front.
+    struct alignas(detail::kCacheLineSize) Shard {
+        std::mutex mtx;
+        EntryList  probation;
+        EntryList  protect;
+        std::unordered_map<CacheKey, EntryList::iterator, CacheKeyHash> index;
+        std::unordered_map<CacheKey, std::vector<Waiter>, CacheKeyHash> inflight;
+        std::size_t bytes = 0;
+        std::size_t protected_bytes = 0;
+    };
+
+    Shard& shard_for(const CacheKey& key) {
+        return *shards_[CacheKeyHash{}(key) % shards_.size()];
+    }
+
+    /// Read @p req through inner_ into memory the cache can keep.
+    void fetch(Request req, detail::SharedReadCallback on_done) {
+        detail::fetch_shared_read(*inner_, inner_buffers_, *buffer_pool_, "cache",
+                                  std::move(req), std::move(on_done));
+    }
+
+    /**
+     * @brief Finish a single-flighted miss: store the result and complete
+     *        every waiter.
+     */
+    void complete(const CacheKey& key, Request& result, BufferView view) {
+        Shard& shard = shard_for(key);
+        std::vector<Waiter> waiters;
+        std::vector<BufferView> evicted;
+        {
+            std::lock_guard<std::mutex> lock(shard.mtx);
+            const auto found = shard.inflight.find(key);
+            if (found != shard.inflight.end()) {
+                waiters = std::move(found->second);
+                shard.inflight.erase(found);
+            }
+            if (result.status == RequestStatus::Ok) {
+                insert(shard, key, view, evicted);
+            }
+        }
+        evicted.clear(); // Recycle outside the shard lock.
+
+        for (auto& waiter : waiters) {
+            detail::deliver_shared_read(std::move(waiter), result, view);
+        }
+    }
+
+    /// Writes pass through; entries of the file are dropped before the
+    /// write starts and again once it lands, so a read that raced it
+    /// cannot leave stale bytes behind.
+    void forward_write(Request req, CompletionCallback on_complete) {
+        struct stat st{};
+        const bool known = ::fstat(req.fd, &st) == 0;
+        const auto same_file = [dev = st.st_dev, ino = st.st_ino](const CacheKey& key) {
+            return key.dev == dev && key.ino == ino;
+        };
+        if (known) {
+            drop_if(same_file);
+        }
+        inner_->submit(std::move(req),
+                       [this, known, same_file, on_complete = std::move(on_complete)](Request& done) {
+            if (known) {
+                drop_if(same_file);
+            }
+            if (on_complete) {
+                on_complete(done);
+            }
+        });
+    }
+
+    /// Mark @p it used: move it to the front of its segment, promoting a
+    /// probationary entry into the protected segment. Caller holds the lock.
+    void touch(Shard& shard, EntryList::iterator it) {
+        if (it->is_protected) {
+            shard.protect.splice(shard.protect.begin(), shard.protect, it);
+            return;
+        }
+        shard.protect.splice(shard.protect.begin(), shard.probation, it);
+        it->is_protected = true;
+        shard.protected_bytes += it->charge;
+        counters_.add(kPromotions);
+        // Demote the least recently used protected entries back to
+        // probation, where they get one more chance before eviction.
+        while (shard.protected_bytes > protected_budget_ && shard.protect.size() > 1) {
+            auto victim = std::prev(shard.protect.end());
+            victim->is_protected = false;
+            shard.protected_bytes -= victim->charge;
+            shard.probation.splice(shard.probation.begin(), shard.protect, victim);
+        }
+    }
+
+    /// Insert a fresh result into probation and evict down to budget.
+    /// Evicted views are moved into @p evicted so they are released after
+    /// the lock is dropped. Caller holds the lock.
+    void insert(Shard& shard, const CacheKey& key, const BufferView& view,
+                std::vector<BufferView>& evicted) {
+        const std::size_t charge = view.size() + kEntryOverhead;
+        if (charge > shard_budget_ || shard.index.count(key) != 0) {
+            return;
+        }
+        shard.probation.push_front(Entry{key, view, charge, false});
+        shard.index.emplace(key, shard.probation.begin());
+        shard.bytes += charge;
+        counters_.add(kInsertions);
+
+        while (shard.bytes > shard_budget_) {
+            EntryList& from = shard.probation.empty() ? shard.protect : shard.probation;
+            auto victim = std::prev(from.end());
+            evicted.push_back(std::move(victim->view));
+            erase(shard, victim);
+            counters_.add(kEvictions);
+        }
+    }
+
+    /// Unlink @p it from its segment and the index. Caller holds the lock.
+    static void erase(Shard& shard, EntryList::iterator it) {
+        shard.bytes -= it->charge;
+        shard.index.erase(it->key);
+        if (it->is_protected) {
+            shard.protected_bytes -= it->charge;
+            shard.protect.erase(it);
+        } else {
+            shard.probation.erase(it);
+        }
+    }
+
+    /// Drop every entry whose key satisfies @p pred.
+    template <typename Pred>
+    void drop_if(const Pred& pred) {
+        for (auto& shard : shards_) {
+            std::vector<BufferView> dropped;
+            {
+                std::lock_guard<std::mutex> lock(shard->mtx);
+                for (EntryList* list : {&shard->probation, &shard->protect}) {
+                    for (auto it = list->begin(); it != list->end();) {
+                        auto next = std::next(it);
+                        if (pred(it->key)) {
+                            dropped.push_back(std::move(it->view));
+                            erase(*shard, it);
+                            counters_.add(kInvalidations);
+                        }
+                        it = next;
+                    }
+                }
+            }
+        }
+    }
+
+    const std::shared_ptr<BufferPool> buffer_pool_; ///< Destination of misses when inner_ has no buffers.
+    const bool  inner_buffers_;         ///< inner_->provides_buffers().
+    std::size_t shard_budget_ = 0;      ///< Bytes (with overhead) per shard.
+    std::size_t protected_budget_ = 0;  ///< Protected-segment bytes per shard.
+    std::size_t max_entry_bytes_ = 0;   ///< Larger reads bypass the cache.
+    std::vector<std::unique_ptr<Shard>> shards_;
+    detail::ShardedCounters<kCounterCount> counters_;
+    /// Declared last so it is released first: a backend owned only by the
+    /// cache drains its workers while the shards are still alive.
+    const std::shared_ptr<Backend> inner_;
+};
+
+} // namespace
+
+std::shared_ptr<CachingBackend> make_caching_backend(std::shared_ptr<Backend> inner,
+                                                     const CacheConfig& config) {
+    return std::make_shared<CachingBackendImpl>(std::move(inner), config);
+}
+
+} // namespace ds
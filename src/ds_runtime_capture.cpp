@@ -0,0 +1,214 @@
+// SPDX-License-Identifier: Apache-2.0
+// Request capture for ds-runtime.
+//
+// Text format, one record per line:
+//   ds-capture 1
+//   file <id> <extent> <name>
+//   req <time_ns> <file_id> <r|w> <none|fake_uppercase|gdeflate> <offset> <size>
+// File lines come first and ids are dense, starting at 0. Names run to the
+// end of the line and may contain spaces.
+
+#include "ds_runtime_capture.hpp"
+#include "ds_runtime_stats.hpp" // steady_now_ns
+
+#include <algorithm>
+#include <fstream>
+#include <istream>
+#include <ostream>
+#include <sstream>
+
+namespace ds {
+
+namespace {
+
+constexpr const char* kMagic = "ds-capture";
+constexpr int         kFormatVersion = 1;
+
+const char* compression_name(Compression c) {
+    switch (c) {
+    case Compression::FakeUppercase: return "fake_uppercase";
+    case Compression::GDeflate:      return "gdeflate";
+    case Compression::None:          break;
+    }
+    return "none";
+}
+
+bool parse_compression(const std::string& s, Compression& out) {
+    if (s == "none") {
+        out = Compression::None;
+    } else if (s == "fake_uppercase") {
+        out = Compression::FakeUppercase;
+    } else if (s == "gdeflate") {
+        out = Compression::GDeflate;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+} // namespace
+
+RequestCapture::RequestCapture()
+    : start_ns_(detail::steady_now_ns())
+{}
+
+/**
+ * @brief Bind @p fd to a file called @p name, allocating a new id if the
+ * fd was unnamed or named differently.
+ */
+void RequestCapture::name_file(int fd, const std::string& name) {
+    std::lock_guard<std::mutex> lock(mtx_);
+    auto it = fd_to_file_.find(fd);
+    if (it != fd_to_file_.end()) {
+        CapturedFile& file = trace_.files[it->second];
+        if (file.name == name) {
+            return;
+        }
+        if (file.extent == 0) {
+            // Nothing recorded against the old name yet; just relabel.
+            file.name = name;
+            return;
+        }
+    }
+    const auto id = static_cast<std::uint32_t>(trace_.files.size());
+    trace_.files.push_back(CapturedFile{name, 0});
+    fd_to_file_[fd] = id;
+}
+
+/**
+ * @brief File id for @p fd, creating an "fd<N>" entry on first use.
+ */
+std::uint32_t RequestCapture::file_id_locked(int fd) {
+    auto it = fd_to_file_.find(fd);
+    if (it != fd_to_file_.end()) {
+        return it->second;
+    }
+    const auto id = static_cast<std::uint32_t>(trace_.files.size());
+    trace_.files.push_back(CapturedFile{"fd" + std::to_string(fd), 0});
+    fd_to_file_.emplace(fd, id);
+    return id;
+}
+
+void RequestCapture::record(const Request& req) noexcept {
+    CapturedRequest entry;
+    entry.op = req.op;
+    entry.compression = req.compression;
+    entry.offset = req.offset;
+    entry.size = req.size;
+
+    std::lock_guard<std::mutex> lock(mtx_);
+    // Timestamp under the lock so entries stay in time order.
+    const std::uint64_t now = detail::steady_now_ns();
+    entry.time_ns = now > start_ns_ ? now - start_ns_ : 0;
+    try {
+        entry.file_id = file_id_locked(req.fd);
+        trace_.requests.push_back(entry);
+    } catch (...) {
+        ++dropped_;
+        return;
+    }
+    CapturedFile& file = trace_.files[entry.file_id];
+    file.extent = std::max<std::uint64_t>(file.extent, req.offset + req.size);
+}
+
+CaptureTrace RequestCapture::snapshot() const {
+    std::lock_guard<std::mutex> lock(mtx_);
+    return trace_;
+}
+
+std::size_t RequestCapture::size() const {
+    std::lock_guard<std::mutex> lock(mtx_);
+    return trace_.requests.size();
+}
+
+std::size_t RequestCapture::dropped() const {
+    std::lock_guard<std::mutex> lock(mtx_);
+    return dropped_;
+}
+
+bool write_capture(std::ostream& out, const CaptureTrace& trace) {
+    out << kMagic << ' ' << kFormatVersion << '\n';
+    for (std::size_t i = 0; i < trace.files.size(); ++i) {
+        std::string name = trace.files[i].name;
+        std::replace(name.begin(), name.end(), '\n', ' ');
+        out << "file " << i << ' ' << trace.files[i].extent << ' ' << name << '\n';
+    }
+    for (const auto& r : trace.requests) {
+        out << "req " << r.time_ns << ' ' << r.file_id << ' '
+            << (r.op == RequestOp::Write ? 'w' : 'r') << ' '
+            << compression_name(r.compression) << ' '
+            << r.offset << ' ' << r.size << '\n';
+    }
+    return static_cast<bool>(out);
+}
+
+bool write_capture(const std::string& path, const CaptureTrace& trace) {
+    std::ofstream file(path, std::ios::out | std::ios::trunc);
+    if (!file) {
+        return false;
+    }
+    write_capture(file, trace);
+    file.flush();
+    return static_cast<bool>(file);
+}
+
+/**
+ * @brief Parse the text format line by line, validating file references.
+ */
+bool read_capture(std::istream& in, CaptureTrace& out) {
+    out = CaptureTrace{};
+
+    std::string line;
+    if (!std::getline(in, line)) {
+        return false;
+    }
+    {
+        std::istringstream header(line);
+        std::string magic;
+        int version = 0;
+        if (!(header >> magic >> version) || magic != kMagic || version != kFormatVersion) {
+            return false;
+        }
+    }
+
+    while (std::getline(in, line)) {
+        if (line.empty()) {
+            continue;
+        }
+        std::istringstream fields(line);
+        std::string kind;
+        fields >> kind;
+        if (kind == "file") {
+            std::size_t id = 0;
+            CapturedFile file;
+            if (!(fields >> id >> file.extent) || id != out.files.size()) {
+                return false;
+            }
+            fields >> std::ws;
+            std::getline(fields, file.name);
+            out.files.push_back(std::move(file));
+        } else if (kind == "req") {
+            CapturedRequest r;
+            char op = 0;
+            std::string compression;
+            if (!(fields >> r.time_ns >> r.file_id >> op >> compression >> r.offset >> r.size) ||
+                (op != 'r' && op != 'w') ||
+                !parse_compression(compression, r.compression) ||
+                r.file_id >= out.files.size()) {
+                return false;
+            }
+            r.op = op == 'w' ? RequestOp::Write : RequestOp::Read;
+            out.requests.push_back(r);
+        } else {
+            return false;
+        }
+    }
+    return !in.bad();
+}
+
+bool read_capture(const std::string& path, CaptureTrace& out) {
+    std::ifstream file(path);
+    return file && read_capture(file, out);
+}
+
+} // namespace ds
@@ -0,0 +1,237 @@
+// SPDX-License-Identifier: Apache-2.0
+// Checksums for ds-runtime.
+//
+// CRC-32C runs on the CPU's CRC32C instructions where they exist: SSE4.2
+// crc32 on x86, the ARMv8 CRC extension on AArch64. Both consume eight
+// bytes per instruction, several times faster than tables, which matters
+// when every decoded block is checked. The instructions are compiled with
+// a per-function target attribute and chosen at first use, so the library
+// itself builds for the baseline ISA.
+//
+// One crc32 chain is bound by the instruction's latency, not its
+// throughput. With PCLMULQDQ as well, long inputs are cut into three
+// stripes checksummed as independent chains, which are then folded into
+// one by carry-less multiplication with x^(8 * stripe bytes) mod P.
+//
+// Elsewhere, and on big-endian hosts, the slice-by-8 table method is used:
+// eight 256-entry tables, built once, consume eight input bytes per step.
+
+#include "ds_runtime_checksum.hpp"
+
+#include <array>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <nmmintrin.h>
+#include <wmmintrin.h>
+#define DS_CRC32C_X86 1
+#elif defined(__aarch64__) && defined(__linux__)
+#include <arm_acle.h>
+#include <asm/hwcap.h>
+#include <sys/auxv.h>
+#define DS_CRC32C_ARM 1
+#endif
+
+namespace ds {
+
+namespace {
+
+/// Reflected Castagnoli polynomial.
+constexpr std::uint32_t kCrc32cPoly = 0x82f63b78u;
+
+using CrcTables = std::array<std::array<std::uint32_t, 256>, 8>;
+
+constexpr CrcTables make_tables() {
+    CrcTables tables{};
+    for (std::uint32_t i = 0; i < 256; ++i) {
+        std::uint32_t crc = i;
+        for (int bit = 0; bit < 8; ++bit) {
+            crc = (crc >> 1) ^ ((crc & 1u) ? kCrc32cPoly : 0u);
+        }
+        tables[0][i] = crc;
+    }
+    for (std::size_t t = 1; t < tables.size(); ++t) {
+        for (std::size_t i = 0; i < 256; ++i) {
+            const std::uint32_t prev = tables[t - 1][i];
+            tables[t][i] = (prev >> 8) ^ tables[0][prev & 0xffu];
+        }
+    }
+    return tables;
+}
+
+constexpr CrcTables kTables = make_tables();
+
+/// x^n mod P in reflected bit order.
+constexpr std::uint32_t x_pow_mod(std::size_t n) {
+    std::uint32_t v = 0x80000000u; // x^0
+    while (n-- != 0) {
+        v = (v & 1u) ? (v >> 1) ^ kCrc32cPoly : v >> 1;
+    }
+    return v;
+}
+
+/// Checksum kernel; @p crc is the running, already inverted value.
+using CrcKernel = std::uint32_t (*)(const unsigned char* p, std::size_t size, std::uint32_t crc);
+
+std::uint32_t crc32c_tables(const unsigned char* p, std::size_t size, std::uint32_t crc) {
+    while (size >= 8) {
+        std::uint32_t lo = 0;
+        std::uint32_t hi = 0;
+        std::memcpy(&lo, p, 4);
+        std::memcpy(&hi, p + 4, 4);
+        if constexpr (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__) {
+            lo = __builtin_bswap32(lo);
+            hi = __builtin_bswap32(hi);
+        }
+        lo ^= crc;
+        crc = kTables[7][lo & 0xffu] ^ kTables[6][(lo >> 8) & 0xffu] ^
+              kTables[5][(lo >> 16) & 0xffu] ^ kTables[4][lo >> 24] ^
+              kTables[3][hi & 0xffu] ^ kTables[2][(hi >> 8) & 0xffu] ^
+              kTables[1][(hi >> 16) & 0xffu] ^ kTables[0][hi >> 24];
+        p += 8;
+        size -= 8;
+    }
+    while (size-- != 0) {
+        crc = (crc >> 8) ^ kTables[0][(crc ^ *p++) & 0xffu];
+    }
+    return crc;
+}
+
+#if defined(DS_CRC32C_X86)
+
+__attribute__((target("sse4.2")))
+std::uint32_t crc32c_sse42(const unsigned char* p, std::size_t size, std::uint32_t crc) {
+    // Byte steps up to an 8-byte boundary keep the wide loads aligned.
+    while (size != 0 && (reinterpret_cast<std::uintptr_t>(p) & 7u) != 0) {
+        crc = _mm_crc32_u8(crc, *p++);
+        --size;
+    }
+#if defined(__x86_64__)
+    std::uint64_t wide = crc;
+    for (; size >= 8; p += 8, size -= 8) {
+        std::uint64_t word = 0;
+        std::memcpy(&word, p, 8);
+        wide = _mm_crc32_u64(wide, word);
+    }
+    crc = static_cast<std::uint32_t>(wide);
+#endif
+    for (; size >= 4; p += 4, size -= 4) {
+        std::uint32_t word = 0;
+        std::memcpy(&word, p, 4);
+        crc = _mm_crc32_u32(crc, word);
+    }
+    while (size-- != 0) {
+        crc = _mm_crc32_u8(crc, *p++);
+    }
+    return crc;
+}
+
+#if defined(__x86_64__)
+
+/// Bytes per stripe of the three-chain kernel.
+constexpr std::size_t kStripe = 2048;
+
+// Folding constants. The product of two reflected 32-bit values, read
+// back by crc32, gains a factor of x^33, which they pre-divide.
+constexpr std::uint32_t kShift1 = x_pow_mod(8 * kStripe - 33);
+constexpr std::uint32_t kShift2 = x_pow_mod(16 * kStripe - 33);
+
+/// Advance a running CRC over @p k's worth of zero bytes.
+__attribute__((target("sse4.2,pclmul")))
+inline std::uint32_t fold(std::uint64_t crc, std::uint32_t k) {
+    const __m128i product = _mm_clmulepi64_si128(_mm_cvtsi64_si128(static_cast<long long>(crc)),
+                                                 _mm_cvtsi32_si128(static_cast<int>(k)), 0x00);
+    return static_cast<std::uint32_t>(_mm_crc32_u64(0, static_cast<std::uint64_t>(_mm_cvtsi128_si64(product))));
+}
+
+__attribute__((target("sse4.2,pclmul")))
+std::uint32_t crc32c_sse42_clmul(const unsigned char* p, std::size_t size, std::uint32_t crc) {
+    if (size < 3 * kStripe) {
+        return crc32c_sse42(p, size, crc);
+    }
+    while (size != 0 && (reinterpret_cast<std::uintptr_t>(p) & 7u) != 0) {
+        crc = _mm_crc32_u8(crc, *p++);
+        --size;
+    }
+    for (; size >= 3 * kStripe; p += 3 * kStripe, size -= 3 * kStripe) {
+        std::uint64_t a = crc;
+        std::uint64_t b = 0;
+        std::uint64_t c = 0;
+        for (std::size_t i = 0; i < kStripe; i += 8) {
+            std::uint64_t wa = 0;
+            std::uint64_t wb = 0;
+            std::uint64_t wc = 0;
+            std::memcpy(&wa, p + i, 8);
+            std::memcpy(&wb, p + kStripe + i, 8);
+            std::memcpy(&wc, p + 2 * kStripe + i, 8);
+            a = _mm_crc32_u64(a, wa);
+            b = _mm_crc32_u64(b, wb);
+            c = _mm_crc32_u64(c, wc);
+        }
+        crc = fold(a, kShift2) ^ fold(b, kShift1) ^ static_cast<std::uint32_t>(c);
+    }
+    return crc32c_sse42(p, size, crc);
+}
+
+#endif
+
+CrcKernel pick_kernel() {
+    if (!__builtin_cpu_supports("sse4.2")) {
+        return crc32c_tables;
+    }
+#if defined(__x86_64__)
+    if (__builtin_cpu_supports("pclmul")) {
+        return crc32c_sse42_clmul;
+    }
+#endif
+    return crc32c_sse42;
+}
+
+#elif defined(DS_CRC32C_ARM)
+
+__attribute__((target("+crc")))
+std::uint32_t crc32c_armv8(const unsigned char* p, std::size_t size, std::uint32_t crc) {
+    while (size != 0 && (reinterpret_cast<std::uintptr_t>(p) & 7u) != 0) {
+        crc = __crc32cb(crc, *p++);
+        --size;
+    }
+    for (; size >= 8; p += 8, size -= 8) {
+        std::uint64_t word = 0;
+        std::memcpy(&word, p, 8);
+        crc = __crc32cd(crc, word);
+    }
+    while (size-- != 0) {
+        crc = __crc32cb(crc, *p++);
+    }
+    return crc;
+}
+
+CrcKernel pick_kernel() {
+    if constexpr (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__) {
+        return crc32c_tables;
+    }
+    return (::getauxval(AT_HWCAP) & HWCAP_CRC32) != 0 ? crc32c_armv8 : crc32c_tables;
+}
+
+#else
+
+CrcKernel pick_kernel() { return crc32c_tables; }
+
+#endif
+
+CrcKernel kernel() noexcept {
+    static const CrcKernel picked = pick_kernel();
+    return picked;
+}
+
+} // namespace
+
+std::uint32_t crc32c(const void* data, std::size_t size, std::uint32_t crc) noexcept {
+    return ~kernel()(static_cast<const unsigned char*>(data), size, ~crc);
+}
+
+bool crc32c_hardware() noexcept {
+    return kernel() != crc32c_tables;
+}
+
+} // namespace ds
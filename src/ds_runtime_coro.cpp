@@ -0,0 +1,52 @@
+// SPDX-License-Identifier: Apache-2.0
+// Coroutine executors for ds-runtime.
+
+#include "ds_runtime_coro.hpp"
+
+namespace ds::coro {
+
+/**
+ * @brief Shared InlineExecutor used as the default for awaitables.
+ */
+InlineExecutor& inline_executor() {
+    static InlineExecutor executor;
+    return executor;
+}
+
+/**
+ * @brief Queue a coroutine for the next run_pending() call.
+ */
+void ManualExecutor::post(std::coroutine_handle<> handle) {
+    std::lock_guard<std::mutex> lock(mtx_);
+    ready_.push_back(handle);
+}
+
+/**
+ * @brief Resume the coroutines posted so far on the calling thread.
+ *
+ * The ready list is swapped out under the lock and resumed without it, so
+ * coroutines may post follow-up work (or await again) while running.
+ * Both vectors keep their capacity between calls.
+ */
+std::size_t ManualExecutor::run_pending() {
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        running_.swap(ready_);
+    }
+    const std::size_t count = running_.size();
+    for (const auto handle : running_) {
+        handle.resume();
+    }
+    running_.clear();
+    return count;
+}
+
+/**
+ * @brief Number of coroutines waiting for run_pending().
+ */
+std::size_t ManualExecutor::pending() const {
+    std::lock_guard<std::mutex> lock(mtx_);
+    return ready_.size();
+}
+
+} // namespace ds::coro
@@ -0,0 +1,97 @@
+// SPDX-License-Identifier: Apache-2.0
+// GDeflate stream index shared by the decoding backends.
+//
+// A stream is a FileHeader, a table of header.block_count BlockInfo
+// records, then the payload that block offsets count from. Blocks decode
+// back to back, in table order, into the destination. Both the CPU
+// backend's block-parallel decode and the streaming decoder read the
+// header and table first and check them here before touching the payload.
+// The index views the bytes it was read into through a
+// gdeflate::StreamView rather than copying the table out of them.
+//
+// Streams flagged FLAG_BLOCK_CRC32C carry the CRC-32C of each decoded
+// block. Decoders check it right after the block is written, while it is
+// still in cache, and fail the read with EBADMSG on a mismatch.
+
+#pragma once
+
+#include "ds_runtime_checksum.hpp"
+#include "gdeflate_format.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <utility>
+#include <vector>
+
+namespace ds::detail {
+
+/// Checked layout of one GDeflate stream.
+struct GDeflateIndex {
+    std::vector<char>    bytes;           ///< Header and block table as read.
+    gdeflate::StreamView stream;          ///< Over bytes.
+    std::span<const gdeflate::BlockInfo> blocks;
+    std::span<const std::uint64_t> dst_offsets; ///< Decoded offset of each block.
+    std::uint64_t payload_offset = 0;     ///< From the stream start to block offset 0.
+    std::size_t   decoded_size = 0;
+    std::uint32_t max_compressed = 0;     ///< Largest compressed block.
+    bool          checksummed = false;    ///< Blocks carry CRC-32C of their decoded bytes.
+};
+
+/// Bytes of the block table that follows @p header.
+inline std::size_t gdeflate_table_bytes(const gdeflate::FileHeader& header) noexcept {
+    return std::size_t{header.block_count} * sizeof(gdeflate::BlockInfo);
+}
+
+/// Check the stream header in @p data against a destination of
+/// @p capacity bytes. Returns null, or a description with @p err set.
+inline const char* check_gdeflate_header(const void* data, std::size_t size, std::size_t capacity,
+                                         gdeflate::FileHeader& header, int& err) {
+    err = EINVAL;
+    if (!gdeflate::parse_file_header(data, size, header)) {
+        return "Not a GDeflate stream";
+    }
+    if (header.uncompressed_size > capacity) {
+        err = EOVERFLOW;
+        return "GDeflate stream decodes past the destination";
+    }
+    // Every block decodes to at least one byte.
+    if (header.block_count > header.uncompressed_size) {
+        return "Corrupt GDeflate block count";
+    }
+    err = 0;
+    return nullptr;
+}
+
+/// Take the header and block table in @p bytes into @p index once
+/// gdeflate::StreamView has vetted them: every block inside the payload,
+/// none overlapping, sizes adding up. Returns null, or a description with
+/// @p err set to EINVAL.
+inline const char* build_gdeflate_index(std::vector<char> bytes, GDeflateIndex& index, int& err) {
+    err = EINVAL;
+    index.bytes = std::move(bytes);
+    const gdeflate::ParseStatus status = index.stream.open(index.bytes.data(), index.bytes.size());
+    if (status != gdeflate::ParseStatus::Ok) {
+        return gdeflate::parse_status_string(status);
+    }
+
+    const gdeflate::StreamView& stream = index.stream;
+    index.blocks = stream.blocks();
+    index.dst_offsets = stream.decoded_offsets().first(stream.block_count());
+    index.decoded_size = static_cast<std::size_t>(stream.decoded_size());
+    index.max_compressed = stream.max_compressed_size();
+    index.payload_offset = stream.payload_offset();
+    index.checksummed = (stream.header().flags & gdeflate::FLAG_BLOCK_CRC32C) != 0;
+    err = 0;
+    return nullptr;
+}
+
+/// True when block @p b, decoded at @p data, matches its checksum.
+inline bool gdeflate_block_intact(const GDeflateIndex& index, std::size_t b, const void* data) noexcept {
+    const gdeflate::BlockInfo& block = index.blocks[b];
+    return crc32c(data, block.uncompressed_size) == block.checksum;
+}
+
+} // namespace ds::detail
@@ -29,6 +29,15 @@ std::string format_timestamp(const std::chrono::system_clock::time_point& tp) {
     return oss.str();
 }
 
+const char* memory_name(RequestMemory memory) {
+    switch (memory) {
+    case RequestMemory::Gpu:     return "gpu";
+    case RequestMemory::Runtime: return "runtime";
+    case RequestMemory::Host:    break;
+    }
+    return "host";
+}
+
 void default_reporter(const ErrorContext& ctx) {
     std::cerr << "[ds-runtime][error] " << format_timestamp(ctx.timestamp)
               << " subsystem=" << ctx.subsystem
@@ -45,9 +54,9 @@ void default_reporter(const ErrorContext& ctx) {
               << (ctx.has_request ? " op=" : "")
               << (ctx.has_request ? (ctx.op == RequestOp::Write ? "write" : "read") : "")
               << (ctx.has_request ? " src_mem=" : "")
-              << (ctx.has_request ? (ctx.src_memory == RequestMemory::Gpu ? "gpu" : "host") : "")
+              << (ctx.has_request ? memory_name(ctx.src_memory) : "")
               << (ctx.has_request ? " dst_mem=" : "")
-              << (ctx.has_request ? (ctx.dst_memory == RequestMemory::Gpu ? "gpu" : "host") : "")
+              << (ctx.has_request ? memory_name(ctx.dst_memory) : "")
               << " at " << ctx.file << ":" << ctx.line
               << " (" << ctx.function << ")"
               << std::endl;
@@ -0,0 +1,545 @@
+// SPDX-License-Identifier: Apache-2.0
+// Memory-mapped file backend implementation for ds-runtime.
+//
+// Each file is mapped once, read-only and shared, the first time a read
+// touches it. Reads copy out of the mapping; the access pattern of each
+// file drives madvise() hints (SEQUENTIAL plus a WILLNEED window for
+// streams, WILLNEED over large random reads) so that page faults overlap
+// with kernel readahead instead of stalling the copy. RequestMemory::Runtime
+// reads skip the copy altogether and complete with a view of the mapping.
+
+#include "ds_runtime_mmap.hpp"
+#include "ds_runtime_buffer.hpp"
+#include "ds_runtime_stats.hpp"
+#include "ds_runtime_thread_pool.hpp"
+#include "ds_runtime_trace.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <shared_mutex>
+#include <unordered_map>
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace ds {
+
+namespace {
+
+constexpr std::size_t kHugePageSize = std::size_t{2} << 20;
+
+std::size_t page_size() {
+    static const std::size_t size = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+    return size;
+}
+
+/**
+ * @brief One read-only shared mapping of a file.
+ *
+ * Held by shared_ptr so that release_file() or a remap never unmaps memory
+ * a reader is still copying from. The access-pattern fields are advisory
+ * and updated with relaxed atomics; races only affect which hint is sent.
+ */
+struct Mapping {
+    const char*   base = nullptr; ///< Null for empty files.
+    std::size_t   length = 0;     ///< File size when mapped.
+    dev_t         dev = 0;
+    ino_t         ino = 0;
+
+    std::atomic<std::uint64_t> next_offset{std::numeric_limits<std::uint64_t>::max()};
+    std::atomic<std::size_t>   streak{0};       ///< Consecutive back-to-back reads.
+    std::atomic<bool>          sequential{false};
+    std::atomic<std::uint64_t> willneed_end{0}; ///< End of the advised window.
+
+    Mapping() = default;
+    Mapping(const Mapping&) = delete;
+    Mapping& operator=(const Mapping&) = delete;
+
+    ~Mapping() {
+        if (base != nullptr) {
+            ::munmap(const_cast<char*>(base), length);
+        }
+    }
+
+    /// madvise() the page-aligned span covering [offset, offset + len).
+    bool advise(std::uint64_t offset, std::size_t len, int advice) const {
+        if (base == nullptr || offset >= length) {
+            return false;
+        }
+        const std::uintptr_t mask = page_size() - 1;
+        const std::uintptr_t begin = reinterpret_cast<std::uintptr_t>(base + offset) & ~mask;
+        const std::uintptr_t end = reinterpret_cast<std::uintptr_t>(
+            base + std::min<std::uint64_t>(length, offset + len));
+        return end > begin &&
+               ::madvise(reinterpret_cast<void*>(begin), end - begin, advice) == 0;
+    }
+};
+
+/// Keeps a Mapping alive for as long as views into it exist.
+struct MappedStorage final : BufferStorage {
+    explicit MappedStorage(std::shared_ptr<const Mapping> m) : mapping(std::move(m)) {}
+
+    void recycle() noexcept override { delete this; }
+
+    const std::shared_ptr<const Mapping> mapping;
+};
+
+class MmapBackendImpl final : public MmapBackend {
+public:
+    explicit MmapBackendImpl(const MmapBackendConfig& config)
+        : config_(config)
+        , buffer_pool_(config.buffer_pool ? config.buffer_pool : default_buffer_pool())
+    {
+        if (config.worker_count != 0 || config.placement.workers_per_node != 0) {
+            pool_ = std::make_unique<detail::ThreadPool>(config.worker_count, config.placement);
+        }
+    }
+
+    // Without workers the request runs (and completes) inside submit().
+    void submit(Request req, CompletionCallback on_complete) override {
+        counters_.add(kSubmitted);
+        if (!pool_) {
+            req.start_time_ns = detail::steady_now_ns();
+            execute(req);
+            finish(req, on_complete);
+            return;
+        }
+
+        const std::uint64_t queued_ns = trace::enabled() ? trace::now_ns() : 0;
+        const int node = pool_->routes_by_node() ? detail::request_numa_node(req, false) : -1;
+        pool_->submit([this, req, on_complete, queued_ns]() mutable {
+            req.start_time_ns = detail::steady_now_ns();
+            if (queued_ns != 0) {
+                trace::record("mmap", "pool_wait", queued_ns, req.start_time_ns, req);
+            }
+            execute(req);
+            finish(req, on_complete);
+        }, node);
+    }
+
+    // Runtime reads are served straight from the mapping.
+    bool provides_buffers() const noexcept override { return true; }
+
+    void release_file(int fd) override {
+        std::unique_lock<std::shared_mutex> lock(maps_mtx_);
+        maps_.erase(fd);
+    }
+
+    // Counters plus mapping and madvise events. "mapped_files" and
+    // "mapped_bytes" are current values, the rest are cumulative.
+    BackendStats stats() const override {
+        BackendStats out;
+        out.backend = "mmap";
+        out.submitted = counters_.read(kSubmitted);
+        out.completed = counters_.read(kCompleted);
+        out.failed = counters_.read(kFailed);
+        out.bytes_transferred = counters_.read(kBytes);
+
+        std::uint64_t mapped_bytes = 0;
+        std::size_t mapped_files = 0;
+        {
+            std::shared_lock<std::shared_mutex> lock(maps_mtx_);
+            mapped_files = maps_.size();
+            for (const auto& [fd, mapping] : maps_) {
+                mapped_bytes += mapping->length;
+            }
+        }
+        out.counters.push_back({"workers", pool_ ? pool_->worker_count() : 0});
+        out.counters.push_back({"numa_groups", pool_ ? pool_->group_count() : 0});
+        out.counters.push_back({"pinned_workers", pool_ ? pool_->pinned_count() : 0});
+        out.counters.push_back({"mapped_files", mapped_files});
+        out.counters.push_back({"mapped_bytes", mapped_bytes});
+        out.counters.push_back({"maps", counters_.read(kMaps)});
+        out.counters.push_back({"remaps", counters_.read(kRemaps)});
+        out.counters.push_back({"populated_maps", counters_.read(kPopulated)});
+        out.counters.push_back({"huge_page_maps", counters_.read(kHugePages)});
+        out.counters.push_back({"advise_sequential", counters_.read(kAdviseSequential)});
+        out.counters.push_back({"advise_normal", counters_.read(kAdviseNormal)});
+        out.counters.push_back({"advise_willneed", counters_.read(kAdviseWillneed)});
+        out.counters.push_back({"zero_copy_views", counters_.read(kZeroCopyViews)});
+        return out;
+    }
+
+private:
+    enum Counter : std::size_t {
+        kSubmitted,
+        kCompleted,
+        kFailed,
+        kBytes,
+        kMaps,
+        kRemaps,
+        kPopulated,
+        kHugePages,
+        kAdviseSequential,
+        kAdviseNormal,
+        kAdviseWillneed,
+        kZeroCopyViews,
+        kCounterCount
+    };
+
+    // Count a completion and hand it to the caller.
+    void finish(Request& req, const CompletionCallback& callback) {
+        counters_.add(kCompleted);
+        if (req.status != RequestStatus::Ok) {
+            counters_.add(kFailed);
+        }
+        counters_.add(kBytes, req.bytes_transferred);
+        if (callback) {
+            trace::Span span("mmap", "callback", req);
+            callback(req);
+        }
+    }
+
+    void fail(Request& req, const char* operation, const char* detail, int err,
+              int line, const char* function) {
+        report_request_error("mmap", operation, detail, req, err, __FILE__, line, function);
+        req.status = RequestStatus::IoError;
+        req.errno_value = err;
+        req.bytes_transferred = 0;
+    }
+
+    /**
+     * @brief Validate and execute @p req on the calling thread.
+     */
+    void execute(Request& req) {
+        if (req.fd < 0) {
+            fail(req, "submit", "Invalid file descriptor", EBADF, __LINE__, __func__);
+            return;
+        }
+        if (req.size == 0) {
+            fail(req, "submit", "Zero-length request is not allowed", EINVAL, __LINE__, __func__);
+            return;
+        }
+        if ((req.op == RequestOp::Read && req.dst_memory == RequestMemory::Gpu) ||
+            (req.op == RequestOp::Write && req.src_memory == RequestMemory::Gpu)) {
+            fail(req, "submit", "GPU memory requested on mmap backend", EINVAL, __LINE__, __func__);
+            return;
+        }
+        if (req.op == RequestOp::Read && req.dst == nullptr &&
+            req.dst_memory != RequestMemory::Runtime) {
+            fail(req, "submit", "Read request missing destination buffer", EINVAL,
+                 __LINE__, __func__);
+            return;
+        }
+        if (req.op == RequestOp::Write && req.src == nullptr) {
+            fail(req, "submit", "Write request missing source buffer", EINVAL,
+                 __LINE__, __func__);
+            return;
+        }
+        if (req.offset > std::numeric_limits<std::uint64_t>::max() - req.size) {
+            fail(req, "submit", "Request range overflows", EOVERFLOW, __LINE__, __func__);
+            return;
+        }
+
+        if (req.op == RequestOp::Write) {
+            // Writes go through the page cache, which the mapping shares.
+            trace::Span span("mmap", "pwrite", req);
+            const ssize_t written = ::pwrite(req.fd, req.src, req.size,
+                                             static_cast<off_t>(req.offset));
+            if (written < 0) {
+                fail(req, "pwrite", "POSIX I/O failed", errno, __LINE__, __func__);
+                return;
+            }
+            req.status = RequestStatus::Ok;
+            req.errno_value = 0;
+            req.bytes_transferred = static_cast<std::size_t>(written);
+            return;
+        }
+
+        int err = 0;
+        std::shared_ptr<Mapping> mapping = mapping_for(req.fd, req.offset + req.size, err);
+        if (!mapping) {
+            fail(req, "mmap", "Failed to map file", err, __LINE__, __func__);
+            return;
+        }
+
+        const std::size_t available = req.offset >= mapping->length
+            ? 0 : static_cast<std::size_t>(
+                      std::min<std::uint64_t>(req.size, mapping->length - req.offset));
+        if (available != 0) {
+            advise(*mapping, req.offset, available);
+        }
+        if (req.dst_memory == RequestMemory::Runtime) {
+            read_into_view(req, std::move(mapping), available);
+            return;
+        }
+        if (available != 0) {
+            trace::Span span("mmap", "memcpy", req);
+            std::memcpy(req.dst, mapping->base + req.offset, available);
+        }
+        req.status = RequestStatus::Ok;
+        req.errno_value = 0;
+        req.bytes_transferred = available;
+
+        // Same short-read convention as the CPU backend.
+        if (available < req.size) {
+            static_cast<char*>(req.dst)[available] = '\0';
+        }
+
+        if (req.compression == Compression::None) {
+            return;
+        }
+        trace::Span span("mmap", "decompress", req);
+        if (req.compression == Compression::FakeUppercase) {
+            char* c = static_cast<char*>(req.dst);
+            for (std::size_t i = 0; i < req.size && c[i] != '\0'; ++i) {
+                c[i] = static_cast<char>(std::toupper(static_cast<unsigned char>(c[i])));
+            }
+        } else if (req.compression == Compression::GDeflate) {
+            fail(req, "decompression", "GDeflate compression is not yet implemented (ENOTSUP)",
+                 ENOTSUP, __LINE__, __func__);
+        }
+    }
+
+    /**
+     * @brief Complete a Runtime read with a view of the mapping itself, or
+     * of a pool block when the bytes have to be decoded first.
+     */
+    void read_into_view(Request& req, std::shared_ptr<const Mapping> mapping,
+                        std::size_t available) {
+        if (req.compression == Compression::GDeflate) {
+            fail(req, "decompression", "GDeflate compression is not yet implemented (ENOTSUP)",
+                 ENOTSUP, __LINE__, __func__);
+            return;
+        }
+
+        const char* src = available != 0 ? mapping->base + req.offset : nullptr;
+        if (req.compression == Compression::None) {
+            if (available != 0) {
+                auto* storage = new (std::nothrow) MappedStorage(std::move(mapping));
+                if (storage == nullptr) {
+                    fail(req, "submit", "Out of memory for buffer view", ENOMEM,
+                         __LINE__, __func__);
+                    return;
+                }
+                req.buffer = BufferView(storage, src, available);
+                counters_.add(kZeroCopyViews);
+            }
+        } else {
+            PoolBuffer block = buffer_pool_->allocate(available);
+            if (!block) {
+                fail(req, "allocate", "Buffer pool exhausted", ENOMEM, __LINE__, __func__);
+                return;
+            }
+            char* c = static_cast<char*>(block.data());
+            if (available != 0) {
+                trace::Span span("mmap", "memcpy", req);
+                std::memcpy(c, src, available);
+            }
+            trace::Span span("mmap", "decompress", req);
+            for (std::size_t i = 0; i < available && c[i] != '\0'; ++i) {
+                c[i] = static_cast<char>(std::toupper(static_cast<unsigned char>(c[i])));
+            }
+            req.buffer = block.share(available);
+        }
+        req.status = RequestStatus::Ok;
+        req.errno_value = 0;
+        req.bytes_transferred = available;
+    }
+
+    /**
+     * @brief Mapping of @p fd covering @p end bytes if the file is that
+     * large, creating or growing it as needed.
+     *
+     * The common case is a shared-lock lookup. New mappings are created
+     * outside the lock (MAP_POPULATE can take a while); if two threads race,
+     * the loser's mapping is dropped.
+     */
+    std::shared_ptr<Mapping> mapping_for(int fd, std::uint64_t end, int& err) {
+        std::shared_ptr<Mapping> current;
+        {
+            std::shared_lock<std::shared_mutex> lock(maps_mtx_);
+            auto it = maps_.find(fd);
+            if (it != maps_.end()) {
+                current = it->second;
+                if (end <= current->length) {
+                    return current;
+                }
+            }
+        }
+
+        struct stat st {};
+        if (::fstat(fd, &st) != 0) {
+            err = errno;
+            return nullptr;
+        }
+        const bool same_file = current && current->dev == st.st_dev && current->ino == st.st_ino;
+        if (same_file && static_cast<std::uint64_t>(st.st_size) <= current->length) {
+            // The read runs past EOF; serve the short read from what we have.
+            return current;
+        }
+
+        std::shared_ptr<Mapping> fresh = map_file(fd, st, err);
+        if (!fresh) {
+            return nullptr;
+        }
+        counters_.add(current ? kRemaps : kMaps);
+
+        std::unique_lock<std::shared_mutex> lock(maps_mtx_);
+        auto& slot = maps_[fd];
+        if (slot && slot != current && slot->length >= fresh->length &&
+            slot->ino == fresh->ino && slot->dev == fresh->dev) {
+            return slot; // Another thread already mapped it.
+        }
+        slot = fresh;
+        return fresh;
+    }
+
+    /**
+     * @brief Map the whole of @p fd read-only, applying populate and
+     * huge-page policy.
+     */
+    std::shared_ptr<Mapping> map_file(int fd, const struct stat& st, int& err) {
+        if (!S_ISREG(st.st_mode)) {
+            err = ENODEV; // Pipes, sockets and devices cannot be mapped by size.
+            return nullptr;
+        }
+        auto mapping = std::make_shared<Mapping>();
+        mapping->dev = st.st_dev;
+        mapping->ino = st.st_ino;
+        mapping->length = static_cast<std::size_t>(st.st_size);
+        if (mapping->length == 0) {
+            return mapping;
+        }
+
+        int flags = MAP_SHARED;
+        const bool populate = config_.populate_max_bytes != 0 &&
+                              mapping->length <= config_.populate_max_bytes;
+        if (populate) {
+            flags |= MAP_POPULATE;
+        }
+
+        // For huge pages the mapping must start on a 2 MiB boundary:
+        // reserve an oversized range, then map the file over its aligned
+        // part and give the slack back.
+        const bool huge = config_.huge_pages && mapping->length >= kHugePageSize;
+        const std::size_t reserve_len = mapping->length + kHugePageSize;
+        void* reserve = MAP_FAILED;
+        void* want = nullptr;
+        if (huge) {
+            reserve = ::mmap(nullptr, reserve_len, PROT_NONE,
+                             MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+            if (reserve != MAP_FAILED) {
+                const std::uintptr_t raw = reinterpret_cast<std::uintptr_t>(reserve);
+                want = reinterpret_cast<void*>((raw + kHugePageSize - 1) & ~(kHugePageSize - 1));
+                flags |= MAP_FIXED;
+            }
+        }
+
+        void* addr = ::mmap(want, mapping->length, PROT_READ, flags, fd, 0);
+        const int map_errno = errno;
+
+        if (reserve != MAP_FAILED) {
+            char* const reserve_begin = static_cast<char*>(reserve);
+            char* const reserve_end = reserve_begin + reserve_len;
+            if (addr == MAP_FAILED) {
+                ::munmap(reserve, reserve_len);
+            } else {
+                char* const head_end = static_cast<char*>(want);
+                const std::size_t mapped = (mapping->length + page_size() - 1) & ~(page_size() - 1);
+                char* const tail_begin = head_end + mapped;
+                if (head_end > reserve_begin) {
+                    ::munmap(reserve_begin, static_cast<std::size_t>(head_end - reserve_begin));
+                }
+                if (reserve_end > tail_begin) {
+                    ::munmap(tail_begin, static_cast<std::size_t>(reserve_end - tail_begin));
+                }
+            }
+        }
+
+        if (addr == MAP_FAILED) {
+            err = map_errno;
+            return nullptr;
+        }
+        mapping->base = static_cast<const char*>(addr);
+
+        if (populate) {
+            counters_.add(kPopulated);
+        }
+#ifdef MADV_HUGEPAGE
+        if (huge && ::madvise(addr, mapping->length, MADV_HUGEPAGE) == 0) {
+            counters_.add(kHugePages);
+        }
+#endif
+        return mapping;
+    }
+
+    /**
+     * @brief Update the access pattern of @p m and send matching hints.
+     *
+     * Back-to-back reads switch the file to MADV_SEQUENTIAL and keep a
+     * WILLNEED window of readahead_bytes ahead of the stream; the first
+     * non-contiguous read switches it back to MADV_NORMAL. Outside of
+     * streams, large reads are advised WILLNEED over their own range.
+     */
+    void advise(Mapping& m, std::uint64_t offset, std::size_t len) {
+        const std::uint64_t end = offset + len;
+        const std::uint64_t prev = m.next_offset.exchange(end, std::memory_order_relaxed);
+        std::size_t streak = 0;
+        if (prev == offset) {
+            streak = m.streak.fetch_add(1, std::memory_order_relaxed) + 1;
+        } else {
+            m.streak.store(0, std::memory_order_relaxed);
+        }
+
+        const std::size_t threshold = config_.sequential_threshold;
+        if (threshold != 0 && streak >= threshold) {
+            if (!m.sequential.exchange(true, std::memory_order_relaxed) &&
+                m.advise(0, m.length, MADV_SEQUENTIAL)) {
+                counters_.add(kAdviseSequential);
+            }
+            const std::uint64_t window = config_.readahead_bytes;
+            const std::uint64_t target = std::min<std::uint64_t>(m.length, end + window);
+            std::uint64_t have = m.willneed_end.load(std::memory_order_relaxed);
+            const std::uint64_t from = std::max(have, end);
+            // Advise in chunks of a quarter window rather than per read.
+            if (target > from && (target - from >= window / 4 || target == m.length) &&
+                m.willneed_end.compare_exchange_strong(have, target, std::memory_order_relaxed) &&
+                m.advise(from, static_cast<std::size_t>(target - from), MADV_WILLNEED)) {
+                counters_.add(kAdviseWillneed);
+            }
+            return;
+        }
+
+        if (streak == 0 && m.sequential.load(std::memory_order_relaxed) &&
+            m.sequential.exchange(false, std::memory_order_relaxed)) {
+            m.willneed_end.store(0, std::memory_order_relaxed);
+            if (m.advise(0, m.length, MADV_NORMAL)) {
+                counters_.add(kAdviseNormal);
+            }
+        }
+        if (config_.willneed_min_bytes != 0 && len >= config_.willneed_min_bytes &&
+            m.advise(offset, len, MADV_WILLNEED)) {
+            counters_.add(kAdviseWillneed);
+        }
+    }
+
+    const MmapBackendConfig config_;
+    const std::shared_ptr<BufferPool> buffer_pool_; ///< Destination of decoded Runtime reads.
+
+    mutable std::shared_mutex maps_mtx_; ///< Protects maps_.
+    std::unordered_map<int, std::shared_ptr<Mapping>> maps_; ///< Mappings by fd.
+
+    detail::ShardedCounters<kCounterCount> counters_; ///< Per-thread request counters.
+
+    /// Null when requests run inline. Declared last so workers are joined
+    /// before the mappings they use are destroyed.
+    std::unique_ptr<detail::ThreadPool> pool_;
+};
+
+} // namespace
+
+std::shared_ptr<MmapBackend> make_mmap_backend(const MmapBackendConfig& config) {
+    return std::make_shared<MmapBackendImpl>(config);
+}
+
+} // namespace ds
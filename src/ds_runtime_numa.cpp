@@ -0,0 +1,308 @@
+// SPDX-License-Identifier: Apache-2.0
+// NUMA helpers for ds-runtime.
+
+#include "ds_runtime_numa.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+
+#include <sched.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/sysmacros.h>
+#include <unistd.h>
+
+namespace ds {
+
+namespace detail {
+
+namespace {
+
+constexpr int kMpolPreferred = 1; ///< MPOL_PREFERRED from <linux/mempolicy.h>.
+constexpr int kMpolFNode = 1;     ///< MPOL_F_NODE.
+constexpr int kMpolFAddr = 2;     ///< MPOL_F_ADDR.
+
+/**
+ * @brief Parse a sysfs list such as "0-3,8,10-11" into ascending ids.
+ */
+std::vector<int> parse_id_list(const std::string& list) {
+    std::vector<int> ids;
+    std::size_t pos = 0;
+    while (pos < list.size()) {
+        char* end = nullptr;
+        const long first = std::strtol(list.c_str() + pos, &end, 10);
+        if (end == list.c_str() + pos) {
+            break;
+        }
+        long last = first;
+        pos = static_cast<std::size_t>(end - list.c_str());
+        if (pos < list.size() && list[pos] == '-') {
+            last = std::strtol(list.c_str() + pos + 1, &end, 10);
+            pos = static_cast<std::size_t>(end - list.c_str());
+        }
+        for (long id = first; id <= last && id >= 0 && id < INT_MAX; ++id) {
+            ids.push_back(static_cast<int>(id));
+        }
+        if (pos < list.size() && list[pos] == ',') {
+            ++pos;
+        } else {
+            break;
+        }
+    }
+    std::sort(ids.begin(), ids.end());
+    ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+    return ids;
+}
+
+/**
+ * @brief First line of a sysfs file, or an empty string.
+ */
+std::string read_line(const std::string& path) {
+    std::ifstream in(path);
+    std::string line;
+    std::getline(in, line);
+    return line;
+}
+
+/**
+ * @brief CPUs the process may run on, ascending.
+ */
+std::vector<int> allowed_cpus() {
+    std::vector<int> cpus;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (::sched_getaffinity(0, sizeof(set), &set) == 0) {
+        for (std::size_t cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+            if (CPU_ISSET(cpu, &set)) {
+                cpus.push_back(static_cast<int>(cpu));
+            }
+        }
+    }
+    if (cpus.empty()) {
+        const unsigned n = std::max(1u, std::thread::hardware_concurrency());
+        for (unsigned cpu = 0; cpu < n; ++cpu) {
+            cpus.push_back(static_cast<int>(cpu));
+        }
+    }
+    return cpus;
+}
+
+/**
+ * @brief Walk up from a sysfs device directory to the first numa_node >= 0.
+ */
+int device_numa_node(dev_t dev) {
+    const std::string link = "/sys/dev/block/" + std::to_string(major(dev)) + ":" +
+                             std::to_string(minor(dev));
+    char* resolved = ::realpath(link.c_str(), nullptr);
+    if (!resolved) {
+        return -1;
+    }
+    std::string dir(resolved);
+    std::free(resolved);
+
+    while (dir.size() > sizeof("/sys/devices") - 1) {
+        const std::string value = read_line(dir + "/numa_node");
+        if (!value.empty()) {
+            const int node = std::atoi(value.c_str());
+            if (node >= 0) {
+                return node;
+            }
+        }
+        const std::size_t slash = dir.rfind('/');
+        if (slash == std::string::npos || slash == 0) {
+            break;
+        }
+        dir.resize(slash);
+    }
+    return -1;
+}
+
+} // namespace
+
+std::size_t numa_node_count() noexcept {
+    static const std::size_t count = [] {
+        const std::vector<int> nodes =
+            parse_id_list(read_line("/sys/devices/system/node/possible"));
+        return nodes.empty() ? std::size_t{1} : static_cast<std::size_t>(nodes.back()) + 1;
+    }();
+    return count;
+}
+
+int current_numa_node() noexcept {
+#ifdef SYS_getcpu
+    unsigned cpu = 0;
+    unsigned node = 0;
+    if (::syscall(SYS_getcpu, &cpu, &node, nullptr) == 0 &&
+        node < numa_node_count()) {
+        return static_cast<int>(node);
+    }
+#endif
+    return 0;
+}
+
+bool prefer_numa_node(void* addr, std::size_t len, int node) noexcept {
+#ifdef SYS_mbind
+    constexpr std::size_t kMaskBits = sizeof(unsigned long) * 8;
+    if (node < 0 || static_cast<std::size_t>(node) >= kMaskBits) {
+        return false;
+    }
+    const unsigned long mask = 1ul << node;
+    // maxnode counts bits and the kernel ignores the last one.
+    return ::syscall(SYS_mbind, addr, len, kMpolPreferred, &mask, kMaskBits + 1, 0) == 0;
+#else
+    (void)addr;
+    (void)len;
+    (void)node;
+    errno = ENOSYS;
+    return false;
+#endif
+}
+
+int memory_numa_node(const void* addr) noexcept {
+#ifdef SYS_get_mempolicy
+    int node = -1;
+    if (addr &&
+        ::syscall(SYS_get_mempolicy, &node, nullptr, 0, addr, kMpolFNode | kMpolFAddr) == 0) {
+        return node;
+    }
+#else
+    (void)addr;
+#endif
+    return -1;
+}
+
+int file_numa_node(int fd) {
+    struct stat st{};
+    if (::fstat(fd, &st) != 0) {
+        return -1;
+    }
+    const dev_t dev = S_ISBLK(st.st_mode) ? st.st_rdev : st.st_dev;
+
+    static std::mutex mtx;
+    static std::unordered_map<dev_t, int> cache;
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        const auto it = cache.find(dev);
+        if (it != cache.end()) {
+            return it->second;
+        }
+    }
+    const int node = device_numa_node(dev);
+    std::lock_guard<std::mutex> lock(mtx);
+    cache.emplace(dev, node);
+    return node;
+}
+
+int request_numa_node(const Request& req, bool use_device) {
+    int node = -1;
+    if (req.op == RequestOp::Write && req.src_memory == RequestMemory::Host) {
+        node = memory_numa_node(req.src);
+    } else if (req.op == RequestOp::Read && req.dst_memory == RequestMemory::Host) {
+        node = memory_numa_node(req.dst);
+    }
+    if (node < 0 && use_device) {
+        node = file_numa_node(req.fd);
+    }
+    return node;
+}
+
+bool pin_current_thread(const std::vector<int>& cpus) noexcept {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    bool any = false;
+    for (const int cpu : cpus) {
+        if (cpu >= 0 && cpu < CPU_SETSIZE) {
+            CPU_SET(static_cast<std::size_t>(cpu), &set);
+            any = true;
+        }
+    }
+    return any && ::sched_setaffinity(0, sizeof(set), &set) == 0;
+}
+
+std::vector<WorkerGroup> plan_worker_groups(std::size_t worker_count,
+                                            const WorkerPlacement& placement) {
+    worker_count = std::max<std::size_t>(worker_count, 1);
+    if (placement.workers_per_node == 0 && !placement.pin_workers) {
+        return {WorkerGroup{-1, {}, worker_count}};
+    }
+
+    const std::vector<NumaNodeInfo>& nodes = numa_topology();
+    std::vector<WorkerGroup> groups;
+    groups.reserve(nodes.size());
+    for (const NumaNodeInfo& info : nodes) {
+        groups.push_back(WorkerGroup{info.id, info.cpus, placement.workers_per_node});
+    }
+    if (placement.workers_per_node == 0) {
+        for (std::size_t i = 0; i < worker_count; ++i) {
+            ++groups[i % groups.size()].workers;
+        }
+        groups.erase(std::remove_if(groups.begin(), groups.end(),
+                                    [](const WorkerGroup& g) { return g.workers == 0; }),
+                     groups.end());
+    }
+    return groups;
+}
+
+LaneSelector::LaneSelector(const std::vector<int>& lane_nodes)
+    : lane_count_(std::max<std::size_t>(lane_nodes.size(), 1))
+{
+    int first = lane_nodes.empty() ? -1 : lane_nodes.front();
+    for (std::size_t lane = 0; lane < lane_nodes.size(); ++lane) {
+        const int node = lane_nodes[lane];
+        multi_node_ = multi_node_ || node != first;
+        if (node < 0) {
+            continue;
+        }
+        if (by_node_.size() <= static_cast<std::size_t>(node)) {
+            by_node_.resize(static_cast<std::size_t>(node) + 1);
+        }
+        by_node_[static_cast<std::size_t>(node)].push_back(lane);
+    }
+}
+
+std::size_t LaneSelector::pick(int node) noexcept {
+    const std::size_t ticket = next_.fetch_add(1, std::memory_order_relaxed);
+    if (node >= 0 && static_cast<std::size_t>(node) < by_node_.size()) {
+        const std::vector<std::size_t>& lanes = by_node_[static_cast<std::size_t>(node)];
+        if (!lanes.empty()) {
+            return lanes[ticket % lanes.size()];
+        }
+    }
+    return ticket % lane_count_;
+}
+
+} // namespace detail
+
+const std::vector<NumaNodeInfo>& numa_topology() {
+    static const std::vector<NumaNodeInfo> topology = [] {
+        const std::vector<int> allowed = detail::allowed_cpus();
+        std::vector<NumaNodeInfo> nodes;
+        for (const int id : detail::parse_id_list(detail::read_line("/sys/devices/system/node/online"))) {
+            NumaNodeInfo info;
+            info.id = id;
+            const std::vector<int> cpus = detail::parse_id_list(detail::read_line(
+                "/sys/devices/system/node/node" + std::to_string(id) + "/cpulist"));
+            std::set_intersection(cpus.begin(), cpus.end(), allowed.begin(), allowed.end(),
+                                  std::back_inserter(info.cpus));
+            // Memory-only nodes (CXL, HBM) cannot host workers.
+            if (!info.cpus.empty()) {
+                nodes.push_back(std::move(info));
+            }
+        }
+        if (nodes.empty()) {
+            nodes.push_back(NumaNodeInfo{0, allowed});
+        }
+        return nodes;
+    }();
+    return topology;
+}
+
+} // namespace ds
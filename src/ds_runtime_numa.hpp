@@ -0,0 +1,89 @@
+// SPDX-License-Identifier: Apache-2.0
+// Internal NUMA helpers used by ds-runtime allocators and worker pools.
+//
+// This header is private to the runtime (it lives in src/, not include/).
+// It wraps the few kernel interfaces the runtime needs (sysfs node lists,
+// getcpu, mbind, get_mempolicy, sched_setaffinity) without a libnuma
+// dependency. On kernels or containers without NUMA support everything
+// degrades to a single node 0.
+
+#pragma once
+
+#include "ds_runtime.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+namespace ds {
+namespace detail {
+
+/// Number of NUMA nodes the kernel may report (highest possible node id
+/// plus one), at least 1.
+std::size_t numa_node_count() noexcept;
+
+/// Node of the CPU the calling thread is running on, or 0 if unknown.
+int current_numa_node() noexcept;
+
+/// Ask the kernel to place pages of [addr, addr + len) on @p node,
+/// falling back to other nodes when it is full. @p addr must be page
+/// aligned. Returns false if the kernel rejected the policy.
+bool prefer_numa_node(void* addr, std::size_t len, int node) noexcept;
+
+/// Node holding the page at @p addr, or -1 if unknown. Faults the page in
+/// if it was never touched.
+int memory_numa_node(const void* addr) noexcept;
+
+/// Node of the block device backing @p fd (walking up sysfs from the
+/// device to the first ancestor with a known node), or -1 for virtual
+/// filesystems, device-mapper stacks without a node, or errors. Results
+/// are cached per device.
+int file_numa_node(int fd);
+
+/// Node a request's data lives on: the caller's host buffer if it has
+/// one, else (when @p use_device) the file's block device, else -1.
+int request_numa_node(const Request& req, bool use_device);
+
+/// Restrict the calling thread to @p cpus. Returns false on failure or
+/// when @p cpus is empty.
+bool pin_current_thread(const std::vector<int>& cpus) noexcept;
+
+/// A set of workers that share a node (or, with node == -1, are unplaced).
+struct WorkerGroup {
+    int node = -1;          ///< Kernel node id, or -1 when unplaced.
+    std::vector<int> cpus;  ///< CPUs to pin to; empty leaves affinity alone.
+    std::size_t workers = 0;
+};
+
+/// Lay @p worker_count workers out according to @p placement. Returns a
+/// single unplaced group when placement is not requested. Every group has
+/// at least one worker.
+std::vector<WorkerGroup> plan_worker_groups(std::size_t worker_count,
+                                            const WorkerPlacement& placement);
+
+/**
+ * @brief Picks a lane (worker group, ring, ...) for a request's node.
+ *
+ * Lanes on the requested node are used round-robin; unknown nodes, or
+ * nodes without a lane, fall back to round-robin over every lane.
+ */
+class LaneSelector {
+public:
+    /// @p lane_nodes holds the node id of each lane (-1 for unplaced).
+    explicit LaneSelector(const std::vector<int>& lane_nodes);
+
+    /// Lane for work whose data is on @p node (-1 if unknown).
+    std::size_t pick(int node) noexcept;
+
+    /// True when lanes sit on more than one node, i.e. routing matters.
+    bool multi_node() const noexcept { return multi_node_; }
+
+private:
+    std::vector<std::vector<std::size_t>> by_node_; ///< Lanes per node id.
+    std::size_t lane_count_;
+    bool multi_node_ = false;
+    std::atomic<std::size_t> next_{0};
+};
+
+} // namespace detail
+} // namespace ds
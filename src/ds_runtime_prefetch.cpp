@@ -0,0 +1,537 @@
+// SPDX-License-Identifier: Apache-2.0
+// Readahead prefetcher for ds-runtime.
+//
+// Every tracked read takes its result from the prefetch table when one is
+// there, then updates its file's stream and plans the speculative reads
+// that keep the stream `depth` positions ahead, all under one lock. The
+// planned reads are issued after the lock is dropped; their results wait
+// in the table until a matching read consumes them, the pattern breaks,
+// or the budget needs the room for another stream.
+
+#include "ds_runtime_prefetch.hpp"
+#include "ds_runtime_buffer.hpp"
+#include "ds_runtime_read_key.hpp"
+#include "ds_runtime_shared_read.hpp"
+#include "ds_runtime_stats.hpp"
+#include "ds_runtime_trace.hpp"
+
+#include <algorithm>
+#include <condition_variable>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace ds {
+
+namespace {
+
+using SlotKey = detail::ReadKey;
+using SlotKeyHash = detail::ReadKeyHash;
+
+/// Identity of a file, shared by every descriptor open on it.
+struct FileKey {
+    dev_t dev = 0;
+    ino_t ino = 0;
+
+    bool operator==(const FileKey& other) const noexcept {
+        return dev == other.dev && ino == other.ino;
+    }
+};
+
+struct FileKeyHash {
+    std::size_t operator()(const FileKey& key) const noexcept {
+        std::uint64_t h = static_cast<std::uint64_t>(key.dev) * 0x9e3779b97f4a7c15ull;
+        h ^= static_cast<std::uint64_t>(key.ino) + 0x9e3779b97f4a7c15ull + (h << 6) + (h >> 2);
+        return static_cast<std::size_t>(h);
+    }
+};
+
+FileKey file_of(const SlotKey& key) noexcept {
+    return FileKey{key.dev, key.ino};
+}
+
+/// Private duplicate of a caller's descriptor. Shared by a stream and its
+/// prefetches in flight, and closed when the last of them lets go.
+class FileHandle {
+public:
+    explicit FileHandle(int fd) noexcept : fd_(fd) {}
+    ~FileHandle() { ::close(fd_); }
+
+    FileHandle(const FileHandle&) = delete;
+    FileHandle& operator=(const FileHandle&) = delete;
+
+    int fd() const noexcept { return fd_; }
+
+private:
+    int fd_;
+};
+
+class PrefetchingBackendImpl final : public PrefetchingBackend {
+public:
+    PrefetchingBackendImpl(std::shared_ptr<Backend> inner, const PrefetchConfig& config)
+        : config_(config)
+        , buffer_pool_(config.buffer_pool ? config.buffer_pool : default_buffer_pool())
+        , inner_buffers_(inner->provides_buffers())
+        , inner_(std::move(inner))
+    {
+        config_.trigger = std::max(config_.trigger, 1u);
+        config_.max_depth = std::max(config_.max_depth, 1u);
+        config_.initial_depth = std::clamp(config_.initial_depth, 1u, config_.max_depth);
+        config_.max_streams = std::max<std::size_t>(config_.max_streams, 1);
+    }
+
+    ~PrefetchingBackendImpl() override {
+        // Speculative reads call back into this object; let them land.
+        std::unique_lock<std::mutex> lock(mtx_);
+        idle_cv_.wait(lock, [this] { return in_flight_ == 0; });
+    }
+
+    void submit(Request req, CompletionCallback on_complete) override {
+        if (req.op == RequestOp::Write) {
+            forward_write(std::move(req), std::move(on_complete));
+            return;
+        }
+
+        SlotKey key;
+        std::uint64_t file_size = 0;
+        const bool tracked = detail::is_shareable_read(req) &&
+                             req.size <= config_.max_request_bytes &&
+                             detail::make_read_key(req, key, &file_size);
+        if (!tracked) {
+            counters_.add(kBypassed);
+            forward(std::move(req), std::move(on_complete));
+            return;
+        }
+
+        std::vector<Planned> planned;
+        std::vector<BufferView> dropped;
+        BufferView hit;
+        bool waiting = false;
+        {
+            std::lock_guard<std::mutex> lock(mtx_);
+            const auto found = slots_.find(key);
+            if (found != slots_.end() && !found->second.stale) {
+                Slot& slot = found->second;
+                if (slot.ready) {
+                    hit = std::move(slot.view);
+                    ready_order_.erase(slot.order);
+                    bytes_buffered_ -= key.size;
+                    slots_.erase(found);
+                } else {
+                    req.start_time_ns = detail::steady_now_ns();
+                    slot.waiters.push_back(Waiter{req, std::move(on_complete)});
+                    waiting = true;
+                }
+            }
+            Stream& stream = stream_for(req.fd, key, dropped);
+            advance(stream, key, waiting, dropped);
+            plan(stream, key, file_size, planned, dropped);
+        }
+        dropped.clear(); // Recycle outside the lock.
+
+        if (hit) {
+            counters_.add(kHits);
+            req.start_time_ns = detail::steady_now_ns();
+            Request result = req;
+            result.status = RequestStatus::Ok;
+            result.errno_value = 0;
+            trace::Span span("prefetch", "hit", result);
+            detail::deliver_shared_read(Waiter{std::move(req), std::move(on_complete)}, result, hit);
+        } else if (waiting) {
+            counters_.add(kLateHits);
+        } else {
+            counters_.add(kMisses);
+            forward(std::move(req), std::move(on_complete));
+        }
+        issue(planned);
+    }
+
+    // Runtime reads are answered from prefetched buffers.
+    bool provides_buffers() const noexcept override { return true; }
+
+    // The wrapped backend's counters plus prefetch_* counters.
+    BackendStats stats() const override {
+        BackendStats out = inner_->stats();
+        const PrefetchStats prefetch = prefetch_stats();
+        out.counters.push_back({"prefetch_issued", prefetch.issued});
+        out.counters.push_back({"prefetch_hits", prefetch.hits});
+        out.counters.push_back({"prefetch_late_hits", prefetch.late_hits});
+        out.counters.push_back({"prefetch_misses", prefetch.misses});
+        out.counters.push_back({"prefetch_wasted", prefetch.wasted});
+        out.counters.push_back({"prefetch_bypassed", prefetch.bypassed});
+        out.counters.push_back({"prefetch_bytes_buffered", prefetch.bytes_buffered});
+        out.counters.push_back({"prefetch_streams", prefetch.streams});
+        return out;
+    }
+
+    PrefetchStats prefetch_stats() const override {
+        PrefetchStats out;
+        out.issued = counters_.read(kIssued);
+        out.hits = counters_.read(kHits);
+        out.late_hits = counters_.read(kLateHits);
+        out.misses = counters_.read(kMisses);
+        out.wasted = counters_.read(kWasted);
+        out.bypassed = counters_.read(kBypassed);
+        std::lock_guard<std::mutex> lock(mtx_);
+        out.bytes_buffered = bytes_buffered_;
+        out.streams = streams_.size();
+        return out;
+    }
+
+    void invalidate(int fd) override {
+        struct stat st{};
+        if (::fstat(fd, &st) == 0) {
+            invalidate_file(FileKey{st.st_dev, st.st_ino});
+        }
+    }
+
+private:
+    enum Counter : std::size_t {
+        kIssued,
+        kHits,
+        kLateHits,
+        kMisses,
+        kWasted,
+        kBypassed,
+        kCounterCount
+    };
+
+    using Waiter = detail::ReadWaiter;
+    using ReadyList = std::list<SlotKey>;
+
+    /// A speculative result, in flight or waiting to be consumed.
+    struct Slot {
+        std::uint64_t seq = 0;      ///< Distinguishes reissues of one key.
+        bool ready = false;         ///< Completed successfully; view is set.
+        bool stale = false;         ///< Dropped while reads wait on it; no new joins.
+        BufferView view;
+        std::vector<Waiter> waiters; ///< Reads that arrived while in flight.
+        ReadyList::iterator order;  ///< Position in ready_order_ once ready.
+    };
+
+    /// Access pattern of one file.
+    struct Stream {
+        FileKey       file;
+        std::shared_ptr<FileHandle> handle; ///< Null if the fd could not be duplicated.
+        std::int64_t  mtime_ns = 0;
+        Compression   compression = Compression::None;
+        bool          has_last = false;
+        std::uint64_t last_offset = 0;
+        std::size_t   last_size = 0;
+        std::uint64_t stride = 0;     ///< Offset step of the current run; 0 if none.
+        unsigned      confidence = 0; ///< Consecutive reads on the stride, capped at trigger.
+        unsigned      depth = 0;      ///< Reads kept in flight ahead of the consumer.
+        std::uint64_t frontier = 0;   ///< Furthest offset prefetched on this run; 0 if none.
+    };
+    using StreamList = std::list<Stream>;
+
+    /// A prefetch planned under the lock and issued after it.
+    struct Planned {
+        SlotKey       key;
+        std::uint64_t seq = 0;
+        std::shared_ptr<FileHandle> handle;
+    };
+
+    /// Find or start the stream for @p key's file, most recently used
+    /// first. Caller holds the lock.
+    Stream& stream_for(int fd, const SlotKey& key, std::vector<BufferView>& dropped) {
+        const FileKey file = file_of(key);
+        const auto found = stream_index_.find(file);
+        if (found != stream_index_.end()) {
+            streams_.splice(streams_.begin(), streams_, found->second);
+            Stream& stream = *found->second;
+            if (stream.mtime_ns != key.mtime_ns) {
+                // Rewritten behind our back: nothing read ahead is valid.
+                drop_slots(file, dropped);
+                reset(stream);
+                stream.mtime_ns = key.mtime_ns;
+            }
+            return stream;
+        }
+
+        if (streams_.size() >= config_.max_streams) {
+            Stream& victim = streams_.back();
+            if (victim.frontier != 0) {
+                drop_slots(victim.file, dropped);
+            }
+            stream_index_.erase(victim.file);
+            streams_.pop_back();
+        }
+        streams_.emplace_front();
+        Stream& stream = streams_.front();
+        stream.file = file;
+        stream.mtime_ns = key.mtime_ns;
+        stream.depth = config_.initial_depth;
+        const int dup = ::fcntl(fd, F_DUPFD_CLOEXEC, 0);
+        if (dup >= 0) {
+            stream.handle = std::make_shared<FileHandle>(dup);
+        }
+        stream_index_.emplace(file, streams_.begin());
+        return stream;
+    }
+
+    /// Forget the pattern of @p stream, keeping its descriptor.
+    void reset(Stream& stream) const {
+        stream.has_last = false;
+        stream.stride = 0;
+        stream.confidence = 0;
+        stream.depth = config_.initial_depth;
+        stream.frontier = 0;
+    }
+
+    /// Feed the read @p key into @p stream's pattern detector; @p late is
+    /// set when it had to wait for its prefetch. Caller holds the lock.
+    void advance(Stream& stream, const SlotKey& key, bool late,
+                 std::vector<BufferView>& dropped) {
+        const bool same_shape = stream.has_last && key.offset > stream.last_offset &&
+                                key.size == stream.last_size &&
+                                key.compression == stream.compression;
+        const std::uint64_t delta = same_shape ? key.offset - stream.last_offset : 0;
+        if (delta != 0 && delta == stream.stride) {
+            stream.confidence = std::min(stream.confidence + 1, config_.trigger);
+        } else {
+            if (stream.frontier != 0) {
+                // The pattern broke: what was read ahead will not be used.
+                stream.depth = std::max(stream.depth / 2, 1u);
+                drop_slots(stream.file, dropped);
+            }
+            stream.stride = delta;
+            stream.confidence = delta != 0 ? 1 : 0;
+            stream.frontier = 0;
+        }
+        if (late) {
+            // The consumer caught up with the prefetches: read further ahead.
+            stream.depth = std::min(stream.depth * 2, config_.max_depth);
+        }
+        stream.has_last = true;
+        stream.last_offset = key.offset;
+        stream.last_size = key.size;
+        stream.compression = key.compression;
+    }
+
+    /// Reserve slots for the reads @p stream should have in flight after
+    /// @p key, bounded by the end of the file and the budget. Caller holds
+    /// the lock.
+    void plan(Stream& stream, const SlotKey& key, std::uint64_t file_size,
+              std::vector<Planned>& planned, std::vector<BufferView>& dropped) {
+        if (stream.confidence < config_.trigger || !stream.handle || key.offset >= file_size) {
+            return;
+        }
+        SlotKey ahead = key;
+        for (unsigned i = 0; i < stream.depth; ++i) {
+            if (file_size - ahead.offset <= stream.stride) {
+                break;
+            }
+            ahead.offset += stream.stride;
+            if (ahead.offset <= stream.frontier) {
+                continue;
+            }
+            if (slots_.count(ahead) == 0) {
+                if (!reserve(key.size, stream.file, dropped)) {
+                    break;
+                }
+                Slot& slot = slots_[ahead];
+                slot.seq = ++next_seq_;
+                bytes_buffered_ += key.size;
+                ++in_flight_;
+                planned.push_back(Planned{ahead, slot.seq, stream.handle});
+            }
+            stream.frontier = ahead.offset;
+        }
+    }
+
+    /// Make room for @p size bytes by evicting the oldest unconsumed
+    /// results of other files; results of @p file are the next ones its
+    /// consumer reads, so they are kept. Caller holds the lock.
+    bool reserve(std::size_t size, const FileKey& file, std::vector<BufferView>& dropped) {
+        if (size > config_.buffer_bytes) {
+            return false;
+        }
+        for (auto it = ready_order_.begin();
+             bytes_buffered_ + size > config_.buffer_bytes && it != ready_order_.end();) {
+            const SlotKey victim = *it;
+            if (file_of(victim) == file) {
+                ++it;
+                continue;
+            }
+            const auto slot = slots_.find(victim);
+            dropped.push_back(std::move(slot->second.view));
+            slots_.erase(slot);
+            it = ready_order_.erase(it);
+            bytes_buffered_ -= victim.size;
+            counters_.add(kWasted);
+            const auto owner = stream_index_.find(file_of(victim));
+            if (owner != stream_index_.end()) {
+                // Its consumer is not keeping up with what it is given.
+                Stream& stream = *owner->second;
+                stream.depth = std::max(stream.depth / 2, 1u);
+            }
+        }
+        return bytes_buffered_ + size <= config_.buffer_bytes;
+    }
+
+    /// Drop every prefetch of @p file. Results in flight release their
+    /// budget when they land; ones with readers waiting are delivered but
+    /// not joined again. Caller holds the lock.
+    void drop_slots(const FileKey& file, std::vector<BufferView>& dropped) {
+        for (auto it = slots_.begin(); it != slots_.end();) {
+            Slot& slot = it->second;
+            if (!(file_of(it->first) == file)) {
+                ++it;
+                continue;
+            }
+            if (!slot.waiters.empty()) {
+                slot.stale = true;
+                ++it;
+                continue;
+            }
+            counters_.add(kWasted);
+            if (slot.ready) {
+                dropped.push_back(std::move(slot.view));
+                ready_order_.erase(slot.order);
+                bytes_buffered_ -= it->first.size;
+            }
+            it = slots_.erase(it);
+        }
+    }
+
+    /// Send the planned reads to the wrapped backend.
+    void issue(std::vector<Planned>& planned) {
+        for (Planned& p : planned) {
+            Request op;
+            op.fd = p.handle->fd();
+            op.offset = p.key.offset;
+            op.size = p.key.size;
+            op.compression = p.key.compression;
+            op.dst_memory = RequestMemory::Runtime;
+            counters_.add(kIssued);
+            detail::fetch_shared_read(
+                *inner_, inner_buffers_, *buffer_pool_, "prefetch", std::move(op),
+                [this, key = p.key, seq = p.seq, handle = std::move(p.handle)](
+                    Request& done, BufferView view) {
+                    complete(key, seq, done, std::move(view));
+                });
+        }
+    }
+
+    /**
+     * @brief Land a prefetch: park the result for its reader, or hand it
+     *        to the readers already waiting.
+     *
+     * Waiters of a failed prefetch are forwarded as ordinary reads, so a
+     * speculative failure never fails a request by itself.
+     */
+    void complete(const SlotKey& key, std::uint64_t seq, Request& result, BufferView view) {
+        std::vector<Waiter> waiters;
+        {
+            std::lock_guard<std::mutex> lock(mtx_);
+            const auto found = slots_.find(key);
+            if (found == slots_.end() || found->second.seq != seq) {
+                bytes_buffered_ -= key.size; // Dropped while in flight.
+            } else {
+                Slot& slot = found->second;
+                waiters = std::move(slot.waiters);
+                if (waiters.empty() && result.status == RequestStatus::Ok) {
+                    slot.ready = true;
+                    slot.view = std::move(view);
+                    slot.order = ready_order_.insert(ready_order_.end(), key);
+                } else {
+                    bytes_buffered_ -= key.size;
+                    slots_.erase(found);
+                }
+            }
+        }
+
+        for (auto& waiter : waiters) {
+            if (result.status != RequestStatus::Ok) {
+                forward(std::move(waiter.req), std::move(waiter.callback));
+                continue;
+            }
+            Request outcome = result;
+            outcome.start_time_ns = waiter.req.start_time_ns;
+            detail::deliver_shared_read(std::move(waiter), outcome, view);
+        }
+
+        // Last access to *this: the destructor may proceed once it sees zero.
+        std::lock_guard<std::mutex> lock(mtx_);
+        if (--in_flight_ == 0) {
+            idle_cv_.notify_all();
+        }
+    }
+
+    /// Pass a read through, giving Runtime reads a buffer when the
+    /// wrapped backend does not.
+    void forward(Request req, CompletionCallback on_complete) {
+        if (req.dst_memory != RequestMemory::Runtime || inner_buffers_) {
+            inner_->submit(std::move(req), std::move(on_complete));
+            return;
+        }
+        detail::fetch_shared_read(*inner_, false, *buffer_pool_, "prefetch", std::move(req),
+                                  [on_complete](Request& done, BufferView view) {
+            detail::deliver_shared_read(Waiter{done, on_complete}, done, view);
+        });
+    }
+
+    /// Writes pass through; the file's prefetches are dropped and its
+    /// stream reset before the write starts and again once it lands.
+    void forward_write(Request req, CompletionCallback on_complete) {
+        struct stat st{};
+        const bool known = ::fstat(req.fd, &st) == 0;
+        const FileKey file{st.st_dev, st.st_ino};
+        if (known) {
+            invalidate_file(file);
+        }
+        inner_->submit(std::move(req),
+                       [this, known, file, on_complete = std::move(on_complete)](Request& done) {
+            if (known) {
+                invalidate_file(file);
+            }
+            if (on_complete) {
+                on_complete(done);
+            }
+        });
+    }
+
+    void invalidate_file(const FileKey& file) {
+        std::vector<BufferView> dropped;
+        std::lock_guard<std::mutex> lock(mtx_);
+        drop_slots(file, dropped);
+        const auto found = stream_index_.find(file);
+        if (found != stream_index_.end()) {
+            reset(*found->second);
+        }
+    }
+
+    PrefetchConfig config_;
+    const std::shared_ptr<BufferPool> buffer_pool_; ///< Destination of prefetches when inner_ has no buffers.
+    const bool inner_buffers_;                      ///< inner_->provides_buffers().
+
+    mutable std::mutex      mtx_;
+    std::condition_variable idle_cv_;  ///< Signalled when in_flight_ drops to zero.
+    std::unordered_map<SlotKey, Slot, SlotKeyHash> slots_;
+    ReadyList               ready_order_; ///< Completed, unconsumed slots, oldest first.
+    StreamList              streams_;     ///< Most recently read first.
+    std::unordered_map<FileKey, StreamList::iterator, FileKeyHash> stream_index_;
+    std::size_t             bytes_buffered_ = 0; ///< Budget held by slots, in flight or ready.
+    std::size_t             in_flight_ = 0;      ///< Prefetches not yet completed.
+    std::uint64_t           next_seq_ = 0;
+    detail::ShardedCounters<kCounterCount> counters_;
+    /// Declared last so it is released first, after the destructor has
+    /// waited for every prefetch.
+    const std::shared_ptr<Backend> inner_;
+};
+
+} // namespace
+
+std::shared_ptr<PrefetchingBackend> make_prefetching_backend(std::shared_ptr<Backend> inner,
+                                                             const PrefetchConfig& config) {
+    return std::make_shared<PrefetchingBackendImpl>(std::move(inner), config);
+}
+
+} // namespace ds
@@ -0,0 +1,95 @@
+// SPDX-License-Identifier: Apache-2.0
+// Internal identity of a read result, shared by the asset cache, the
+// prefetcher and the Queue's in-flight read deduplication.
+//
+// This header is private to the runtime (it lives in src/, not include/).
+
+#pragma once
+
+#include "ds_runtime.hpp"
+
+#include <cstddef>
+#include <cstdint>
+
+#include <sys/stat.h>
+#include <sys/types.h>
+
+namespace ds {
+namespace detail {
+
+/**
+ * @brief Identity of the bytes a read produces.
+ *
+ * The file is identified by device and inode rather than descriptor, so
+ * two descriptors for one asset share a key and a reused descriptor
+ * number does not. Its modification time is part of the key so a
+ * rewritten file never matches an older result.
+ */
+struct ReadKey {
+    dev_t         dev = 0;
+    ino_t         ino = 0;
+    std::int64_t  mtime_ns = 0;
+    std::uint64_t offset = 0;
+    std::size_t   size = 0;
+    Compression   compression = Compression::None;
+
+    bool operator==(const ReadKey& other) const noexcept {
+        return dev == other.dev && ino == other.ino && mtime_ns == other.mtime_ns &&
+               offset == other.offset && size == other.size &&
+               compression == other.compression;
+    }
+};
+
+struct ReadKeyHash {
+    std::size_t operator()(const ReadKey& key) const noexcept {
+        std::uint64_t h = 0x9e3779b97f4a7c15ull;
+        const auto mix = [&h](std::uint64_t v) {
+            h ^= v + 0x9e3779b97f4a7c15ull + (h << 6) + (h >> 2);
+        };
+        mix(static_cast<std::uint64_t>(key.dev));
+        mix(static_cast<std::uint64_t>(key.ino));
+        mix(static_cast<std::uint64_t>(key.mtime_ns));
+        mix(key.offset);
+        mix(key.size);
+        mix(static_cast<std::uint64_t>(key.compression));
+        // Final avalanche (splitmix64) so shard selection uses all bits.
+        h ^= h >> 30;
+        h *= 0xbf58476d1ce4e5b9ull;
+        h ^= h >> 27;
+        h *= 0x94d049bb133111ebull;
+        h ^= h >> 31;
+        return static_cast<std::size_t>(h);
+    }
+};
+
+/// True if @p req is a host or Runtime read whose result can be shared:
+/// non-empty, not GPU-targeted, and with somewhere to put the bytes.
+inline bool is_shareable_read(const Request& req) noexcept {
+    return req.op == RequestOp::Read && req.size != 0 &&
+           (req.dst_memory == RequestMemory::Runtime ||
+            (req.dst_memory == RequestMemory::Host && req.dst != nullptr));
+}
+
+/// Build the key for @p req, or return false if its file cannot be stat'ed.
+/// The file's current size is stored in @p file_size when it is non-null.
+inline bool make_read_key(const Request& req, ReadKey& key,
+                          std::uint64_t* file_size = nullptr) noexcept {
+    struct stat st{};
+    if (::fstat(req.fd, &st) != 0) {
+        return false;
+    }
+    if (file_size != nullptr) {
+        *file_size = st.st_size > 0 ? static_cast<std::uint64_t>(st.st_size) : 0;
+    }
+    key.dev = st.st_dev;
+    key.ino = st.st_ino;
+    key.mtime_ns = static_cast<std::int64_t>(st.st_mtim.tv_sec) * 1000000000 +
+                   st.st_mtim.tv_nsec;
+    key.offset = req.offset;
+    key.size = req.size;
+    key.compression = req.compression;
+    return true;
+}
+
+} // namespace detail
+} // namespace ds
@@ -0,0 +1,134 @@
+// SPDX-License-Identifier: Apache-2.0
+// Internal lock-free ring buffer used by ds-runtime queues.
+//
+// This header is private to the runtime (it lives in src/, not include/).
+// It provides a bounded multi-producer ring based on per-slot sequence
+// numbers (Vyukov-style). Producers and consumers never take a lock; a full
+// ring is reported to the caller, who decides how to handle overflow.
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <utility>
+
+namespace ds {
+namespace detail {
+
+/// Size of a destructive-interference region. Hard-coded rather than using
+/// std::hardware_destructive_interference_size, which GCC warns about when
+/// used in headers.
+constexpr std::size_t kCacheLineSize = 64;
+
+/**
+ * @brief Bounded lock-free ring with multi-producer push and pop.
+ *
+ *  - Capacity is rounded up to a power of two (minimum 2).
+ *  - try_push()/try_pop() never block and never allocate.
+ *  - Each slot carries a sequence number so producers claim slots with a
+ *    single CAS on the tail index and publish with a release store.
+ *
+ * The queue front-end uses it as an MPSC channel (many enqueueing threads,
+ * one draining thread at a time), but concurrent consumers are also safe.
+ *
+ * @tparam T  Element type. Must be default-constructible and movable.
+ */
+template <typename T>
+class BoundedRing {
+public:
+    /// Construct a ring with room for at least @p capacity elements.
+    explicit BoundedRing(std::size_t capacity)
+        : mask_(round_up_pow2(capacity) - 1)
+        , cells_(std::make_unique<Cell[]>(mask_ + 1))
+    {
+        for (std::size_t i = 0; i <= mask_; ++i) {
+            cells_[i].seq.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    BoundedRing(const BoundedRing&) = delete;
+    BoundedRing& operator=(const BoundedRing&) = delete;
+
+    /// Try to append @p value. Returns false if the ring is full, in which
+    /// case @p value is left untouched.
+    bool try_push(T& value) {
+        std::size_t pos = tail_.load(std::memory_order_relaxed);
+        for (;;) {
+            Cell& cell = cells_[pos & mask_];
+            const std::size_t seq = cell.seq.load(std::memory_order_acquire);
+            const auto diff =
+                static_cast<std::ptrdiff_t>(seq) - static_cast<std::ptrdiff_t>(pos);
+            if (diff == 0) {
+                if (tail_.compare_exchange_weak(pos, pos + 1,
+                                                std::memory_order_relaxed)) {
+                    cell.value = std::move(value);
+                    cell.seq.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false; // Slot still owned by a consumer lap behind: full.
+            } else {
+                pos = tail_.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    /// Try to remove the oldest element into @p out. Returns false if the
+    /// ring is empty.
+    bool try_pop(T& out) {
+        std::size_t pos = head_.load(std::memory_order_relaxed);
+        for (;;) {
+            Cell& cell = cells_[pos & mask_];
+            const std::size_t seq = cell.seq.load(std::memory_order_acquire);
+            const auto diff =
+                static_cast<std::ptrdiff_t>(seq) - static_cast<std::ptrdiff_t>(pos + 1);
+            if (diff == 0) {
+                if (head_.compare_exchange_weak(pos, pos + 1,
+                                                std::memory_order_relaxed)) {
+                    out = std::move(cell.value);
+                    cell.seq.store(pos + mask_ + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false; // Slot not yet published: empty.
+            } else {
+                pos = head_.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    /// Approximate number of elements currently stored. Only a hint; it may
+    /// be stale as soon as it is read.
+    std::size_t size_approx() const {
+        const std::size_t tail = tail_.load(std::memory_order_relaxed);
+        const std::size_t head = head_.load(std::memory_order_relaxed);
+        return tail >= head ? tail - head : 0;
+    }
+
+    /// Number of slots in the ring.
+    std::size_t capacity() const { return mask_ + 1; }
+
+private:
+    struct Cell {
+        std::atomic<std::size_t> seq{0}; ///< Publication sequence for this slot.
+        T                        value{}; ///< Stored element (valid when published).
+    };
+
+    static std::size_t round_up_pow2(std::size_t n) {
+        std::size_t p = 2;
+        while (p < n) {
+            p <<= 1;
+        }
+        return p;
+    }
+
+    const std::size_t       mask_;  ///< capacity - 1 (capacity is a power of two).
+    std::unique_ptr<Cell[]> cells_; ///< Slot storage.
+
+    alignas(kCacheLineSize) std::atomic<std::size_t> tail_{0}; ///< Next slot to produce.
+    alignas(kCacheLineSize) std::atomic<std::size_t> head_{0}; ///< Next slot to consume.
+};
+
+} // namespace detail
+} // namespace ds
@@ -0,0 +1,119 @@
+// SPDX-License-Identifier: Apache-2.0
+// Internal helpers for Backend decorators that answer several reads from
+// one backend read (the asset cache and the prefetcher).
+//
+// This header is private to the runtime (it lives in src/, not include/).
+
+#pragma once
+
+#include "ds_runtime.hpp"
+#include "ds_runtime_buffer.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <utility>
+
+namespace ds {
+namespace detail {
+
+/// A read waiting for a shared result, with the callback that completes it.
+struct ReadWaiter {
+    Request            req;
+    CompletionCallback callback;
+};
+
+/// Result handler for fetch_shared_read(): the completed request and, on
+/// success, a view of the decoded bytes.
+using SharedReadCallback = std::function<void(Request&, BufferView)>;
+
+/**
+ * @brief Read @p req through @p inner into memory that can outlive the
+ *        request.
+ *
+ * Uses @p inner's own buffers when @p inner_buffers is set (a Runtime
+ * read), otherwise a block from @p pool. @p on_done receives the request
+ * with its original destination fields restored and, on success, a view
+ * of the bytes. Allocation failures complete inline with ENOMEM and are
+ * reported under @p subsystem.
+ */
+inline void fetch_shared_read(Backend& inner,
+                              bool inner_buffers,
+                              BufferPool& pool,
+                              const char* subsystem,
+                              Request req,
+                              SharedReadCallback on_done) {
+    Request op = req;
+    op.buffer.reset();
+    std::shared_ptr<PoolBuffer> block;
+    if (inner_buffers) {
+        op.dst_memory = RequestMemory::Runtime;
+        op.dst = nullptr;
+    } else {
+        block = std::make_shared<PoolBuffer>(pool.allocate(req.size));
+        if (!*block) {
+            report_request_error(subsystem,
+                                 "allocate",
+                                 "Buffer pool exhausted",
+                                 req,
+                                 ENOMEM,
+                                 __FILE__,
+                                 __LINE__,
+                                 __func__);
+            req.status = RequestStatus::IoError;
+            req.errno_value = ENOMEM;
+            req.bytes_transferred = 0;
+            on_done(req, BufferView());
+            return;
+        }
+        op.dst_memory = RequestMemory::Host;
+        op.dst = block->data();
+    }
+
+    inner.submit(std::move(op),
+                 [dst = req.dst, dst_memory = req.dst_memory, block,
+                  on_done = std::move(on_done)](Request& done) {
+        BufferView view;
+        if (done.status == RequestStatus::Ok) {
+            view = block ? block->share(done.bytes_transferred) : std::move(done.buffer);
+            if (!view) {
+                done.status = RequestStatus::IoError;
+                done.errno_value = EIO;
+            }
+        }
+        done.dst = dst;
+        done.dst_memory = dst_memory;
+        done.buffer.reset();
+        on_done(done, std::move(view));
+    });
+}
+
+/**
+ * @brief Complete @p waiter with the outcome in @p result and the decoded
+ *        bytes in @p view: Runtime reads share the view, host reads get a
+ *        copy in dst.
+ */
+inline void deliver_shared_read(ReadWaiter waiter, const Request& result, const BufferView& view) {
+    Request& req = waiter.req;
+    req.status = result.status;
+    req.errno_value = result.errno_value;
+    req.start_time_ns = result.start_time_ns;
+    req.bytes_transferred = 0;
+    if (req.status == RequestStatus::Ok) {
+        const std::size_t bytes = std::min(view.size(), req.size);
+        if (req.dst_memory == RequestMemory::Runtime) {
+            req.buffer = view.subview(0, bytes);
+        } else if (bytes != 0) {
+            std::memcpy(req.dst, view.data(), bytes);
+        }
+        req.bytes_transferred = bytes;
+    }
+    if (waiter.callback) {
+        waiter.callback(req);
+    }
+}
+
+} // namespace detail
+} // namespace ds
@@ -0,0 +1,134 @@
+// SPDX-License-Identifier: Apache-2.0
+// Telemetry snapshot helpers for ds-runtime.
+//
+// Implements the value-type helpers declared in ds_runtime.hpp:
+// LatencyHistogram bucketing and percentiles, BackendStats lookup, and
+// throughput_between(). The concurrent recorders live in
+// ds_runtime_stats.hpp.
+
+#include "ds_runtime.hpp"
+
+#include <bit>
+#include <cmath>
+
+namespace ds {
+
+/**
+ * @brief Map a sample to its log-linear bucket.
+ *
+ * Values below kSubBuckets get one exact bucket each. Above that, the most
+ * significant bit selects the power-of-two range and the next
+ * kSubBucketBits bits select the linear sub-bucket within it.
+ */
+std::size_t LatencyHistogram::bucket_index(std::uint64_t ns) noexcept {
+    if (ns < kSubBuckets) {
+        return static_cast<std::size_t>(ns);
+    }
+    const std::size_t magnitude = static_cast<std::size_t>(std::bit_width(ns)) - 1;
+    if (magnitude > kMaxMagnitude) {
+        return kBucketCount - 1;
+    }
+    const std::size_t sub = static_cast<std::size_t>(
+        (ns >> (magnitude - kSubBucketBits)) & (kSubBuckets - 1));
+    return (magnitude - kSubBucketBits + 1) * kSubBuckets + sub;
+}
+
+/**
+ * @brief Inclusive upper bound of bucket @p index (inverse of bucket_index).
+ */
+std::uint64_t LatencyHistogram::bucket_upper_ns(std::size_t index) noexcept {
+    if (index < kSubBuckets) {
+        return index;
+    }
+    const std::size_t magnitude = index / kSubBuckets + kSubBucketBits - 1;
+    const std::uint64_t sub = index % kSubBuckets;
+    return ((kSubBuckets + sub + 1) << (magnitude - kSubBucketBits)) - 1;
+}
+
+/**
+ * @brief Walk the cumulative distribution up to rank ceil(p% * count).
+ */
+std::uint64_t LatencyHistogram::percentile_ns(double p) const noexcept {
+    if (count == 0) {
+        return 0;
+    }
+    if (p < 0.0) {
+        p = 0.0;
+    } else if (p > 100.0) {
+        p = 100.0;
+    }
+
+    std::uint64_t rank = static_cast<std::uint64_t>(
+        std::ceil(p / 100.0 * static_cast<double>(count)));
+    if (rank == 0) {
+        rank = 1;
+    }
+
+    std::uint64_t seen = 0;
+    for (std::size_t i = 0; i < kBucketCount; ++i) {
+        seen += counts[i];
+        if (seen >= rank) {
+            const std::uint64_t upper = bucket_upper_ns(i);
+            return upper < max_ns ? upper : max_ns;
+        }
+    }
+    return max_ns;
+}
+
+double LatencyHistogram::mean_ns() const noexcept {
+    return count == 0 ? 0.0
+                      : static_cast<double>(sum_ns) / static_cast<double>(count);
+}
+
+void LatencyHistogram::record(std::uint64_t ns) noexcept {
+    ++counts[bucket_index(ns)];
+    ++count;
+    sum_ns += ns;
+    if (ns > max_ns) {
+        max_ns = ns;
+    }
+}
+
+void LatencyHistogram::merge(const LatencyHistogram& other) noexcept {
+    for (std::size_t i = 0; i < kBucketCount; ++i) {
+        counts[i] += other.counts[i];
+    }
+    count += other.count;
+    sum_ns += other.sum_ns;
+    if (other.max_ns > max_ns) {
+        max_ns = other.max_ns;
+    }
+}
+
+std::uint64_t BackendStats::counter(const std::string& name) const noexcept {
+    for (const auto& c : counters) {
+        if (c.name == name) {
+            return c.value;
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief Completion and byte rates over the interval between two snapshots.
+ *
+ * Returns zero rates if @p later is not after @p earlier (e.g. snapshots of
+ * different queues or passed in the wrong order).
+ */
+Throughput throughput_between(const QueueStats& earlier, const QueueStats& later) {
+    Throughput out;
+    if (later.elapsed <= earlier.elapsed ||
+        later.completed < earlier.completed ||
+        later.bytes_transferred < earlier.bytes_transferred) {
+        return out;
+    }
+    const double seconds =
+        std::chrono::duration<double>(later.elapsed - earlier.elapsed).count();
+    out.requests_per_second =
+        static_cast<double>(later.completed - earlier.completed) / seconds;
+    out.bytes_per_second =
+        static_cast<double>(later.bytes_transferred - earlier.bytes_transferred) / seconds;
+    return out;
+}
+
+} // namespace ds
@@ -0,0 +1,130 @@
+// SPDX-License-Identifier: Apache-2.0
+// Internal telemetry primitives used by ds-runtime queues and backends.
+//
+// This header is private to the runtime (it lives in src/, not include/).
+// Hot paths record into per-thread shards with relaxed atomics, so worker
+// threads never contend on a shared cache line; readers sum the shards into
+// the public snapshot types (LatencyHistogram, QueueStats, BackendStats).
+
+#pragma once
+
+#include "ds_runtime.hpp"
+#include "ds_runtime_ring.hpp" // kCacheLineSize
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+namespace ds {
+namespace detail {
+
+/// Number of per-thread shards. Threads are assigned round-robin, so with
+/// more threads than shards a few of them share one.
+constexpr std::size_t kStatsShards = 8;
+
+/// Monotonic timestamp in nanoseconds, as stored in Request timestamps.
+inline std::uint64_t steady_now_ns() noexcept {
+    return static_cast<std::uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()
+        ).count()
+    );
+}
+
+/// Shard owned by the calling thread, assigned on first use.
+inline std::size_t this_thread_shard() noexcept {
+    static std::atomic<std::size_t> next{0};
+    thread_local const std::size_t shard =
+        next.fetch_add(1, std::memory_order_relaxed) % kStatsShards;
+    return shard;
+}
+
+/// Raise @p peak to at least @p value.
+inline void update_peak(std::atomic<std::uint64_t>& peak, std::uint64_t value) noexcept {
+    std::uint64_t prev = peak.load(std::memory_order_relaxed);
+    while (value > prev &&
+           !peak.compare_exchange_weak(prev, value, std::memory_order_relaxed)) {
+    }
+}
+
+/**
+ * @brief Fixed set of monotonically increasing counters, sharded per thread.
+ *
+ * @tparam N  Number of counters. Callers index them with their own enum.
+ */
+template <std::size_t N>
+class ShardedCounters {
+public:
+    /// Add @p delta to counter @p index in the calling thread's shard.
+    void add(std::size_t index, std::uint64_t delta = 1) noexcept {
+        shards_[this_thread_shard()].values[index].fetch_add(
+            delta, std::memory_order_relaxed);
+    }
+
+    /// Sum of counter @p index across all shards.
+    std::uint64_t read(std::size_t index) const noexcept {
+        std::uint64_t total = 0;
+        for (const auto& shard : shards_) {
+            total += shard.values[index].load(std::memory_order_relaxed);
+        }
+        return total;
+    }
+
+private:
+    struct alignas(kCacheLineSize) Shard {
+        std::array<std::atomic<std::uint64_t>, N> values{};
+    };
+
+    std::array<Shard, kStatsShards> shards_{};
+};
+
+/**
+ * @brief Concurrent LatencyHistogram, sharded per thread.
+ *
+ * record() is a handful of relaxed atomic adds on the caller's shard;
+ * snapshot() merges the shards into a plain LatencyHistogram.
+ */
+class ShardedHistogram {
+public:
+    /// Record one latency sample of @p ns nanoseconds.
+    void record(std::uint64_t ns) noexcept {
+        Shard& shard = shards_[this_thread_shard()];
+        shard.counts[LatencyHistogram::bucket_index(ns)].fetch_add(
+            1, std::memory_order_relaxed);
+        shard.count.fetch_add(1, std::memory_order_relaxed);
+        shard.sum_ns.fetch_add(ns, std::memory_order_relaxed);
+        update_peak(shard.max_ns, ns);
+    }
+
+    /// Merge every shard into a snapshot.
+    LatencyHistogram snapshot() const noexcept {
+        LatencyHistogram out;
+        for (const auto& shard : shards_) {
+            for (std::size_t i = 0; i < LatencyHistogram::kBucketCount; ++i) {
+                out.counts[i] += shard.counts[i].load(std::memory_order_relaxed);
+            }
+            out.count += shard.count.load(std::memory_order_relaxed);
+            out.sum_ns += shard.sum_ns.load(std::memory_order_relaxed);
+            const std::uint64_t max_ns = shard.max_ns.load(std::memory_order_relaxed);
+            if (max_ns > out.max_ns) {
+                out.max_ns = max_ns;
+            }
+        }
+        return out;
+    }
+
+private:
+    struct alignas(kCacheLineSize) Shard {
+        std::array<std::atomic<std::uint64_t>, LatencyHistogram::kBucketCount> counts{};
+        std::atomic<std::uint64_t> count{0};
+        std::atomic<std::uint64_t> sum_ns{0};
+        std::atomic<std::uint64_t> max_ns{0};
+    };
+
+    std::array<Shard, kStatsShards> shards_{};
+};
+
+} // namespace detail
+} // namespace ds
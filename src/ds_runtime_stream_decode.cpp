@@ -0,0 +1,397 @@
+// SPDX-License-Identifier: Apache-2.0
+// Streaming GDeflate decoder for ds-runtime.
+//
+// Each GDeflate read becomes a small state machine driven by completions:
+// the index read, then block reads into ring slots, then a decode job per
+// landed block. A decode that finishes returns its slot and issues the
+// next block read, so the wrapped backend stays `ring_blocks` reads ahead
+// of the decoders for the whole stream. The first failure stops new
+// reads; the request completes once everything in flight has drained.
+
+#include "ds_runtime_stream_decode.hpp"
+#include "ds_runtime_buffer.hpp"
+#include "ds_runtime_gdeflate_index.hpp"
+#include "ds_runtime_stats.hpp"
+#include "ds_runtime_thread_pool.hpp"
+#include "ds_runtime_trace.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace ds {
+
+namespace {
+
+class StreamingDecodeBackendImpl final : public StreamingDecodeBackend {
+public:
+    StreamingDecodeBackendImpl(std::shared_ptr<Backend> inner, const StreamDecodeConfig& config)
+        : decoder_(config.decoder)
+        , ring_blocks_(std::max<std::size_t>(config.ring_blocks, 1))
+        , index_bytes_(std::max(config.index_read_bytes, sizeof(gdeflate::FileHeader)))
+        , buffer_pool_(config.buffer_pool ? config.buffer_pool : default_buffer_pool())
+        , inner_buffers_(inner->provides_buffers())
+        , verify_(config.verify_checksums)
+        , pool_(std::max<std::size_t>(config.decode_workers, 1), config.placement)
+        , inner_(std::move(inner))
+    {}
+
+    ~StreamingDecodeBackendImpl() override {
+        // Reads and decode jobs call back into this object; let them land.
+        std::unique_lock<std::mutex> lock(mtx_);
+        idle_cv_.wait(lock, [this] { return in_flight_ == 0 && submitting_ == 0; });
+    }
+
+    void submit(Request req, CompletionCallback on_complete) override {
+        if (!decoder_ || req.op != RequestOp::Read || req.compression != Compression::GDeflate ||
+            req.dst_memory == RequestMemory::Gpu) {
+            inner_->submit(std::move(req), std::move(on_complete));
+            return;
+        }
+
+        auto job = std::make_shared<Job>();
+        job->on_complete = std::move(on_complete);
+        if (req.dst_memory == RequestMemory::Runtime && req.dst == nullptr) {
+            job->block = buffer_pool_->allocate(req.size);
+            req.dst = job->block.data();
+        }
+        job->req = std::move(req);
+        {
+            std::lock_guard<std::mutex> lock(mtx_);
+            ++in_flight_;
+        }
+        if (job->req.dst == nullptr) {
+            const bool runtime = job->req.dst_memory == RequestMemory::Runtime;
+            fail(*job, runtime ? ENOMEM : EINVAL, "submit",
+                 runtime ? "Buffer pool exhausted" : "Read request missing destination buffer");
+            complete(job);
+            return;
+        }
+
+        job->head.resize(index_bytes_);
+        read(job, job->req.offset, job->head.data(), job->head.size(),
+             [this](const std::shared_ptr<Job>& j, Request& done) { on_head(j, done); });
+    }
+
+    BackendStats stats() const override {
+        BackendStats out = inner_->stats();
+        const StreamDecodeStats decode = decode_stats();
+        out.counters.push_back({"decode_streams", decode.streams});
+        out.counters.push_back({"decode_failed", decode.failed});
+        out.counters.push_back({"decode_blocks", decode.blocks});
+        out.counters.push_back({"decode_overlapped", decode.overlapped});
+        out.counters.push_back({"decode_ring_full", decode.ring_full});
+        out.counters.push_back({"decode_verified", decode.verified});
+        out.counters.push_back({"decode_corrupt", decode.corrupt});
+        out.counters.push_back({"decode_in_flight", decode.in_flight});
+        return out;
+    }
+
+    bool provides_buffers() const noexcept override { return inner_buffers_; }
+
+    StreamDecodeStats decode_stats() const override {
+        StreamDecodeStats out;
+        out.streams = counters_.read(kStreams);
+        out.failed = counters_.read(kFailed);
+        out.blocks = counters_.read(kBlocks);
+        out.overlapped = counters_.read(kOverlapped);
+        out.ring_full = counters_.read(kRingFull);
+        out.verified = counters_.read(kVerified);
+        out.corrupt = counters_.read(kCorrupt);
+        std::lock_guard<std::mutex> lock(mtx_);
+        out.in_flight = in_flight_;
+        return out;
+    }
+
+private:
+    /// One GDeflate read in progress.
+    struct Job {
+        Request            req;
+        CompletionCallback on_complete;
+        PoolBuffer         block;  ///< Runtime destination allocated here, if any.
+        std::vector<char>  head;   ///< Stream header and block table, until indexed.
+        gdeflate::FileHeader  header{};
+        detail::GDeflateIndex index; ///< payload_offset is made absolute.
+        std::vector<PoolBuffer> slots; ///< The ring.
+
+        std::mutex         mtx;    ///< Protects the fields below.
+        std::vector<std::size_t> free_slots;
+        std::size_t        next_block = 0;  ///< Next block to read.
+        std::size_t        reading = 0;     ///< Block reads in flight.
+        std::size_t        busy = 0;        ///< Block reads and decodes in flight.
+        std::size_t        decoded = 0;     ///< Blocks decoded.
+        int                error = 0;       ///< First failure's errno, or 0.
+    };
+
+    enum Counter : std::size_t {
+        kStreams, kFailed, kBlocks, kOverlapped, kRingFull, kVerified, kCorrupt, kCounterCount
+    };
+
+    /// Read [@p offset, +@p size) of the job's file into @p dst through
+    /// the wrapped backend.
+    template <typename Done>
+    void read(const std::shared_ptr<Job>& job, std::uint64_t offset, void* dst, std::size_t size,
+              Done done) {
+        Request op;
+        op.fd = job->req.fd;
+        op.offset = offset;
+        op.size = size;
+        op.dst = dst;
+        op.user_tag = job->req.user_tag;
+        enter();
+        inner_->submit(std::move(op), [job, done](Request& result) { done(job, result); });
+        leave();
+    }
+
+    /// Bracket a hand-off to inner_ or pool_ that may finish the job, and
+    /// let the destructor run, before it returns.
+    void enter() {
+        std::lock_guard<std::mutex> lock(mtx_);
+        ++submitting_;
+    }
+
+    void leave() {
+        std::lock_guard<std::mutex> lock(mtx_);
+        if (--submitting_ == 0 && in_flight_ == 0) {
+            idle_cv_.notify_all();
+        }
+    }
+
+    /// The header and the start of the table have landed; fetch the rest
+    /// of the table if it did not fit.
+    void on_head(const std::shared_ptr<Job>& job, Request& done) {
+        if (done.status != RequestStatus::Ok) {
+            fail(*job, done.errno_value, "read", "Cannot read GDeflate stream header");
+            complete(job);
+            return;
+        }
+        int err = 0;
+        const char* problem = detail::check_gdeflate_header(job->head.data(), done.bytes_transferred,
+                                                            job->req.size, job->header, err);
+        if (problem != nullptr) {
+            fail(*job, err, "decompression", problem);
+            complete(job);
+            return;
+        }
+        const std::size_t index_bytes = sizeof(gdeflate::FileHeader) +
+                                        detail::gdeflate_table_bytes(job->header);
+        if (done.bytes_transferred >= index_bytes) {
+            job->head.resize(index_bytes);
+            start_blocks(job);
+            return;
+        }
+        const std::size_t have = done.bytes_transferred;
+        job->head.resize(index_bytes);
+        read(job, job->req.offset + have, job->head.data() + have, index_bytes - have,
+             [this, missing = index_bytes - have](const std::shared_ptr<Job>& j, Request& rest) {
+                 if (rest.status != RequestStatus::Ok || rest.bytes_transferred != missing) {
+                     fail(*j, rest.status != RequestStatus::Ok ? rest.errno_value : EIO, "read",
+                          "Cannot read GDeflate block table");
+                     complete(j);
+                     return;
+                 }
+                 start_blocks(j);
+             });
+    }
+
+    /// Check the block table, fill the ring and issue the first reads.
+    void start_blocks(const std::shared_ptr<Job>& job) {
+        int err = 0;
+        const char* problem = detail::build_gdeflate_index(std::move(job->head), job->index, err);
+        if (problem != nullptr) {
+            fail(*job, err, "decompression", problem);
+            complete(job);
+            return;
+        }
+        job->index.payload_offset += job->req.offset;
+
+        const std::size_t slots = std::min(ring_blocks_, job->index.blocks.size());
+        for (std::size_t s = 0; s < slots; ++s) {
+            PoolBuffer slot = buffer_pool_->allocate(job->index.max_compressed);
+            if (!slot) {
+                break;
+            }
+            job->slots.push_back(std::move(slot));
+            job->free_slots.push_back(s);
+        }
+        if (job->slots.empty()) {
+            fail(*job, ENOMEM, "allocate", "Buffer pool exhausted");
+            complete(job);
+            return;
+        }
+        pump(job);
+    }
+
+    /// Issue block reads into every free slot.
+    void pump(const std::shared_ptr<Job>& job) {
+        std::vector<std::pair<std::size_t, std::size_t>> issue; // (block, slot)
+        {
+            std::lock_guard<std::mutex> lock(job->mtx);
+            while (job->error == 0 && job->next_block < job->index.blocks.size() &&
+                   !job->free_slots.empty()) {
+                issue.emplace_back(job->next_block++, job->free_slots.back());
+                job->free_slots.pop_back();
+            }
+            if (job->error == 0 && job->next_block < job->index.blocks.size()) {
+                counters_.add(kRingFull);
+            }
+            job->reading += issue.size();
+            job->busy += issue.size();
+        }
+        for (const auto& [b, slot] : issue) {
+            const gdeflate::BlockInfo& block = job->index.blocks[b];
+            read(job, job->index.payload_offset + block.offset, job->slots[slot].data(),
+                 block.compressed_size,
+                 [this, b = b, slot = slot](const std::shared_ptr<Job>& j, Request& done) {
+                     on_block(j, b, slot, done);
+                 });
+        }
+    }
+
+    /// Block @p b has landed in @p slot; hand it to a decode worker.
+    void on_block(const std::shared_ptr<Job>& job, std::size_t b, std::size_t slot, Request& done) {
+        const bool ok = done.status == RequestStatus::Ok &&
+                        done.bytes_transferred == job->index.blocks[b].compressed_size;
+        {
+            std::lock_guard<std::mutex> lock(job->mtx);
+            --job->reading;
+        }
+        if (!ok) {
+            release(job, slot, done.status != RequestStatus::Ok ? done.errno_value : EIO,
+                    "read", "GDeflate block " + std::to_string(b) + " could not be read");
+            return;
+        }
+        enter();
+        pool_.submit([this, job, b, slot] { decode(job, b, slot); });
+        leave();
+    }
+
+    /// Decode block @p b from @p slot into its place in dst, then check
+    /// its checksum while the bytes are still in cache.
+    void decode(const std::shared_ptr<Job>& job, std::size_t b, std::size_t slot) {
+        bool skip = false;
+        {
+            std::lock_guard<std::mutex> lock(job->mtx);
+            skip = job->error != 0;
+            if (!skip && job->reading != 0) {
+                counters_.add(kOverlapped);
+            }
+        }
+        int err = 0;
+        const char* operation = "decompression";
+        if (!skip) {
+            trace::Span span("decode", "block", job->req);
+            const gdeflate::BlockInfo& block = job->index.blocks[b];
+            char* out = static_cast<char*>(job->req.dst) + job->index.dst_offsets[b];
+            err = decoder_(job->slots[slot].data(), block.compressed_size, out,
+                           block.uncompressed_size);
+            if (err == 0 && verify_ && job->index.checksummed) {
+                counters_.add(kVerified);
+                if (!detail::gdeflate_block_intact(job->index, b, out)) {
+                    counters_.add(kCorrupt);
+                    operation = "verify";
+                    err = EBADMSG;
+                }
+            }
+            if (err == 0) {
+                counters_.add(kBlocks);
+            }
+        }
+        release(job, slot, err, operation, "GDeflate block " + std::to_string(b) + " failed");
+    }
+
+    /// Return @p slot to the ring after a block read or decode finished
+    /// with @p err, then complete the job or read the next block.
+    void release(const std::shared_ptr<Job>& job, std::size_t slot, int err,
+                 const char* operation, const std::string& detail) {
+        bool finished = false;
+        {
+            std::lock_guard<std::mutex> lock(job->mtx);
+            job->free_slots.push_back(slot);
+            --job->busy;
+            if (err != 0 && job->error == 0) {
+                job->error = err;
+                report_request_error("decode", operation, detail, job->req, err,
+                                     __FILE__, __LINE__, __func__);
+            } else if (err == 0 && job->error == 0) {
+                ++job->decoded;
+            }
+            finished = job->error != 0 ? job->busy == 0
+                                       : job->decoded == job->index.blocks.size();
+        }
+        if (finished) {
+            complete(job);
+        } else {
+            pump(job);
+        }
+    }
+
+    /// Record @p err as the job's failure and report it.
+    static void fail(Job& job, int err, const char* operation, const char* detail) {
+        job.error = err != 0 ? err : EIO;
+        report_request_error("decode", operation, detail, job.req, job.error,
+                             __FILE__, __LINE__, __func__);
+    }
+
+    /// Finish the request. Nothing of the job is in flight any more.
+    void complete(const std::shared_ptr<Job>& job) {
+        Request& req = job->req;
+        job->slots.clear();
+        if (job->error != 0) {
+            req.status = job->error == EBADMSG ? RequestStatus::Corrupt : RequestStatus::IoError;
+            req.errno_value = job->error;
+            req.bytes_transferred = 0;
+            counters_.add(kFailed);
+        } else {
+            req.status = RequestStatus::Ok;
+            req.errno_value = 0;
+            req.bytes_transferred = job->index.decoded_size;
+            if (job->block) {
+                req.buffer = job->block.share(job->index.decoded_size);
+            }
+            counters_.add(kStreams);
+        }
+        // Settle the count first, so a caller woken by the callback sees
+        // it; nothing below touches this object.
+        {
+            std::lock_guard<std::mutex> lock(mtx_);
+            if (--in_flight_ == 0 && submitting_ == 0) {
+                idle_cv_.notify_all();
+            }
+        }
+        if (job->on_complete) {
+            job->on_complete(req);
+        }
+    }
+
+    const BlockDecoder decoder_;
+    const std::size_t  ring_blocks_;
+    const std::size_t  index_bytes_;
+    const std::shared_ptr<BufferPool> buffer_pool_; ///< Ring slots and own Runtime destinations.
+    const bool inner_buffers_;                      ///< inner_->provides_buffers().
+    const bool verify_;                             ///< Check CRC-32C of checksummed blocks.
+
+    mutable std::mutex      mtx_;
+    std::condition_variable idle_cv_;    ///< Signalled when in_flight_ and submitting_ reach zero.
+    std::size_t             in_flight_ = 0; ///< GDeflate reads not yet completed.
+    std::size_t             submitting_ = 0; ///< Hand-offs between enter() and leave().
+    detail::ShardedCounters<kCounterCount> counters_;
+    detail::ThreadPool      pool_;       ///< Decode workers.
+    /// Declared last so it is released first, after the destructor has
+    /// waited for every read it was given.
+    const std::shared_ptr<Backend> inner_;
+};
+
+} // namespace
+
+std::shared_ptr<StreamingDecodeBackend> make_streaming_decode_backend(
+    std::shared_ptr<Backend> inner, const StreamDecodeConfig& config) {
+    return std::make_shared<StreamingDecodeBackendImpl>(std::move(inner), config);
+}
+
+} // namespace ds
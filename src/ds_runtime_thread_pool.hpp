@@ -0,0 +1,209 @@
+// SPDX-License-Identifier: Apache-2.0
+// Internal worker pool shared by the CPU and mmap backends.
+//
+// This header is private to the runtime (it lives in src/, not include/).
+
+#pragma once
+
+#include "ds_runtime_numa.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+namespace ds {
+namespace detail {
+
+/**
+ * @brief Very small, fixed-size thread pool.
+ *
+ *  - Jobs are std::function<void()>.
+ *  - Threads run until destruction, which first runs every job submitted
+ *    so far, including jobs those jobs submit.
+ *  - Workers are split into groups (one per NUMA node when placement is
+ *    requested, otherwise a single group); each group has its own job
+ *    queue and its workers may be pinned to the group's CPUs.
+ *  - No dynamic resizing or work stealing; this is intentionally minimal.
+ */
+class ThreadPool {
+public:
+    /**
+     * @brief Construct a thread pool with @p thread_count workers.
+     *
+     * If @p thread_count is 0, it is clamped up to 1 to avoid
+     * a degenerate pool with no workers.
+     */
+    explicit ThreadPool(std::size_t thread_count)
+        : ThreadPool(thread_count, WorkerPlacement{})
+    {}
+
+    /**
+     * @brief Construct a pool laid out over NUMA nodes per @p placement.
+     *
+     * See plan_worker_groups() for how @p thread_count and @p placement
+     * combine. Pinning failures (e.g. a restricted cpuset) leave the
+     * worker unpinned.
+     */
+    ThreadPool(std::size_t thread_count, const WorkerPlacement& placement)
+        : ThreadPool(plan_worker_groups(thread_count, placement), placement)
+    {}
+
+    /**
+     * @brief Run every outstanding job, then join the workers.
+     *
+     * Waits until no job is queued or running in any group before
+     * stopping the workers, so a running job may still submit to another
+     * group (e.g. a decode splitting into sub-jobs) and have that job run.
+     * Jobs must not be submitted from outside the pool once destruction
+     * starts.
+     */
+    ~ThreadPool() {
+        {
+            std::unique_lock<std::mutex> lock(idle_mtx_);
+            idle_cv_.wait(lock, [this] {
+                return outstanding_.load(std::memory_order_acquire) == 0;
+            });
+        }
+        for (auto& group : groups_) {
+            {
+                std::lock_guard<std::mutex> lock(group->mtx);
+                group->stop = true;
+            }
+            group->cv.notify_all();
+        }
+
+        for (auto& t : workers_) {
+            if (t.joinable()) {
+                t.join();
+            }
+        }
+    }
+
+    /**
+     * @brief Submit a job to be executed by the pool.
+     *
+     * The job is queued and executed by the next available worker thread
+     * of the group chosen for @p node (see LaneSelector), or of any group
+     * when @p node is -1. This function is thread-safe.
+     */
+    void submit(std::function<void()> job, int node = -1) {
+        Group& group = *groups_[selector_.pick(node)];
+        outstanding_.fetch_add(1, std::memory_order_relaxed);
+        {
+            std::lock_guard<std::mutex> lock(group.mtx);
+            group.jobs.push(std::move(job));
+        }
+        group.cv.notify_one();
+    }
+
+    /// True when jobs should carry a node hint: workers span several
+    /// nodes and the placement asked for locality routing.
+    bool routes_by_node() const { return route_; }
+
+    /// Number of worker threads.
+    std::size_t worker_count() const { return workers_.size(); }
+
+    /// Number of worker groups (NUMA nodes served).
+    std::size_t group_count() const { return groups_.size(); }
+
+    /// Workers whose affinity was set successfully.
+    std::size_t pinned_count() const { return pinned_.load(std::memory_order_relaxed); }
+
+    /// Jobs waiting for a free worker.
+    std::size_t queued() const {
+        std::size_t total = 0;
+        for (const auto& group : groups_) {
+            std::lock_guard<std::mutex> lock(group->mtx);
+            total += group->jobs.size();
+        }
+        return total;
+    }
+
+private:
+    /// Per-node job queue and the state its workers wait on.
+    struct Group {
+        std::queue<std::function<void()>> jobs; ///< FIFO queue of pending jobs.
+        mutable std::mutex                mtx;  ///< Protects jobs and stop.
+        std::condition_variable           cv;   ///< Signals workers when work is available or stop changes.
+        bool                              stop = false; ///< Set during destruction to shut workers down.
+    };
+
+    static std::vector<int> group_nodes(const std::vector<WorkerGroup>& plan) {
+        std::vector<int> nodes;
+        for (const auto& g : plan) {
+            nodes.push_back(g.node);
+        }
+        return nodes;
+    }
+
+    ThreadPool(const std::vector<WorkerGroup>& plan, const WorkerPlacement& placement)
+        : selector_(group_nodes(plan))
+        , route_(placement.route_by_locality && selector_.multi_node())
+    {
+        for (const auto& g : plan) {
+            groups_.push_back(std::make_unique<Group>());
+            Group* group = groups_.back().get();
+            for (std::size_t i = 0; i < g.workers; ++i) {
+                workers_.emplace_back([this, group, cpus = g.cpus]() {
+                    if (!cpus.empty() && pin_current_thread(cpus)) {
+                        pinned_.fetch_add(1, std::memory_order_relaxed);
+                    }
+                    worker_loop(*group);
+                });
+            }
+        }
+    }
+
+    /// Worker thread main loop.
+    ///
+    /// Each worker waits for jobs of its group, executes them, and
+    /// terminates only when:
+    ///  - the group's stop flag is true *and*
+    ///  - its job queue is empty.
+    ///
+    /// The destructor sets stop only once outstanding_ is zero, so no
+    /// group can exit while another still has work that may feed it.
+    void worker_loop(Group& group) {
+        for (;;) {
+            std::function<void()> job;
+
+            {
+                std::unique_lock<std::mutex> lock(group.mtx);
+                group.cv.wait(lock, [&] { return group.stop || !group.jobs.empty(); });
+
+                // If we're asked to stop and there's no more work, exit.
+                if (group.stop && group.jobs.empty()) {
+                    return;
+                }
+
+                job = std::move(group.jobs.front());
+                group.jobs.pop();
+            }
+
+            job();
+            job = nullptr; // Release captures before counting the job done.
+            if (outstanding_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                std::lock_guard<std::mutex> lock(idle_mtx_);
+                idle_cv_.notify_all();
+            }
+        }
+    }
+
+    std::vector<std::unique_ptr<Group>> groups_;     ///< One per node served (or one unplaced).
+    std::vector<std::thread>            workers_;    ///< Worker threads owned by the pool.
+    LaneSelector                        selector_;   ///< Maps node hints to groups.
+    const bool                          route_;      ///< See routes_by_node().
+    std::atomic<std::size_t>            pinned_{0};  ///< Workers pinned successfully.
+    std::atomic<std::size_t>            outstanding_{0}; ///< Jobs queued or running.
+    std::mutex                          idle_mtx_;   ///< Guards idle_cv_ waits.
+    std::condition_variable             idle_cv_;    ///< Signalled when outstanding_ drops to zero.
+};
+
+} // namespace detail
+} // namespace ds
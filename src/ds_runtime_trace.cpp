@@ -0,0 +1,296 @@
+// SPDX-License-Identifier: Apache-2.0
+// Request tracing for ds-runtime.
+//
+// Spans are stored in per-thread single-producer/single-consumer rings:
+// the recording thread is the only producer, and the flushing thread
+// (serialized by the registry mutex) is the only consumer. The registry
+// mutex is taken when a thread records its first event and on flush, never
+// on the recording fast path.
+
+#include "ds_runtime_trace.hpp"
+#include "ds_runtime_ring.hpp" // kCacheLineSize
+
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <vector>
+
+#include <unistd.h>
+
+namespace ds::trace {
+
+namespace detail {
+std::atomic<bool> g_enabled{false};
+} // namespace detail
+
+namespace {
+
+/// One completed span ("X" phase event in Chrome trace terms).
+struct Event {
+    const char*   category = nullptr;
+    const char*   name = nullptr;
+    std::uint64_t start_ns = 0;
+    std::uint64_t end_ns = 0;
+    std::uint64_t offset = 0;
+    std::uint64_t size = 0;
+    std::uint64_t user_tag = 0;
+    int           fd = -1;
+};
+
+/**
+ * @brief Per-thread SPSC event ring.
+ *
+ * head_ is advanced only by the owning thread, tail_ only by the flusher.
+ * The buffer outlives its thread (the registry keeps a reference) so that
+ * events recorded just before a worker exits are still flushed.
+ */
+class ThreadBuffer {
+public:
+    ThreadBuffer(std::size_t capacity, std::uint32_t tid)
+        : mask_(round_up_pow2(capacity) - 1)
+        , events_(std::make_unique<Event[]>(mask_ + 1))
+        , tid_(tid)
+    {}
+
+    /// Producer side; never blocks. Drops the event if the ring is full.
+    void push(const Event& event) noexcept {
+        const std::uint64_t head = head_.load(std::memory_order_relaxed);
+        if (head - tail_.load(std::memory_order_acquire) > mask_) {
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        events_[head & mask_] = event;
+        head_.store(head + 1, std::memory_order_release);
+    }
+
+    /// Consumer side; calls @p fn for every published event, then frees
+    /// their slots. Returns the number of events consumed.
+    template <typename Fn>
+    std::size_t drain(Fn&& fn) {
+        const std::uint64_t tail = tail_.load(std::memory_order_relaxed);
+        const std::uint64_t head = head_.load(std::memory_order_acquire);
+        for (std::uint64_t i = tail; i != head; ++i) {
+            fn(events_[i & mask_], tid_);
+        }
+        tail_.store(head, std::memory_order_release);
+        return static_cast<std::size_t>(head - tail);
+    }
+
+    std::uint64_t dropped() const noexcept {
+        return dropped_.load(std::memory_order_relaxed);
+    }
+
+    /// True once the owning thread has exited and every event is drained.
+    bool retired() const noexcept {
+        return !owner_alive_.load(std::memory_order_acquire) &&
+               head_.load(std::memory_order_acquire) ==
+                   tail_.load(std::memory_order_relaxed);
+    }
+
+    void mark_owner_exited() noexcept {
+        owner_alive_.store(false, std::memory_order_release);
+    }
+
+private:
+    static std::size_t round_up_pow2(std::size_t v) {
+        std::size_t p = 2;
+        while (p < v) {
+            p <<= 1;
+        }
+        return p;
+    }
+
+    const std::size_t        mask_;
+    std::unique_ptr<Event[]> events_;
+    const std::uint32_t      tid_;
+    alignas(ds::detail::kCacheLineSize) std::atomic<std::uint64_t> head_{0};
+    alignas(ds::detail::kCacheLineSize) std::atomic<std::uint64_t> tail_{0};
+    std::atomic<std::uint64_t> dropped_{0};
+    std::atomic<bool>          owner_alive_{true};
+};
+
+/// All thread buffers, plus settings for buffers created later.
+struct Registry {
+    std::mutex                                 mtx;
+    std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+    std::size_t                                events_per_thread = kDefaultEventsPerThread;
+    std::uint32_t                              next_tid = 1;
+    std::uint64_t                              retired_dropped = 0;
+};
+
+Registry& registry() {
+    static Registry instance;
+    return instance;
+}
+
+/// Thread-local handle; flags the buffer as orphaned when the thread exits.
+struct LocalBuffer {
+    std::shared_ptr<ThreadBuffer> buffer;
+
+    ~LocalBuffer() {
+        if (buffer) {
+            buffer->mark_owner_exited();
+        }
+    }
+};
+
+ThreadBuffer& local_buffer() {
+    thread_local LocalBuffer local;
+    if (!local.buffer) {
+        Registry& reg = registry();
+        std::lock_guard<std::mutex> lock(reg.mtx);
+        local.buffer = std::make_shared<ThreadBuffer>(reg.events_per_thread, reg.next_tid++);
+        reg.buffers.push_back(local.buffer);
+    }
+    return *local.buffer;
+}
+
+/// Drain all buffers into @p fn and drop buffers of exited threads.
+/// Called with the registry mutex held.
+template <typename Fn>
+std::size_t drain_all(Registry& reg, Fn&& fn) {
+    std::size_t total = 0;
+    for (auto it = reg.buffers.begin(); it != reg.buffers.end();) {
+        total += (*it)->drain(fn);
+        if ((*it)->retired()) {
+            reg.retired_dropped += (*it)->dropped();
+            it = reg.buffers.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    return total;
+}
+
+/// Write a nanosecond quantity as fractional microseconds (Chrome units).
+void write_us(std::ostream& out, std::uint64_t ns) {
+    out << ns / 1000 << '.';
+    const std::uint64_t frac = ns % 1000;
+    out << static_cast<char>('0' + frac / 100)
+        << static_cast<char>('0' + frac / 10 % 10)
+        << static_cast<char>('0' + frac % 10);
+}
+
+/// Names are runtime string literals, but escape defensively.
+void write_json_string(std::ostream& out, const char* s) {
+    out << '"';
+    for (; s != nullptr && *s != '\0'; ++s) {
+        const char c = *s;
+        if (c == '"' || c == '\\') {
+            out << '\\' << c;
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            out << ' ';
+        } else {
+            out << c;
+        }
+    }
+    out << '"';
+}
+
+} // namespace
+
+/**
+ * @brief Start recording spans.
+ */
+void enable(std::size_t events_per_thread) {
+    {
+        Registry& reg = registry();
+        std::lock_guard<std::mutex> lock(reg.mtx);
+        reg.events_per_thread = events_per_thread == 0 ? 1 : events_per_thread;
+    }
+    detail::g_enabled.store(true, std::memory_order_release);
+}
+
+/**
+ * @brief Stop recording; buffered events remain until flushed.
+ */
+void disable() {
+    detail::g_enabled.store(false, std::memory_order_release);
+}
+
+/**
+ * @brief Append a span to the calling thread's ring.
+ */
+void record(const char* category, const char* name,
+            std::uint64_t start_ns, std::uint64_t end_ns,
+            const Request& req) noexcept {
+    Event event;
+    event.category = category;
+    event.name = name;
+    event.start_ns = start_ns;
+    event.end_ns = end_ns < start_ns ? start_ns : end_ns;
+    event.offset = req.offset;
+    event.size = req.size;
+    event.user_tag = req.user_tag;
+    event.fd = req.fd;
+    try {
+        local_buffer().push(event);
+    } catch (...) {
+        // Allocating a thread's first buffer failed; drop the event.
+    }
+}
+
+/**
+ * @brief Drain every buffer into a Chrome trace JSON document.
+ *
+ * Emits complete ("X") events; timestamps are microseconds on the steady
+ * clock, which is all chrome://tracing and Perfetto need for alignment.
+ */
+std::size_t write_chrome_json(std::ostream& out) {
+    const long pid = static_cast<long>(::getpid());
+    bool first = true;
+
+    out << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+    std::size_t written = 0;
+    {
+        Registry& reg = registry();
+        std::lock_guard<std::mutex> lock(reg.mtx);
+        written = drain_all(reg, [&](const Event& e, std::uint32_t tid) {
+            out << (first ? "\n" : ",\n");
+            first = false;
+            out << "{\"ph\":\"X\",\"cat\":";
+            write_json_string(out, e.category);
+            out << ",\"name\":";
+            write_json_string(out, e.name);
+            out << ",\"pid\":" << pid << ",\"tid\":" << tid << ",\"ts\":";
+            write_us(out, e.start_ns);
+            out << ",\"dur\":";
+            write_us(out, e.end_ns - e.start_ns);
+            out << ",\"args\":{\"fd\":" << e.fd
+                << ",\"offset\":" << e.offset
+                << ",\"size\":" << e.size
+                << ",\"user_tag\":" << e.user_tag << "}}";
+        });
+    }
+    out << "\n]}\n";
+    return written;
+}
+
+bool write_chrome_json(const std::string& path) {
+    std::ofstream file(path, std::ios::out | std::ios::trunc);
+    if (!file) {
+        return false;
+    }
+    write_chrome_json(file);
+    file.flush();
+    return static_cast<bool>(file);
+}
+
+void clear() {
+    Registry& reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mtx);
+    drain_all(reg, [](const Event&, std::uint32_t) {});
+}
+
+std::uint64_t dropped_events() {
+    Registry& reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mtx);
+    std::uint64_t total = reg.retired_dropped;
+    for (const auto& buffer : reg.buffers) {
+        total += buffer->dropped();
+    }
+    return total;
+}
+
+} // namespace ds::trace
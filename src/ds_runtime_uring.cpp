@@ -2,10 +2,14 @@
 // io_uring backend implementation for ds-runtime.
 
 #include "ds_runtime_uring.hpp"
+#include "ds_runtime_numa.hpp"
+#include "ds_runtime_stats.hpp"
+#include "ds_runtime_trace.hpp"
 
 #include <atomic>
 #include <cerrno>
 #include <condition_variable>
+#include <memory>
 #include <mutex>
 #include <queue>
 #include <thread>
@@ -19,45 +23,71 @@ namespace {
 
 // Simple io_uring backend that offloads POSIX read/write to the kernel.
 // This backend is host-memory only and rejects GPU-targeted requests.
+// Each worker thread owns one ring; with NUMA placement, rings are grouped
+// per node and requests go to a ring on the node of their data.
 class IoUringBackend final : public Backend {
 public:
     explicit IoUringBackend(const IoUringBackendConfig& config)
         : entries_(config.entries ? config.entries : 1u)
-        , stop_(false)
     {
-        const int init_rc = io_uring_queue_init(entries_, &ring_, 0);
-        if (init_rc != 0) {
-            report_error("io_uring",
-                         "io_uring_queue_init",
-                         "Failed to initialize io_uring ring",
-                         -init_rc,
-                         __FILE__,
-                         __LINE__,
-                         __func__);
-            init_failed_ = true;
-        } else {
-            worker_ = std::thread([this]() { worker_loop(); });
+        std::vector<int> lane_nodes;
+        for (const auto& group : detail::plan_worker_groups(config.worker_count, config.placement)) {
+            for (std::size_t i = 0; i < group.workers; ++i) {
+                auto ring = std::make_unique<Ring>();
+                ring->cpus = group.cpus;
+                const int init_rc = io_uring_queue_init(entries_, &ring->ring, 0);
+                if (init_rc != 0) {
+                    report_error("io_uring",
+                                 "io_uring_queue_init",
+                                 "Failed to initialize io_uring ring",
+                                 -init_rc,
+                                 __FILE__,
+                                 __LINE__,
+                                 __func__);
+                    init_failed_ = true;
+                    break;
+                }
+                ring->initialized = true;
+                lane_nodes.push_back(group.node);
+                rings_.push_back(std::move(ring));
+            }
+            if (init_failed_) {
+                break;
+            }
         }
-    }
+        selector_ = std::make_unique<detail::LaneSelector>(lane_nodes);
+        route_ = config.placement.route_by_locality && selector_->multi_node();
 
-    ~IoUringBackend() override {
-        {
-            std::lock_guard<std::mutex> lock(mtx_);
-            stop_ = true;
+        if (!init_failed_) {
+            for (auto& ring : rings_) {
+                Ring* r = ring.get();
+                r->worker = std::thread([this, r]() { worker_loop(*r); });
+            }
         }
-        cv_.notify_all();
+    }
 
-        if (worker_.joinable()) {
-            worker_.join();
+    ~IoUringBackend() override {
+        for (auto& ring : rings_) {
+            {
+                std::lock_guard<std::mutex> lock(ring->mtx);
+                ring->stop = true;
+            }
+            ring->cv.notify_all();
         }
 
-        if (!init_failed_) {
-            io_uring_queue_exit(&ring_);
+        for (auto& ring : rings_) {
+            if (ring->worker.joinable()) {
+                ring->worker.join();
+            }
+            if (ring->initialized) {
+                io_uring_queue_exit(&ring->ring);
+            }
         }
     }
 
-    // Submit a host-memory-only request to the ring worker thread.
+    // Submit a host-memory-only request to a ring worker thread.
     void submit(Request req, CompletionCallback on_complete) override {
+        counters_.add(kSubmitted);
         if (init_failed_) {
             report_request_error("io_uring",
                                  "submit",
@@ -69,9 +99,7 @@ public:
                                  __func__);
             req.status = RequestStatus::IoError;
             req.errno_value = EINVAL;
-            if (on_complete) {
-                on_complete(req);
-            }
+            finish(req, on_complete);
             return;
         }
 
@@ -87,47 +115,107 @@ public:
                                  __func__);
             req.status = RequestStatus::IoError;
             req.errno_value = EINVAL;
-            if (on_complete) {
-                on_complete(req);
-            }
+            finish(req, on_complete);
             return;
         }
 
+        // Registered on the device's node, the ring worker also sees the
+        // device's interrupts and completions locally.
+        Ring& ring = *rings_[selector_->pick(route_ ? detail::request_numa_node(req, true) : -1)];
         {
-            std::lock_guard<std::mutex> lock(mtx_);
-            pending_.push({std::move(req), std::move(on_complete)});
+            std::lock_guard<std::mutex> lock(ring.mtx);
+            const std::uint64_t queued_ns = trace::enabled() ? trace::now_ns() : 0;
+            ring.pending.push({std::move(req), std::move(on_complete), queued_ns});
         }
-        cv_.notify_one();
+        ring.cv.notify_one();
+    }
+
+    // Counters plus ring-specific events (SQ full, submit batches/errors).
+    BackendStats stats() const override {
+        BackendStats out;
+        out.backend = "io_uring";
+        out.submitted = counters_.read(kSubmitted);
+        out.completed = counters_.read(kCompleted);
+        out.failed = counters_.read(kFailed);
+        out.bytes_transferred = counters_.read(kBytes);
+        out.counters.push_back({"sq_full", counters_.read(kSqFull)});
+        out.counters.push_back({"submit_batches", counters_.read(kSubmitBatches)});
+        out.counters.push_back({"submit_errors", counters_.read(kSubmitErrors)});
+        out.counters.push_back({"ring_entries", entries_});
+        out.counters.push_back({"rings", rings_.size()});
+        out.counters.push_back({"pinned_workers", pinned_.load(std::memory_order_relaxed)});
+        return out;
     }
 
 private:
+    enum Counter : std::size_t {
+        kSubmitted,
+        kCompleted,
+        kFailed,
+        kBytes,
+        kSqFull,
+        kSubmitBatches,
+        kSubmitErrors,
+        kCounterCount
+    };
+
+    // Count a completion and hand it to the caller.
+    void finish(Request& req, const CompletionCallback& callback) {
+        counters_.add(kCompleted);
+        if (req.status != RequestStatus::Ok) {
+            counters_.add(kFailed);
+        }
+        counters_.add(kBytes, req.bytes_transferred);
+        if (callback) {
+            trace::Span span("io_uring", "callback", req);
+            callback(req);
+        }
+    }
+
     struct PendingOp {
         Request req;
         CompletionCallback callback;
+        std::uint64_t queued_ns = 0; // Set only while tracing.
+    };
+
+    // One ring, its worker thread and the requests waiting for it.
+    struct Ring {
+        io_uring ring{};
+        bool initialized = false;
+        std::vector<int> cpus; // Pin targets; empty leaves affinity alone.
+        bool stop = false;
+        std::mutex mtx;
+        std::condition_variable cv;
+        std::queue<PendingOp> pending;
+        std::thread worker;
     };
 
     // Worker thread loop:
     // 1) Drain pending requests into a local batch.
     // 2) Prepare SQEs and submit to io_uring.
     // 3) Wait for CQEs and invoke callbacks.
-    void worker_loop() {
+    void worker_loop(Ring& r) {
+        if (!r.cpus.empty() && detail::pin_current_thread(r.cpus)) {
+            pinned_.fetch_add(1, std::memory_order_relaxed);
+        }
         while (true) {
             std::queue<PendingOp> batch;
             {
-                std::unique_lock<std::mutex> lock(mtx_);
-                cv_.wait(lock, [this] { return stop_ || !pending_.empty(); });
-                if (stop_ && pending_.empty()) {
+                std::unique_lock<std::mutex> lock(r.mtx);
+                r.cv.wait(lock, [&r] { return r.stop || !r.pending.empty(); });
+                if (r.stop && r.pending.empty()) {
                     break;
                 }
-                std::swap(batch, pending_);
+                std::swap(batch, r.pending);
             }
 
             while (!batch.empty()) {
                 auto op = std::make_unique<PendingOp>(std::move(batch.front()));
                 batch.pop();
 
-                io_uring_sqe* sqe = io_uring_get_sqe(&ring_);
+                io_uring_sqe* sqe = io_uring_get_sqe(&r.ring);
                 if (!sqe) {
+                    counters_.add(kSqFull);
                     report_request_error("io_uring",
                                          "io_uring_get_sqe",
                                          "Submission queue is full",
@@ -138,12 +226,16 @@ private:
                                          __func__);
                     op->req.status = RequestStatus::IoError;
                     op->req.errno_value = EBUSY;
-                    if (op->callback) {
-                        op->callback(op->req);
-                    }
+                    finish(op->req, op->callback);
                     continue;
                 }
 
+                op->req.start_time_ns = detail::steady_now_ns();
+                if (op->queued_ns != 0) {
+                    trace::record("io_uring", "pending", op->queued_ns,
+                                  op->req.start_time_ns, op->req);
+                }
+
                 if (op->req.op == RequestOp::Write) {
                     io_uring_prep_write(
                         sqe,
@@ -165,8 +257,10 @@ private:
                 io_uring_sqe_set_data(sqe, op.release());
             }
 
-            const int submitted = io_uring_submit(&ring_);
+            const int submitted = io_uring_submit(&r.ring);
+            counters_.add(kSubmitBatches);
             if (submitted <= 0) {
+                counters_.add(kSubmitErrors);
                 report_error("io_uring",
                              "io_uring_submit",
                              "Submission failed",
@@ -179,7 +273,7 @@ private:
             unsigned completed = 0;
             while (completed < static_cast<unsigned>(submitted)) {
                 io_uring_cqe* cqe = nullptr;
-                const int wait_rc = io_uring_wait_cqe(&ring_, &cqe);
+                const int wait_rc = io_uring_wait_cqe(&r.ring, &cqe);
                 if (wait_rc != 0 || !cqe) {
                     report_error("io_uring",
                                  "io_uring_wait_cqe",
@@ -192,32 +286,36 @@ private:
                 }
                 auto* op = static_cast<PendingOp*>(io_uring_cqe_get_data(cqe));
                 if (op) {
+                    if (trace::enabled()) {
+                        trace::record("io_uring",
+                                      op->req.op == RequestOp::Write ? "write" : "read",
+                                      op->req.start_time_ns, trace::now_ns(), op->req);
+                    }
                     if (cqe->res < 0) {
                         op->req.status = RequestStatus::IoError;
                         op->req.errno_value = -cqe->res;
+                        op->req.bytes_transferred = 0;
                     } else {
                         op->req.status = RequestStatus::Ok;
                         op->req.errno_value = 0;
+                        op->req.bytes_transferred = static_cast<std::size_t>(cqe->res);
                     }
-                    if (op->callback) {
-                        op->callback(op->req);
-                    }
+                    finish(op->req, op->callback);
                     delete op;
                 }
-                io_uring_cqe_seen(&ring_, cqe);
+                io_uring_cqe_seen(&r.ring, cqe);
                 ++completed;
             }
         }
     }
 
     unsigned entries_;
-    io_uring ring_{};
+    std::vector<std::unique_ptr<Ring>> rings_;
+    std::unique_ptr<detail::LaneSelector> selector_;
+    bool route_ = false;
     std::atomic<bool> init_failed_{false};
-    std::atomic<bool> stop_;
-    std::mutex mtx_;
-    std::condition_variable cv_;
-    std::queue<PendingOp> pending_;
-    std::thread worker_;
+    std::atomic<std::size_t> pinned_{0};
+    detail::ShardedCounters<kCounterCount> counters_;
 };
 
 } // namespace
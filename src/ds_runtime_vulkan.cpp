@@ -2,6 +2,8 @@
 // Vulkan backend implementation for ds-runtime.
 
 #include "ds_runtime_vulkan.hpp"
+#include "ds_runtime_stats.hpp"
+#include "ds_runtime_trace.hpp"
 
 #include <atomic>
 #include <cerrno>
@@ -927,7 +929,13 @@ public:
     // Submit work asynchronously. The Request is copied into the worker
     // lambda to decouple lifetime from the caller.
     void submit(Request req, CompletionCallback on_complete) override {
-        pool_.submit([this, req, on_complete]() mutable {
+        counters_.add(kSubmitted);
+        const std::uint64_t queued_ns = trace::enabled() ? trace::now_ns() : 0;
+        pool_.submit([this, req, on_complete, queued_ns]() mutable {
+            req.start_time_ns = detail::steady_now_ns();
+            if (queued_ns != 0) {
+                trace::record("vulkan", "pool_wait", queued_ns, req.start_time_ns, req);
+            }
             // Validate the request before performing any GPU operations.
             if (req.fd < 0) {
                 report_request_error("vulkan",
@@ -940,9 +948,7 @@ public:
                                      __func__);
                 req.status = RequestStatus::IoError;
                 req.errno_value = EBADF;
-                if (on_complete) {
-                    on_complete(req);
-                }
+                finish(req, on_complete);
                 return;
             }
 
@@ -957,9 +963,7 @@ public:
                                      __func__);
                 req.status = RequestStatus::IoError;
                 req.errno_value = EINVAL;
-                if (on_complete) {
-                    on_complete(req);
-                }
+                finish(req, on_complete);
                 return;
             }
 
@@ -975,9 +979,7 @@ public:
                                      __func__);
                 req.status = RequestStatus::IoError;
                 req.errno_value = EINVAL;
-                if (on_complete) {
-                    on_complete(req);
-                }
+                finish(req, on_complete);
                 return;
             }
 
@@ -993,20 +995,59 @@ public:
                                      __func__);
                 req.status = RequestStatus::IoError;
                 req.errno_value = EINVAL;
-                if (on_complete) {
-                    on_complete(req);
-                }
+                finish(req, on_complete);
                 return;
             }
 
             handle_request(req);
-            if (on_complete) {
-                on_complete(req);
-            }
+            finish(req, on_complete);
         });
     }
 
+    // Counters plus staging-path events. "staging_stalls" counts copies
+    // that had to wait for another worker's copy to finish.
+    BackendStats stats() const override {
+        BackendStats out;
+        out.backend = "vulkan";
+        out.submitted = counters_.read(kSubmitted);
+        out.completed = counters_.read(kCompleted);
+        out.failed = counters_.read(kFailed);
+        out.bytes_transferred = counters_.read(kBytes);
+        out.counters.push_back({"staging_allocations", counters_.read(kStagingAllocations)});
+        out.counters.push_back({"staging_alloc_failures", counters_.read(kStagingAllocFailures)});
+        out.counters.push_back({"staging_stalls", counters_.read(kStagingStalls)});
+        out.counters.push_back({"copy_submits", counters_.read(kCopySubmits)});
+        out.counters.push_back({"copy_wait_ns", counters_.read(kCopyWaitNs)});
+        return out;
+    }
+
 private:
+    enum Counter : std::size_t {
+        kSubmitted,
+        kCompleted,
+        kFailed,
+        kBytes,
+        kStagingAllocations,
+        kStagingAllocFailures,
+        kStagingStalls,
+        kCopySubmits,
+        kCopyWaitNs,
+        kCounterCount
+    };
+
+    // Count a completion and hand it to the caller.
+    void finish(Request& req, const CompletionCallback& callback) {
+        counters_.add(kCompleted);
+        if (req.status != RequestStatus::Ok) {
+            counters_.add(kFailed);
+        }
+        counters_.add(kBytes, req.bytes_transferred);
+        if (callback) {
+            trace::Span span("vulkan", "callback", req);
+            callback(req);
+        }
+    }
+
     // Initialize Vulkan context. Either borrow existing objects from config
     // or create a minimal Vulkan instance/device/queue/pool.
     void init(const VulkanBackendConfig& config) {
@@ -1170,6 +1211,7 @@ private:
     // Host-only I/O fallback path (no GPU buffers involved).
     // Host-only I/O fallback path (no GPU buffers involved).
     void handle_host_io(Request& req) {
+        trace::Span span("vulkan", req.op == RequestOp::Write ? "pwrite" : "pread", req);
         ssize_t io_bytes = 0;
         if (req.op == RequestOp::Write) {
             io_bytes = ::pwrite(
@@ -1201,6 +1243,7 @@ private:
         } else {
             req.status = RequestStatus::Ok;
             req.errno_value = 0;
+            req.bytes_transferred = static_cast<std::size_t>(io_bytes);
         }
     }
 
@@ -1254,12 +1297,16 @@ private:
             req.errno_value = EIO;
             return;
         }
-        const ssize_t rd = ::pread(
-            req.fd,
-            mapped,
-            req.size,
-            static_cast<off_t>(req.offset)
-        );
+        ssize_t rd = 0;
+        {
+            trace::Span span("vulkan", "pread", req);
+            rd = ::pread(
+                req.fd,
+                mapped,
+                req.size,
+                static_cast<off_t>(req.offset)
+            );
+        }
         vkUnmapMemory(device_, staging_memory);
 
         if (rd < 0) {
@@ -1278,7 +1325,12 @@ private:
         }
 
         // Copy staged contents into the GPU buffer.
-        if (!submit_copy(staging_buffer, gpu_buffer, req.size, 0, req.gpu_offset)) {
+        bool copied = false;
+        {
+            trace::Span span("vulkan", "staging_copy", req);
+            copied = submit_copy(staging_buffer, gpu_buffer, req.size, 0, req.gpu_offset);
+        }
+        if (!copied) {
             report_request_error("vulkan",
                                  "vkCmdCopyBuffer",
                                  "Failed to copy staging buffer to GPU buffer",
@@ -1296,6 +1348,7 @@ private:
         destroy_buffer(staging_buffer, staging_memory);
         req.status = RequestStatus::Ok;
         req.errno_value = 0;
+        req.bytes_transferred = static_cast<std::size_t>(rd);
     }
 
     // Copy GPU buffer contents into a staging buffer, then write to disk.
@@ -1333,7 +1386,12 @@ private:
         }
 
         // Copy GPU buffer contents into staging.
-        if (!submit_copy(gpu_buffer, staging_buffer, req.size, req.gpu_offset, 0)) {
+        bool copied = false;
+        {
+            trace::Span span("vulkan", "staging_copy", req);
+            copied = submit_copy(gpu_buffer, staging_buffer, req.size, req.gpu_offset, 0);
+        }
+        if (!copied) {
             report_request_error("vulkan",
                                  "vkCmdCopyBuffer",
                                  "Failed to copy GPU buffer to staging buffer",
@@ -1364,12 +1422,16 @@ private:
             req.errno_value = EIO;
             return;
         }
-        const ssize_t wr = ::pwrite(
-            req.fd,
-            mapped,
-            req.size,
-            static_cast<off_t>(req.offset)
-        );
+        ssize_t wr = 0;
+        {
+            trace::Span span("vulkan", "pwrite", req);
+            wr = ::pwrite(
+                req.fd,
+                mapped,
+                req.size,
+                static_cast<off_t>(req.offset)
+            );
+        }
         vkUnmapMemory(device_, staging_memory);
 
         destroy_buffer(staging_buffer, staging_memory);
@@ -1390,6 +1452,7 @@ private:
 
         req.status = RequestStatus::Ok;
         req.errno_value = 0;
+        req.bytes_transferred = static_cast<std::size_t>(wr);
     }
 
     // Allocate a host-visible staging buffer for file transfers.
@@ -1397,6 +1460,7 @@ private:
                                VkBufferUsageFlags usage,
                                VkBuffer& buffer,
                                VkDeviceMemory& memory) {
+        counters_.add(kStagingAllocations);
         VkBufferCreateInfo buffer_info{};
         buffer_info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
         buffer_info.size = size;
@@ -1411,6 +1475,7 @@ private:
                          __FILE__,
                          __LINE__,
                          __func__);
+            counters_.add(kStagingAllocFailures);
             return false;
         }
 
@@ -1433,6 +1498,7 @@ private:
                          __func__);
             vkDestroyBuffer(device_, buffer, nullptr);
             buffer = VK_NULL_HANDLE;
+            counters_.add(kStagingAllocFailures);
             return false;
         }
 
@@ -1451,6 +1517,7 @@ private:
                          __func__);
             vkDestroyBuffer(device_, buffer, nullptr);
             buffer = VK_NULL_HANDLE;
+            counters_.add(kStagingAllocFailures);
             return false;
         }
 
@@ -1476,7 +1543,12 @@ private:
                      VkDeviceSize size,
                      VkDeviceSize src_offset,
                      VkDeviceSize dst_offset) {
-        std::lock_guard<std::mutex> lock(vk_mutex_);
+        std::unique_lock<std::mutex> lock(vk_mutex_, std::try_to_lock);
+        if (!lock.owns_lock()) {
+            counters_.add(kStagingStalls);
+            lock.lock();
+        }
+        counters_.add(kCopySubmits);
 
         if (command_pool_ == VK_NULL_HANDLE || queue_ == VK_NULL_HANDLE) {
             report_error("vulkan",
@@ -1575,7 +1647,11 @@ private:
             return false;
         }
 
-        if (vkWaitForFences(device_, 1, &fence, VK_TRUE, UINT64_C(1'000'000'000)) != VK_SUCCESS) {
+        const std::uint64_t wait_start_ns = detail::steady_now_ns();
+        const VkResult wait_rc =
+            vkWaitForFences(device_, 1, &fence, VK_TRUE, UINT64_C(1'000'000'000));
+        counters_.add(kCopyWaitNs, detail::steady_now_ns() - wait_start_ns);
+        if (wait_rc != VK_SUCCESS) {
             report_error("vulkan",
                          "vkWaitForFences",
                          "Fence wait failed",
@@ -1602,6 +1678,7 @@ private:
     bool owns_device_{false};
     bool owns_command_pool_{false};
     std::mutex vk_mutex_;
+    detail::ShardedCounters<kCounterCount> counters_;
 };
 
 } // namespace
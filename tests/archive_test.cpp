@@ -0,0 +1,423 @@
+// SPDX-License-Identifier: Apache-2.0
+// Asset archive test.
+//
+// This test verifies:
+//  - crc32c() matches the standard check value and a bitwise reference at
+//    every length and alignment, and chains across buffers
+//  - Packs round-trip: names resolve to aligned Requests that read back
+//    the stored bytes through a Queue, including decode-on-read entries
+//  - Lookups of many entries and of missing names
+//  - The perfect hash maps every id to its own entry, rejects unknown ids,
+//    stays compact, and is checked at open and by verify()
+//  - GDeflate streams are stored with their header's uncompressed size
+//  - Duplicate names fail the build; damaged indexes and data are caught
+//    by open_archive(), verify() and verify_entry()
+
+#include "ds_runtime.hpp"
+#include "ds_runtime_archive.hpp"
+#include "ds_runtime_checksum.hpp"
+#include "gdeflate_format.h"
+
+#include <cassert>
+#include <cstddef>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace {
+
+const char* kPackPath = "archive_test.dspk";
+const char* kStreamPath = "archive_test.gdf";
+
+std::string asset_name(std::size_t i) {
+    return "textures/tile_" + std::to_string(i) + ".dds";
+}
+
+std::string asset_bytes(std::size_t i) {
+    return std::string(1 + (i * 37) % 700, static_cast<char>('a' + i % 26));
+}
+
+void flip_byte(const char* path, std::uint64_t offset) {
+    const int fd = ::open(path, O_RDWR);
+    assert(fd >= 0);
+    char byte = 0;
+    const ssize_t rd = ::pread(fd, &byte, 1, static_cast<off_t>(offset));
+    assert(rd == 1);
+    byte = static_cast<char>(byte ^ 0x5a);
+    const ssize_t wr = ::pwrite(fd, &byte, 1, static_cast<off_t>(offset));
+    assert(wr == 1);
+    ::close(fd);
+}
+
+void test_crc32c() {
+    const char* check = "123456789";
+    assert(ds::crc32c(check, 9) == 0xe3069283u);
+    assert(ds::crc32c(check + 4, 5, ds::crc32c(check, 4)) == 0xe3069283u);
+    assert(ds::crc32c(nullptr, 0) == 0);
+
+    // Whichever kernel runs must match the bitwise definition at every
+    // length and alignment, across its 8-byte and tail steps.
+    const auto reference = [](const unsigned char* p, std::size_t n) {
+        std::uint32_t crc = ~0u;
+        while (n-- != 0) {
+            crc ^= *p++;
+            for (int bit = 0; bit < 8; ++bit) {
+                crc = (crc >> 1) ^ ((crc & 1u) ? 0x82f63b78u : 0u);
+            }
+        }
+        return ~crc;
+    };
+    std::vector<unsigned char> data(20000);
+    for (std::size_t i = 0; i < data.size(); ++i) {
+        data[i] = static_cast<unsigned char>(i * 131 + 7);
+    }
+    for (std::size_t start = 0; start < 8; ++start) {
+        for (std::size_t n = 0; start + n <= data.size(); n += 1 + n / 8) {
+            const std::uint32_t crc = ds::crc32c(data.data() + start, n);
+            assert(crc == reference(data.data() + start, n));
+        }
+    }
+    std::cout << "[archive_test] crc32c on " << (ds::crc32c_hardware() ? "CRC32C instructions" : "tables")
+              << "\n";
+
+    std::cout << "[archive_test] test_crc32c PASSED\n";
+}
+
+void test_round_trip() {
+    using namespace ds;
+
+    ArchiveBuilder builder;
+    const std::string intro = "shader: lighting.hlsl";
+    ArchiveAsset shader;
+    shader.name = "shaders/lighting.hlsl";
+    shader.compression = Compression::FakeUppercase;
+    shader.alignment = 64;
+    const bool added = builder.add(shader, intro.data(), intro.size());
+    assert(added);
+    constexpr std::size_t kAssets = 300;
+    for (std::size_t i = 0; i < kAssets; ++i) {
+        const std::string bytes = asset_bytes(i);
+        ArchiveAsset asset;
+        asset.name = asset_name(i);
+        const bool added = builder.add(asset, bytes.data(), bytes.size());
+        assert(added);
+    }
+    const bool written = builder.write(kPackPath);
+    assert(written);
+
+    const auto pack = open_archive(kPackPath);
+    assert(pack);
+    assert(pack->entry_count() == kAssets + 1);
+    assert(pack->header().version_major == archive::kVersionMajor);
+    assert(pack->verify());
+
+    auto backend = make_cpu_backend(/*worker_count=*/2);
+    Queue queue(backend);
+    std::vector<std::vector<char>> buffers(kAssets);
+    for (std::size_t i = 0; i < kAssets; ++i) {
+        Request req;
+        const bool found = pack->make_request(asset_name(i), req);
+        assert(found);
+        assert(req.fd == pack->fd());
+        assert(req.offset % archive::kDefaultAlignment == 0);
+        assert(req.size == asset_bytes(i).size());
+        buffers[i].resize(req.size);
+        req.dst = buffers[i].data();
+        queue.enqueue(req);
+    }
+    std::vector<char> upper(intro.size());
+    Request shader_req;
+    const bool shader_found = pack->make_request("shaders/lighting.hlsl", shader_req);
+    assert(shader_found);
+    assert(shader_req.compression == Compression::FakeUppercase);
+    assert(shader_req.offset % 64 == 0);
+    shader_req.dst = upper.data();
+    queue.enqueue(shader_req);
+    queue.submit_all();
+    queue.wait_all();
+    assert(queue.stats().failed == 0);
+
+    for (std::size_t i = 0; i < kAssets; ++i) {
+        const std::string expected = asset_bytes(i);
+        assert(std::memcmp(buffers[i].data(), expected.data(), expected.size()) == 0);
+        const archive::TocEntry* entry = pack->find(asset_name(i));
+        assert(entry != nullptr);
+        assert(pack->name(*entry) == asset_name(i));
+        assert(pack->find_id(archive::hash_id(asset_name(i))) == entry);
+        assert(entry->checksum == crc32c(expected.data(), expected.size()));
+        assert(pack->verify_entry(*entry));
+    }
+    assert(std::string(upper.data(), upper.size()) == "SHADER: LIGHTING.HLSL");
+
+    Request missing;
+    assert(pack->find("textures/absent.dds") == nullptr);
+    assert(!pack->make_request("textures/absent.dds", missing));
+
+    std::cout << "[archive_test] test_round_trip PASSED\n";
+}
+
+void test_many_entries() {
+    using namespace ds;
+
+    ArchiveBuildConfig config;
+    config.alignment = 1;
+    ArchiveBuilder builder(config);
+    constexpr std::size_t kAssets = 50000;
+    for (std::size_t i = 0; i < kAssets; ++i) {
+        const std::string name = "e/" + std::to_string(i);
+        ArchiveAsset asset;
+        asset.name = name;
+        const bool added = builder.add(asset, name.data(), name.size());
+        assert(added);
+    }
+    const bool written = builder.write(kPackPath);
+    assert(written);
+
+    const auto pack = open_archive(kPackPath);
+    assert(pack);
+    assert(pack->header().fanout_bits == 15);
+    assert(pack->verify());
+    for (std::size_t i = 0; i < kAssets; ++i) {
+        const std::string name = "e/" + std::to_string(i);
+        const archive::TocEntry* entry = pack->find(name);
+        assert(entry != nullptr && entry->size == name.size());
+    }
+    assert(pack->find("e/" + std::to_string(kAssets)) == nullptr);
+
+    std::cout << "[archive_test] test_many_entries PASSED\n";
+}
+
+void test_perfect_hash() {
+    using namespace ds;
+
+    constexpr std::size_t kAssets = 100000;
+    const auto build = [](bool perfect_hash) {
+        ArchiveBuildConfig config;
+        config.alignment = 1;
+        config.perfect_hash = perfect_hash;
+        ArchiveBuilder builder(config);
+        for (std::size_t i = 0; i < kAssets; ++i) {
+            const std::string name = "h/" + std::to_string(i);
+            ArchiveAsset asset;
+            asset.name = name;
+            const bool added = builder.add(asset, name.data(), 1);
+            assert(added);
+        }
+        const bool written = builder.write(kPackPath);
+        assert(written);
+    };
+
+    build(/*perfect_hash=*/true);
+    std::uint64_t mphf_offset = 0;
+    std::uint64_t slots_offset = 0;
+    {
+        const auto pack = open_archive(kPackPath);
+        assert(pack && pack->has_perfect_hash());
+        const archive::Header& h = pack->header();
+        assert((h.flags & archive::kFlagPerfectHash) != 0);
+        assert(h.version_minor == archive::kVersionMinor);
+        assert(h.mphf_offset % 8 == 0);
+        // Bitsets, ranks and headers stay under 4 bits per asset; the rest
+        // is the 32-bit slot table.
+        const double bits_per_key =
+            8.0 * static_cast<double>(h.mphf_size - kAssets * sizeof(std::uint32_t)) / kAssets;
+        assert(bits_per_key < 4.0);
+        mphf_offset = h.mphf_offset;
+        slots_offset = h.mphf_offset + h.mphf_size - kAssets * sizeof(std::uint32_t);
+
+        const bool verified = pack->verify();
+        assert(verified);
+        for (std::size_t i = 0; i < kAssets; ++i) {
+            const std::string name = "h/" + std::to_string(i);
+            const archive::TocEntry* entry = pack->find(name);
+            assert(entry != nullptr && pack->name(*entry) == name);
+        }
+        for (std::size_t i = kAssets; i < 2 * kAssets; ++i) {
+            assert(pack->find("h/" + std::to_string(i)) == nullptr);
+        }
+        assert(pack->find_id(0) == nullptr);
+    }
+
+    // Without the section lookups fall back to the fanout table.
+    build(/*perfect_hash=*/false);
+    {
+        const auto pack = open_archive(kPackPath);
+        assert(pack && !pack->has_perfect_hash());
+        assert(pack->header().mphf_size == 0);
+        assert(pack->find("h/17") != nullptr);
+        assert(pack->find("h/" + std::to_string(kAssets)) == nullptr);
+    }
+
+    // Damaged slots are caught by the checksum; lookups stay in bounds and
+    // never return another name's entry.
+    build(/*perfect_hash=*/true);
+    flip_byte(kPackPath, slots_offset + 3);
+    flip_byte(kPackPath, slots_offset + 4);
+    {
+        const auto pack = open_archive(kPackPath);
+        assert(pack && pack->has_perfect_hash());
+        const bool verified = pack->verify();
+        assert(!verified);
+        for (std::size_t i = 0; i < 1000; ++i) {
+            const archive::TocEntry* entry = pack->find("h/" + std::to_string(i));
+            assert(entry == nullptr || pack->name(*entry) == "h/" + std::to_string(i));
+        }
+    }
+
+    // An impossible level count is refused at open.
+    std::size_t errors = 0;
+    set_error_callback([&errors](const ErrorContext&) { ++errors; });
+    flip_byte(kPackPath, mphf_offset + offsetof(archive::PerfectHashHeader, level_count) + 3);
+    assert(!open_archive(kPackPath));
+    assert(errors == 1);
+    set_error_callback(nullptr);
+
+    std::cout << "[archive_test] test_perfect_hash PASSED\n";
+}
+
+void test_gdeflate_entry() {
+    using namespace ds;
+
+    // A stream with a valid header and block table; the payload is never
+    // decoded here.
+    gdeflate::FileHeader header{};
+    header.magic = gdeflate::GDEFLATE_MAGIC;
+    header.version_major = gdeflate::GDEFLATE_VERSION_MAJOR;
+    header.uncompressed_size = 1 << 16;
+    header.compressed_size = 128;
+    header.block_count = 1;
+    gdeflate::BlockInfo block{};
+    block.compressed_size = 128;
+    block.uncompressed_size = 1 << 16;
+    std::vector<char> stream(sizeof(header) + sizeof(block) + 128, 'g');
+    std::memcpy(stream.data(), &header, sizeof(header));
+    std::memcpy(stream.data() + sizeof(header), &block, sizeof(block));
+    const int fd = ::open(kStreamPath, O_CREAT | O_WRONLY | O_TRUNC, 0644);
+    assert(fd >= 0);
+    const ssize_t wr = ::write(fd, stream.data(), stream.size());
+    assert(wr == static_cast<ssize_t>(stream.size()));
+    ::close(fd);
+
+    ArchiveBuilder builder;
+    ArchiveAsset asset;
+    asset.name = "meshes/rock.gdf";
+    asset.compression = Compression::GDeflate;
+    const bool added = builder.add_file(asset, kStreamPath);
+    assert(added);
+    const bool written = builder.write(kPackPath);
+    assert(written);
+
+    const auto pack = open_archive(kPackPath);
+    assert(pack && pack->verify());
+    const archive::TocEntry* entry = pack->find("meshes/rock.gdf");
+    assert(entry != nullptr);
+    assert(entry->size == stream.size());
+    assert(entry->uncompressed_size == (1u << 16));
+    assert(pack->verify_entry(*entry));
+    Request req;
+    const bool resolved = pack->make_request(*entry, req);
+    assert(resolved);
+    assert(req.compression == Compression::GDeflate);
+    assert(req.size == (1u << 16));
+
+    // Plain files are refused as GDeflate.
+    const std::string text = "not a stream";
+    const int text_fd = ::open(kStreamPath, O_WRONLY | O_TRUNC);
+    const ssize_t text_wr = ::write(text_fd, text.data(), text.size());
+    assert(text_wr == static_cast<ssize_t>(text.size()));
+    ::close(text_fd);
+    set_error_callback([](const ErrorContext&) {});
+    const bool accepted = builder.add_file(asset, kStreamPath);
+    assert(!accepted);
+    set_error_callback(nullptr);
+
+    ::unlink(kStreamPath);
+    std::cout << "[archive_test] test_gdeflate_entry PASSED\n";
+}
+
+void test_damage() {
+    using namespace ds;
+
+    std::size_t errors = 0;
+    set_error_callback([&errors](const ErrorContext& ctx) {
+        assert(ctx.subsystem == "archive");
+        ++errors;
+    });
+
+    ArchiveBuilder duplicate;
+    ArchiveAsset asset;
+    asset.name = "dup";
+    const bool first = duplicate.add(asset, "a", 1);
+    const bool second = duplicate.add(asset, "b", 1);
+    assert(first && second); // Duplicates are caught when the index is built.
+    const bool duplicate_written = duplicate.write(kPackPath);
+    assert(!duplicate_written);
+    assert(errors == 1);
+    asset.name.clear();
+    const bool unnamed = duplicate.add(asset, "c", 1);
+    assert(!unnamed);
+
+    ArchiveBuilder builder;
+    for (std::size_t i = 0; i < 8; ++i) {
+        const std::string bytes = asset_bytes(i);
+        asset.name = asset_name(i);
+        const bool added = builder.add(asset, bytes.data(), bytes.size());
+        assert(added);
+    }
+    const bool written = builder.write(kPackPath);
+    assert(written);
+
+    // Asset data: the index is intact, the entry checksum is not.
+    std::uint64_t entry_offset = 0;
+    {
+        const auto pack = open_archive(kPackPath);
+        assert(pack);
+        entry_offset = pack->find(asset_name(3))->offset;
+    }
+    flip_byte(kPackPath, entry_offset);
+    {
+        const auto pack = open_archive(kPackPath);
+        assert(pack && pack->verify());
+        assert(!pack->verify_entry(*pack->find(asset_name(3))));
+        assert(pack->verify_entry(*pack->find(asset_name(4))));
+    }
+
+    // TOC: the index checksum catches it.
+    flip_byte(kPackPath, sizeof(archive::Header) + 8);
+    {
+        const auto pack = open_archive(kPackPath);
+        assert(pack);
+        assert(!pack->verify());
+    }
+
+    // Header: rejected at open.
+    const std::size_t before = errors;
+    flip_byte(kPackPath, offsetof(archive::Header, data_offset) + 7);
+    assert(!open_archive(kPackPath));
+    flip_byte(kPackPath, 0);
+    assert(!open_archive(kPackPath));
+    assert(!open_archive("archive_test_missing.dspk"));
+    assert(errors == before + 3);
+
+    set_error_callback(nullptr);
+    std::cout << "[archive_test] test_damage PASSED\n";
+}
+
+} // namespace
+
+int main() {
+    test_crc32c();
+    test_round_trip();
+    test_many_entries();
+    test_perfect_hash();
+    test_gdeflate_entry();
+    test_damage();
+
+    ::unlink(kPackPath);
+    std::cout << "[archive_test] ALL TESTS PASSED\n";
+    return 0;
+}
@@ -0,0 +1,352 @@
+// SPDX-License-Identifier: Apache-2.0
+// Decoded-asset cache test.
+//
+// This test verifies:
+//  - Repeated host and Runtime reads hit the cache, skip the wrapped
+//    backend, return the decoded bytes and (for Runtime reads) share the
+//    cached memory; compression is part of the key
+//  - Concurrent identical misses run a single backend operation and every
+//    waiter completes with the result
+//  - Segmented LRU keeps entries hit twice while a one-pass scan streams
+//    through probation, and stays within its budget
+//  - Failed reads are not cached; writes, invalidate() and clear() drop
+//    entries; oversized reads bypass the cache
+//  - The cache works behind a Queue and reports its counters in stats()
+
+#include "ds_runtime.hpp"
+#include "ds_runtime_buffer.hpp"
+#include "ds_runtime_cache.hpp"
+
+#include <atomic>
+#include <cassert>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace {
+
+const char* kFilename = "asset_cache_test.bin";
+constexpr std::size_t kChunk = 4096;
+constexpr std::size_t kChunks = 16;
+
+/// Inline backend that counts reads and can hold them until released, so
+/// a test can line up concurrent misses. Does not provide buffers.
+class GateBackend final : public ds::Backend {
+public:
+    void submit(ds::Request req, ds::CompletionCallback on_complete) override {
+        submitted.fetch_add(1);
+        {
+            std::lock_guard<std::mutex> lock(mtx_);
+            if (closed_) {
+                held_.emplace_back(std::move(req), std::move(on_complete));
+                return;
+            }
+        }
+        run(req, on_complete);
+    }
+
+    void close() {
+        std::lock_guard<std::mutex> lock(mtx_);
+        closed_ = true;
+    }
+
+    void open() {
+        std::vector<std::pair<ds::Request, ds::CompletionCallback>> held;
+        {
+            std::lock_guard<std::mutex> lock(mtx_);
+            closed_ = false;
+            held.swap(held_);
+        }
+        for (auto& [req, cb] : held) {
+            run(req, cb);
+        }
+    }
+
+    std::atomic<std::size_t> submitted{0};
+
+private:
+    static void run(ds::Request& req, const ds::CompletionCallback& on_complete) {
+        ssize_t n = -1;
+        if (req.op == ds::RequestOp::Write) {
+            n = ::pwrite(req.fd, req.src, req.size, static_cast<off_t>(req.offset));
+        } else {
+            n = ::pread(req.fd, req.dst, req.size, static_cast<off_t>(req.offset));
+            if (n > 0 && req.compression == ds::Compression::FakeUppercase) {
+                char* p = static_cast<char*>(req.dst);
+                for (ssize_t i = 0; i < n; ++i) {
+                    if (p[i] >= 'a' && p[i] <= 'z') {
+                        p[i] = static_cast<char>(p[i] - 'a' + 'A');
+                    }
+                }
+            }
+        }
+        req.status = n < 0 ? ds::RequestStatus::IoError : ds::RequestStatus::Ok;
+        req.errno_value = n < 0 ? errno : 0;
+        req.bytes_transferred = n < 0 ? 0 : static_cast<std::size_t>(n);
+        if (on_complete) {
+            on_complete(req);
+        }
+    }
+
+    std::mutex mtx_;
+    bool closed_ = false;
+    std::vector<std::pair<ds::Request, ds::CompletionCallback>> held_;
+};
+
+int create_file() {
+    std::vector<char> contents(kChunk * kChunks);
+    for (std::size_t i = 0; i < kChunks; ++i) {
+        std::memset(contents.data() + i * kChunk, 'a' + static_cast<int>(i), kChunk);
+    }
+    const int fd = ::open(kFilename, O_CREAT | O_RDWR | O_TRUNC, 0644);
+    assert(fd >= 0);
+    const ssize_t wr = ::write(fd, contents.data(), contents.size());
+    assert(wr == static_cast<ssize_t>(contents.size()));
+    return fd;
+}
+
+ds::Request make_read(int fd, std::size_t chunk, void* dst,
+                      ds::Compression compression = ds::Compression::None) {
+    ds::Request req;
+    req.fd = fd;
+    req.offset = chunk * kChunk;
+    req.size = kChunk;
+    req.dst = dst;
+    req.dst_memory = dst ? ds::RequestMemory::Host : ds::RequestMemory::Runtime;
+    req.compression = compression;
+    return req;
+}
+
+/// Submit @p req and return the completed copy (the gate backend and hits
+/// complete inline).
+ds::Request read_sync(ds::Backend& backend, ds::Request req) {
+    ds::Request out;
+    bool done = false;
+    backend.submit(req, [&](ds::Request& r) {
+        out = r;
+        done = true;
+    });
+    assert(done);
+    return out;
+}
+
+void test_hits(int fd) {
+    using namespace ds;
+
+    auto gate = std::make_shared<GateBackend>();
+    auto cache = make_caching_backend(gate);
+    assert(cache->provides_buffers());
+
+    std::vector<char> a(kChunk), b(kChunk);
+    Request r = read_sync(*cache, make_read(fd, 3, a.data()));
+    assert(r.status == RequestStatus::Ok && r.bytes_transferred == kChunk);
+    assert(a[0] == 'd' && a[kChunk - 1] == 'd');
+    r = read_sync(*cache, make_read(fd, 3, b.data()));
+    assert(r.status == RequestStatus::Ok && r.bytes_transferred == kChunk);
+    assert(std::memcmp(a.data(), b.data(), kChunk) == 0);
+    assert(gate->submitted == 1);
+
+    // Runtime reads share the cached block.
+    Request v1 = read_sync(*cache, make_read(fd, 3, nullptr));
+    Request v2 = read_sync(*cache, make_read(fd, 3, nullptr));
+    assert(v1.buffer && v1.buffer.size() == kChunk);
+    assert(v1.buffer.data() == v2.buffer.data());
+    assert(static_cast<char>(v1.buffer.data()[0]) == 'd');
+    assert(gate->submitted == 1);
+
+    // Compression is part of the key.
+    Request upper = read_sync(*cache, make_read(fd, 3, nullptr, Compression::FakeUppercase));
+    assert(static_cast<char>(upper.buffer.data()[0]) == 'D');
+    assert(gate->submitted == 2);
+
+    const CacheStats stats = cache->cache_stats();
+    assert(stats.hits == 3);
+    assert(stats.misses == 2);
+    assert(stats.insertions == 2);
+    assert(stats.entries == 2);
+    assert(stats.bytes >= 2 * kChunk);
+    assert(stats.promotions == 1);
+
+    std::cout << "[asset_cache_test] test_hits PASSED\n";
+}
+
+void test_single_flight(int fd) {
+    using namespace ds;
+
+    auto gate = std::make_shared<GateBackend>();
+    auto cache = make_caching_backend(gate);
+    gate->close();
+
+    constexpr std::size_t kWaiters = 8;
+    std::vector<std::vector<char>> buffers(kWaiters, std::vector<char>(kChunk));
+    std::atomic<std::size_t> done{0};
+    std::vector<std::thread> threads;
+    for (std::size_t i = 0; i < kWaiters; ++i) {
+        threads.emplace_back([&, i] {
+            // Half the waiters want host copies, half want views.
+            Request req = make_read(fd, 5, i % 2 ? buffers[i].data() : nullptr);
+            cache->submit(req, [&, i](Request& r) {
+                assert(r.status == RequestStatus::Ok);
+                assert(r.bytes_transferred == kChunk);
+                const char first = i % 2 ? buffers[i][0] : static_cast<char>(r.buffer.data()[0]);
+                assert(first == 'f');
+                done.fetch_add(1);
+            });
+        });
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+    assert(done == 0);
+    assert(gate->submitted == 1);
+    gate->open();
+    assert(done == kWaiters);
+
+    const CacheStats stats = cache->cache_stats();
+    assert(stats.misses == 1);
+    assert(stats.coalesced == kWaiters - 1);
+    assert(stats.entries == 1);
+
+    std::cout << "[asset_cache_test] test_single_flight PASSED\n";
+}
+
+void test_eviction(int fd) {
+    using namespace ds;
+
+    auto gate = std::make_shared<GateBackend>();
+    CacheConfig config;
+    config.shard_count = 1;
+    config.capacity_bytes = 4 * (kChunk + 256); // Four entries.
+    config.protected_percent = 50;              // Two protected.
+    auto cache = make_caching_backend(gate, config);
+
+    std::vector<char> dst(kChunk);
+    // Chunk 0 is hot: read twice, so it is protected.
+    read_sync(*cache, make_read(fd, 0, dst.data()));
+    read_sync(*cache, make_read(fd, 0, dst.data()));
+    // A one-pass scan over the rest cycles through probation only.
+    for (std::size_t chunk = 1; chunk < kChunks; ++chunk) {
+        read_sync(*cache, make_read(fd, chunk, dst.data()));
+    }
+    const std::size_t before = gate->submitted;
+    read_sync(*cache, make_read(fd, 0, dst.data()));
+    assert(gate->submitted == before); // Survived the scan.
+    assert(dst[0] == 'a');
+
+    const CacheStats stats = cache->cache_stats();
+    assert(stats.entries <= 4);
+    assert(stats.bytes <= config.capacity_bytes);
+    assert(stats.evictions == kChunks - 4);
+    assert(stats.protected_bytes > 0);
+
+    std::cout << "[asset_cache_test] test_eviction PASSED\n";
+}
+
+void test_invalidation(int fd) {
+    using namespace ds;
+
+    auto gate = std::make_shared<GateBackend>();
+    CacheConfig config;
+    config.max_entry_bytes = kChunk;
+    auto cache = make_caching_backend(gate, config);
+
+    // Failures are not cached.
+    std::vector<char> dst(2 * kChunk);
+    Request bad = read_sync(*cache, make_read(-1, 0, dst.data()));
+    assert(bad.status == RequestStatus::IoError);
+    bad = read_sync(*cache, make_read(-1, 0, dst.data()));
+    assert(bad.status == RequestStatus::IoError);
+    assert(cache->cache_stats().entries == 0);
+
+    // Oversized reads bypass it, including Runtime reads, which still get
+    // a buffer.
+    Request big = make_read(fd, 0, nullptr);
+    big.size = 2 * kChunk;
+    Request out = read_sync(*cache, big);
+    assert(out.status == RequestStatus::Ok && out.buffer.size() == 2 * kChunk);
+    assert(cache->cache_stats().bypassed >= 3); // Bad fd twice, oversized once.
+    assert(cache->cache_stats().entries == 0);
+
+    // A write through the cache drops the file's entries.
+    read_sync(*cache, make_read(fd, 7, dst.data()));
+    assert(cache->cache_stats().entries == 1);
+    const char patch[] = "hhhh";
+    Request write;
+    write.fd = fd;
+    write.op = RequestOp::Write;
+    write.offset = 7 * kChunk;
+    write.size = sizeof(patch) - 1;
+    write.src = patch;
+    assert(read_sync(*cache, write).status == RequestStatus::Ok);
+    assert(cache->cache_stats().entries == 0);
+
+    // invalidate() and clear().
+    read_sync(*cache, make_read(fd, 8, dst.data()));
+    read_sync(*cache, make_read(fd, 9, dst.data()));
+    cache->invalidate(fd);
+    assert(cache->cache_stats().entries == 0);
+    read_sync(*cache, make_read(fd, 8, dst.data()));
+    cache->clear();
+    const CacheStats stats = cache->cache_stats();
+    assert(stats.entries == 0 && stats.bytes == 0);
+    assert(stats.invalidations == 4);
+
+    std::cout << "[asset_cache_test] test_invalidation PASSED\n";
+}
+
+void test_queue(int fd) {
+    using namespace ds;
+
+    auto cache = make_caching_backend(make_cpu_backend(2));
+    Queue queue(cache);
+    std::vector<char> dst(kChunk);
+    for (int round = 0; round < 3; ++round) {
+        for (std::size_t chunk = 10; chunk < 14; ++chunk) {
+            queue.enqueue(make_read(fd, chunk, nullptr));
+        }
+        queue.enqueue(make_read(fd, 10, dst.data()));
+        queue.submit_all();
+        queue.wait_all();
+        for (const Request& r : queue.take_completed()) {
+            assert(r.status == RequestStatus::Ok);
+            assert(r.bytes_transferred == kChunk);
+            const char expect = static_cast<char>('a' + r.offset / kChunk);
+            if (r.dst_memory == RequestMemory::Runtime) {
+                assert(static_cast<char>(r.buffer.data()[0]) == expect);
+            }
+        }
+        assert(dst[0] == 'k');
+    }
+
+    const BackendStats stats = cache->stats();
+    assert(stats.backend == "cpu");
+    assert(stats.submitted <= 5); // Only first-round misses reach the CPU backend.
+    assert(stats.counter("cache_hits") + stats.counter("cache_coalesced") >= 10);
+
+    std::cout << "[asset_cache_test] test_queue PASSED\n";
+}
+
+} // namespace
+
+int main() {
+    const int fd = create_file();
+
+    test_hits(fd);
+    test_single_flight(fd);
+    test_eviction(fd);
+    test_invalidation(fd);
+    test_queue(fd);
+
+    ::close(fd);
+    ::unlink(kFilename);
+    std::cout << "[asset_cache_test] ALL TESTS PASSED\n";
+    return 0;
+}
@@ -0,0 +1,339 @@
+// SPDX-License-Identifier: Apache-2.0
+// Buffer view test.
+//
+// This test verifies:
+//  - BufferPool rounds to size classes, carves small blocks from slabs,
+//    reuses released blocks, respects its cache budget, trims free slabs
+//    and outlives its own destruction while views exist
+//  - Huge-page slabs are 2 MiB aligned and node hints are accepted
+//  - BufferView copies share memory and subview() clamps to the view
+//  - RequestMemory::Runtime reads on the CPU backend land in pool memory
+//    allocated by the worker, are trimmed to bytes_transferred and return
+//    to the pool on release
+//  - For backends that do not provide buffers, the Queue allocates them,
+//    including in Records completion mode
+//  - The mmap backend serves Runtime reads as zero-copy views of the
+//    mapping and only uses the pool for decoded reads
+
+#include "ds_runtime.hpp"
+#include "ds_runtime_buffer.hpp"
+#include "ds_runtime_mmap.hpp"
+#include "file_test_util.hpp"
+
+#include <cassert>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace {
+
+using namespace file_test;
+
+const char* kFilename = "buffer_view_test.bin";
+constexpr std::size_t kFileSize = 32 * 1024;
+
+bool same_bytes(const ds::BufferView& view, const char* expected, std::size_t size) {
+    return view.size() == size && std::memcmp(view.data(), expected, size) == 0;
+}
+
+void test_pool() {
+    using namespace ds;
+
+    BufferPoolConfig config;
+    config.min_block_bytes = 4096;
+    config.max_pooled_bytes = 64 * 1024;
+    config.max_cached_bytes = 32 * 1024;
+    config.slab_bytes = 16 * 1024; // 4K and 8K blocks are carved from slabs.
+    auto pool = std::make_shared<BufferPool>(config);
+
+    PoolBuffer block = pool->allocate(5000);
+    assert(block);
+    assert(block.capacity() == 8192);
+    assert(reinterpret_cast<std::uintptr_t>(block.data()) % 4096 == 0);
+    BufferPoolStats stats = pool->stats();
+    assert(stats.slabs == 1);
+    assert(stats.cached_bytes == 8192); // The slab's other block.
+    assert(stats.numa_nodes >= 1);
+    std::memset(block.data(), 'x', 5000);
+    void* const first_address = block.data();
+
+    BufferView view = block.share(5000);
+    assert(!block);
+    assert(view.size() == 5000);
+    assert(view.use_count() == 1);
+
+    BufferView copy = view;
+    assert(copy.data() == view.data());
+    assert(view.use_count() == 2);
+
+    BufferView tail = view.subview(4990, 100);
+    assert(tail.size() == 10);
+    assert(tail.data() == view.data() + 4990);
+    assert(view.subview(6000).empty());
+
+    view.reset();
+    copy.reset();
+    assert(pool->stats().outstanding == 1); // tail still holds the block.
+    tail.reset();
+    stats = pool->stats();
+    assert(stats.outstanding == 0);
+    assert(stats.cached_bytes == 16384);
+
+    // Same class: the last released block comes back first, and the
+    // slab's second block is used before a new slab is mapped.
+    PoolBuffer again = pool->allocate(6000);
+    assert(again.data() == first_address);
+    PoolBuffer other = pool->allocate(8192, /*node=*/0);
+    assert(other && other.data() != first_address);
+    stats = pool->stats();
+    assert(stats.reused == 2);
+    assert(stats.slabs == 1);
+
+    // trim() unmaps a slab only once all of its blocks are free.
+    again = PoolBuffer();
+    pool->trim();
+    assert(pool->stats().slabs == 1);
+    other = PoolBuffer();
+    pool->trim();
+    stats = pool->stats();
+    assert(stats.slabs == 0);
+    assert(stats.mapped_bytes == 0);
+    assert(stats.cached_bytes == 0);
+
+    // Blocks of slab size or more own their mapping; the cache budget
+    // keeps one 32 KiB block and unmaps the second.
+    PoolBuffer large_a = pool->allocate(20000);
+    PoolBuffer large_b = pool->allocate(20000, /*node=*/99); // Unknown node: clamped.
+    assert(large_a.capacity() == 32 * 1024 && large_b.capacity() == 32 * 1024);
+    large_a = PoolBuffer();
+    large_b = PoolBuffer();
+    stats = pool->stats();
+    assert(stats.cached_bytes == 32 * 1024);
+    assert(stats.mapped_bytes == 32 * 1024);
+    assert(stats.outstanding == 0);
+
+    // Oversized blocks are never cached.
+    PoolBuffer big = pool->allocate(128 * 1024);
+    assert(big.capacity() >= 128 * 1024);
+    big = PoolBuffer();
+    stats = pool->stats();
+    assert(stats.oversized == 1);
+    assert(stats.cached_bytes == 32 * 1024);
+
+    // Views outlive the pool.
+    PoolBuffer survivor = pool->allocate(100);
+    std::memcpy(survivor.data(), "still here", 11);
+    const BufferView kept = survivor.share(11);
+    pool.reset();
+    assert(std::string(reinterpret_cast<const char*>(kept.data())) == "still here");
+
+    std::cout << "[buffer_view_test] test_pool PASSED\n";
+}
+
+void test_huge_page_slabs() {
+    using namespace ds;
+
+    BufferPoolConfig config;
+    config.huge_pages = true;
+    config.lock_memory = true; // May exceed RLIMIT_MEMLOCK; counted, not fatal.
+    BufferPool pool(config);
+
+    PoolBuffer first = pool.allocate(4096);
+    assert(first);
+    assert(reinterpret_cast<std::uintptr_t>(first.data()) % (2u << 20) == 0);
+    std::memset(first.data(), 0xab, first.capacity());
+
+    const BufferPoolStats stats = pool.stats();
+    assert(stats.slabs == 1);
+    assert(stats.mapped_bytes == (2u << 20));
+    assert(stats.huge_page_regions <= 1); // Zero where THP is unavailable.
+    assert(stats.lock_failures <= 1);
+
+    std::cout << "[buffer_view_test] test_huge_page_slabs PASSED\n";
+}
+
+/// Minimal inline backend that reads into Request::dst and leaves buffer
+/// allocation to the Queue.
+class PreadBackend final : public ds::Backend {
+public:
+    void submit(ds::Request req, ds::CompletionCallback on_complete) override {
+        assert(req.dst != nullptr);
+        const ssize_t n = ::pread(req.fd, req.dst, req.size, static_cast<off_t>(req.offset));
+        req.status = n < 0 ? ds::RequestStatus::IoError : ds::RequestStatus::Ok;
+        req.errno_value = n < 0 ? errno : 0;
+        req.bytes_transferred = n < 0 ? 0 : static_cast<std::size_t>(n);
+        on_complete(req);
+    }
+};
+
+void test_cpu_runtime_reads() {
+    using namespace ds;
+
+    const std::vector<char> contents = make_contents(kFileSize);
+    const int fd = create_file(kFilename, contents);
+    set_error_callback([](const ErrorContext&) {});
+
+    auto pool = std::make_shared<BufferPool>();
+    CpuBackendConfig config;
+    config.worker_count = 2;
+    config.buffer_pool = pool;
+    Queue queue(make_cpu_backend(config));
+
+    queue.enqueue(make_runtime_read(fd, 100, 3000));
+    Request short_read = make_runtime_read(fd, kFileSize - 10, 64);
+    short_read.user_tag = 1;
+    queue.enqueue(short_read);
+    Request upper = make_runtime_read(fd, 0, 26);
+    upper.compression = Compression::FakeUppercase;
+    upper.user_tag = 2;
+    queue.enqueue(upper);
+    Request bad = make_runtime_read(-1, 0, 64);
+    bad.user_tag = 3;
+    queue.enqueue(bad);
+    queue.submit_all();
+    queue.wait_all();
+
+    std::vector<Request> done = queue.take_completed();
+    assert(done.size() == 4);
+    for (const auto& req : done) {
+        assert(req.dst == nullptr);
+        switch (req.user_tag) {
+        case 0:
+            assert(req.status == RequestStatus::Ok);
+            assert(same_bytes(req.buffer, contents.data() + 100, 3000));
+            break;
+        case 1:
+            assert(req.bytes_transferred == 10);
+            assert(same_bytes(req.buffer, contents.data() + kFileSize - 10, 10));
+            break;
+        case 2:
+            assert(same_bytes(req.buffer, "ABCDEFGHIJKLMNOPQRSTUVWXYZ", 26));
+            break;
+        default:
+            assert(req.status == RequestStatus::IoError);
+            assert(!req.buffer);
+            break;
+        }
+    }
+    assert(pool->stats().outstanding == 3);
+    done.clear();
+    assert(pool->stats().outstanding == 0);
+
+    set_error_callback(nullptr);
+    ::close(fd);
+    ::unlink(kFilename);
+
+    std::cout << "[buffer_view_test] test_cpu_runtime_reads PASSED\n";
+}
+
+void test_queue_allocated_buffers() {
+    using namespace ds;
+
+    const std::vector<char> contents = make_contents(kFileSize);
+    const int fd = create_file(kFilename, contents);
+
+    // Records mode carries the view in the record.
+    auto pool = std::make_shared<BufferPool>();
+    QueueConfig records_config;
+    records_config.buffer_pool = pool;
+    records_config.completion_mode = CompletionMode::Records;
+    Queue records_queue(std::make_shared<PreadBackend>(), records_config);
+    for (std::uint64_t i = 0; i < 8; ++i) {
+        Request req = make_runtime_read(fd, i * 1024, 1024);
+        req.user_tag = i;
+        records_queue.enqueue(req);
+    }
+    records_queue.submit_all();
+    records_queue.wait_all();
+
+    std::vector<CompletionRecord> records(8);
+    assert(records_queue.poll_completions(records.data(), records.size()) == 8);
+    for (const auto& record : records) {
+        assert(record.status == RequestStatus::Ok);
+        assert(same_bytes(record.buffer, contents.data() + record.user_tag * 1024, 1024));
+    }
+    const BufferPoolStats stats = pool->stats();
+    assert(stats.allocations == 8);
+    assert(stats.outstanding == 8);
+    records.clear();
+    assert(pool->stats().outstanding == 0);
+
+    ::close(fd);
+    ::unlink(kFilename);
+
+    std::cout << "[buffer_view_test] test_queue_allocated_buffers PASSED\n";
+}
+
+void test_mmap_zero_copy() {
+    using namespace ds;
+
+    const std::vector<char> contents = make_contents(kFileSize);
+    const int fd = create_file(kFilename, contents);
+
+    auto pool = std::make_shared<BufferPool>();
+    QueueConfig queue_config;
+    queue_config.buffer_pool = pool;
+    MmapBackendConfig config;
+    config.buffer_pool = pool;
+    auto backend = make_mmap_backend(config);
+    Queue queue(backend, queue_config);
+
+    queue.enqueue(make_runtime_read(fd, 4096, 8192));
+    Request past_eof = make_runtime_read(fd, kFileSize + 1, 16);
+    past_eof.user_tag = 1;
+    queue.enqueue(past_eof);
+    Request upper = make_runtime_read(fd, 26, 26);
+    upper.compression = Compression::FakeUppercase;
+    upper.user_tag = 2;
+    queue.enqueue(upper);
+    queue.submit_all();
+    queue.wait_all();
+
+    BufferView mapped, decoded;
+    for (auto& req : queue.take_completed()) {
+        assert(req.status == RequestStatus::Ok);
+        if (req.user_tag == 0) {
+            mapped = std::move(req.buffer);
+        } else if (req.user_tag == 1) {
+            assert(req.bytes_transferred == 0);
+            assert(req.buffer.empty());
+        } else {
+            decoded = std::move(req.buffer);
+        }
+    }
+    assert(same_bytes(mapped, contents.data() + 4096, 8192));
+    assert(same_bytes(decoded, "ABCDEFGHIJKLMNOPQRSTUVWXYZ", 26));
+
+    // Only the decoded read touched the pool.
+    assert(pool->stats().allocations == 1);
+    assert(backend->stats().counter("zero_copy_views") == 1);
+
+    // The view keeps its mapping alive after the backend lets go of it.
+    backend->release_file(fd);
+    assert(backend->stats().counter("mapped_files") == 0);
+    assert(same_bytes(mapped, contents.data() + 4096, 8192));
+
+    ::close(fd);
+    ::unlink(kFilename);
+
+    std::cout << "[buffer_view_test] test_mmap_zero_copy PASSED\n";
+}
+
+} // namespace
+
+int main() {
+    test_pool();
+    test_huge_page_slabs();
+    test_cpu_runtime_reads();
+    test_queue_allocated_buffers();
+    test_mmap_zero_copy();
+
+    std::cout << "[buffer_view_test] ALL TESTS PASSED\n";
+    return 0;
+}
@@ -5,10 +5,13 @@
 //  - ds_queue_total_completed
 //  - ds_queue_total_failed
 //  - ds_queue_total_bytes_transferred
+//  - ds_queue_get_stats, including the versioned struct_size handshake
 
 #include "ds_runtime_c.h"
 
 #include <assert.h>
+#include <errno.h>
+#include <stddef.h>
 #include <string.h>
 
 #include <fcntl.h>
@@ -55,6 +58,47 @@ int main(void) {
 
     assert(strcmp(buffer, payload) == 0);
 
+    ds_queue_stats stats;
+    memset(&stats, 0, sizeof(stats));
+    stats.struct_size = sizeof(stats);
+    assert(ds_queue_get_stats(queue, &stats) == 0);
+    assert(stats.version == DS_QUEUE_STATS_VERSION);
+    assert(stats.struct_size == sizeof(stats));
+    assert(stats.pending == 0);
+    assert(stats.in_flight == 0);
+    assert(stats.in_flight_bytes == 0);
+    assert(stats.total_submitted == 1);
+    assert(stats.total_completed == 1);
+    assert(stats.total_failed == 0);
+    assert(stats.total_bytes_transferred == strlen(payload));
+    assert(stats.latency_p50_ns <= stats.latency_p99_ns);
+    assert(stats.latency_p99_ns <= stats.latency_max_ns);
+    assert(stats.latency_max_ns > 0);
+
+    /* An older caller that only knows the first few fields. */
+    const size_t old_size = offsetof(ds_queue_stats, in_flight);
+    ds_queue_stats old_stats;
+    memset(&old_stats, 0xAB, sizeof(old_stats));
+    old_stats.struct_size = (uint32_t)old_size;
+    assert(ds_queue_get_stats(queue, &old_stats) == 0);
+    assert(old_stats.struct_size == old_size);
+    assert(old_stats.pending == 0);
+    assert(old_stats.in_flight == 0xABABABABABABABABull); /* Untouched. */
+
+    stats.struct_size = 4;
+    assert(ds_queue_get_stats(queue, &stats) == EINVAL);
+    assert(ds_queue_get_stats(NULL, &stats) == EINVAL);
+
+    /* A failed request is counted. */
+    ds_request bad = req;
+    bad.fd = -1;
+    ds_queue_enqueue(queue, &bad);
+    ds_queue_submit_all(queue, NULL, NULL);
+    ds_queue_wait_all(queue);
+    assert(bad.status == DS_REQUEST_IO_ERROR);
+    assert(ds_queue_total_completed(queue) == 2);
+    assert(ds_queue_total_failed(queue) == 1);
+
     ds_queue_release(queue);
     ds_backend_release(backend);
     close(fd_read);
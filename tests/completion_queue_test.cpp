@@ -0,0 +1,124 @@
+// SPDX-License-Identifier: Apache-2.0
+// Completion-queue (CompletionMode::Records) test.
+//
+// This test verifies:
+//  - Completion records carry the caller's user_tag and the request result
+//  - poll_completions() is non-blocking and drains records in batches
+//  - wait_completions() blocks for a minimum batch and returns early when
+//    the queue runs dry
+//  - Failed requests surface as records with IoError status
+//  - take_completed() stays empty in Records mode
+
+#include "ds_runtime.hpp"
+
+#include <cassert>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <set>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace {
+
+void test_records_carry_tags() {
+    using namespace ds;
+
+    const char* filename = "completion_queue_test.bin";
+    const char* payload = "0123456789abcdefghijklmnopqrstuv";
+    const std::size_t payload_len = std::strlen(payload);
+
+    const int fd_write = ::open(filename, O_CREAT | O_WRONLY | O_TRUNC, 0644);
+    assert(fd_write >= 0);
+    const ssize_t wr = ::write(fd_write, payload, payload_len);
+    assert(wr == static_cast<ssize_t>(payload_len));
+    ::close(fd_write);
+
+    const int fd_read = ::open(filename, O_RDONLY);
+    assert(fd_read >= 0);
+
+    QueueConfig config;
+    config.completion_mode = CompletionMode::Records;
+    config.completion_capacity = 4; // Force record overflow.
+    Queue queue(make_cpu_backend(2), config);
+
+    constexpr std::size_t kRequests = 16;
+    std::vector<char> buffer(payload_len, '\0');
+    for (std::size_t i = 0; i < kRequests; ++i) {
+        Request req;
+        req.fd = fd_read;
+        req.offset = i * 2;
+        req.size = 2;
+        req.dst = buffer.data() + i * 2;
+        req.user_tag = 1000 + i;
+        queue.enqueue(req);
+    }
+    queue.submit_all();
+
+    std::set<std::uint64_t> seen;
+    CompletionRecord records[8];
+    while (seen.size() < kRequests) {
+        const std::size_t n = queue.wait_completions(records, 8, 1);
+        assert(n > 0);
+        for (std::size_t i = 0; i < n; ++i) {
+            assert(records[i].status == RequestStatus::Ok);
+            assert(records[i].bytes_transferred == 2);
+            assert(seen.insert(records[i].user_tag).second);
+        }
+    }
+    assert(*seen.begin() == 1000);
+    assert(*seen.rbegin() == 1000 + kRequests - 1);
+    assert(std::memcmp(buffer.data(), payload, payload_len) == 0);
+
+    // Nothing left: polling returns immediately, waiting returns early.
+    assert(queue.poll_completions(records, 8) == 0);
+    assert(queue.wait_completions(records, 8, 4) == 0);
+    assert(queue.take_completed().empty());
+
+    ::close(fd_read);
+    ::unlink(filename);
+
+    std::cout << "[completion_queue_test] test_records_carry_tags PASSED\n";
+}
+
+void test_failed_request_record() {
+    using namespace ds;
+
+    set_error_callback([](const ErrorContext&) {});
+
+    QueueConfig config;
+    config.completion_mode = CompletionMode::Records;
+    Queue queue(make_cpu_backend(1), config);
+
+    char buffer[8] = {};
+    Request req;
+    req.fd = -1;
+    req.size = sizeof(buffer);
+    req.dst = buffer;
+    req.user_tag = 42;
+    queue.enqueue(req);
+    queue.submit_all();
+    queue.wait_all();
+
+    CompletionRecord record;
+    assert(queue.poll_completions(&record, 1) == 1);
+    assert(record.user_tag == 42);
+    assert(record.status == RequestStatus::IoError);
+    assert(record.errno_value == EBADF);
+
+    set_error_callback(nullptr);
+
+    std::cout << "[completion_queue_test] test_failed_request_record PASSED\n";
+}
+
+} // namespace
+
+int main() {
+    test_records_carry_tags();
+    test_failed_request_record();
+
+    std::cout << "[completion_queue_test] ALL TESTS PASSED\n";
+    return 0;
+}
@@ -0,0 +1,157 @@
+// SPDX-License-Identifier: Apache-2.0
+// Coroutine awaitable test.
+//
+// This test verifies:
+//  - co_await read() resumes with the completed Request, so header-then-body
+//    streaming can be written sequentially
+//  - A batch await resumes once, after every request, with per-request
+//    results written back and user tags preserved
+//  - ManualExecutor resumes coroutines only on the thread that drains it
+//  - Awaited requests do not show up in take_completed()
+
+#include "ds_runtime_coro.hpp"
+#include "header_body_test_util.hpp"
+
+#include <atomic>
+#include <cassert>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace {
+
+using header_body_test::write_header_body_file;
+
+// Minimal eager, fire-and-forget coroutine type for the tests.
+struct Task {
+    struct promise_type {
+        Task get_return_object() noexcept { return {}; }
+        std::suspend_never initial_suspend() noexcept { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; }
+        void return_void() noexcept {}
+        void unhandled_exception() { std::terminate(); }
+    };
+};
+
+const char* kFilename = "coroutine_test.bin";
+
+Task load_asset(ds::Queue& queue, int fd, std::string& out,
+                std::atomic<bool>& done) {
+    std::uint64_t header[2] = {0, 0};
+    const ds::Request h = co_await ds::coro::read(
+        queue, fd, 0, std::as_writable_bytes(std::span(header)));
+    assert(h.status == ds::RequestStatus::Ok);
+    assert(h.bytes_transferred == sizeof(header));
+
+    std::vector<std::byte> body(static_cast<std::size_t>(header[1]));
+    const ds::Request b = co_await ds::coro::read(queue, fd, header[0], body);
+    assert(b.status == ds::RequestStatus::Ok);
+
+    out.assign(reinterpret_cast<const char*>(body.data()), body.size());
+    done.store(true);
+}
+
+void test_sequential_reads() {
+    using namespace ds;
+
+    const std::string body = "streamed-body-after-header";
+    const int fd = write_header_body_file(kFilename, body, 4096);
+
+    Queue queue(make_cpu_backend(2));
+
+    std::string loaded;
+    std::atomic<bool> done{false};
+    load_asset(queue, fd, loaded, done);
+
+    queue.wait_all();
+    assert(done.load());
+    assert(loaded == body);
+    assert(queue.take_completed().empty());
+
+    ::close(fd);
+    ::unlink(kFilename);
+
+    std::cout << "[coroutine_test] test_sequential_reads PASSED\n";
+}
+
+Task load_batch(ds::Queue& queue, std::span<ds::Request> requests,
+                ds::coro::Executor& executor, std::size_t& failed,
+                std::thread::id& resumed_on, std::atomic<bool>& done) {
+    failed = co_await ds::coro::submit_all(queue, requests, executor);
+    resumed_on = std::this_thread::get_id();
+    done.store(true);
+}
+
+void test_batch_on_manual_executor() {
+    using namespace ds;
+
+    set_error_callback([](const ErrorContext&) {});
+
+    const int fd = write_header_body_file(kFilename, "0123456789abcdef", 64);
+    Queue queue(make_cpu_backend(4));
+    coro::ManualExecutor executor;
+
+    constexpr std::size_t kChunks = 8;
+    char buffer[kChunks * 2] = {};
+    std::vector<Request> requests(kChunks + 1);
+    for (std::size_t i = 0; i < kChunks; ++i) {
+        requests[i].fd = fd;
+        requests[i].offset = 64 + i * 2;
+        requests[i].size = 2;
+        requests[i].dst = buffer + i * 2;
+        requests[i].user_tag = 500 + i;
+    }
+    char sink[4] = {};
+    requests[kChunks].fd = -1; // One failing request in the batch.
+    requests[kChunks].size = sizeof(sink);
+    requests[kChunks].dst = sink;
+    requests[kChunks].user_tag = 999;
+
+    std::size_t failed = 0;
+    std::thread::id resumed_on;
+    std::atomic<bool> done{false};
+    load_batch(queue, requests, executor, failed, resumed_on, done);
+
+    // Completions only post to the executor; nothing resumes until drained.
+    queue.wait_all();
+    assert(!done.load());
+    assert(executor.pending() == 1);
+    assert(executor.run_pending() == 1);
+    assert(done.load());
+    assert(resumed_on == std::this_thread::get_id());
+
+    assert(failed == 1);
+    assert(std::memcmp(buffer, "0123456789abcdef", sizeof(buffer)) == 0);
+    for (std::size_t i = 0; i < kChunks; ++i) {
+        assert(requests[i].status == RequestStatus::Ok);
+        assert(requests[i].bytes_transferred == 2);
+        assert(requests[i].user_tag == 500 + i);
+    }
+    assert(requests[kChunks].status == RequestStatus::IoError);
+    assert(requests[kChunks].errno_value == EBADF);
+    assert(requests[kChunks].user_tag == 999);
+
+    ::close(fd);
+    ::unlink(kFilename);
+    set_error_callback(nullptr);
+
+    std::cout << "[coroutine_test] test_batch_on_manual_executor PASSED\n";
+}
+
+} // namespace
+
+int main() {
+    test_sequential_reads();
+    test_batch_on_manual_executor();
+
+    std::cout << "[coroutine_test] ALL TESTS PASSED\n";
+    return 0;
+}
@@ -0,0 +1,353 @@
+// SPDX-License-Identifier: Apache-2.0
+// Request dependency graph test.
+//
+// This test verifies:
+//  - A continuation can read a header and enqueue the body read, and
+//    wait_all() covers the whole chain
+//  - A continuation on a header that already landed runs inline and its
+//    body read is submitted without another submit_all()
+//  - enqueue_tracked() with predecessors submits only after they complete
+//  - Fan-in continuations run once, after every predecessor
+//  - A failed predecessor cancels dependent requests and is reported to
+//    continuations
+//  - The same holds when the predecessor failed before the dependent was
+//    enqueued
+//  - Remembered failures stay within QueueConfig::failed_id_window however
+//    many requests fail
+
+#include "ds_runtime.hpp"
+#include "header_body_test_util.hpp"
+
+#include <atomic>
+#include <cassert>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace {
+
+using header_body_test::write_header_body_file;
+
+// Forwards to a real backend and logs submit/complete events by offset.
+class RecordingBackend final : public ds::Backend {
+public:
+    explicit RecordingBackend(std::shared_ptr<ds::Backend> inner)
+        : inner_(std::move(inner)) {}
+
+    void submit(ds::Request req, ds::CompletionCallback on_complete) override {
+        log("submit", req.offset);
+        inner_->submit(std::move(req), [this, on_complete](ds::Request& done) {
+            log("complete", done.offset);
+            on_complete(done);
+        });
+    }
+
+    // Position of an event in the log, or -1 if absent.
+    int position(const std::string& what, std::uint64_t offset) {
+        std::lock_guard<std::mutex> lock(mtx_);
+        for (std::size_t i = 0; i < events_.size(); ++i) {
+            if (events_[i].first == what && events_[i].second == offset) {
+                return static_cast<int>(i);
+            }
+        }
+        return -1;
+    }
+
+private:
+    void log(const char* what, std::uint64_t offset) {
+        std::lock_guard<std::mutex> lock(mtx_);
+        events_.emplace_back(what, offset);
+    }
+
+    std::shared_ptr<ds::Backend> inner_;
+    std::mutex mtx_;
+    std::vector<std::pair<std::string, std::uint64_t>> events_;
+};
+
+const char* kFilename = "dependency_graph_test.bin";
+
+void test_header_then_body() {
+    using namespace ds;
+
+    const std::string body = "body-payload-located-by-header";
+    const int fd = write_header_body_file(kFilename, body, 4096);
+
+    Queue queue(make_cpu_backend(2));
+
+    std::uint64_t header[2] = {0, 0};
+    Request header_req;
+    header_req.fd = fd;
+    header_req.size = sizeof(header);
+    header_req.dst = header;
+    const RequestId header_id = queue.enqueue_tracked(header_req);
+
+    std::vector<char> body_buf(body.size() + 1, '\0');
+    std::atomic<bool> ran{false};
+    queue.then({header_id}, [&](Queue& q, bool ok) {
+        assert(ok);
+        Request body_req;
+        body_req.fd = fd;
+        body_req.offset = header[0];
+        body_req.size = static_cast<std::size_t>(header[1]);
+        body_req.dst = body_buf.data();
+        q.enqueue(body_req);
+        ran = true;
+    });
+
+    queue.submit_all();
+    queue.wait_all(); // Must cover the body read issued by the continuation.
+
+    assert(ran.load());
+    assert(std::string(body_buf.data()) == body);
+    assert(queue.take_completed().size() == 2);
+
+    ::close(fd);
+    ::unlink(kFilename);
+
+    std::cout << "[dependency_graph_test] test_header_then_body PASSED\n";
+}
+
+void test_inline_continuation_submits() {
+    using namespace ds;
+
+    const std::string body = "body-after-landed-header";
+    const int fd = write_header_body_file(kFilename, body, 4096);
+
+    Queue queue(make_cpu_backend(2));
+
+    std::uint64_t header[2] = {0, 0};
+    Request header_req;
+    header_req.fd = fd;
+    header_req.size = sizeof(header);
+    header_req.dst = header;
+    const RequestId header_id = queue.enqueue_tracked(header_req);
+    queue.submit_all();
+    queue.wait(header_id);
+
+    std::vector<char> body_buf(body.size() + 1, '\0');
+    RequestId body_id = 0;
+    queue.then({header_id}, [&](Queue& q, bool ok) {
+        assert(ok);
+        Request body_req;
+        body_req.fd = fd;
+        body_req.offset = header[0];
+        body_req.size = static_cast<std::size_t>(header[1]);
+        body_req.dst = body_buf.data();
+        body_id = q.enqueue_tracked(body_req);
+    });
+    assert(body_id != 0); // Ran inline.
+
+    queue.wait(body_id); // No submit_all(): then() already submitted it.
+    assert(std::string(body_buf.data()) == body);
+    assert(queue.take_completed().size() == 2);
+
+    ::close(fd);
+    ::unlink(kFilename);
+
+    std::cout << "[dependency_graph_test] test_inline_continuation_submits PASSED\n";
+}
+
+void test_chain_ordering_and_fan_in() {
+    using namespace ds;
+
+    const int fd = write_header_body_file(kFilename, "0123456789", 64);
+    auto recorder = std::make_shared<RecordingBackend>(make_cpu_backend(4));
+    Queue queue(recorder);
+
+    char a[4] = {}, b[4] = {}, c[4] = {};
+    Request ra;
+    ra.fd = fd; ra.offset = 64; ra.size = 4; ra.dst = a;
+    Request rb = ra;
+    rb.offset = 68; rb.dst = b;
+    Request rc = ra;
+    rc.offset = 66; rc.dst = c;
+
+    const RequestId ia = queue.enqueue_tracked(ra);
+    const RequestId ib = queue.enqueue_tracked(rb, {ia});
+    const RequestId ic = queue.enqueue_tracked(rc, {ia});
+    assert(ia != 0 && ib != ia && ic != ib);
+
+    std::atomic<int> fan_in_runs{0};
+    queue.then({ib, ic}, [&](Queue&, bool ok) {
+        assert(ok);
+        assert(std::memcmp(b, "4567", 4) == 0);
+        assert(std::memcmp(c, "2345", 4) == 0);
+        fan_in_runs.fetch_add(1);
+    });
+
+    queue.submit_all();
+    queue.wait_all();
+
+    assert(fan_in_runs.load() == 1);
+    assert(std::memcmp(a, "0123", 4) == 0);
+    assert(recorder->position("complete", 64) < recorder->position("submit", 68));
+    assert(recorder->position("complete", 64) < recorder->position("submit", 66));
+
+    // Predecessors that already completed count as satisfied.
+    bool late_ran = false;
+    queue.then({ia, ib}, [&](Queue&, bool) { late_ran = true; });
+    assert(late_ran);
+
+    ::close(fd);
+    ::unlink(kFilename);
+
+    std::cout << "[dependency_graph_test] test_chain_ordering_and_fan_in PASSED\n";
+}
+
+void test_failure_propagation() {
+    using namespace ds;
+
+    set_error_callback([](const ErrorContext&) {});
+
+    Queue queue(make_cpu_backend(1));
+
+    char buf[8] = {};
+    Request bad;
+    bad.fd = -1;
+    bad.size = sizeof(buf);
+    bad.dst = buf;
+    const RequestId bad_id = queue.enqueue_tracked(bad);
+
+    Request dependent = bad;
+    dependent.fd = 0;
+    dependent.user_tag = 7;
+    queue.enqueue_tracked(dependent, {bad_id});
+
+    std::atomic<int> saw_failure{0};
+    queue.then({bad_id}, [&](Queue&, bool ok) {
+        if (!ok) {
+            saw_failure.fetch_add(1);
+        }
+    });
+
+    queue.submit_all();
+    queue.wait_all();
+
+    assert(saw_failure.load() == 1);
+    auto completed = queue.take_completed();
+    assert(completed.size() == 2);
+    bool found_cancelled = false;
+    for (const auto& req : completed) {
+        if (req.user_tag == 7) {
+            assert(req.status == RequestStatus::Cancelled);
+            assert(req.errno_value == ECANCELED);
+            found_cancelled = true;
+        } else {
+            assert(req.status == RequestStatus::IoError);
+        }
+    }
+    assert(found_cancelled);
+
+    set_error_callback(nullptr);
+
+    std::cout << "[dependency_graph_test] test_failure_propagation PASSED\n";
+}
+
+void test_already_failed_predecessor() {
+    using namespace ds;
+
+    set_error_callback([](const ErrorContext&) {});
+
+    Queue queue(make_cpu_backend(1));
+
+    char buf[8] = {};
+    Request bad;
+    bad.fd = -1;
+    bad.size = sizeof(buf);
+    bad.dst = buf;
+    const RequestId bad_id = queue.enqueue_tracked(bad);
+    queue.submit_all();
+    queue.wait_all();
+    assert(queue.take_completed().size() == 1);
+
+    // The failed predecessor has left the graph by now.
+    Request dependent = bad;
+    dependent.fd = 0;
+    dependent.user_tag = 9;
+    queue.enqueue_tracked(dependent, {bad_id});
+
+    bool ran = false;
+    bool ran_ok = true;
+    queue.then({bad_id}, [&](Queue&, bool ok) {
+        ran = true;
+        ran_ok = ok;
+    });
+    assert(ran && !ran_ok);
+
+    queue.submit_all();
+    queue.wait_all();
+    auto completed = queue.take_completed();
+    assert(completed.size() == 1);
+    assert(completed[0].user_tag == 9);
+    assert(completed[0].status == RequestStatus::Cancelled);
+    assert(completed[0].errno_value == ECANCELED);
+
+    set_error_callback(nullptr);
+
+    std::cout << "[dependency_graph_test] test_already_failed_predecessor PASSED\n";
+}
+
+void test_failure_window_bounded() {
+    using namespace ds;
+
+    set_error_callback([](const ErrorContext&) {});
+
+    constexpr std::size_t kWindow = 16;
+    QueueConfig config;
+    config.failed_id_window = kWindow;
+    Queue queue(make_cpu_backend(2), config);
+
+    char buf[8] = {};
+    Request bad;
+    bad.fd = -1;
+    bad.size = sizeof(buf);
+    bad.dst = buf;
+    std::vector<RequestId> ids;
+    for (int i = 0; i < 1000; ++i) {
+        ids.push_back(queue.enqueue_tracked(bad));
+        if (i % 100 == 99) {
+            queue.submit_all();
+            queue.wait_all();
+            assert(queue.stats().remembered_failures <= kWindow);
+        }
+    }
+    assert(queue.take_completed().size() == 1000);
+    assert(queue.stats().remembered_failures == kWindow);
+
+    // The newest failures still cancel late dependents.
+    Request dependent = bad;
+    dependent.fd = 0;
+    queue.enqueue_tracked(dependent, {ids.back()});
+    queue.submit_all();
+    queue.wait_all();
+    auto completed = queue.take_completed();
+    assert(completed.size() == 1);
+    assert(completed[0].status == RequestStatus::Cancelled);
+    assert(queue.stats().remembered_failures == kWindow);
+
+    set_error_callback(nullptr);
+
+    std::cout << "[dependency_graph_test] test_failure_window_bounded PASSED\n";
+}
+
+} // namespace
+
+int main() {
+    test_header_then_body();
+    test_inline_continuation_submits();
+    test_chain_ordering_and_fan_in();
+    test_failure_propagation();
+    test_already_failed_predecessor();
+    test_failure_window_bounded();
+
+    std::cout << "[dependency_graph_test] ALL TESTS PASSED\n";
+    return 0;
+}
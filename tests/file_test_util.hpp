@@ -0,0 +1,53 @@
+// SPDX-License-Identifier: Apache-2.0
+// Plain test file and read builders shared by the backend tests.
+
+#pragma once
+
+#include "ds_runtime.hpp"
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace file_test {
+
+/// @p size bytes of repeating lowercase ASCII.
+inline std::vector<char> make_contents(std::size_t size) {
+    std::vector<char> contents(size);
+    for (std::size_t i = 0; i < contents.size(); ++i) {
+        contents[i] = static_cast<char>('a' + i % 26);
+    }
+    return contents;
+}
+
+/// Write @p contents to @p path; returns a read/write fd.
+inline int create_file(const char* path, const std::vector<char>& contents) {
+    const int fd = ::open(path, O_CREAT | O_RDWR | O_TRUNC, 0644);
+    assert(fd >= 0);
+    const ssize_t wr = ::write(fd, contents.data(), contents.size());
+    assert(wr == static_cast<ssize_t>(contents.size()));
+    return fd;
+}
+
+/// Read of @p size bytes at @p offset into @p dst.
+inline ds::Request make_read(int fd, std::uint64_t offset, std::size_t size, void* dst) {
+    ds::Request req;
+    req.fd = fd;
+    req.offset = offset;
+    req.size = size;
+    req.dst = dst;
+    return req;
+}
+
+/// Read of @p size bytes at @p offset into runtime-owned memory.
+inline ds::Request make_runtime_read(int fd, std::uint64_t offset, std::size_t size) {
+    ds::Request req = make_read(fd, offset, size, nullptr);
+    req.dst_memory = ds::RequestMemory::Runtime;
+    return req;
+}
+
+} // namespace file_test
@@ -0,0 +1,343 @@
+// SPDX-License-Identifier: Apache-2.0
+// Parallel GDeflate decode test.
+//
+// The runtime has no GDeflate codec of its own, so this test plugs in the
+// "stored" block codec of gdeflate_test_util.hpp and checks the CPU
+// backend's block splitting around it.
+//
+// This test verifies:
+//  - One large read is split into block groups decoded by several workers,
+//    each block landing at its decoded offset, in requested or Runtime
+//    memory, from a stream at any file offset
+//  - Streams smaller than decode_split_bytes stay on one worker
+//  - Decoder failures, malformed streams and short destinations fail the
+//    request with the first error, reported once
+//  - Blocks of checksummed streams are verified as they decode; a damaged
+//    block completes the read as Corrupt and is counted
+
+#include "ds_runtime.hpp"
+#include "gdeflate_format.h"
+#include "gdeflate_test_util.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace {
+
+using namespace gdeflate_test;
+
+const char* kFilename = "gdeflate_decode_test.bin";
+
+/// Blocks growing by 37 bytes each, with payloads stored in reverse order
+/// so decoding must follow the block table rather than the payload order.
+StreamLayout layout(std::size_t blocks, std::size_t block_size) {
+    return {blocks, block_size, 37, true};
+}
+
+/// Stored-block codec shared by the tests: records which threads ran it
+/// and fails blocks whose first decoded byte equals fail_on.
+struct XorDecoder {
+    std::mutex mtx;
+    std::set<std::thread::id> threads;
+    std::atomic<std::size_t> calls{0};
+    int fail_on = -1;
+
+    ds::BlockDecoder bind() {
+        return [this](const void* src, std::size_t src_size, void* dst, std::size_t dst_size) {
+            ++calls;
+            {
+                std::lock_guard<std::mutex> lock(mtx);
+                threads.insert(std::this_thread::get_id());
+            }
+            // Give the other workers time to pick up their groups.
+            std::this_thread::sleep_for(std::chrono::microseconds(200));
+            if (src_size != dst_size) {
+                return EINVAL;
+            }
+            const auto* in = static_cast<const unsigned char*>(src);
+            auto* out = static_cast<unsigned char*>(dst);
+            for (std::size_t i = 0; i < src_size; ++i) {
+                out[i] = static_cast<unsigned char>(in[i] ^ kKey);
+            }
+            return fail_on >= 0 && out[0] == fail_on ? EILSEQ : 0;
+        };
+    }
+};
+
+std::uint64_t counter(const ds::BackendStats& stats, const std::string& name) {
+    for (const auto& c : stats.counters) {
+        if (c.name == name) {
+            return c.value;
+        }
+    }
+    return ~std::uint64_t{0};
+}
+
+ds::Request make_read(int fd, void* dst, std::size_t size) {
+    ds::Request req;
+    req.fd = fd;
+    req.offset = kStreamOffset;
+    req.size = size;
+    req.dst = dst;
+    req.compression = ds::Compression::GDeflate;
+    return req;
+}
+
+void test_parallel_decode() {
+    using namespace ds;
+
+    constexpr std::size_t kBlocks = 64;
+    const std::vector<char> decoded = make_decoded(layout(kBlocks, 16 * 1024));
+    const int fd = create_file(kFilename, encode(decoded, layout(kBlocks, 16 * 1024)));
+
+    XorDecoder codec;
+    CpuBackendConfig config;
+    config.worker_count = 4;
+    config.gdeflate_decoder = codec.bind();
+    config.decode_split_bytes = 64 * 1024;
+    auto backend = make_cpu_backend(config);
+    Queue queue(backend);
+
+    // Destination larger than the stream: bytes_transferred is the decoded size.
+    std::vector<char> out(decoded.size() + 100, '\0');
+    queue.enqueue(make_read(fd, out.data(), out.size()));
+    Request runtime = make_read(fd, nullptr, decoded.size());
+    runtime.dst_memory = RequestMemory::Runtime;
+    queue.enqueue(runtime);
+    queue.submit_all();
+    queue.wait_all();
+
+    const std::vector<Request> completed = queue.take_completed();
+    assert(completed.size() == 2);
+    for (const Request& r : completed) {
+        assert(r.status == RequestStatus::Ok);
+        assert(r.bytes_transferred == decoded.size());
+    }
+    assert(std::memcmp(out.data(), decoded.data(), decoded.size()) == 0);
+    const auto runtime_it = std::find_if(completed.begin(), completed.end(), [](const Request& r) {
+        return r.dst_memory == RequestMemory::Runtime;
+    });
+    assert(runtime_it != completed.end());
+    assert(runtime_it->buffer.size() == decoded.size());
+    assert(std::memcmp(runtime_it->buffer.data(), decoded.data(), decoded.size()) == 0);
+
+    const BackendStats stats = backend->stats();
+    assert(counter(stats, "decode_groups") == 8);
+    assert(counter(stats, "decoded_blocks") == 2 * kBlocks);
+    assert(codec.calls.load() == 2 * kBlocks);
+    assert(codec.threads.size() >= 2);
+    assert(stats.completed == 2 && stats.failed == 0);
+
+    ::close(fd);
+    std::cout << "[gdeflate_decode_test] test_parallel_decode PASSED\n";
+}
+
+void test_small_stream() {
+    using namespace ds;
+
+    const std::vector<char> decoded = make_decoded(layout(4, 1000));
+    const int fd = create_file(kFilename, encode(decoded, layout(4, 1000)));
+
+    XorDecoder codec;
+    CpuBackendConfig config;
+    config.worker_count = 4;
+    config.gdeflate_decoder = codec.bind();
+    auto backend = make_cpu_backend(config);
+    Queue queue(backend);
+
+    std::vector<char> out(decoded.size());
+    queue.enqueue(make_read(fd, out.data(), out.size()));
+    queue.submit_all();
+    queue.wait_all();
+
+    assert(queue.stats().failed == 0);
+    assert(out == decoded);
+    assert(counter(backend->stats(), "decode_groups") == 1);
+    assert(codec.threads.size() == 1);
+
+    ::close(fd);
+    std::cout << "[gdeflate_decode_test] test_small_stream PASSED\n";
+}
+
+void test_failures() {
+    using namespace ds;
+
+    std::atomic<int> errors{0};
+    int last_errno = 0;
+    set_error_callback([&errors, &last_errno](const ErrorContext& ctx) {
+        assert(ctx.subsystem == "cpu");
+        last_errno = ctx.errno_value;
+        ++errors;
+    });
+
+    constexpr std::size_t kBlocks = 32;
+    const std::vector<char> decoded = make_decoded(layout(kBlocks, 4096));
+    std::vector<char> stream = encode(decoded, layout(kBlocks, 4096));
+
+    XorDecoder codec;
+    CpuBackendConfig config;
+    config.worker_count = 4;
+    config.gdeflate_decoder = codec.bind();
+    config.decode_split_bytes = 4096;
+    Queue queue(make_cpu_backend(config));
+    std::vector<char> out(decoded.size());
+
+    const auto run = [&](const Request& req) {
+        queue.enqueue(req);
+        queue.submit_all();
+        queue.wait_all();
+        const std::vector<Request> completed = queue.take_completed();
+        assert(completed.size() == 1);
+        assert(completed[0].status == RequestStatus::IoError);
+        assert(completed[0].bytes_transferred == 0);
+        return completed[0].errno_value;
+    };
+
+    // A failing block fails the request with the decoder's errno, once.
+    int fd = create_file(kFilename, stream);
+    codec.fail_on = static_cast<unsigned char>(decoded[make_decoded(layout(20, 4096)).size()]);
+    int err = run(make_read(fd, out.data(), out.size()));
+    assert(err == EILSEQ);
+    assert(errors.load() == 1 && last_errno == EILSEQ);
+    codec.fail_on = -1;
+    ::close(fd);
+
+    // Destination too small for the decoded stream.
+    fd = create_file(kFilename, stream);
+    err = run(make_read(fd, out.data(), out.size() - 1));
+    assert(err == EOVERFLOW);
+
+    // Not a stream at all.
+    Request plain = make_read(fd, out.data(), out.size());
+    plain.offset = 0;
+    err = run(plain);
+    assert(err == EINVAL);
+    ::close(fd);
+
+    // A block pointing past the payload.
+    gdeflate::BlockInfo last{};
+    const std::size_t last_at = sizeof(gdeflate::FileHeader) + (kBlocks - 1) * sizeof(last);
+    std::memcpy(&last, stream.data() + last_at, sizeof(last));
+    last.offset = stream.size();
+    std::memcpy(stream.data() + last_at, &last, sizeof(last));
+    fd = create_file(kFilename, stream);
+    err = run(make_read(fd, out.data(), out.size()));
+    assert(err == EINVAL);
+
+    // Stream cut short: blocks past the end of the file fail to read.
+    const int cut = ::ftruncate(fd, static_cast<off_t>(kStreamOffset + stream.size() / 2));
+    assert(cut == 0);
+    ::close(fd);
+    fd = ::open(kFilename, O_RDWR);
+    std::vector<char> intact = encode(decoded, layout(kBlocks, 4096));
+    const ssize_t wr = ::pwrite(fd, intact.data(), intact.size() / 2, kStreamOffset);
+    assert(wr == static_cast<ssize_t>(intact.size() / 2));
+    err = run(make_read(fd, out.data(), out.size()));
+    assert(err == EIO);
+    ::close(fd);
+
+    set_error_callback(nullptr);
+    std::cout << "[gdeflate_decode_test] test_failures PASSED\n";
+}
+
+void test_checksums() {
+    using namespace ds;
+
+    std::atomic<int> errors{0};
+    set_error_callback([&errors](const ErrorContext& ctx) {
+        assert(ctx.subsystem == "cpu" && ctx.operation == "verify");
+        assert(ctx.errno_value == EBADMSG);
+        ++errors;
+    });
+
+    constexpr std::size_t kBlocks = 16;
+    const std::vector<char> decoded = make_decoded(layout(kBlocks, 4096));
+    std::vector<char> stream = encode(decoded, layout(kBlocks, 4096), true);
+
+    const auto run = [](const std::shared_ptr<Backend>& backend, int fd, std::vector<char>& out) {
+        Queue queue(backend);
+        queue.enqueue(make_read(fd, out.data(), out.size()));
+        queue.submit_all();
+        queue.wait_all();
+        std::vector<Request> completed = queue.take_completed();
+        assert(completed.size() == 1);
+        return completed[0];
+    };
+
+    XorDecoder codec;
+    CpuBackendConfig config;
+    config.worker_count = 4;
+    config.gdeflate_decoder = codec.bind();
+    config.decode_split_bytes = 4096;
+    std::vector<char> out(decoded.size());
+
+    // An intact stream verifies every block.
+    int fd = create_file(kFilename, stream);
+    auto backend = make_cpu_backend(config);
+    Request done = run(backend, fd, out);
+    assert(done.status == RequestStatus::Ok);
+    assert(out == decoded);
+    assert(counter(backend->stats(), "verified_blocks") == kBlocks);
+    assert(counter(backend->stats(), "checksum_failures") == 0);
+    ::close(fd);
+
+    // One damaged payload byte: the block decodes, then fails its check.
+    // Payloads are stored in reverse, so the last block comes first.
+    stream[sizeof(gdeflate::FileHeader) + kBlocks * sizeof(gdeflate::BlockInfo) + 10] ^= 0x01;
+    fd = create_file(kFilename, stream);
+    backend = make_cpu_backend(config);
+    done = run(backend, fd, out);
+    assert(done.status == RequestStatus::Corrupt);
+    assert(done.errno_value == EBADMSG && done.bytes_transferred == 0);
+    assert(errors.load() == 1);
+    assert(counter(backend->stats(), "checksum_failures") == 1);
+    assert(backend->stats().failed == 1);
+
+    // With verification off the damage goes unnoticed.
+    config.verify_block_checksums = false;
+    backend = make_cpu_backend(config);
+    done = run(backend, fd, out);
+    assert(done.status == RequestStatus::Ok);
+    assert(out != decoded);
+    assert(counter(backend->stats(), "verified_blocks") == 0);
+    ::close(fd);
+
+    // Streams without the flag carry no checksums to check.
+    config.verify_block_checksums = true;
+    fd = create_file(kFilename, encode(decoded, layout(kBlocks, 4096)));
+    backend = make_cpu_backend(config);
+    done = run(backend, fd, out);
+    assert(done.status == RequestStatus::Ok);
+    assert(out == decoded);
+    assert(counter(backend->stats(), "verified_blocks") == 0);
+    ::close(fd);
+
+    set_error_callback(nullptr);
+    std::cout << "[gdeflate_decode_test] test_checksums PASSED\n";
+}
+
+} // namespace
+
+int main() {
+    test_parallel_decode();
+    test_small_stream();
+    test_failures();
+    test_checksums();
+
+    ::unlink(kFilename);
+    std::cout << "[gdeflate_decode_test] ALL TESTS PASSED\n";
+    return 0;
+}
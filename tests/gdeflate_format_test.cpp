@@ -1,9 +1,14 @@
 // SPDX-License-Identifier: Apache-2.0
 // Test for GDeflate format parsing
+// Covers header and block table parsing, hostile tables (wrapping counts
+// and offsets, overlaps, bad sums) and the zero-copy StreamView with its
+// offset-to-block lookup.
 
 #include "gdeflate_format.h"
+#include <cstdint>
 #include <cstring>
 #include <iostream>
+#include <vector>
 
 using namespace ds::gdeflate;
 
@@ -140,6 +145,171 @@ bool test_stream_info() {
     return true;
 }
 
+// Build a two-block stream index (header + table, no payload) at a
+// deliberately odd address inside storage.
+const uint8_t* make_index(std::vector<uint8_t>& storage, const BlockInfo (&blocks)[2],
+                          uint32_t compressed_size, uint32_t block_count = 2) {
+    FileHeader header{};
+    header.magic = GDEFLATE_MAGIC;
+    header.version_major = GDEFLATE_VERSION_MAJOR;
+    header.uncompressed_size = blocks[0].uncompressed_size + blocks[1].uncompressed_size;
+    header.compressed_size = compressed_size;
+    header.block_count = block_count;
+    storage.assign(1 + sizeof(header) + sizeof(blocks), 0);
+    std::memcpy(storage.data() + 1, &header, sizeof(header));
+    std::memcpy(storage.data() + 1 + sizeof(header), blocks, sizeof(blocks));
+    return storage.data() + 1;
+}
+
+// Hostile tables: wrapping counts and offsets, overlaps, bad sums
+bool test_hostile_tables() {
+    std::vector<uint8_t> storage;
+    FileHeader header;
+    BlockTableView view;
+    const size_t size = sizeof(FileHeader) + 2 * sizeof(BlockInfo);
+
+    // Payload stored in reverse order is fine, at any alignment.
+    BlockInfo blocks[2] = {{100, 100, 300, 0}, {0, 100, 300, 0}};
+    const uint8_t* data = make_index(storage, blocks, 200);
+    if (check_stream_index(data, size, header, view) != ParseStatus::Ok ||
+        view.size() != 2 || view[0].offset != 100 || view[1].compressed_size != 100) {
+        std::cerr << "Reversed table rejected or misread\n";
+        return false;
+    }
+
+    // A count whose table size would wrap a size_t multiplication.
+    std::vector<BlockInfo> parsed;
+    if (parse_block_info(data, size, SIZE_MAX / sizeof(BlockInfo) + 2, parsed) != 0) {
+        std::cerr << "Wrapping block count accepted\n";
+        return false;
+    }
+    data = make_index(storage, blocks, 200, 0xFFFFFFFFu);
+    if (check_stream_index(data, size, header, view) != ParseStatus::Truncated) {
+        std::cerr << "Huge block count not reported as truncated\n";
+        return false;
+    }
+
+    // offset + compressed_size wrapping past 2^64.
+    BlockInfo wrapping[2] = {{UINT64_MAX - 10, 100, 300, 0}, {0, 100, 300, 0}};
+    data = make_index(storage, wrapping, 200);
+    if (check_stream_index(data, size, header, view) != ParseStatus::BlockOutOfBounds) {
+        std::cerr << "Wrapping block offset accepted\n";
+        return false;
+    }
+
+    // Two blocks sharing payload bytes, out of table order.
+    BlockInfo overlapping[2] = {{80, 100, 300, 0}, {0, 100, 300, 0}};
+    data = make_index(storage, overlapping, 200);
+    if (check_stream_index(data, size, header, view) != ParseStatus::BlocksOverlap) {
+        std::cerr << "Overlapping blocks accepted\n";
+        return false;
+    }
+
+    // Decoded sizes not adding up to the header's.
+    data = make_index(storage, blocks, 200);
+    FileHeader lying{};
+    std::memcpy(&lying, data, sizeof(lying));
+    lying.uncompressed_size += 1;
+    std::memcpy(storage.data() + 1, &lying, sizeof(lying));
+    StreamInfo info;
+    if (check_stream_index(data, size, header, view) != ParseStatus::SizeMismatch ||
+        parse_stream_info(data, size, info)) {
+        std::cerr << "Block size sum mismatch accepted\n";
+        return false;
+    }
+
+    return true;
+}
+
+// Zero-copy view: spans into the buffer, prefix sums, block lookup
+bool test_stream_view() {
+    // Blocks of 1..n decoded bytes * 3, payload in table order.
+    constexpr uint32_t kBlocks = 200000;
+    const size_t bytes = sizeof(FileHeader) + kBlocks * sizeof(BlockInfo);
+    std::vector<uint64_t> aligned((bytes + 1) / sizeof(uint64_t) + 1); // 8-byte aligned backing
+    auto* base = reinterpret_cast<uint8_t*>(aligned.data());
+
+    FileHeader header{};
+    header.magic = GDEFLATE_MAGIC;
+    header.version_major = GDEFLATE_VERSION_MAJOR;
+    header.block_count = kBlocks;
+    uint64_t decoded = 0;
+    for (uint32_t b = 0; b < kBlocks; ++b) {
+        BlockInfo block{};
+        block.offset = b * uint64_t{8};
+        block.compressed_size = 8;
+        block.uncompressed_size = (b % 7 + 1) * 3;
+        block.checksum = b;
+        std::memcpy(base + sizeof(FileHeader) + b * sizeof(BlockInfo), &block, sizeof(block));
+        decoded += block.uncompressed_size;
+    }
+    header.uncompressed_size = static_cast<uint32_t>(decoded);
+    header.compressed_size = kBlocks * 8;
+    std::memcpy(base, &header, sizeof(header));
+
+    StreamView view;
+    if (view.open(base, bytes) != ParseStatus::Ok || !view.valid() || !view.zero_copy() ||
+        &view.header() != reinterpret_cast<const FileHeader*>(base) ||
+        view.blocks().data() != reinterpret_cast<const BlockInfo*>(base + sizeof(FileHeader))) {
+        std::cerr << "Aligned stream not viewed in place\n";
+        return false;
+    }
+    if (view.block_count() != kBlocks || view.decoded_size() != decoded ||
+        view.decoded_offsets().size() != kBlocks + 1 || view.max_compressed_size() != 8 ||
+        view.payload_offset() != bytes) {
+        std::cerr << "StreamView totals wrong\n";
+        return false;
+    }
+
+    // Every block boundary, and a byte inside each of a sample of blocks.
+    for (size_t b = 0; b < kBlocks; b += 997) {
+        const uint64_t start = view.decoded_offset(b);
+        if (view.find_block(start) != b ||
+            view.find_block(start + view.blocks()[b].uncompressed_size - 1) != b ||
+            (b > 0 && view.find_block(start - 1) != b - 1)) {
+            std::cerr << "find_block wrong near block " << b << "\n";
+            return false;
+        }
+    }
+    if (view.find_block(decoded) != StreamView::npos || view.find_block(0) != 0 ||
+        view.find_block(decoded - 1) != kBlocks - 1) {
+        std::cerr << "find_block wrong at the stream ends\n";
+        return false;
+    }
+    const auto range = view.block_range(view.decoded_offset(10) + 1, view.decoded_offset(20) - view.decoded_offset(10));
+    const auto tail = view.block_range(decoded - 1, 1000);
+    if (range.first != 10 || range.second != 21 || tail.first != kBlocks - 1 || tail.second != kBlocks ||
+        view.block_range(decoded, 1).second != 0 || view.block_range(5, 0).second != 0) {
+        std::cerr << "block_range wrong\n";
+        return false;
+    }
+
+    // Misaligned: the same stream one byte in is decoded into a copy.
+    std::vector<uint8_t> shifted(bytes + 1);
+    std::memcpy(shifted.data() + 1, base, bytes);
+    StreamView copy;
+    if (copy.open(shifted.data() + 1, bytes) != ParseStatus::Ok || copy.zero_copy() ||
+        copy.header().block_count != kBlocks || copy.blocks()[12345].checksum != 12345 ||
+        copy.find_block(decoded / 2) != view.find_block(decoded / 2)) {
+        std::cerr << "Misaligned stream misread\n";
+        return false;
+    }
+
+    // Moving keeps the spans valid; a rejected stream leaves the view empty.
+    StreamView moved = std::move(copy);
+    if (moved.blocks()[777].checksum != 777 || moved.header().uncompressed_size != decoded) {
+        std::cerr << "Moved view lost its storage\n";
+        return false;
+    }
+    if (moved.open(base, sizeof(FileHeader) + 10) != ParseStatus::Truncated || moved.valid() ||
+        moved.block_count() != 0 || moved.find_block(0) != StreamView::npos) {
+        std::cerr << "Rejected stream left a usable view\n";
+        return false;
+    }
+
+    return true;
+}
+
 int main() {
     std::cout << "[gdeflate_format_test] Running tests...\n";
     
@@ -167,6 +337,18 @@ int main() {
     }
     std::cout << "[gdeflate_format_test] test_stream_info PASSED\n";
     
+    if (!test_hostile_tables()) {
+        std::cerr << "[gdeflate_format_test] test_hostile_tables FAILED\n";
+        return 1;
+    }
+    std::cout << "[gdeflate_format_test] test_hostile_tables PASSED\n";
+    
+    if (!test_stream_view()) {
+        std::cerr << "[gdeflate_format_test] test_stream_view FAILED\n";
+        return 1;
+    }
+    std::cout << "[gdeflate_format_test] test_stream_view PASSED\n";
+    
     std::cout << "[gdeflate_format_test] ALL TESTS PASSED\n";
     return 0;
 }
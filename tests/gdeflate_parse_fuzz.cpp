@@ -0,0 +1,270 @@
+// SPDX-License-Identifier: Apache-2.0
+// GDeflate container parser fuzz target.
+//
+// Built two ways:
+//  - With DS_FUZZ_LIBFUZZER (-DDS_BUILD_FUZZERS=ON, Clang): a libFuzzer
+//    target fed arbitrary bytes
+//  - Otherwise: a plain CTest program that replays the files named on its
+//    command line, then runs seed streams and a fixed, seeded series of
+//    mutations of them through the same checks
+//
+// Every input goes through check_stream_index(), parse_stream_info(),
+// StreamView and parse_block_info(). Accepted streams must satisfy what the decoders rely
+// on (blocks inside the payload, no overlap, sizes adding up), and the
+// parsers must agree with each other.
+
+#include "gdeflate_format.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <vector>
+
+namespace {
+
+using namespace ds::gdeflate;
+
+void require(bool ok, const char* what) {
+    if (!ok) {
+        std::fprintf(stderr, "[gdeflate_parse_fuzz] invariant violated: %s\n", what);
+        std::abort();
+    }
+}
+
+/// Field-wise equality; tail padding is whatever the input held.
+bool same_block(const BlockInfo& a, const BlockInfo& b) {
+    return a.offset == b.offset && a.compressed_size == b.compressed_size &&
+           a.uncompressed_size == b.uncompressed_size && a.checksum == b.checksum;
+}
+
+void fuzz_one(const uint8_t* data, size_t size) {
+    FileHeader header{};
+    BlockTableView view;
+    const ParseStatus status = check_stream_index(data, size, header, view);
+    require(parse_status_string(status) != nullptr, "status has a description");
+
+    StreamInfo info;
+    const bool parsed = parse_stream_info(data, size, info);
+    require(parsed == (status == ParseStatus::Ok), "parse_stream_info agrees with check_stream_index");
+
+    StreamView stream;
+    require(stream.open(data, size) == status && stream.valid() == parsed, "StreamView agrees");
+
+    // A hostile count read from the input must not wrap the size check.
+    if (size >= 4) {
+        const size_t count = load_le32(data);
+        std::vector<BlockInfo> blocks;
+        const size_t n = parse_block_info(data, size, count, blocks);
+        require(n == 0 || (n == count && count <= size / sizeof(BlockInfo)), "parse_block_info bound");
+        require(blocks.size() == n, "parse_block_info fills what it reports");
+    }
+
+    if (status != ParseStatus::Ok) {
+        return;
+    }
+    require(view.size() == header.block_count && info.blocks.size() == view.size(), "block count");
+    require(sizeof(FileHeader) + uint64_t{header.block_count} * sizeof(BlockInfo) <= size,
+            "table inside the buffer");
+    require(stream_size(header) >= sizeof(FileHeader) + header.compressed_size, "stream size");
+
+    uint64_t decoded = 0;
+    for (size_t b = 0; b < view.size(); ++b) {
+        const BlockInfo block = view[b];
+        require(same_block(block, info.blocks[b]), "view matches copy");
+        require(block.is_valid(), "block sizes");
+        require(block.offset + block.compressed_size <= header.compressed_size, "block inside payload");
+        decoded += block.uncompressed_size;
+    }
+    require(decoded == header.uncompressed_size, "decoded sizes add up");
+
+    require(stream.block_count() == view.size() && stream.decoded_size() == decoded, "view totals");
+    for (size_t b = 0; b < stream.block_count(); ++b) {
+        const BlockInfo block = view[b];
+        require(same_block(block, stream.blocks()[b]), "view matches table");
+        const uint64_t start = stream.decoded_offset(b);
+        require(stream.find_block(start) == b, "find_block at block start");
+        require(stream.find_block(start + block.uncompressed_size - 1) == b, "find_block at block end");
+    }
+    require(stream.find_block(decoded) == StreamView::npos, "find_block past the end");
+
+    // Brute-force overlap check on small tables.
+    if (view.size() <= 64) {
+        for (size_t a = 0; a < view.size(); ++a) {
+            for (size_t b = a + 1; b < view.size(); ++b) {
+                const BlockInfo x = view[a];
+                const BlockInfo y = view[b];
+                require(x.offset + x.compressed_size <= y.offset ||
+                        y.offset + y.compressed_size <= x.offset, "blocks disjoint");
+            }
+        }
+    }
+}
+
+} // namespace
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+    fuzz_one(data, size);
+    return 0;
+}
+
+#ifndef DS_FUZZ_LIBFUZZER
+
+namespace {
+
+/// Deterministic xorshift generator, so every run covers the same inputs.
+struct Rng {
+    uint64_t state = 0x9E3779B97F4A7C15ull;
+    uint32_t next() {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        return static_cast<uint32_t>(state >> 32);
+    }
+    size_t below(size_t n) { return n == 0 ? 0 : next() % n; }
+};
+
+void put32(std::vector<uint8_t>& out, size_t at, uint32_t v) {
+    for (int i = 0; i < 4; ++i) {
+        out[at + static_cast<size_t>(i)] = static_cast<uint8_t>(v >> (8 * i));
+    }
+}
+
+void put64(std::vector<uint8_t>& out, size_t at, uint64_t v) {
+    put32(out, at, static_cast<uint32_t>(v));
+    put32(out, at + 4, static_cast<uint32_t>(v >> 32));
+}
+
+/// A well-formed stream of @p blocks blocks, payload in table order or
+/// reversed, with the payload bytes present.
+std::vector<uint8_t> make_seed(uint32_t blocks, uint32_t block_size, bool reversed) {
+    const uint32_t payload = blocks * block_size;
+    std::vector<uint8_t> out(sizeof(FileHeader) + blocks * sizeof(BlockInfo) + payload, 0x5A);
+    put32(out, 0, GDEFLATE_MAGIC);
+    out[4] = static_cast<uint8_t>(GDEFLATE_VERSION_MAJOR);
+    out[5] = 0;
+    out[6] = static_cast<uint8_t>(GDEFLATE_VERSION_MINOR);
+    out[7] = 0;
+    put32(out, 8, 0);
+    put32(out, 12, blocks * block_size * 2);
+    put32(out, 16, payload);
+    put32(out, 20, blocks);
+    put32(out, 24, 0);
+    put32(out, 28, 0);
+    for (uint32_t b = 0; b < blocks; ++b) {
+        const size_t at = sizeof(FileHeader) + b * sizeof(BlockInfo);
+        const uint32_t slot = reversed ? blocks - 1 - b : b;
+        put64(out, at, uint64_t{slot} * block_size);
+        put32(out, at + 8, block_size);
+        put32(out, at + 12, block_size * 2);
+        put32(out, at + 16, b);
+        put32(out, at + 20, 0);
+    }
+    return out;
+}
+
+/// Apply one random mutation, biased towards the header and table fields
+/// the parser reads.
+void mutate(std::vector<uint8_t>& input, Rng& rng) {
+    static const uint32_t kInteresting[] = {
+        0, 1, 2, 23, 24, 25, 0x7FFFFFFFu, 0x80000000u, 0xFFFFFFFFu, 0xFFFFFFFEu,
+        0x0AAAAAABu, MAX_BLOCK_SIZE, MAX_BLOCK_SIZE + 1,
+    };
+    // Mutate the header and block table, not the payload behind them.
+    size_t table_end = input.size();
+    if (input.size() >= sizeof(FileHeader)) {
+        table_end = std::min<uint64_t>(input.size(),
+                                       sizeof(FileHeader) + uint64_t{load_le32(&input[20])} * sizeof(BlockInfo));
+    }
+    switch (rng.below(5)) {
+        case 0: // flip a bit
+            if (!input.empty()) {
+                input[rng.below(table_end)] ^= static_cast<uint8_t>(1u << rng.below(8));
+            }
+            break;
+        case 1: // an interesting 32-bit value at a field boundary
+            if (table_end >= 4) {
+                const size_t at = rng.below(table_end / 4) * 4;
+                put32(input, at, kInteresting[rng.below(std::size(kInteresting))]);
+            }
+            break;
+        case 2: // a large 64-bit block offset
+            if (table_end >= sizeof(FileHeader) + 8) {
+                const size_t blocks = (table_end - sizeof(FileHeader)) / sizeof(BlockInfo);
+                if (blocks != 0) {
+                    const uint64_t big = (uint64_t{rng.next()} << 32) | rng.next();
+                    put64(input, sizeof(FileHeader) + rng.below(blocks) * sizeof(BlockInfo), big);
+                }
+            }
+            break;
+        case 3: // truncate
+            input.resize(rng.below(input.size() + 1));
+            break;
+        default: // copy one table entry over another, making overlaps
+            if (table_end >= sizeof(FileHeader) + 2 * sizeof(BlockInfo)) {
+                const size_t blocks = (table_end - sizeof(FileHeader)) / sizeof(BlockInfo);
+                const size_t from = sizeof(FileHeader) + rng.below(blocks) * sizeof(BlockInfo);
+                const size_t to = sizeof(FileHeader) + rng.below(blocks) * sizeof(BlockInfo);
+                std::memmove(input.data() + to, input.data() + from, 16);
+            }
+            break;
+    }
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    // Replay inputs saved by the libFuzzer build.
+    for (int i = 1; i < argc; ++i) {
+        std::ifstream file(argv[i], std::ios::binary);
+        const std::vector<uint8_t> input((std::istreambuf_iterator<char>(file)),
+                                         std::istreambuf_iterator<char>());
+        fuzz_one(input.data(), input.size());
+        std::cout << "[gdeflate_parse_fuzz] replayed " << argv[i] << "\n";
+    }
+
+    const std::vector<std::vector<uint8_t>> seeds = {
+        make_seed(1, 64, false),
+        make_seed(4, 100, false),
+        make_seed(16, 32, true),
+        make_seed(3, 4096, true),
+    };
+    size_t accepted = 0;
+    for (const auto& seed : seeds) {
+        FileHeader header{};
+        BlockTableView view;
+        require(check_stream_index(seed.data(), seed.size(), header, view) == ParseStatus::Ok,
+                "seed accepted");
+        require(stream_size(header) == seed.size(), "seed carries its payload");
+        fuzz_one(seed.data(), seed.size());
+    }
+    fuzz_one(nullptr, 0);
+
+    Rng rng;
+    constexpr int kIterations = 50000;
+    for (int i = 0; i < kIterations; ++i) {
+        std::vector<uint8_t> input = seeds[rng.below(seeds.size())];
+        const size_t steps = 1 + rng.below(4);
+        for (size_t s = 0; s < steps; ++s) {
+            mutate(input, rng);
+        }
+        fuzz_one(input.data(), input.size());
+        FileHeader header{};
+        BlockTableView view;
+        accepted += check_stream_index(input.data(), input.size(), header, view) == ParseStatus::Ok;
+    }
+    // Some mutations leave the stream valid (checksum or padding bytes);
+    // most must be caught.
+    require(accepted > 0 && accepted < kIterations / 2, "mutations exercise both outcomes");
+
+    std::cout << "[gdeflate_parse_fuzz] " << kIterations << " mutated inputs, " << accepted
+              << " accepted\n";
+    std::cout << "[gdeflate_parse_fuzz] ALL TESTS PASSED\n";
+    return 0;
+}
+
+#endif
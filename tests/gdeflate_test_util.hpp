@@ -0,0 +1,111 @@
+// SPDX-License-Identifier: Apache-2.0
+// GDeflate test streams shared by the decode tests.
+//
+// The runtime has no GDeflate codec of its own, so the tests build streams
+// of "stored" blocks whose payload is the decoded bytes XOR kKey, and plug
+// in a matching codec.
+
+#pragma once
+
+#include "ds_runtime_checksum.hpp"
+#include "gdeflate_format.h"
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace gdeflate_test {
+
+/// File offset the test stream is written at, after filler bytes.
+constexpr std::uint64_t kStreamOffset = 512;
+
+/// Byte the stored-block codec XORs payloads with.
+constexpr unsigned char kKey = 0xA5;
+
+/// Shape of a test stream.
+struct StreamLayout {
+    std::size_t blocks = 0;     ///< Number of blocks.
+    std::size_t block_size = 0; ///< Decoded bytes of block 0.
+    std::size_t growth = 0;     ///< Extra bytes per block: block b holds block_size + b * growth.
+    bool        reversed = false; ///< Lay payloads out in reverse table order.
+
+    std::size_t size_of(std::size_t b) const { return block_size + b * growth; }
+};
+
+/// Decoded contents of a stream shaped like @p layout.
+inline std::vector<char> make_decoded(const StreamLayout& layout) {
+    std::vector<char> decoded;
+    for (std::size_t b = 0; b < layout.blocks; ++b) {
+        for (std::size_t i = 0; i < layout.size_of(b); ++i) {
+            decoded.push_back(static_cast<char>('a' + (b + i) % 26));
+        }
+    }
+    return decoded;
+}
+
+/// Encode @p decoded as a stream of stored blocks shaped like @p layout.
+/// Reversed payloads make decoding follow the block table rather than the
+/// payload order. With @p checksummed, each block carries the CRC-32C of
+/// its decoded bytes.
+inline std::vector<char> encode(const std::vector<char>& decoded, const StreamLayout& layout,
+                                bool checksummed = false) {
+    namespace gd = ds::gdeflate;
+    const std::size_t blocks = layout.blocks;
+    std::vector<gd::BlockInfo> table(blocks);
+    std::vector<std::size_t> starts(blocks);
+    std::size_t at = 0;
+    for (std::size_t b = 0; b < blocks; ++b) {
+        starts[b] = at;
+        table[b].compressed_size = static_cast<std::uint32_t>(layout.size_of(b));
+        table[b].uncompressed_size = table[b].compressed_size;
+        if (checksummed) {
+            table[b].checksum = ds::crc32c(decoded.data() + at, table[b].uncompressed_size);
+        }
+        at += table[b].uncompressed_size;
+    }
+    assert(at == decoded.size());
+
+    std::vector<char> payload;
+    for (std::size_t n = 0; n < blocks; ++n) {
+        const std::size_t b = layout.reversed ? blocks - 1 - n : n;
+        table[b].offset = payload.size();
+        for (std::size_t i = 0; i < table[b].compressed_size; ++i) {
+            payload.push_back(static_cast<char>(decoded[starts[b] + i] ^ kKey));
+        }
+    }
+
+    gd::FileHeader header{};
+    header.magic = gd::GDEFLATE_MAGIC;
+    header.version_major = gd::GDEFLATE_VERSION_MAJOR;
+    header.uncompressed_size = static_cast<std::uint32_t>(decoded.size());
+    header.compressed_size = static_cast<std::uint32_t>(payload.size());
+    header.block_count = static_cast<std::uint32_t>(blocks);
+    header.flags = checksummed ? gd::FLAG_BLOCK_CRC32C : 0;
+
+    std::vector<char> stream(sizeof(header) + blocks * sizeof(gd::BlockInfo));
+    std::memcpy(stream.data(), &header, sizeof(header));
+    std::memcpy(stream.data() + sizeof(header), table.data(), blocks * sizeof(gd::BlockInfo));
+    stream.insert(stream.end(), payload.begin(), payload.end());
+    return stream;
+}
+
+/// Write @p stream to @p path at kStreamOffset after 'x' filler; returns
+/// a read/write fd.
+inline int create_file(const char* path, const std::vector<char>& stream) {
+    const int fd = ::open(path, O_CREAT | O_RDWR | O_TRUNC, 0644);
+    assert(fd >= 0);
+    const std::string filler(kStreamOffset, 'x');
+    const ssize_t head = ::pwrite(fd, filler.data(), filler.size(), 0);
+    assert(head == static_cast<ssize_t>(filler.size()));
+    const ssize_t wr = ::pwrite(fd, stream.data(), stream.size(), static_cast<off_t>(kStreamOffset));
+    assert(wr == static_cast<ssize_t>(stream.size()));
+    return fd;
+}
+
+} // namespace gdeflate_test
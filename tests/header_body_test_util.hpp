@@ -0,0 +1,39 @@
+// SPDX-License-Identifier: Apache-2.0
+// Header-then-body test file shared by the dependency graph and coroutine
+// tests.
+
+#pragma once
+
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace header_body_test {
+
+/// Write @p body to @p path behind a header locating it; returns a read fd.
+///
+/// Layout: [u64 body offset][u64 body size] ... body at that offset.
+inline int write_header_body_file(const char* path, const std::string& body,
+                                  std::uint64_t body_offset) {
+    std::vector<char> contents(body_offset + body.size(), '.');
+    const std::uint64_t header[2] = {body_offset, body.size()};
+    std::memcpy(contents.data(), header, sizeof(header));
+    std::memcpy(contents.data() + body_offset, body.data(), body.size());
+
+    const int fd_write = ::open(path, O_CREAT | O_WRONLY | O_TRUNC, 0644);
+    assert(fd_write >= 0);
+    const ssize_t wr = ::write(fd_write, contents.data(), contents.size());
+    assert(wr == static_cast<ssize_t>(contents.size()));
+    ::close(fd_write);
+
+    const int fd = ::open(path, O_RDONLY);
+    assert(fd >= 0);
+    return fd;
+}
+
+} // namespace header_body_test
@@ -0,0 +1,301 @@
+// SPDX-License-Identifier: Apache-2.0
+// mmap backend test.
+//
+// This test verifies:
+//  - Reads through the mapping match the file, including short reads at
+//    EOF and reads entirely past EOF
+//  - Writes land in the file and later reads see them, growing the mapping
+//  - FakeUppercase / GDeflate and invalid requests behave like the CPU backend
+//  - Sequential streams are advised MADV_SEQUENTIAL and release_file() unmaps
+//  - Inline execution works with in-flight caps and dependent requests
+//  - Worker-pool mode handles concurrent reads
+
+#include "ds_runtime.hpp"
+#include "ds_runtime_mmap.hpp"
+#include "file_test_util.hpp"
+
+#include <cassert>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace {
+
+using namespace file_test;
+
+const char* kFilename = "mmap_backend_test.bin";
+constexpr std::size_t kFileSize = 64 * 1024;
+
+void test_reads_and_writes() {
+    using namespace ds;
+
+    const std::vector<char> contents = make_contents(kFileSize);
+    const int fd = create_file(kFilename, contents);
+
+    auto backend = make_mmap_backend();
+    Queue queue(backend);
+
+    std::vector<char> a(4096), b(200), c(16, 'x');
+    queue.enqueue(make_read(fd, 1000, a.size(), a.data()));
+    queue.enqueue(make_read(fd, kFileSize - 100, b.size(), b.data()));  // Short read.
+    queue.enqueue(make_read(fd, kFileSize + 10, c.size(), c.data()));   // Past EOF.
+    queue.submit_all();
+    queue.wait_all();
+
+    auto done = queue.take_completed();
+    assert(done.size() == 3);
+    for (const auto& req : done) {
+        assert(req.status == RequestStatus::Ok);
+        if (req.offset == 1000) {
+            assert(req.bytes_transferred == a.size());
+        } else if (req.offset == kFileSize - 100) {
+            assert(req.bytes_transferred == 100);
+        } else {
+            assert(req.bytes_transferred == 0);
+        }
+    }
+    assert(std::memcmp(a.data(), contents.data() + 1000, a.size()) == 0);
+    assert(std::memcmp(b.data(), contents.data() + kFileSize - 100, 100) == 0);
+    assert(b[100] == '\0');
+    assert(c[0] == '\0');
+
+    // Extend the file through the backend, then read the new tail.
+    const std::string tail = "appended-by-mmap-backend";
+    Request write;
+    write.op = RequestOp::Write;
+    write.fd = fd;
+    write.offset = kFileSize;
+    write.size = tail.size();
+    write.src = tail.data();
+    queue.enqueue(write);
+    queue.submit_all();
+    queue.wait_all();
+
+    std::vector<char> grown(tail.size());
+    queue.enqueue(make_read(fd, kFileSize, grown.size(), grown.data()));
+    queue.submit_all();
+    queue.wait_all();
+    done = queue.take_completed();
+    assert(done.size() == 2);
+    assert(done[1].status == RequestStatus::Ok);
+    assert(done[1].bytes_transferred == tail.size());
+    assert(std::string(grown.begin(), grown.end()) == tail);
+
+    const BackendStats stats = backend->stats();
+    assert(stats.backend == "mmap");
+    assert(stats.completed == 5);
+    assert(stats.failed == 0);
+    assert(stats.counter("maps") == 1);
+    assert(stats.counter("remaps") == 1);
+    assert(stats.counter("mapped_files") == 1);
+    assert(stats.counter("mapped_bytes") == kFileSize + tail.size());
+    assert(stats.counter("populated_maps") == 2);
+
+    backend->release_file(fd);
+    assert(backend->stats().counter("mapped_files") == 0);
+
+    ::close(fd);
+    ::unlink(kFilename);
+
+    std::cout << "[mmap_backend_test] test_reads_and_writes PASSED\n";
+}
+
+void test_decode_and_errors() {
+    using namespace ds;
+
+    set_error_callback([](const ErrorContext&) {});
+    const int fd = create_file(kFilename, make_contents(kFileSize));
+    Queue queue(make_mmap_backend());
+
+    std::vector<char> upper(27, '\0'), gdeflate(26), gpu(8);
+    Request up = make_read(fd, 0, 26, upper.data());
+    up.compression = Compression::FakeUppercase;
+    queue.enqueue(up);
+
+    Request gd = make_read(fd, 0, gdeflate.size(), gdeflate.data());
+    gd.compression = Compression::GDeflate;
+    gd.user_tag = 1;
+    queue.enqueue(gd);
+
+    Request bad_fd = make_read(-1, 0, 8, gpu.data());
+    bad_fd.user_tag = 2;
+    queue.enqueue(bad_fd);
+
+    Request gpu_req = make_read(fd, 0, 8, nullptr);
+    gpu_req.dst_memory = RequestMemory::Gpu;
+    gpu_req.user_tag = 3;
+    queue.enqueue(gpu_req);
+
+    // Pipes cannot be mapped.
+    int fds[2];
+    assert(::pipe(fds) == 0);
+    Request not_mappable = make_read(fds[0], 0, 8, gpu.data());
+    not_mappable.user_tag = 4;
+    queue.enqueue(not_mappable);
+
+    queue.submit_all();
+    queue.wait_all();
+
+    for (const auto& req : queue.take_completed()) {
+        switch (req.user_tag) {
+        case 0:
+            assert(req.status == RequestStatus::Ok);
+            assert(std::string(upper.data()) == "ABCDEFGHIJKLMNOPQRSTUVWXYZ");
+            break;
+        case 1:
+            assert(req.status == RequestStatus::IoError);
+            assert(req.errno_value == ENOTSUP);
+            break;
+        case 2:
+            assert(req.errno_value == EBADF);
+            break;
+        case 3:
+            assert(req.errno_value == EINVAL);
+            break;
+        default:
+            assert(req.status == RequestStatus::IoError);
+            assert(req.errno_value != 0);
+            break;
+        }
+    }
+
+    ::close(fds[0]);
+    ::close(fds[1]);
+    ::close(fd);
+    ::unlink(kFilename);
+    set_error_callback(nullptr);
+
+    std::cout << "[mmap_backend_test] test_decode_and_errors PASSED\n";
+}
+
+void test_sequential_advice() {
+    using namespace ds;
+
+    const std::vector<char> contents = make_contents(kFileSize);
+    const int fd = create_file(kFilename, contents);
+
+    MmapBackendConfig config;
+    config.readahead_bytes = 16 * 1024;
+    auto backend = make_mmap_backend(config);
+    Queue queue(backend);
+
+    // Inline execution completes each read in order, so the stream is
+    // strictly back-to-back.
+    constexpr std::size_t kChunk = 1024;
+    std::vector<char> buffer(kFileSize);
+    for (std::size_t off = 0; off < kFileSize; off += kChunk) {
+        queue.enqueue(make_read(fd, off, kChunk, buffer.data() + off));
+    }
+    queue.submit_all();
+    queue.wait_all();
+    assert(buffer == contents);
+
+    BackendStats stats = backend->stats();
+    assert(stats.counter("advise_sequential") == 1);
+    assert(stats.counter("advise_willneed") >= 1);
+
+    // A jump back ends the stream.
+    std::vector<char> one(kChunk);
+    queue.enqueue(make_read(fd, 0, kChunk, one.data()));
+    queue.submit_all();
+    queue.wait_all();
+    stats = backend->stats();
+    assert(stats.counter("advise_normal") == 1);
+
+    ::close(fd);
+    ::unlink(kFilename);
+
+    std::cout << "[mmap_backend_test] test_sequential_advice PASSED\n";
+}
+
+void test_inline_with_caps_and_dependencies() {
+    using namespace ds;
+
+    const std::vector<char> contents = make_contents(kFileSize);
+    const int fd = create_file(kFilename, contents);
+
+    QueueConfig config;
+    config.max_in_flight_requests = 2;
+    Queue queue(make_mmap_backend(), config);
+
+    constexpr std::size_t kReads = 64;
+    std::vector<char> buffer(kReads * 256);
+    RequestId previous = 0;
+    for (std::size_t i = 0; i < kReads; ++i) {
+        Request req = make_read(fd, i * 256, 256, buffer.data() + i * 256);
+        if (i % 2 == 0) {
+            previous = queue.enqueue_tracked(req);
+        } else {
+            queue.enqueue_tracked(req, {previous});
+        }
+    }
+    queue.submit_all();
+    queue.wait_all();
+
+    assert(queue.take_completed().size() == kReads);
+    assert(std::memcmp(buffer.data(), contents.data(), buffer.size()) == 0);
+    assert(queue.stats().peak_in_flight <= 2);
+
+    ::close(fd);
+    ::unlink(kFilename);
+
+    std::cout << "[mmap_backend_test] test_inline_with_caps_and_dependencies PASSED\n";
+}
+
+void test_worker_pool() {
+    using namespace ds;
+
+    const std::vector<char> contents = make_contents(kFileSize);
+    const int fd = create_file(kFilename, contents);
+
+    MmapBackendConfig config;
+    config.worker_count = 4;
+    config.populate_max_bytes = 0;
+    auto backend = make_mmap_backend(config);
+    Queue queue(backend);
+
+    constexpr std::size_t kReads = 512;
+    std::vector<char> buffer(kReads * 128);
+    for (std::size_t i = 0; i < kReads; ++i) {
+        const std::uint64_t offset = (i * 7919 % (kFileSize / 128)) * 128;
+        Request req = make_read(fd, offset, 128, buffer.data() + i * 128);
+        req.user_tag = offset;
+        queue.enqueue(req);
+    }
+    queue.submit_all();
+    queue.wait_all();
+
+    const auto done = queue.take_completed();
+    assert(done.size() == kReads);
+    for (const auto& req : done) {
+        assert(req.status == RequestStatus::Ok);
+        assert(std::memcmp(req.dst, contents.data() + req.user_tag, 128) == 0);
+    }
+    const BackendStats stats = backend->stats();
+    assert(stats.counter("workers") == 4);
+    assert(stats.counter("maps") >= 1);
+    assert(stats.counter("populated_maps") == 0);
+
+    ::close(fd);
+    ::unlink(kFilename);
+
+    std::cout << "[mmap_backend_test] test_worker_pool PASSED\n";
+}
+
+} // namespace
+
+int main() {
+    test_reads_and_writes();
+    test_decode_and_errors();
+    test_sequential_advice();
+    test_inline_with_caps_and_dependencies();
+    test_worker_pool();
+
+    std::cout << "[mmap_backend_test] ALL TESTS PASSED\n";
+    return 0;
+}
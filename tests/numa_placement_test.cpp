@@ -0,0 +1,185 @@
+// SPDX-License-Identifier: Apache-2.0
+// NUMA placement test.
+//
+// This test verifies:
+//  - numa_topology() reports at least one node, with ascending unique ids
+//    and a non-empty, ascending CPU list on every node
+//  - workers_per_node starts that many workers per node on the CPU and mmap
+//    backends (the latter even with worker_count = 0) and pins them
+//  - pin_workers spreads worker_count workers over the nodes
+//  - the default placement leaves workers unpinned in a single group
+//  - pinned workers run requests only on their node's CPUs, and reads
+//    through placed backends (routed or not) return the right bytes
+
+#include "ds_runtime.hpp"
+#include "ds_runtime_mmap.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <sched.h>
+#include <unistd.h>
+
+namespace {
+
+const char* kFilename = "numa_placement_test.bin";
+constexpr std::size_t kChunk = 4096;
+constexpr std::size_t kChunks = 16;
+
+std::uint64_t counter(const ds::BackendStats& stats, const std::string& name) {
+    for (const auto& c : stats.counters) {
+        if (c.name == name) {
+            return c.value;
+        }
+    }
+    assert(false && "missing counter");
+    return 0;
+}
+
+// True if the calling thread's affinity lies within one node's CPUs.
+bool affinity_within_one_node() {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (::sched_getaffinity(0, sizeof(set), &set) != 0) {
+        return false;
+    }
+    for (const auto& node : ds::numa_topology()) {
+        bool inside = true;
+        for (std::size_t cpu = 0; cpu < CPU_SETSIZE && inside; ++cpu) {
+            if (CPU_ISSET(cpu, &set)) {
+                inside = std::binary_search(node.cpus.begin(), node.cpus.end(),
+                                            static_cast<int>(cpu));
+            }
+        }
+        if (inside) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Read every chunk through @p backend into separate buffers and check the
+// contents. Returns the number of completions that ran on a thread pinned
+// within a single node.
+std::size_t read_all(ds::Backend& backend, int fd) {
+    std::vector<std::vector<char>> buffers(kChunks, std::vector<char>(kChunk));
+    std::atomic<std::size_t> done{0};
+    std::atomic<std::size_t> pinned{0};
+    for (std::size_t i = 0; i < kChunks; ++i) {
+        ds::Request req;
+        req.fd = fd;
+        req.offset = i * kChunk;
+        req.size = kChunk;
+        req.dst = buffers[i].data();
+        backend.submit(req, [&](ds::Request& r) {
+            assert(r.status == ds::RequestStatus::Ok);
+            assert(r.bytes_transferred == kChunk);
+            if (affinity_within_one_node()) {
+                pinned.fetch_add(1);
+            }
+            done.fetch_add(1);
+        });
+    }
+    while (done.load() != kChunks) {
+        std::this_thread::yield();
+    }
+    for (std::size_t i = 0; i < kChunks; ++i) {
+        assert(buffers[i][0] == static_cast<char>('A' + i));
+        assert(buffers[i][kChunk - 1] == static_cast<char>('A' + i));
+    }
+    return pinned.load();
+}
+
+void test_topology() {
+    const auto& nodes = ds::numa_topology();
+    assert(!nodes.empty());
+    for (std::size_t i = 0; i < nodes.size(); ++i) {
+        assert(nodes[i].id >= 0);
+        assert(i == 0 || nodes[i - 1].id < nodes[i].id);
+        assert(!nodes[i].cpus.empty());
+        assert(std::is_sorted(nodes[i].cpus.begin(), nodes[i].cpus.end()));
+    }
+    // Cached: the same vector every time.
+    assert(&ds::numa_topology() == &nodes);
+    std::cout << "[numa_placement_test] test_topology PASSED (" << nodes.size()
+              << " node(s))\n";
+}
+
+void test_cpu_placement(int fd) {
+    const std::size_t node_count = ds::numa_topology().size();
+
+    ds::CpuBackendConfig config;
+    config.worker_count = 1; // Overridden by workers_per_node.
+    config.placement.workers_per_node = 2;
+    auto backend = ds::make_cpu_backend(config);
+    assert(read_all(*backend, fd) == kChunks);
+    ds::BackendStats stats = backend->stats();
+    assert(counter(stats, "workers") == 2 * node_count);
+    assert(counter(stats, "numa_groups") == node_count);
+    assert(counter(stats, "pinned_workers") <= 2 * node_count);
+
+    ds::CpuBackendConfig spread;
+    spread.worker_count = 3;
+    spread.placement.pin_workers = true;
+    spread.placement.route_by_locality = false;
+    backend = ds::make_cpu_backend(spread);
+    assert(read_all(*backend, fd) == kChunks);
+    stats = backend->stats();
+    assert(counter(stats, "workers") == 3);
+    assert(counter(stats, "numa_groups") == std::min<std::size_t>(3, node_count));
+
+    backend = ds::make_cpu_backend(2);
+    read_all(*backend, fd);
+    stats = backend->stats();
+    assert(counter(stats, "workers") == 2);
+    assert(counter(stats, "numa_groups") == 1);
+    assert(counter(stats, "pinned_workers") == 0);
+
+    std::cout << "[numa_placement_test] test_cpu_placement PASSED\n";
+}
+
+void test_mmap_placement(int fd) {
+    const std::size_t node_count = ds::numa_topology().size();
+
+    ds::MmapBackendConfig config;
+    config.worker_count = 0;
+    config.placement.workers_per_node = 1;
+    auto backend = ds::make_mmap_backend(config);
+    assert(read_all(*backend, fd) == kChunks);
+    const ds::BackendStats stats = backend->stats();
+    assert(counter(stats, "workers") == node_count);
+    assert(counter(stats, "numa_groups") == node_count);
+    backend->release_file(fd);
+
+    std::cout << "[numa_placement_test] test_mmap_placement PASSED\n";
+}
+
+} // namespace
+
+int main() {
+    std::vector<char> contents(kChunk * kChunks);
+    for (std::size_t i = 0; i < kChunks; ++i) {
+        std::memset(contents.data() + i * kChunk, 'A' + static_cast<int>(i), kChunk);
+    }
+    const int fd = ::open(kFilename, O_CREAT | O_RDWR | O_TRUNC, 0644);
+    assert(fd >= 0);
+    const ssize_t wr = ::write(fd, contents.data(), contents.size());
+    assert(wr == static_cast<ssize_t>(contents.size()));
+
+    test_topology();
+    test_cpu_placement(fd);
+    test_mmap_placement(fd);
+
+    ::close(fd);
+    ::unlink(kFilename);
+    std::cout << "[numa_placement_test] ALL TESTS PASSED\n";
+    return 0;
+}
@@ -0,0 +1,350 @@
+// SPDX-License-Identifier: Apache-2.0
+// Readahead prefetcher test.
+//
+// This test verifies:
+//  - A sequential consumer is served from prefetches after the trigger,
+//    each chunk is read from the backend once, and readahead stops at
+//    the end of the file
+//  - Strided Runtime reads through a Queue are detected and answered
+//    with prefetched buffers
+//  - A read that catches up with a prefetch in flight waits for it and
+//    doubles the read-ahead depth
+//  - A pattern break drops the prefetched results and halves the depth
+//  - Writes drop stale prefetches
+//  - The budget bounds buffered bytes, and the destructor waits for
+//    prefetches in flight
+
+#include "ds_runtime.hpp"
+#include "ds_runtime_prefetch.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cerrno>
+#include <cstdint>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace {
+
+const char* kFilename = "prefetch_test.bin";
+constexpr std::size_t kChunk = 4096;
+constexpr std::size_t kChunks = 32;
+
+char chunk_byte(std::size_t chunk) {
+    return static_cast<char>('A' + chunk % 26);
+}
+
+/// Backend executing reads and writes with pread()/pwrite(), inline by
+/// default or held until release() to keep them in flight.
+class ScriptBackend final : public ds::Backend {
+public:
+    explicit ScriptBackend(bool hold = false) : hold_(hold) {}
+
+    void submit(ds::Request req, ds::CompletionCallback on_complete) override {
+        {
+            std::lock_guard<std::mutex> lock(mtx_);
+            ++submitted_;
+            if (hold_) {
+                held_.emplace_back(std::move(req), std::move(on_complete));
+                return;
+            }
+        }
+        run(req, on_complete);
+    }
+
+    /// Run the @p count oldest held requests (all by default).
+    void release(std::size_t count = SIZE_MAX) {
+        std::vector<std::pair<ds::Request, ds::CompletionCallback>> held;
+        {
+            std::lock_guard<std::mutex> lock(mtx_);
+            count = std::min(count, held_.size());
+            held.assign(std::make_move_iterator(held_.begin()),
+                        std::make_move_iterator(held_.begin() + static_cast<std::ptrdiff_t>(count)));
+            held_.erase(held_.begin(), held_.begin() + static_cast<std::ptrdiff_t>(count));
+        }
+        for (auto& [req, cb] : held) {
+            run(req, cb);
+        }
+    }
+
+    std::size_t submitted() {
+        std::lock_guard<std::mutex> lock(mtx_);
+        return submitted_;
+    }
+
+private:
+    static void run(ds::Request& req, const ds::CompletionCallback& cb) {
+        const ssize_t n = req.op == ds::RequestOp::Write
+            ? ::pwrite(req.fd, req.src, req.size, static_cast<off_t>(req.offset))
+            : ::pread(req.fd, req.dst, req.size, static_cast<off_t>(req.offset));
+        req.status = n < 0 ? ds::RequestStatus::IoError : ds::RequestStatus::Ok;
+        req.errno_value = n < 0 ? errno : 0;
+        req.bytes_transferred = n < 0 ? 0 : static_cast<std::size_t>(n);
+        cb(req);
+    }
+
+    const bool hold_;
+    std::mutex mtx_;
+    std::vector<std::pair<ds::Request, ds::CompletionCallback>> held_;
+    std::size_t submitted_ = 0;
+};
+
+/// Read chunk @p chunk into @p dst through @p backend and wait for it.
+ds::Request read_chunk(ds::Backend& backend, int fd, std::size_t chunk, void* dst) {
+    ds::Request req;
+    req.fd = fd;
+    req.offset = chunk * kChunk;
+    req.size = kChunk;
+    req.dst = dst;
+    ds::Request out;
+    bool done = false;
+    backend.submit(req, [&](ds::Request& r) {
+        out = r;
+        done = true;
+    });
+    assert(done);
+    return out;
+}
+
+void test_sequential(int fd) {
+    auto inner = std::make_shared<ScriptBackend>();
+    auto prefetcher = ds::make_prefetching_backend(inner);
+    assert(prefetcher->provides_buffers());
+
+    std::vector<char> buffer(kChunk);
+    for (std::size_t i = 0; i < kChunks; ++i) {
+        const ds::Request r = read_chunk(*prefetcher, fd, i, buffer.data());
+        assert(r.status == ds::RequestStatus::Ok);
+        assert(r.bytes_transferred == kChunk);
+        assert(buffer[0] == chunk_byte(i) && buffer[kChunk - 1] == chunk_byte(i));
+    }
+
+    const ds::PrefetchStats stats = prefetcher->prefetch_stats();
+    assert(stats.misses == 3); // Chunks 0-2 establish the stride.
+    assert(stats.hits == kChunks - 3);
+    assert(stats.issued == kChunks - 3);
+    assert(stats.wasted == 0);
+    assert(stats.bytes_buffered == 0);
+    assert(stats.streams == 1);
+    assert(inner->submitted() == kChunks); // Nothing past the end.
+
+    assert(prefetcher->stats().counter("prefetch_hits") == kChunks - 3);
+
+    std::cout << "[prefetch_test] test_sequential PASSED\n";
+}
+
+void test_strided_queue(int fd) {
+    auto inner = std::make_shared<ScriptBackend>();
+    auto prefetcher = ds::make_prefetching_backend(inner);
+    ds::Queue queue(prefetcher);
+
+    // Every third chunk, one at a time as a streaming consumer would.
+    std::size_t reads = 0;
+    for (std::size_t i = 0; i < kChunks; i += 3, ++reads) {
+        ds::Request req;
+        req.fd = fd;
+        req.offset = i * kChunk;
+        req.size = kChunk;
+        req.dst_memory = ds::RequestMemory::Runtime;
+        queue.enqueue(req);
+        queue.submit_all();
+        queue.wait_all();
+        auto done = queue.take_completed();
+        assert(done.size() == 1);
+        assert(done[0].status == ds::RequestStatus::Ok);
+        assert(done[0].buffer.size() == kChunk);
+        assert(static_cast<char>(done[0].buffer.data()[0]) == chunk_byte(i));
+    }
+
+    const ds::PrefetchStats stats = prefetcher->prefetch_stats();
+    assert(stats.misses == 3);
+    assert(stats.hits == reads - 3);
+    assert(inner->submitted() == reads);
+
+    std::cout << "[prefetch_test] test_strided_queue PASSED\n";
+}
+
+void test_late_hit(int fd) {
+    auto inner = std::make_shared<ScriptBackend>(/*hold=*/true);
+    auto prefetcher = ds::make_prefetching_backend(inner);
+
+    std::vector<char> buffer(kChunk);
+    const auto submit = [&](std::size_t chunk, bool& done) {
+        ds::Request req;
+        req.fd = fd;
+        req.offset = chunk * kChunk;
+        req.size = kChunk;
+        req.dst = buffer.data();
+        prefetcher->submit(req, [&done](ds::Request& r) {
+            assert(r.status == ds::RequestStatus::Ok);
+            done = true;
+        });
+    };
+
+    for (std::size_t i = 0; i < 3; ++i) {
+        bool done = false;
+        submit(i, done);
+        inner->release(1); // Only the read itself.
+        assert(done);
+    }
+    // Chunk 2 triggered prefetches of 3 and 4, still held by the backend.
+    assert(inner->submitted() == 5);
+
+    bool done = false;
+    submit(3, done);
+    assert(!done);
+    // Waiting doubled the depth to 4: chunks 5-7 were added.
+    assert(inner->submitted() == 8);
+    inner->release();
+    assert(done);
+    assert(buffer[0] == chunk_byte(3));
+
+    const ds::PrefetchStats stats = prefetcher->prefetch_stats();
+    assert(stats.late_hits == 1);
+    assert(stats.issued == 5);
+    assert(stats.bytes_buffered == 4 * kChunk); // 4-7 ready and unread.
+
+    std::cout << "[prefetch_test] test_late_hit PASSED\n";
+}
+
+void test_pattern_break(int fd) {
+    auto inner = std::make_shared<ScriptBackend>();
+    auto prefetcher = ds::make_prefetching_backend(inner);
+
+    std::vector<char> buffer(kChunk);
+    for (std::size_t i = 0; i < 6; ++i) {
+        read_chunk(*prefetcher, fd, i, buffer.data());
+    }
+    assert(prefetcher->prefetch_stats().bytes_buffered == 2 * kChunk); // 6 and 7.
+
+    // Seek: the read-ahead of 6 and 7 is dropped.
+    read_chunk(*prefetcher, fd, 20, buffer.data());
+    ds::PrefetchStats stats = prefetcher->prefetch_stats();
+    assert(stats.wasted == 2);
+    assert(stats.bytes_buffered == 0);
+
+    // The new run prefetches at the halved depth of 1.
+    read_chunk(*prefetcher, fd, 21, buffer.data());
+    const std::size_t before = inner->submitted();
+    read_chunk(*prefetcher, fd, 22, buffer.data());
+    assert(inner->submitted() == before + 2); // The miss plus one prefetch.
+    stats = prefetcher->prefetch_stats();
+    assert(stats.bytes_buffered == kChunk);
+
+    const ds::Request r = read_chunk(*prefetcher, fd, 23, buffer.data());
+    assert(r.status == ds::RequestStatus::Ok);
+    assert(buffer[0] == chunk_byte(23));
+    assert(prefetcher->prefetch_stats().hits == 4); // Chunks 3-5 and 23.
+
+    std::cout << "[prefetch_test] test_pattern_break PASSED\n";
+}
+
+void test_write_invalidates(int fd) {
+    auto inner = std::make_shared<ScriptBackend>();
+    auto prefetcher = ds::make_prefetching_backend(inner);
+
+    std::vector<char> buffer(kChunk);
+    for (std::size_t i = 0; i < 4; ++i) {
+        read_chunk(*prefetcher, fd, i, buffer.data());
+    }
+    assert(prefetcher->prefetch_stats().bytes_buffered == 2 * kChunk); // 4 and 5.
+
+    std::vector<char> replacement(kChunk, 'z');
+    ds::Request write;
+    write.op = ds::RequestOp::Write;
+    write.fd = fd;
+    write.offset = 4 * kChunk;
+    write.size = kChunk;
+    write.src = replacement.data();
+    bool written = false;
+    prefetcher->submit(write, [&written](ds::Request& r) {
+        assert(r.status == ds::RequestStatus::Ok);
+        written = true;
+    });
+    assert(written);
+    assert(prefetcher->prefetch_stats().bytes_buffered == 0);
+
+    read_chunk(*prefetcher, fd, 4, buffer.data());
+    assert(buffer[0] == 'z');
+
+    // Restore the chunk for the remaining tests.
+    std::vector<char> original(kChunk, chunk_byte(4));
+    const ssize_t n = ::pwrite(fd, original.data(), kChunk, 4 * kChunk);
+    assert(n == static_cast<ssize_t>(kChunk));
+
+    std::cout << "[prefetch_test] test_write_invalidates PASSED\n";
+}
+
+void test_budget_and_shutdown(int fd) {
+    auto inner = std::make_shared<ScriptBackend>(/*hold=*/true);
+    ds::PrefetchConfig config;
+    config.buffer_bytes = 3 * kChunk;
+    config.initial_depth = 8;
+    auto prefetcher = ds::make_prefetching_backend(inner, config);
+
+    std::vector<char> buffer(kChunk);
+    std::atomic<std::size_t> completed{0};
+    for (std::size_t i = 0; i < 3; ++i) {
+        ds::Request req;
+        req.fd = fd;
+        req.offset = i * kChunk;
+        req.size = kChunk;
+        req.dst = buffer.data();
+        prefetcher->submit(req, [&completed](ds::Request&) { ++completed; });
+        if (i < 2) {
+            inner->release();
+        }
+    }
+    assert(completed == 2);
+    // Depth 8, but only three chunks fit the budget.
+    assert(prefetcher->prefetch_stats().issued == 3);
+    assert(prefetcher->prefetch_stats().bytes_buffered == 3 * kChunk);
+
+    // Drop the last reference while prefetches are still held: the
+    // destructor must wait for them.
+    std::thread releaser([&inner] {
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        inner->release();
+    });
+    prefetcher.reset();
+    releaser.join();
+    assert(completed == 3);
+
+    std::cout << "[prefetch_test] test_budget_and_shutdown PASSED\n";
+}
+
+} // namespace
+
+int main() {
+    std::vector<char> contents(kChunk * kChunks);
+    for (std::size_t i = 0; i < kChunks; ++i) {
+        std::memset(contents.data() + i * kChunk, chunk_byte(i), kChunk);
+    }
+    const int fd = ::open(kFilename, O_CREAT | O_RDWR | O_TRUNC, 0644);
+    assert(fd >= 0);
+    const ssize_t wr = ::write(fd, contents.data(), contents.size());
+    assert(wr == static_cast<ssize_t>(contents.size()));
+
+    test_sequential(fd);
+    test_strided_queue(fd);
+    test_late_hit(fd);
+    test_pattern_break(fd);
+    test_write_invalidates(fd);
+    test_budget_and_shutdown(fd);
+
+    ::close(fd);
+    ::unlink(kFilename);
+    std::cout << "[prefetch_test] ALL TESTS PASSED\n";
+    return 0;
+}
@@ -0,0 +1,166 @@
+// SPDX-License-Identifier: Apache-2.0
+// Queue and backend telemetry test.
+//
+// This test verifies:
+//  - LatencyHistogram buckets stay within their relative-error bound and
+//    percentiles come out of the right bucket
+//  - Queue::stats() counts submissions, completions, failures, bytes and
+//    per-op / per-compression totals
+//  - Every completion lands in the latency histograms
+//  - The CPU backend reports its own counters through QueueStats::backend
+//  - throughput_between() derives rates from two snapshots
+
+#include "ds_runtime.hpp"
+
+#include <cassert>
+#include <cstdint>
+#include <iostream>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace {
+
+void test_histogram_buckets() {
+    using ds::LatencyHistogram;
+
+    // Every bucket's upper bound maps back to itself, and the next value
+    // starts the next bucket.
+    for (std::size_t i = 0; i + 1 < LatencyHistogram::kBucketCount; ++i) {
+        const std::uint64_t upper = LatencyHistogram::bucket_upper_ns(i);
+        assert(LatencyHistogram::bucket_index(upper) == i);
+        assert(LatencyHistogram::bucket_index(upper + 1) == i + 1);
+    }
+
+    // Relative error bound of 1 / kSubBuckets.
+    for (std::uint64_t v : {9ull, 100ull, 12'345ull, 1'000'000ull, 987'654'321ull}) {
+        const std::uint64_t upper =
+            LatencyHistogram::bucket_upper_ns(LatencyHistogram::bucket_index(v));
+        assert(upper >= v);
+        assert(upper - v <= v / LatencyHistogram::kSubBuckets);
+    }
+    assert(LatencyHistogram::bucket_index(~std::uint64_t{0}) ==
+           LatencyHistogram::kBucketCount - 1);
+
+    LatencyHistogram h;
+    assert(h.percentile_ns(50) == 0);
+    for (std::uint64_t v = 1; v <= 100; ++v) {
+        const std::uint64_t ns = v * 1000;
+        ++h.counts[LatencyHistogram::bucket_index(ns)];
+        ++h.count;
+        h.sum_ns += ns;
+        h.max_ns = ns;
+    }
+    const std::uint64_t p50 = h.percentile_ns(50);
+    assert(p50 >= 50'000 && p50 <= 50'000 + 50'000 / 8);
+    assert(h.percentile_ns(100) == 100'000);
+    assert(h.percentile_ns(0) >= 1000);
+    assert(h.mean_ns() == 50'500.0);
+
+    LatencyHistogram merged;
+    merged.merge(h);
+    merged.merge(h);
+    assert(merged.count == 200);
+    assert(merged.percentile_ns(50) == p50);
+
+    std::cout << "[queue_stats_test] test_histogram_buckets PASSED\n";
+}
+
+void test_queue_and_backend_stats() {
+    using namespace ds;
+
+    set_error_callback([](const ErrorContext&) {});
+
+    const char* filename = "queue_stats_test.bin";
+    std::vector<char> contents(4096, 'a');
+    const int fd_write = ::open(filename, O_CREAT | O_WRONLY | O_TRUNC, 0644);
+    assert(fd_write >= 0);
+    const ssize_t wr = ::write(fd_write, contents.data(), contents.size());
+    assert(wr == static_cast<ssize_t>(contents.size()));
+    ::close(fd_write);
+
+    const int fd_read = ::open(filename, O_RDONLY);
+    assert(fd_read >= 0);
+
+    Queue queue(make_cpu_backend(2));
+    const QueueStats before = queue.stats();
+    assert(before.completed == 0);
+    assert(before.backend.backend == "cpu");
+
+    constexpr std::size_t kReads = 64;
+    constexpr std::size_t kChunk = 32;
+    std::vector<char> buffer(kReads * kChunk + 1);
+    for (std::size_t i = 0; i < kReads; ++i) {
+        Request req;
+        req.fd = fd_read;
+        req.offset = i * kChunk;
+        req.size = kChunk;
+        req.dst = buffer.data() + i * kChunk;
+        if (i % 4 == 0) {
+            req.compression = Compression::FakeUppercase;
+        }
+        queue.enqueue(req);
+    }
+    Request bad;
+    bad.fd = -1;
+    bad.size = 8;
+    bad.dst = buffer.data();
+    queue.enqueue(bad);
+
+    assert(queue.stats().pending == kReads + 1);
+    queue.submit_all();
+    queue.wait_all();
+
+    const QueueStats after = queue.stats();
+    assert(after.pending == 0);
+    assert(after.held_back == 0);
+    assert(after.in_flight == 0);
+    assert(after.in_flight_bytes == 0);
+    assert(after.peak_in_flight >= 1);
+    assert(after.submitted == kReads + 1);
+    assert(after.completed == kReads + 1);
+    assert(after.failed == 1);
+    assert(after.bytes_transferred == kReads * kChunk);
+    assert(after.completed_by_op[static_cast<std::size_t>(RequestOp::Read)] == kReads + 1);
+    assert(after.completed_by_op[static_cast<std::size_t>(RequestOp::Write)] == 0);
+    assert(after.completed_by_compression[static_cast<std::size_t>(Compression::FakeUppercase)] ==
+           kReads / 4);
+    assert(after.completed_by_compression[static_cast<std::size_t>(Compression::None)] ==
+           kReads - kReads / 4 + 1);
+
+    // The CPU backend stamps start times, so both histograms see everything.
+    assert(after.submit_to_start.count == kReads + 1);
+    assert(after.start_to_complete.count == kReads + 1);
+    assert(after.start_to_complete.percentile_ns(50) <=
+           after.start_to_complete.percentile_ns(99));
+    assert(after.start_to_complete.percentile_ns(100) == after.start_to_complete.max_ns);
+
+    assert(after.backend.submitted == kReads + 1);
+    assert(after.backend.completed == kReads + 1);
+    assert(after.backend.failed == 1);
+    assert(after.backend.bytes_transferred == kReads * kChunk);
+    assert(after.backend.counter("workers") == 2);
+    assert(after.backend.counter("no_such_counter") == 0);
+
+    const Throughput rate = throughput_between(before, after);
+    assert(rate.requests_per_second > 0.0);
+    assert(rate.bytes_per_second > 0.0);
+    assert(throughput_between(after, before).requests_per_second == 0.0);
+
+    ::close(fd_read);
+    ::unlink(filename);
+    set_error_callback(nullptr);
+
+    std::cout << "[queue_stats_test] test_queue_and_backend_stats PASSED\n";
+}
+
+} // namespace
+
+int main() {
+    test_histogram_buckets();
+    test_queue_and_backend_stats();
+
+    std::cout << "[queue_stats_test] ALL TESTS PASSED\n";
+    return 0;
+}
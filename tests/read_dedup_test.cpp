@@ -0,0 +1,251 @@
+// SPDX-License-Identifier: Apache-2.0
+// Read deduplication test.
+//
+// This test verifies:
+//  - With QueueConfig::deduplicate_reads, identical reads in flight at the
+//    same time reach the backend once, across descriptors for the same
+//    file, and every requester gets the bytes (host copies and shared
+//    Runtime buffers alike)
+//  - Reads of other ranges or compression modes are not merged
+//  - A failed leader fails every follower with the same errno
+//  - Tracked requests and Records mode complete through the fan-out
+//  - Without the option every read is forwarded
+
+#include "ds_runtime.hpp"
+
+#include <cassert>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace {
+
+const char* kFilename = "read_dedup_test.bin";
+constexpr std::size_t kChunk = 4096;
+constexpr std::size_t kChunks = 4;
+
+/// Backend that holds every request until release(), then executes them
+/// with pread() on the releasing thread. Optionally fails them all.
+class HoldBackend final : public ds::Backend {
+public:
+    void submit(ds::Request req, ds::CompletionCallback on_complete) override {
+        std::lock_guard<std::mutex> lock(mtx_);
+        held_.emplace_back(std::move(req), std::move(on_complete));
+        ++submitted_;
+    }
+
+    void release(int fail_errno = 0) {
+        std::vector<std::pair<ds::Request, ds::CompletionCallback>> held;
+        {
+            std::lock_guard<std::mutex> lock(mtx_);
+            held.swap(held_);
+        }
+        for (auto& [req, cb] : held) {
+            ssize_t n = fail_errno != 0
+                ? -1
+                : ::pread(req.fd, req.dst, req.size, static_cast<off_t>(req.offset));
+            req.status = n < 0 ? ds::RequestStatus::IoError : ds::RequestStatus::Ok;
+            req.errno_value = n < 0 ? (fail_errno != 0 ? fail_errno : errno) : 0;
+            req.bytes_transferred = n < 0 ? 0 : static_cast<std::size_t>(n);
+            cb(req);
+        }
+    }
+
+    std::size_t submitted() {
+        std::lock_guard<std::mutex> lock(mtx_);
+        return submitted_;
+    }
+
+private:
+    std::mutex mtx_;
+    std::vector<std::pair<ds::Request, ds::CompletionCallback>> held_;
+    std::size_t submitted_ = 0;
+};
+
+ds::Request make_read(int fd, std::size_t chunk, void* dst) {
+    ds::Request req;
+    req.fd = fd;
+    req.offset = chunk * kChunk;
+    req.size = kChunk;
+    req.dst = dst;
+    req.dst_memory = dst ? ds::RequestMemory::Host : ds::RequestMemory::Runtime;
+    req.user_tag = chunk;
+    return req;
+}
+
+ds::QueueConfig dedup_config() {
+    ds::QueueConfig config;
+    config.deduplicate_reads = true;
+    return config;
+}
+
+void test_fan_out(int fd, int second_fd) {
+    using namespace ds;
+
+    auto backend = std::make_shared<HoldBackend>();
+    Queue queue(backend, dedup_config());
+
+    constexpr std::size_t kCopies = 6;
+    std::vector<std::vector<char>> buffers(kCopies, std::vector<char>(kChunk, 0));
+    for (std::size_t i = 0; i < kCopies; ++i) {
+        // Alternate descriptors: both name the same file.
+        queue.enqueue(make_read(i % 2 ? second_fd : fd, 1, buffers[i].data()));
+    }
+    queue.enqueue(make_read(fd, 1, nullptr)); // Runtime follower of a host leader.
+    std::vector<char> other(kChunk);
+    queue.enqueue(make_read(fd, 2, other.data())); // Different range.
+    Request upper = make_read(fd, 1, nullptr);
+    upper.compression = Compression::FakeUppercase; // Different result.
+    queue.enqueue(upper);
+    queue.submit_all();
+
+    // Second wave while the first is in flight joins it too.
+    std::vector<char> late(kChunk);
+    queue.enqueue(make_read(fd, 1, late.data()));
+    queue.submit_all();
+    assert(backend->submitted() == 3);
+
+    backend->release();
+    queue.wait_all();
+
+    for (const auto& buffer : buffers) {
+        assert(buffer[0] == 'b' && buffer[kChunk - 1] == 'b');
+    }
+    assert(late[0] == 'b');
+    assert(other[0] == 'c');
+    std::size_t runtime_reads = 0;
+    for (const Request& r : queue.take_completed()) {
+        assert(r.status == RequestStatus::Ok);
+        assert(r.bytes_transferred == kChunk);
+        if (r.dst_memory == RequestMemory::Runtime) {
+            assert(r.buffer.size() == kChunk);
+            assert(static_cast<char>(r.buffer.data()[0]) == 'b');
+            ++runtime_reads;
+        }
+    }
+    assert(runtime_reads == 2);
+
+    const QueueStats stats = queue.stats();
+    assert(stats.submitted == 3);
+    assert(stats.deduplicated == 7); // 5 host copies, the Runtime read, the late read.
+    assert(stats.completed == 10);
+    assert(stats.in_flight == 0);
+
+    std::cout << "[read_dedup_test] test_fan_out PASSED\n";
+}
+
+void test_shared_runtime_buffer(int fd) {
+    using namespace ds;
+
+    auto backend = std::make_shared<HoldBackend>();
+    QueueConfig config = dedup_config();
+    config.completion_mode = CompletionMode::Records;
+    Queue queue(backend, config);
+
+    for (int i = 0; i < 3; ++i) {
+        queue.enqueue(make_read(fd, 3, nullptr));
+    }
+    queue.submit_all();
+    assert(backend->submitted() == 1);
+    backend->release();
+    queue.wait_all();
+
+    CompletionRecord records[4];
+    const std::size_t n = queue.poll_completions(records, 4);
+    assert(n == 3);
+    for (std::size_t i = 0; i < n; ++i) {
+        assert(records[i].status == RequestStatus::Ok);
+        assert(records[i].user_tag == 3);
+        assert(records[i].buffer.size() == kChunk);
+        // All three share the block the leader read into.
+        assert(records[i].buffer.data() == records[0].buffer.data());
+        assert(static_cast<char>(records[i].buffer.data()[0]) == 'd');
+    }
+    assert(records[0].buffer.use_count() == 3);
+
+    std::cout << "[read_dedup_test] test_shared_runtime_buffer PASSED\n";
+}
+
+void test_failure_and_graph(int fd) {
+    using namespace ds;
+
+    auto backend = std::make_shared<HoldBackend>();
+    Queue queue(backend, dedup_config());
+    ds::set_error_callback([](const ErrorContext&) {});
+
+    std::vector<char> a(kChunk), b(kChunk);
+    const RequestId first = queue.enqueue_tracked(make_read(fd, 0, a.data()));
+    const RequestId second = queue.enqueue_tracked(make_read(fd, 0, b.data()));
+    bool continuation_ran = false;
+    bool continuation_ok = true;
+    queue.then({first, second}, [&](Queue&, bool ok) {
+        continuation_ran = true;
+        continuation_ok = ok;
+    });
+    queue.submit_all();
+    assert(backend->submitted() == 1);
+    backend->release(EIO);
+    queue.wait_all();
+
+    assert(continuation_ran && !continuation_ok);
+    for (const Request& r : queue.take_completed()) {
+        assert(r.status == RequestStatus::IoError);
+        assert(r.errno_value == EIO);
+        assert(r.bytes_transferred == 0);
+    }
+    assert(queue.stats().failed == 2);
+    ds::set_error_callback(nullptr);
+
+    std::cout << "[read_dedup_test] test_failure_and_graph PASSED\n";
+}
+
+void test_disabled(int fd) {
+    using namespace ds;
+
+    auto backend = std::make_shared<HoldBackend>();
+    Queue queue(backend);
+    std::vector<std::vector<char>> buffers(3, std::vector<char>(kChunk));
+    for (auto& buffer : buffers) {
+        queue.enqueue(make_read(fd, 1, buffer.data()));
+    }
+    queue.submit_all();
+    assert(backend->submitted() == 3);
+    backend->release();
+    queue.wait_all();
+    assert(queue.stats().deduplicated == 0);
+
+    std::cout << "[read_dedup_test] test_disabled PASSED\n";
+}
+
+} // namespace
+
+int main() {
+    std::vector<char> contents(kChunk * kChunks);
+    for (std::size_t i = 0; i < kChunks; ++i) {
+        std::memset(contents.data() + i * kChunk, 'a' + static_cast<int>(i), kChunk);
+    }
+    const int fd = ::open(kFilename, O_CREAT | O_RDWR | O_TRUNC, 0644);
+    assert(fd >= 0);
+    const ssize_t wr = ::write(fd, contents.data(), contents.size());
+    assert(wr == static_cast<ssize_t>(contents.size()));
+    const int second_fd = ::open(kFilename, O_RDONLY);
+    assert(second_fd >= 0);
+
+    test_fan_out(fd, second_fd);
+    test_shared_runtime_buffer(fd);
+    test_failure_and_graph(fd);
+    test_disabled(fd);
+
+    ::close(second_fd);
+    ::close(fd);
+    ::unlink(kFilename);
+    std::cout << "[read_dedup_test] ALL TESTS PASSED\n";
+    return 0;
+}
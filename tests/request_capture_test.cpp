@@ -0,0 +1,183 @@
+// SPDX-License-Identifier: Apache-2.0
+// Request capture test.
+//
+// This test verifies:
+//  - A Queue with QueueConfig::capture records every accepted request,
+//    including dependency-released ones, with dense file ids and extents
+//  - name_file() labels files and starts a new id when an fd is reused
+//  - Captures round-trip through write_capture()/read_capture()
+//  - Malformed capture files are rejected
+
+#include "ds_runtime.hpp"
+#include "ds_runtime_capture.hpp"
+
+#include <cassert>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace {
+
+const char* kFilename = "request_capture_test.bin";
+
+void test_queue_capture() {
+    using namespace ds;
+
+    std::vector<char> contents(4096, 'c');
+    const int fd_write = ::open(kFilename, O_CREAT | O_WRONLY | O_TRUNC, 0644);
+    assert(fd_write >= 0);
+    const ssize_t wr = ::write(fd_write, contents.data(), contents.size());
+    assert(wr == static_cast<ssize_t>(contents.size()));
+    ::close(fd_write);
+
+    const int fd_a = ::open(kFilename, O_RDONLY);
+    const int fd_b = ::open(kFilename, O_RDONLY);
+    assert(fd_a >= 0 && fd_b >= 0);
+
+    auto capture = std::make_shared<RequestCapture>();
+    capture->name_file(fd_a, "assets/textures.pak");
+
+    QueueConfig config;
+    config.capture = capture;
+    Queue queue(make_cpu_backend(2), config);
+
+    std::vector<char> buffer(4096);
+    Request first;
+    first.fd = fd_a;
+    first.offset = 0;
+    first.size = 64;
+    first.dst = buffer.data();
+    const RequestId header = queue.enqueue_tracked(first);
+
+    Request dependent;
+    dependent.fd = fd_a;
+    dependent.offset = 1024;
+    dependent.size = 512;
+    dependent.dst = buffer.data() + 64;
+    dependent.compression = Compression::FakeUppercase;
+    queue.enqueue_tracked(dependent, {header});
+
+    Request other;
+    other.fd = fd_b;
+    other.offset = 128;
+    other.size = 32;
+    other.dst = buffer.data() + 1024;
+    queue.enqueue(other);
+
+    // The dependent request is recorded only once it is released.
+    assert(capture->size() == 2);
+    queue.submit_all();
+    queue.wait_all();
+    assert(capture->size() == 3);
+    assert(capture->dropped() == 0);
+
+    const CaptureTrace trace = capture->snapshot();
+    assert(trace.files.size() == 2);
+    assert(trace.files[0].name == "assets/textures.pak");
+    assert(trace.files[0].extent == 1024 + 512);
+    assert(trace.files[1].name == "fd" + std::to_string(fd_b));
+    assert(trace.files[1].extent == 128 + 32);
+
+    assert(trace.requests[0].file_id == 0);
+    assert(trace.requests[0].size == 64);
+    assert(trace.requests[1].file_id == 1);
+    assert(trace.requests[2].file_id == 0);
+    assert(trace.requests[2].offset == 1024);
+    assert(trace.requests[2].compression == Compression::FakeUppercase);
+    for (std::size_t i = 1; i < trace.requests.size(); ++i) {
+        assert(trace.requests[i - 1].time_ns <= trace.requests[i].time_ns);
+    }
+
+    // Reusing fd_b for a different file starts a new id.
+    capture->name_file(fd_b, "audio/music.pak");
+    Request reused = other;
+    reused.offset = 0;
+    queue.enqueue(reused);
+    queue.submit_all();
+    queue.wait_all();
+    const CaptureTrace later = capture->snapshot();
+    assert(later.files.size() == 3);
+    assert(later.files[2].name == "audio/music.pak");
+    assert(later.requests.back().file_id == 2);
+
+    ::close(fd_a);
+    ::close(fd_b);
+    ::unlink(kFilename);
+
+    std::cout << "[request_capture_test] test_queue_capture PASSED\n";
+}
+
+void test_round_trip() {
+    using namespace ds;
+
+    CaptureTrace trace;
+    trace.files.push_back({"pack 0.bin", 1u << 20});
+    trace.files.push_back({"fd7", 4096});
+    CapturedRequest read;
+    read.time_ns = 10;
+    read.file_id = 0;
+    read.offset = 4096;
+    read.size = 65536;
+    read.compression = Compression::GDeflate;
+    CapturedRequest write;
+    write.time_ns = 2500;
+    write.file_id = 1;
+    write.op = RequestOp::Write;
+    write.size = 4096;
+    trace.requests = {read, write};
+
+    std::stringstream stream;
+    assert(write_capture(stream, trace));
+
+    CaptureTrace parsed;
+    assert(read_capture(stream, parsed));
+    assert(parsed.files.size() == 2);
+    assert(parsed.files[0].name == "pack 0.bin");
+    assert(parsed.files[0].extent == (1u << 20));
+    assert(parsed.requests.size() == 2);
+    assert(parsed.requests[0].time_ns == 10);
+    assert(parsed.requests[0].offset == 4096);
+    assert(parsed.requests[0].size == 65536);
+    assert(parsed.requests[0].compression == Compression::GDeflate);
+    assert(parsed.requests[1].op == RequestOp::Write);
+    assert(parsed.requests[1].file_id == 1);
+
+    std::cout << "[request_capture_test] test_round_trip PASSED\n";
+}
+
+void test_malformed_input() {
+    using namespace ds;
+
+    const char* bad_inputs[] = {
+        "",
+        "ds-capture 2\n",
+        "not-a-capture 1\n",
+        "ds-capture 1\nreq 0 0 r none 0 16\n",          // Unknown file id.
+        "ds-capture 1\nfile 1 16 skipped_id\n",          // Ids must be dense.
+        "ds-capture 1\nfile 0 16 a\nreq 0 0 x none 0 16\n",
+        "ds-capture 1\nfile 0 16 a\nreq 0 0 r zstd 0 16\n",
+        "ds-capture 1\nfile 0 16 a\nbogus line\n",
+    };
+    for (const char* text : bad_inputs) {
+        std::istringstream in(text);
+        CaptureTrace out;
+        assert(!read_capture(in, out));
+    }
+
+    std::cout << "[request_capture_test] test_malformed_input PASSED\n";
+}
+
+} // namespace
+
+int main() {
+    test_queue_capture();
+    test_round_trip();
+    test_malformed_input();
+
+    std::cout << "[request_capture_test] ALL TESTS PASSED\n";
+    return 0;
+}
@@ -0,0 +1,177 @@
+// SPDX-License-Identifier: Apache-2.0
+// Per-request wait test.
+//
+// This test verifies:
+//  - wait_for() times out while a request is still in flight
+//  - wait() returns once that specific request completes, even though
+//    other requests are still outstanding
+//  - wait_any() reports which of several requests finished first
+//  - is_complete() reflects completion without blocking
+//  - A nanoseconds::max() timeout waits for completion instead of
+//    overflowing the deadline
+
+#include "ds_runtime.hpp"
+
+#include <cassert>
+#include <chrono>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace {
+
+// Holds submissions until the test releases them individually.
+class GatedBackend final : public ds::Backend {
+public:
+    void submit(ds::Request req, ds::CompletionCallback on_complete) override {
+        std::lock_guard<std::mutex> lock(mtx_);
+        held_.emplace_back(std::move(req), std::move(on_complete));
+    }
+
+    std::size_t held() {
+        std::lock_guard<std::mutex> lock(mtx_);
+        return held_.size();
+    }
+
+    // Complete the held request whose user_tag is @p tag.
+    void release(std::uint64_t tag) {
+        std::pair<ds::Request, ds::CompletionCallback> entry;
+        {
+            std::lock_guard<std::mutex> lock(mtx_);
+            for (auto it = held_.begin(); it != held_.end(); ++it) {
+                if (it->first.user_tag == tag) {
+                    entry = std::move(*it);
+                    held_.erase(it);
+                    break;
+                }
+            }
+        }
+        assert(entry.second);
+        entry.first.status = ds::RequestStatus::Ok;
+        entry.first.bytes_transferred = entry.first.size;
+        entry.second(entry.first);
+    }
+
+private:
+    std::mutex mtx_;
+    std::vector<std::pair<ds::Request, ds::CompletionCallback>> held_;
+};
+
+ds::Request make_request(std::uint64_t tag, char* sink) {
+    ds::Request req;
+    req.fd = 0;
+    req.size = 1;
+    req.dst = sink;
+    req.user_tag = tag;
+    return req;
+}
+
+void test_wait_single_and_timeout() {
+    using namespace ds;
+    using namespace std::chrono_literals;
+
+    auto gate = std::make_shared<GatedBackend>();
+    Queue queue(gate);
+
+    char sink[3] = {};
+    const RequestId critical = queue.enqueue_tracked(make_request(1, &sink[0]));
+    const RequestId prefetch = queue.enqueue_tracked(make_request(2, &sink[1]));
+    queue.enqueue(make_request(3, &sink[2])); // Untracked background work.
+    queue.submit_all();
+    assert(gate->held() == 3);
+
+    assert(!queue.is_complete(critical));
+    assert(!queue.wait_for(critical, 10ms));
+
+    std::thread releaser([&]() {
+        std::this_thread::sleep_for(20ms);
+        gate->release(1);
+    });
+    queue.wait(critical);
+    releaser.join();
+
+    assert(queue.is_complete(critical));
+    assert(!queue.is_complete(prefetch));
+    assert(queue.in_flight() == 2); // wait() did not wait for the rest.
+
+    gate->release(2);
+    gate->release(3);
+    queue.wait_all();
+    assert(queue.is_complete(prefetch));
+    assert(queue.wait_for(prefetch, 0ms));
+
+    std::cout << "[request_wait_test] test_wait_single_and_timeout PASSED\n";
+}
+
+void test_wait_any() {
+    using namespace ds;
+    using namespace std::chrono_literals;
+
+    auto gate = std::make_shared<GatedBackend>();
+    Queue queue(gate);
+
+    char sink[3] = {};
+    const std::vector<RequestId> ids = {
+        queue.enqueue_tracked(make_request(10, &sink[0])),
+        queue.enqueue_tracked(make_request(11, &sink[1])),
+        queue.enqueue_tracked(make_request(12, &sink[2])),
+    };
+    queue.submit_all();
+
+    assert(queue.wait_any_for(ids, 5ms) == ids.size());
+
+    std::thread releaser([&]() {
+        std::this_thread::sleep_for(10ms);
+        gate->release(11);
+    });
+    assert(queue.wait_any(ids) == 1);
+    releaser.join();
+
+    gate->release(10);
+    gate->release(12);
+    queue.wait_all();
+    assert(queue.wait_any({}) == 0);
+
+    std::cout << "[request_wait_test] test_wait_any PASSED\n";
+}
+
+void test_max_timeout() {
+    using namespace ds;
+    using namespace std::chrono_literals;
+
+    auto gate = std::make_shared<GatedBackend>();
+    Queue queue(gate);
+
+    char sink[2] = {};
+    const std::vector<RequestId> ids = {
+        queue.enqueue_tracked(make_request(20, &sink[0])),
+        queue.enqueue_tracked(make_request(21, &sink[1])),
+    };
+    queue.submit_all();
+
+    std::thread releaser([&]() {
+        std::this_thread::sleep_for(10ms);
+        gate->release(21);
+        std::this_thread::sleep_for(10ms);
+        gate->release(20);
+    });
+    assert(queue.wait_any_for(ids, std::chrono::nanoseconds::max()) == 1);
+    assert(queue.wait_for(ids[0], std::chrono::nanoseconds::max()));
+    releaser.join();
+    queue.wait_all();
+
+    std::cout << "[request_wait_test] test_max_timeout PASSED\n";
+}
+
+} // namespace
+
+int main() {
+    test_wait_single_and_timeout();
+    test_wait_any();
+    test_max_timeout();
+
+    std::cout << "[request_wait_test] ALL TESTS PASSED\n";
+    return 0;
+}
@@ -0,0 +1,381 @@
+// SPDX-License-Identifier: Apache-2.0
+// Streaming GDeflate decode test.
+//
+// The runtime has no GDeflate codec of its own, so this test plugs in the
+// "stored" block codec of gdeflate_test_util.hpp and checks the read/decode
+// pipeline around it.
+//
+// This test verifies:
+//  - Block reads run ahead of decoding through the ring: with a slow
+//    device and a slow codec a stream takes about the longer of the two,
+//    while a one-slot ring takes their sum
+//  - Streams decode over the CPU backend (and io_uring when built), into
+//    caller or Runtime memory, including block tables that need a second
+//    read; other requests pass through
+//  - Malformed streams, short destinations, failed block reads and decoder
+//    errors fail the request once everything in flight has drained
+//  - Checksummed blocks are verified on the decode workers; a damaged one
+//    completes the read as Corrupt
+
+#include "ds_runtime.hpp"
+#include "ds_runtime_stream_decode.hpp"
+#include "gdeflate_format.h"
+#include "gdeflate_test_util.hpp"
+
+#ifdef DS_RUNTIME_HAS_IO_URING
+#include "ds_runtime_uring.hpp"
+#endif
+
+#include <atomic>
+#include <cassert>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace {
+
+using namespace gdeflate_test;
+
+const char* kFilename = "stream_decode_test.bin";
+
+/// Stored-block codec taking @p delay per block; fails blocks whose
+/// first decoded byte equals @p fail_on.
+ds::BlockDecoder xor_decoder(std::chrono::microseconds delay, int fail_on = -1) {
+    return [delay, fail_on](const void* src, std::size_t src_size, void* dst, std::size_t dst_size) {
+        std::this_thread::sleep_for(delay);
+        if (src_size != dst_size) {
+            return EINVAL;
+        }
+        const auto* in = static_cast<const unsigned char*>(src);
+        auto* out = static_cast<unsigned char*>(dst);
+        for (std::size_t i = 0; i < src_size; ++i) {
+            out[i] = static_cast<unsigned char>(in[i] ^ kKey);
+        }
+        return fail_on >= 0 && out[0] == fail_on ? EILSEQ : 0;
+    };
+}
+
+/// A device serving one read at a time, each taking at least `latency`.
+class SerialDisk final : public ds::Backend {
+public:
+    explicit SerialDisk(std::chrono::microseconds latency)
+        : latency_(latency), worker_([this] { run(); }) {}
+
+    ~SerialDisk() override {
+        {
+            std::lock_guard<std::mutex> lock(mtx_);
+            stop_ = true;
+        }
+        cv_.notify_all();
+        worker_.join();
+    }
+
+    void submit(ds::Request req, ds::CompletionCallback on_complete) override {
+        {
+            std::lock_guard<std::mutex> lock(mtx_);
+            ops_.push_back({std::move(req), std::move(on_complete)});
+        }
+        cv_.notify_one();
+    }
+
+private:
+    struct Op {
+        ds::Request req;
+        ds::CompletionCallback on_complete;
+    };
+
+    void run() {
+        for (;;) {
+            Op op;
+            {
+                std::unique_lock<std::mutex> lock(mtx_);
+                cv_.wait(lock, [this] { return stop_ || !ops_.empty(); });
+                if (ops_.empty()) {
+                    return;
+                }
+                op = std::move(ops_.front());
+                ops_.pop_front();
+            }
+            std::this_thread::sleep_for(latency_);
+            const ssize_t n = ::pread(op.req.fd, op.req.dst, op.req.size,
+                                      static_cast<off_t>(op.req.offset));
+            op.req.status = n < 0 ? ds::RequestStatus::IoError : ds::RequestStatus::Ok;
+            op.req.errno_value = n < 0 ? errno : 0;
+            op.req.bytes_transferred = n < 0 ? 0 : static_cast<std::size_t>(n);
+            op.on_complete(op.req);
+        }
+    }
+
+    const std::chrono::microseconds latency_;
+    std::mutex mtx_;
+    std::condition_variable cv_;
+    std::deque<Op> ops_;
+    bool stop_ = false;
+    std::thread worker_;
+};
+
+ds::Request make_read(int fd, void* dst, std::size_t size) {
+    ds::Request req;
+    req.fd = fd;
+    req.offset = kStreamOffset;
+    req.size = size;
+    req.dst = dst;
+    req.compression = ds::Compression::GDeflate;
+    return req;
+}
+
+/// Decode the whole test stream through @p backend; returns seconds taken.
+double timed_read(const std::shared_ptr<ds::Backend>& backend, int fd,
+                  const std::vector<char>& decoded) {
+    std::vector<char> out(decoded.size());
+    ds::Queue queue(backend);
+    const auto start = std::chrono::steady_clock::now();
+    queue.enqueue(make_read(fd, out.data(), out.size()));
+    queue.submit_all();
+    queue.wait_all();
+    const double seconds =
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    assert(queue.stats().failed == 0);
+    assert(out == decoded);
+    return seconds;
+}
+
+void test_overlap() {
+    using namespace ds;
+
+    constexpr std::size_t kBlocks = 24;
+    constexpr std::chrono::milliseconds kStep{4};
+    const std::vector<char> decoded = make_decoded({kBlocks, 16 * 1024});
+    const int fd = create_file(kFilename, encode(decoded, {kBlocks, 16 * 1024}));
+
+    StreamDecodeConfig config;
+    config.decoder = xor_decoder(kStep);
+    config.decode_workers = 1;
+
+    // One slot: each block is read, then decoded, strictly in turn.
+    config.ring_blocks = 1;
+    auto serial = make_streaming_decode_backend(std::make_shared<SerialDisk>(kStep), config);
+    const double serial_seconds = timed_read(serial, fd, decoded);
+    const StreamDecodeStats serial_stats = serial->decode_stats();
+    assert(serial_stats.streams == 1 && serial_stats.blocks == kBlocks);
+    assert(serial_stats.overlapped == 0);
+    assert(serial_seconds >= 2.0 * kBlocks * 0.004);
+
+    // Four slots: the device reads ahead while the codec works.
+    config.ring_blocks = 4;
+    auto piped = make_streaming_decode_backend(std::make_shared<SerialDisk>(kStep), config);
+    const double piped_seconds = timed_read(piped, fd, decoded);
+    const StreamDecodeStats piped_stats = piped->decode_stats();
+    assert(piped_stats.streams == 1 && piped_stats.blocks == kBlocks);
+    assert(piped_stats.overlapped >= kBlocks / 2);
+    assert(piped_stats.in_flight == 0);
+    assert(piped_seconds < 0.8 * serial_seconds);
+
+    ::close(fd);
+    std::cout << "[stream_decode_test] test_overlap PASSED (serial " << serial_seconds * 1000
+              << " ms, pipelined " << piped_seconds * 1000 << " ms)\n";
+}
+
+void check_backend(const std::shared_ptr<ds::Backend>& inner, const char* name) {
+    using namespace ds;
+
+    // 400 blocks: the table does not fit the default 8 KiB index read.
+    constexpr std::size_t kBlocks = 400;
+    const std::vector<char> decoded = make_decoded({kBlocks, 1024});
+    const int fd = create_file(kFilename, encode(decoded, {kBlocks, 1024}));
+
+    StreamDecodeConfig config;
+    config.decoder = xor_decoder(std::chrono::microseconds(0));
+    auto backend = make_streaming_decode_backend(inner, config);
+    assert(backend->provides_buffers() == inner->provides_buffers());
+    Queue queue(backend);
+
+    std::vector<char> out(decoded.size());
+    queue.enqueue(make_read(fd, out.data(), out.size()));
+    Request runtime = make_read(fd, nullptr, decoded.size());
+    runtime.dst_memory = RequestMemory::Runtime;
+    runtime.user_tag = 1;
+    queue.enqueue(runtime);
+    std::vector<char> plain(kStreamOffset);
+    Request passthrough;
+    passthrough.fd = fd;
+    passthrough.size = plain.size();
+    passthrough.dst = plain.data();
+    passthrough.user_tag = 2;
+    queue.enqueue(passthrough);
+    queue.submit_all();
+    queue.wait_all();
+
+    const std::vector<Request> completed = queue.take_completed();
+    assert(completed.size() == 3);
+    for (const Request& r : completed) {
+        assert(r.status == RequestStatus::Ok);
+        if (r.user_tag == 1) {
+            assert(r.bytes_transferred == decoded.size());
+            assert(r.buffer.size() == decoded.size());
+            assert(std::memcmp(r.buffer.data(), decoded.data(), decoded.size()) == 0);
+        }
+    }
+    assert(out == decoded);
+    assert(plain == std::vector<char>(kStreamOffset, 'x'));
+    const StreamDecodeStats stats = backend->decode_stats();
+    assert(stats.streams == 2 && stats.blocks == 2 * kBlocks && stats.failed == 0);
+
+    ::close(fd);
+    std::cout << "[stream_decode_test] check_backend(" << name << ") PASSED\n";
+}
+
+void test_backends() {
+    check_backend(ds::make_cpu_backend(2), "cpu");
+    check_backend(std::make_shared<SerialDisk>(std::chrono::microseconds(0)), "serial");
+#ifdef DS_RUNTIME_HAS_IO_URING
+    ds::IoUringBackendConfig uring;
+    uring.entries = 64;
+    check_backend(ds::make_io_uring_backend(uring), "io_uring");
+#endif
+}
+
+void test_failures() {
+    using namespace ds;
+
+    std::atomic<std::size_t> errors{0};
+    set_error_callback([&errors](const ErrorContext&) { ++errors; });
+
+    constexpr std::size_t kBlocks = 32;
+    const std::vector<char> decoded = make_decoded({kBlocks, 4096});
+    std::vector<char> stream = encode(decoded, {kBlocks, 4096});
+    std::vector<char> out(decoded.size());
+
+    const auto run = [&](const std::shared_ptr<Backend>& backend, const Request& req) {
+        Queue queue(backend);
+        queue.enqueue(req);
+        queue.submit_all();
+        queue.wait_all();
+        const std::vector<Request> completed = queue.take_completed();
+        assert(completed.size() == 1);
+        assert(completed[0].status == RequestStatus::IoError);
+        assert(completed[0].bytes_transferred == 0);
+        return completed[0].errno_value;
+    };
+
+    StreamDecodeConfig config;
+    config.decoder = xor_decoder(std::chrono::microseconds(0));
+    auto backend = make_streaming_decode_backend(make_cpu_backend(2), config);
+
+    int fd = create_file(kFilename, stream);
+    int err = run(backend, make_read(fd, out.data(), out.size() - 1));
+    assert(err == EOVERFLOW);
+    Request plain = make_read(fd, out.data(), out.size());
+    plain.offset = 0;
+    err = run(backend, plain);
+    assert(err == EINVAL);
+
+    // A decoder error stops the stream; every block still in flight drains.
+    const std::size_t before = errors.load();
+    StreamDecodeConfig failing = config;
+    failing.decoder = xor_decoder(std::chrono::microseconds(100), 'a' + 7);
+    auto failing_backend = make_streaming_decode_backend(make_cpu_backend(2), failing);
+    err = run(failing_backend, make_read(fd, out.data(), out.size()));
+    assert(err == EILSEQ);
+    assert(errors.load() == before + 1);
+    const StreamDecodeStats stats = failing_backend->decode_stats();
+    assert(stats.failed == 1 && stats.in_flight == 0 && stats.blocks < kBlocks);
+
+    // Without a decoder the request reaches the CPU backend, which has none.
+    auto bare = make_streaming_decode_backend(make_cpu_backend(1));
+    err = run(bare, make_read(fd, out.data(), out.size()));
+    assert(err == ENOTSUP);
+    ::close(fd);
+
+    // A block pointing past the payload.
+    gdeflate::BlockInfo last{};
+    const std::size_t last_at = sizeof(gdeflate::FileHeader) + (kBlocks - 1) * sizeof(last);
+    std::memcpy(&last, stream.data() + last_at, sizeof(last));
+    last.offset = stream.size();
+    std::memcpy(stream.data() + last_at, &last, sizeof(last));
+    fd = create_file(kFilename, stream);
+    err = run(backend, make_read(fd, out.data(), out.size()));
+    assert(err == EINVAL);
+    ::close(fd);
+
+    // Truncated payload: late blocks come back short.
+    fd = create_file(kFilename, encode(decoded, {kBlocks, 4096}));
+    const int cut = ::ftruncate(fd, static_cast<off_t>(kStreamOffset + stream.size() / 2));
+    assert(cut == 0);
+    err = run(backend, make_read(fd, out.data(), out.size()));
+    assert(err == EIO);
+    assert(backend->decode_stats().in_flight == 0);
+    ::close(fd);
+
+    set_error_callback(nullptr);
+    std::cout << "[stream_decode_test] test_failures PASSED\n";
+}
+
+void test_checksums() {
+    using namespace ds;
+
+    set_error_callback([](const ErrorContext& ctx) {
+        assert(ctx.subsystem == "decode" && ctx.operation == "verify");
+    });
+
+    constexpr std::size_t kBlocks = 32;
+    const std::vector<char> decoded = make_decoded({kBlocks, 4096});
+    std::vector<char> stream = encode(decoded, {kBlocks, 4096}, true);
+    std::vector<char> out(decoded.size());
+
+    StreamDecodeConfig config;
+    config.decoder = xor_decoder(std::chrono::microseconds(0));
+    auto backend = make_streaming_decode_backend(make_cpu_backend(2), config);
+    const auto run = [&](int fd) {
+        Queue queue(backend);
+        queue.enqueue(make_read(fd, out.data(), out.size()));
+        queue.submit_all();
+        queue.wait_all();
+        std::vector<Request> completed = queue.take_completed();
+        assert(completed.size() == 1);
+        return completed[0];
+    };
+
+    int fd = create_file(kFilename, stream);
+    Request done = run(fd);
+    assert(done.status == RequestStatus::Ok && out == decoded);
+    StreamDecodeStats stats = backend->decode_stats();
+    assert(stats.verified == kBlocks && stats.corrupt == 0);
+    ::close(fd);
+
+    // Damage block 20's payload.
+    stream[sizeof(gdeflate::FileHeader) + kBlocks * sizeof(gdeflate::BlockInfo) + 20 * 4096 + 7] ^= 0x40;
+    fd = create_file(kFilename, stream);
+    done = run(fd);
+    assert(done.status == RequestStatus::Corrupt);
+    assert(done.errno_value == EBADMSG && done.bytes_transferred == 0);
+    stats = backend->decode_stats();
+    assert(stats.corrupt == 1 && stats.failed == 1 && stats.in_flight == 0);
+    ::close(fd);
+
+    set_error_callback(nullptr);
+    std::cout << "[stream_decode_test] test_checksums PASSED\n";
+}
+
+} // namespace
+
+int main() {
+    test_overlap();
+    test_backends();
+    test_failures();
+    test_checksums();
+
+    ::unlink(kFilename);
+    std::cout << "[stream_decode_test] ALL TESTS PASSED\n";
+    return 0;
+}
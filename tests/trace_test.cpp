@@ -0,0 +1,155 @@
+// SPDX-License-Identifier: Apache-2.0
+// Request tracing test.
+//
+// This test verifies:
+//  - Nothing is recorded while tracing is disabled
+//  - Queue and CPU backend stages show up as Chrome trace "X" events
+//  - Spans recorded by worker threads that have since exited are flushed
+//  - A flush drains the buffers, and full rings drop (and count) events
+
+#include "ds_runtime.hpp"
+#include "ds_runtime_trace.hpp"
+
+#include <cassert>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace {
+
+const char* kFilename = "trace_test.bin";
+
+int open_test_file() {
+    std::vector<char> contents(1024, 'q');
+    const int fd_write = ::open(kFilename, O_CREAT | O_WRONLY | O_TRUNC, 0644);
+    assert(fd_write >= 0);
+    const ssize_t wr = ::write(fd_write, contents.data(), contents.size());
+    assert(wr == static_cast<ssize_t>(contents.size()));
+    ::close(fd_write);
+
+    const int fd = ::open(kFilename, O_RDONLY);
+    assert(fd >= 0);
+    return fd;
+}
+
+void run_reads(int fd, std::size_t count,
+               ds::Compression compression = ds::Compression::None) {
+    using namespace ds;
+    std::vector<char> buffer(count * 16 + 1);
+    Queue queue(make_cpu_backend(2));
+    for (std::size_t i = 0; i < count; ++i) {
+        Request req;
+        req.fd = fd;
+        req.offset = i * 16;
+        req.size = 16;
+        req.dst = buffer.data() + i * 16;
+        req.compression = compression;
+        req.user_tag = 100 + i;
+        queue.enqueue(req);
+    }
+    queue.submit_all();
+    queue.wait_all();
+    // Queue and backend (and their worker threads) are destroyed here.
+}
+
+std::size_t count_of(const std::string& haystack, const std::string& needle) {
+    std::size_t n = 0;
+    for (std::size_t pos = haystack.find(needle); pos != std::string::npos;
+         pos = haystack.find(needle, pos + 1)) {
+        ++n;
+    }
+    return n;
+}
+
+void test_disabled_records_nothing() {
+    using namespace ds;
+
+    trace::clear();
+    const int fd = open_test_file();
+    assert(!trace::enabled());
+    run_reads(fd, 8);
+
+    std::ostringstream out;
+    assert(trace::write_chrome_json(out) == 0);
+    assert(out.str().find("\"traceEvents\":[") != std::string::npos);
+
+    ::close(fd);
+    ::unlink(kFilename);
+
+    std::cout << "[trace_test] test_disabled_records_nothing PASSED\n";
+}
+
+void test_request_stages() {
+    using namespace ds;
+
+    const int fd = open_test_file();
+    trace::enable();
+    run_reads(fd, 8, Compression::FakeUppercase);
+    trace::disable();
+
+    std::ostringstream out;
+    const std::size_t events = trace::write_chrome_json(out);
+    const std::string json = out.str();
+
+    // Per request: queue pending + complete, cpu pool_wait + pread +
+    // decompress + callback.
+    assert(events == 8 * 6);
+    assert(count_of(json, "\"ph\":\"X\"") == events);
+    assert(count_of(json, "\"name\":\"pending\"") == 8);
+    assert(count_of(json, "\"name\":\"complete\"") == 8);
+    assert(count_of(json, "\"name\":\"pool_wait\"") == 8);
+    assert(count_of(json, "\"name\":\"pread\"") == 8);
+    assert(count_of(json, "\"name\":\"decompress\"") == 8);
+    assert(count_of(json, "\"name\":\"callback\"") == 8);
+    assert(json.find("\"user_tag\":107") != std::string::npos);
+    assert(json.rfind("]}") != std::string::npos);
+
+    // Drained: a second flush has nothing left.
+    std::ostringstream again;
+    assert(trace::write_chrome_json(again) == 0);
+
+    ::close(fd);
+    ::unlink(kFilename);
+
+    std::cout << "[trace_test] test_request_stages PASSED\n";
+}
+
+void test_full_ring_drops() {
+    using namespace ds;
+
+    trace::enable(4);
+    const std::uint64_t dropped_before = trace::dropped_events();
+    std::thread recorder([] {
+        Request req;
+        for (int i = 0; i < 10; ++i) {
+            trace::record("test", "span", 1000, 2000, req);
+        }
+    });
+    recorder.join();
+    trace::disable();
+
+    std::ostringstream out;
+    assert(trace::write_chrome_json(out) == 4);
+    assert(trace::dropped_events() - dropped_before == 6);
+
+    trace::enable(); // Restore the default size for later threads.
+    trace::disable();
+
+    std::cout << "[trace_test] test_full_ring_drops PASSED\n";
+}
+
+} // namespace
+
+int main() {
+    test_disabled_records_nothing();
+    test_request_stages();
+    test_full_ring_drops();
+
+    std::cout << "[trace_test] ALL TESTS PASSED\n";
+    return 0;
+}
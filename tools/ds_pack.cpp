@@ -0,0 +1,180 @@
+// SPDX-License-Identifier: Apache-2.0
+// Asset pack tool for ds-runtime.
+//
+//  - create  packs files into an archive (ds_runtime_archive.hpp). Asset
+//            names are the paths as given, or relative to --root. Files
+//            that start with a GDeflate stream header are stored as
+//            Compression::GDeflate entries.
+//  - list    prints one line per entry: name, offset, stored and decoded
+//            size, compression and checksum.
+//  - verify  checks the index and every entry's checksum.
+
+#include "ds_runtime_archive.hpp"
+#include "gdeflate_format.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace {
+
+void usage(const char* argv0) {
+    std::cerr
+        << "usage: " << argv0 << " create -o ARCHIVE [--align N] [--root DIR] [--no-perfect-hash] FILE...\n"
+        << "       " << argv0 << " list ARCHIVE\n"
+        << "       " << argv0 << " verify ARCHIVE\n"
+        << "  -o ARCHIVE     output pack file\n"
+        << "  --align N      data alignment in bytes, a power of two (default 4096)\n"
+        << "  --root DIR     store names relative to DIR\n"
+        << "  --no-perfect-hash\n"
+        << "                 look names up through the fanout table only\n";
+}
+
+const char* compression_name(std::uint8_t compression) {
+    switch (static_cast<ds::Compression>(compression)) {
+    case ds::Compression::None:
+        return "none";
+    case ds::Compression::FakeUppercase:
+        return "fake_uppercase";
+    case ds::Compression::GDeflate:
+        return "gdeflate";
+    }
+    return "unknown";
+}
+
+/// True if @p path begins with a valid GDeflate stream header.
+bool is_gdeflate_stream(const std::string& path) {
+    const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+    ds::gdeflate::FileHeader header{};
+    const ssize_t n = ::pread(fd, &header, sizeof(header), 0);
+    ::close(fd);
+    return n == static_cast<ssize_t>(sizeof(header)) &&
+           ds::gdeflate::parse_file_header(&header, sizeof(header), header);
+}
+
+int create(int argc, char** argv) {
+    std::string output;
+    std::string root;
+    ds::ArchiveBuildConfig config;
+    std::vector<std::string> files;
+    for (int i = 2; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if ((arg == "-o" || arg == "--align" || arg == "--root") && i + 1 >= argc) {
+            std::cerr << "missing value for " << arg << "\n";
+            return 2;
+        }
+        if (arg == "-o") {
+            output = argv[++i];
+        } else if (arg == "--align") {
+            char* end = nullptr;
+            const unsigned long value = std::strtoul(argv[++i], &end, 0);
+            if (*end != '\0' || value == 0 || value > UINT32_MAX || (value & (value - 1)) != 0) {
+                std::cerr << "invalid alignment " << argv[i] << "\n";
+                return 2;
+            }
+            config.alignment = static_cast<std::uint32_t>(value);
+        } else if (arg == "--no-perfect-hash") {
+            config.perfect_hash = false;
+        } else if (arg == "--root") {
+            root = argv[++i];
+            if (!root.empty() && root.back() != '/') {
+                root += '/';
+            }
+        } else {
+            files.push_back(arg);
+        }
+    }
+    if (output.empty() || files.empty()) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    ds::ArchiveBuilder builder(config);
+    for (const std::string& file : files) {
+        ds::ArchiveAsset asset;
+        asset.name = file;
+        if (!root.empty() && asset.name.compare(0, root.size(), root) == 0) {
+            asset.name.erase(0, root.size());
+        }
+        if (is_gdeflate_stream(file)) {
+            asset.compression = ds::Compression::GDeflate;
+        }
+        if (!builder.add_file(asset, file)) {
+            return 1;
+        }
+    }
+    if (!builder.write(output)) {
+        return 1;
+    }
+    std::cerr << "ds_pack: wrote " << builder.size() << " assets to " << output << "\n";
+    return 0;
+}
+
+int list(const std::string& path) {
+    const auto pack = ds::open_archive(path);
+    if (!pack) {
+        return 1;
+    }
+    for (std::size_t i = 0; i < pack->entry_count(); ++i) {
+        const ds::archive::TocEntry& entry = pack->entries()[i];
+        std::cout << pack->name(entry)
+                  << " offset=" << entry.offset
+                  << " size=" << entry.size
+                  << " uncompressed=" << entry.uncompressed_size
+                  << " compression=" << compression_name(entry.compression)
+                  << " crc32c=" << std::hex << std::setw(8) << std::setfill('0')
+                  << entry.checksum << std::dec << std::setfill(' ') << "\n";
+    }
+    return 0;
+}
+
+int verify(const std::string& path) {
+    const auto pack = ds::open_archive(path);
+    if (!pack) {
+        return 1;
+    }
+    if (!pack->verify()) {
+        std::cerr << "ds_pack: " << path << ": index is corrupt\n";
+        return 1;
+    }
+    std::size_t bad = 0;
+    for (std::size_t i = 0; i < pack->entry_count(); ++i) {
+        const ds::archive::TocEntry& entry = pack->entries()[i];
+        if (!pack->verify_entry(entry)) {
+            std::cerr << "ds_pack: " << path << ": checksum mismatch in "
+                      << pack->name(entry) << "\n";
+            ++bad;
+        }
+    }
+    std::cerr << "ds_pack: " << path << ": " << pack->entry_count() << " entries"
+              << (pack->has_perfect_hash() ? " (perfect hash)" : "") << ", "
+              << bad << " corrupt\n";
+    return bad == 0 ? 0 : 1;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        usage(argv[0]);
+        return 2;
+    }
+    const std::string command = argv[1];
+    if (command == "create") {
+        return create(argc, argv);
+    }
+    if ((command == "list" || command == "verify") && argc == 3) {
+        return command == "list" ? list(argv[2]) : verify(argv[2]);
+    }
+    usage(argv[0]);
+    return command == "--help" || command == "-h" ? 0 : 2;
+}